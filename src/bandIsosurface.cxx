@@ -0,0 +1,466 @@
+/****************************************************************************
+*   bandIsosurface.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the fused threshold and isosurface
+*                   extraction.
+*
+*                   The extraction works in two passes over the volume, in the
+*                   spirit of flying edges:
+*                     1. Count the edge crossings and triangles of every slice
+*                        in parallel.
+*                     2. Turn the counts into offsets (prefix sum), then let every
+*                        thread generate the points and triangles of its own
+*                        slab straight into the preallocated output arrays.
+*                   Only a few slices of edge ids are kept per thread, so no
+*                   volume-sized intermediate is ever allocated.
+****************************************************************************/
+
+#include "bandIsosurface.hxx"
+#include "parallelUtils.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkMarchingCubesTriangleCases.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+
+namespace
+{
+
+// Corners of a cell and the corners joined by each edge, in the order used by vtkMarchingCubes
+const int CORNER_OFFSETS[8][3] = { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 0, 1, 0 },
+                                   { 0, 0, 1 }, { 1, 0, 1 }, { 1, 1, 1 }, { 0, 1, 1 } };
+const int EDGE_CORNERS[12][2] = { { 0, 1 }, { 1, 2 }, { 3, 2 }, { 0, 3 }, { 4, 5 }, { 5, 6 },
+                                  { 7, 6 }, { 4, 7 }, { 0, 4 }, { 1, 5 }, { 3, 7 }, { 2, 6 } };
+
+/*
+*   Extraction of the band surface for one scalar type.
+*/
+template <class T>
+class BandExtractor
+{
+public:
+    BandExtractor( const T* scalars, const int dims[3], const double origin[3], const double spacing[3],
+                   double lower, double upper ) :
+        _Scalars( scalars ), _Lower( lower ), _Upper( upper )
+    {
+        for ( int axis = 0; axis < 3; axis++ )
+        {
+            _Dims[axis] = dims[axis];
+            _Origin[axis] = origin[axis];
+            _Spacing[axis] = spacing[axis];
+        }
+
+        _SliceSize = static_cast<std::size_t>( _Dims[0] ) * _Dims[1];
+
+        // Number of triangles of every marching cubes case
+        vtkMarchingCubesTriangleCases* cases = vtkMarchingCubesTriangleCases::GetCases();
+        for ( int index = 0; index < 256; index++ )
+        {
+            int count = 0;
+            for ( const EDGE_LIST* edge = cases[index].edges; edge[0] > -1; edge += 3 )
+            {
+                count++;
+            }
+            _CaseTriangles[index] = count;
+        }
+    }
+
+    /*
+    *   Count the crossings of the x and y edges of every slice, the crossings of the
+    *   z edges between slice k and k+1, and the triangles of the cells between them.
+    */
+    void count( int k0, int k1, std::vector<vtkIdType>& xyCount, std::vector<vtkIdType>& zCount,
+                std::vector<vtkIdType>& triCount ) const
+    {
+        std::vector<float> f0( _SliceSize ), f1( _SliceSize );
+        std::vector<unsigned char> in0( _SliceSize ), in1( _SliceSize );
+
+        classifySlice( k0, f0.data(), in0.data() );
+
+        for ( int k = k0; k < k1; k++ )
+        {
+            xyCount[k] = countSliceEdges( in0.data() );
+
+            if ( k + 1 < _Dims[2] )
+            {
+                classifySlice( k + 1, f1.data(), in1.data() );
+
+                vtkIdType zEdges = 0, triangles = 0;
+                for ( std::size_t n = 0; n < _SliceSize; n++ )
+                {
+                    zEdges += ( in0[n] != in1[n] );
+                }
+
+                for ( int j = 0; j + 1 < _Dims[1]; j++ )
+                {
+                    for ( int i = 0; i + 1 < _Dims[0]; i++ )
+                    {
+                        triangles += _CaseTriangles[caseIndex( i, j, in0.data(), in1.data() )];
+                    }
+                }
+
+                zCount[k] = zEdges;
+                triCount[k] = triangles;
+
+                f0.swap( f1 );
+                in0.swap( in1 );
+            }
+        }
+    }
+
+    /*
+    *   Generate the points, normals and triangles of the cell layers [k0, k1).
+    *   A thread writes the points of the slices it owns (k0 to k1-1, plus the last
+    *   slice of the volume) and only computes the ids of the next slab's first slice.
+    */
+    void generate( int k0, int k1, const std::vector<vtkIdType>& xyOffset, const std::vector<vtkIdType>& zOffset,
+                   const std::vector<vtkIdType>& triOffset, float* points, float* normals, vtkIdType* cells ) const
+    {
+        std::vector<float> f0( _SliceSize ), f1( _SliceSize );
+        std::vector<unsigned char> in0( _SliceSize ), in1( _SliceSize );
+        std::vector<vtkIdType> x0( _SliceSize ), y0( _SliceSize ), x1( _SliceSize ), y1( _SliceSize ), z( _SliceSize );
+
+        vtkMarchingCubesTriangleCases* cases = vtkMarchingCubesTriangleCases::GetCases();
+
+        classifySlice( k0, f0.data(), in0.data() );
+        assignSliceEdges( k0, f0.data(), in0.data(), xyOffset[k0], x0.data(), y0.data(), points, normals );
+
+        for ( int k = k0; k < k1; k++ )
+        {
+            bool ownsNext = ( k + 1 < k1 ) || ( k + 1 == _Dims[2] - 1 );
+
+            classifySlice( k + 1, f1.data(), in1.data() );
+            assignSliceEdges( k + 1, f1.data(), in1.data(), xyOffset[k + 1], x1.data(), y1.data(),
+                              ownsNext ? points : nullptr, normals );
+
+            // Edges between slice k and k+1
+            vtkIdType id = zOffset[k];
+            for ( int j = 0; j < _Dims[1]; j++ )
+            {
+                for ( int i = 0; i < _Dims[0]; i++ )
+                {
+                    std::size_t n = static_cast<std::size_t>( j ) * _Dims[0] + i;
+                    if ( in0[n] != in1[n] )
+                    {
+                        z[n] = id;
+                        writePoint( id++, i, j, k, 2, f0[n], f1[n], points, normals );
+                    }
+                }
+            }
+
+            // Triangles of the cells between slice k and k+1, as a legacy cell array (3, a, b, c)
+            vtkIdType* cell = cells + 4 * triOffset[k];
+            for ( int j = 0; j + 1 < _Dims[1]; j++ )
+            {
+                for ( int i = 0; i + 1 < _Dims[0]; i++ )
+                {
+                    int index = caseIndex( i, j, in0.data(), in1.data() );
+                    if ( index == 0 || index == 255 )
+                    {
+                        continue;
+                    }
+
+                    std::size_t n = static_cast<std::size_t>( j ) * _Dims[0] + i;
+                    std::size_t right = n + 1, up = n + _Dims[0], upRight = up + 1;
+
+                    vtkIdType edgeIds[12] = { x0[n], y0[right], x0[up], y0[n],
+                                              x1[n], y1[right], x1[up], y1[n],
+                                              z[n],  z[right],  z[up],  z[upRight] };
+
+                    for ( const EDGE_LIST* edge = cases[index].edges; edge[0] > -1; edge += 3 )
+                    {
+                        cell[0] = 3;
+                        cell[1] = edgeIds[edge[0]];
+                        cell[2] = edgeIds[edge[1]];
+                        cell[3] = edgeIds[edge[2]];
+                        cell += 4;
+                    }
+                }
+            }
+
+            f0.swap( f1 );
+            in0.swap( in1 );
+            x0.swap( x1 );
+            y0.swap( y1 );
+        }
+    }
+
+private:
+    const T*    _Scalars;
+    int         _Dims[3];
+    double      _Origin[3];
+    double      _Spacing[3];
+    double      _Lower;
+    double      _Upper;
+    std::size_t _SliceSize;
+    int         _CaseTriangles[256];
+
+    /*
+    *   Band field: positive inside [lower, upper], negative outside.
+    */
+    double bandValue( double value ) const
+    {
+        return std::min( value - _Lower, _Upper - value );
+    }
+
+    double voxel( int i, int j, int k ) const
+    {
+        return static_cast<double>( _Scalars[k * _SliceSize + static_cast<std::size_t>( j ) * _Dims[0] + i] );
+    }
+
+    void classifySlice( int k, float* f, unsigned char* inside ) const
+    {
+        const T* slice = _Scalars + k * _SliceSize;
+        for ( std::size_t n = 0; n < _SliceSize; n++ )
+        {
+            double value = bandValue( static_cast<double>( slice[n] ) );
+            f[n] = static_cast<float>( value );
+            inside[n] = ( value >= 0.0 );
+        }
+    }
+
+    vtkIdType countSliceEdges( const unsigned char* inside ) const
+    {
+        vtkIdType edges = 0;
+        for ( int j = 0; j < _Dims[1]; j++ )
+        {
+            const unsigned char* row = inside + static_cast<std::size_t>( j ) * _Dims[0];
+            for ( int i = 0; i + 1 < _Dims[0]; i++ )
+            {
+                edges += ( row[i] != row[i + 1] );
+            }
+
+            if ( j + 1 < _Dims[1] )
+            {
+                const unsigned char* nextRow = row + _Dims[0];
+                for ( int i = 0; i < _Dims[0]; i++ )
+                {
+                    edges += ( row[i] != nextRow[i] );
+                }
+            }
+        }
+        return edges;
+    }
+
+    /*
+    *   Give ids to the crossed x and y edges of slice k, in the same order as they are
+    *   counted. Points are only written when a point array is given.
+    */
+    void assignSliceEdges( int k, const float* f, const unsigned char* inside, vtkIdType id,
+                           vtkIdType* xIds, vtkIdType* yIds, float* points, float* normals ) const
+    {
+        for ( int j = 0; j < _Dims[1]; j++ )
+        {
+            for ( int i = 0; i < _Dims[0]; i++ )
+            {
+                std::size_t n = static_cast<std::size_t>( j ) * _Dims[0] + i;
+
+                if ( i + 1 < _Dims[0] && inside[n] != inside[n + 1] )
+                {
+                    xIds[n] = id;
+                    if ( points != nullptr )
+                    {
+                        writePoint( id, i, j, k, 0, f[n], f[n + 1], points, normals );
+                    }
+                    id++;
+                }
+
+                if ( j + 1 < _Dims[1] && inside[n] != inside[n + _Dims[0]] )
+                {
+                    yIds[n] = id;
+                    if ( points != nullptr )
+                    {
+                        writePoint( id, i, j, k, 1, f[n], f[n + _Dims[0]], points, normals );
+                    }
+                    id++;
+                }
+            }
+        }
+    }
+
+    /*
+    *   Gradient of the band field at a grid point (central differences, one sided at the border).
+    */
+    void gradient( int i, int j, int k, double g[3] ) const
+    {
+        int index[3] = { i, j, k };
+        double value = voxel( i, j, k );
+
+        for ( int axis = 0; axis < 3; axis++ )
+        {
+            int lo[3] = { i, j, k };
+            int hi[3] = { i, j, k };
+            lo[axis] = std::max( 0, index[axis] - 1 );
+            hi[axis] = std::min( _Dims[axis] - 1, index[axis] + 1 );
+
+            int steps = hi[axis] - lo[axis];
+            g[axis] = ( steps > 0 ) ? ( voxel( hi[0], hi[1], hi[2] ) - voxel( lo[0], lo[1], lo[2] ) ) / ( steps * _Spacing[axis] ) : 0.0;
+        }
+
+        // Below the middle of the band f follows the intensity, above it f follows the negated intensity
+        if ( value - _Lower > _Upper - value )
+        {
+            g[0] = -g[0];
+            g[1] = -g[1];
+            g[2] = -g[2];
+        }
+    }
+
+    /*
+    *   Write the crossing point of the edge from grid point (i, j, k) along an axis.
+    */
+    void writePoint( vtkIdType id, int i, int j, int k, int axis, float fStart, float fEnd,
+                     float* points, float* normals ) const
+    {
+        double t = fStart / ( static_cast<double>( fStart ) - fEnd );
+
+        int start[3] = { i, j, k };
+        int end[3] = { i, j, k };
+        end[axis]++;
+
+        double gStart[3], gEnd[3];
+        gradient( start[0], start[1], start[2], gStart );
+        gradient( end[0], end[1], end[2], gEnd );
+
+        double normal[3];
+        for ( int c = 0; c < 3; c++ )
+        {
+            points[3 * id + c] = static_cast<float>( _Origin[c] + ( start[c] + ( c == axis ? t : 0.0 ) ) * _Spacing[c] );
+
+            // The band field decreases towards the outside, so the outward normal is the negated gradient
+            normal[c] = -( gStart[c] + t * ( gEnd[c] - gStart[c] ) );
+        }
+
+        double length = std::sqrt( normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2] );
+        for ( int c = 0; c < 3; c++ )
+        {
+            normals[3 * id + c] = static_cast<float>( length > 0.0 ? normal[c] / length : 0.0 );
+        }
+    }
+
+    int caseIndex( int i, int j, const unsigned char* in0, const unsigned char* in1 ) const
+    {
+        int index = 0;
+        for ( int corner = 0; corner < 8; corner++ )
+        {
+            const unsigned char* slice = CORNER_OFFSETS[corner][2] ? in1 : in0;
+            std::size_t n = static_cast<std::size_t>( j + CORNER_OFFSETS[corner][1] ) * _Dims[0] + i + CORNER_OFFSETS[corner][0];
+            if ( slice[n] )
+            {
+                index |= ( 1 << corner );
+            }
+        }
+        return index;
+    }
+};
+
+template <class T>
+vtkSmartPointer<vtkPolyData> runExtraction( const T* scalars, const int dims[3], const double origin[3],
+                                            const double spacing[3], double lower, double upper,
+                                            unsigned int numThreads )
+{
+    BandExtractor<T> extractor( scalars, dims, origin, spacing, lower, upper );
+
+    // Pass 1: count per slice
+    std::vector<vtkIdType> xyCount( dims[2], 0 ), zCount( dims[2], 0 ), triCount( dims[2], 0 );
+
+    parallelFor( 0, dims[2], [&]( std::size_t begin, std::size_t end )
+    {
+        extractor.count( static_cast<int>( begin ), static_cast<int>( end ), xyCount, zCount, triCount );
+    }, numThreads );
+
+    // Offsets of every slice in the output arrays
+    std::vector<vtkIdType> xyOffset( dims[2] ), zOffset( dims[2] ), triOffset( dims[2] );
+    vtkIdType numPoints = 0, numTriangles = 0;
+
+    for ( int k = 0; k < dims[2]; k++ )
+    {
+        xyOffset[k] = numPoints;
+        numPoints += xyCount[k];
+        zOffset[k] = numPoints;
+        numPoints += zCount[k];
+        triOffset[k] = numTriangles;
+        numTriangles += triCount[k];
+    }
+
+    vtkSmartPointer<vtkFloatArray> pointArray = vtkSmartPointer<vtkFloatArray>::New();
+    pointArray->SetNumberOfComponents( 3 );
+    pointArray->SetNumberOfTuples( numPoints );
+
+    vtkSmartPointer<vtkFloatArray> normalArray = vtkSmartPointer<vtkFloatArray>::New();
+    normalArray->SetName( "Normals" );
+    normalArray->SetNumberOfComponents( 3 );
+    normalArray->SetNumberOfTuples( numPoints );
+
+    vtkSmartPointer<vtkIdTypeArray> cellArray = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellArray->SetNumberOfValues( 4 * numTriangles );
+
+    // Pass 2: generate the cell layers [0, dims[2] - 1) in slabs
+    float* points = pointArray->GetPointer( 0 );
+    float* normals = normalArray->GetPointer( 0 );
+    vtkIdType* cells = cellArray->GetPointer( 0 );
+
+    parallelFor( 0, dims[2] - 1, [&]( std::size_t begin, std::size_t end )
+    {
+        extractor.generate( static_cast<int>( begin ), static_cast<int>( end ), xyOffset, zOffset, triOffset,
+                            points, normals, cells );
+    }, numThreads );
+
+    vtkSmartPointer<vtkPoints> outputPoints = vtkSmartPointer<vtkPoints>::New();
+    outputPoints->SetData( pointArray );
+
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+    polys->SetCells( numTriangles, cellArray );
+
+    vtkSmartPointer<vtkPolyData> surface = vtkSmartPointer<vtkPolyData>::New();
+    surface->SetPoints( outputPoints );
+    surface->SetPolys( polys );
+    surface->GetPointData()->SetNormals( normalArray );
+
+    return surface;
+}
+
+} // namespace
+
+vtkSmartPointer<vtkPolyData> extractBandSurface( vtkImageData* image, double lower, double upper,
+                                                 unsigned int numThreads )
+{
+    int* extent = image->GetExtent();
+    int dims[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+
+    if ( dims[0] < 2 || dims[1] < 2 || dims[2] < 2 || image->GetNumberOfScalarComponents() != 1 )
+    {
+        return vtkSmartPointer<vtkPolyData>::New();
+    }
+
+    // World position of the first voxel (the extent does not always start at 0)
+    double* spacing = image->GetSpacing();
+    double origin[3];
+    image->GetOrigin( origin );
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        origin[axis] += extent[2 * axis] * spacing[axis];
+    }
+
+    vtkSmartPointer<vtkPolyData> surface;
+    void* scalars = image->GetScalarPointer();
+
+    switch ( image->GetScalarType() )
+    {
+        vtkTemplateMacro( surface = runExtraction( static_cast<const VTK_TT*>( scalars ), dims, origin, spacing,
+                                                   lower, upper, numThreads ) );
+        default:
+            surface = vtkSmartPointer<vtkPolyData>::New();
+            break;
+    }
+
+    return surface;
+}
@@ -0,0 +1,42 @@
+/****************************************************************************
+*   bandIsosurface.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Fused threshold and isosurface extraction. Extracts the
+*                   boundary of an intensity band straight from the smoothed
+*                   volume, without building a binary mask first.
+****************************************************************************/
+
+#ifndef BANDISOSURFACE_H
+#define BANDISOSURFACE_H
+
+#include <vtkImageData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   Extract the surface that encloses all voxels with lower <= value <= upper.
+*
+*   The surface is the zero level of f = min( value - lower, upper - value ), which is
+*   positive inside the band and negative outside. Since f is interpolated from the
+*   smoothed intensities, the surface gets sub-voxel placement instead of the fixed
+*   half-voxel position of marching cubes on a 0/1 mask.
+*
+*   The volume is processed in z-slabs on all cores. Every edge crossing gets exactly
+*   one output point (no duplicates), points and triangles are written straight into
+*   their final position, and the output is the same for any number of threads.
+*   Point normals are computed from the gradient of the volume, like vtkMarchingCubes
+*   with ComputeNormalsOn().
+*
+*   @param   image        Single component volume of any scalar type
+*   @param   lower        Lower threshold (inclusive)
+*   @param   upper        Upper threshold (inclusive)
+*   @param   numThreads   Number of threads (0 = one per core)
+*
+*   @returns The extracted triangle surface with point normals
+*/
+vtkSmartPointer<vtkPolyData> extractBandSurface( vtkImageData* image, double lower, double upper,
+                                                 unsigned int numThreads = 0 );
+
+#endif // BANDISOSURFACE_H
@@ -0,0 +1,261 @@
+/****************************************************************************
+*   dicomSeriesLoader.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the parallel DICOM series loader.
+****************************************************************************/
+
+#include "dicomSeriesLoader.hxx"
+#include "helperFunctions.hxx"
+#include "parallelUtils.hxx"
+#include "volumeCache.hxx"
+
+#include <cmath>
+#include <cstring>
+
+#include <vtkDirectory.h>
+#include <vtkDICOMImageReader.h>
+#include <vtkPointData.h>
+#include <vtksys/SystemTools.hxx>
+
+// Name of the cache files written inside the DICOM directory
+static const char* VOLUME_CACHE_NAME = "volumeCache";
+
+DICOMSeriesLoader::DICOMSeriesLoader() :
+    _UseCache( true ), _NumThreads( 0 ), _LoadTime( 0.0 ), _LoadedFromCache( false )
+{
+}
+
+void DICOMSeriesLoader::setDirectoryName( const std::string& directory )
+{
+    _Directory = directory;
+
+    // Remove trailing slashes so that file paths can be joined with a single separator
+    while ( _Directory.size() > 1 && ( _Directory.back() == '/' || _Directory.back() == '\\' ) )
+    {
+        _Directory.pop_back();
+    }
+}
+
+void DICOMSeriesLoader::setUseCache( bool useCache )
+{
+    _UseCache = useCache;
+}
+
+void DICOMSeriesLoader::setNumberOfThreads( unsigned int numThreads )
+{
+    _NumThreads = numThreads;
+}
+
+bool DICOMSeriesLoader::load()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    _Output = nullptr;
+    _LoadedFromCache = false;
+
+    std::vector<std::string> files = listFiles();
+    if ( files.empty() )
+    {
+        std::cout << "ERROR: No files found in DICOM directory " << _Directory << "\n";
+        return false;
+    }
+
+    _Fingerprint = computeFingerprint( files );
+    std::string cachePath = _Directory + "/" + VOLUME_CACHE_NAME;
+
+    if ( _UseCache )
+    {
+        _Output = readVolumeCache( cachePath, _Fingerprint );
+        _LoadedFromCache = ( _Output != nullptr );
+    }
+
+    if ( _Output == nullptr )
+    {
+        _Output = readSeries( files );
+
+        if ( _Output != nullptr && _UseCache && !writeVolumeCache( cachePath, _Output, _Fingerprint ) )
+        {
+            std::cout << "WARNING: Could not write the volume cache to " << cachePath << "\n";
+        }
+    }
+
+    _LoadTime = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    return _Output != nullptr;
+}
+
+std::vector<std::string> DICOMSeriesLoader::listFiles() const
+{
+    std::vector<std::string> files;
+
+    vtkSmartPointer<vtkDirectory> directory = vtkSmartPointer<vtkDirectory>::New();
+    if ( !directory->Open( _Directory.c_str() ) )
+    {
+        return files;
+    }
+
+    for ( vtkIdType i = 0; i < directory->GetNumberOfFiles(); i++ )
+    {
+        std::string name = directory->GetFile( i );
+
+        // Skip ".", "..", hidden files, sub-directories and our own cache files
+        if ( name.empty() || name[0] == '.' || name.compare( 0, std::strlen( VOLUME_CACHE_NAME ), VOLUME_CACHE_NAME ) == 0 )
+        {
+            continue;
+        }
+
+        std::string path = _Directory + "/" + name;
+        if ( !vtksys::SystemTools::FileIsDirectory( path ) )
+        {
+            files.push_back( path );
+        }
+    }
+
+    std::sort( files.begin(), files.end() );
+    return files;
+}
+
+std::string DICOMSeriesLoader::computeFingerprint( const std::vector<std::string>& files ) const
+{
+    std::stringstream description;
+
+    for ( std::size_t i = 0; i < files.size(); i++ )
+    {
+        description << files[i] << ":" << vtksys::SystemTools::FileLength( files[i] )
+                    << ":" << vtksys::SystemTools::ModifiedTime( files[i] ) << ";";
+    }
+
+    return fingerprintString( description.str() );
+}
+
+vtkSmartPointer<vtkImageData> DICOMSeriesLoader::readSeries( const std::vector<std::string>& files ) const
+{
+    std::size_t numFiles = files.size();
+    std::vector< vtkSmartPointer<vtkDICOMImageReader> > readers( numFiles );
+    std::vector<char> isSlice( numFiles, 0 );
+
+    /*
+    *   Pass 1: read the header of every file in parallel.
+    *   Files that are not DICOM images (e.g. DICOMDIR, notes) are skipped.
+    */
+    parallelFor( 0, numFiles, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t i = begin; i < end; i++ )
+        {
+            vtkSmartPointer<vtkDICOMImageReader> reader = vtkSmartPointer<vtkDICOMImageReader>::New();
+
+            if ( reader->CanReadFile( files[i].c_str() ) )
+            {
+                reader->SetFileName( files[i].c_str() );
+                reader->UpdateInformation();
+                readers[i] = reader;
+                isSlice[i] = 1;
+            }
+        }
+    }, _NumThreads, 1 );
+
+    // Keep the slices only, in their position along the slice normal
+    std::vector< vtkSmartPointer<vtkDICOMImageReader> > slices;
+    for ( std::size_t i = 0; i < numFiles; i++ )
+    {
+        if ( isSlice[i] )
+        {
+            slices.push_back( readers[i] );
+        }
+    }
+    readers.clear();
+
+    if ( slices.empty() )
+    {
+        std::cout << "ERROR: No DICOM images found in " << _Directory << "\n";
+        return nullptr;
+    }
+
+    double normal[3] = { 0.0, 0.0, 1.0 };
+    float* orientation = slices[0]->GetImageOrientationPatient();
+    double row[3] = { orientation[0], orientation[1], orientation[2] };
+    double column[3] = { orientation[3], orientation[4], orientation[5] };
+    vtkMath::Cross( row, column, normal );
+
+    if ( vtkMath::Normalize( normal ) == 0.0 )
+    {
+        // No orientation in the header, assume axial slices
+        normal[0] = 0.0;
+        normal[1] = 0.0;
+        normal[2] = 1.0;
+    }
+
+    std::vector<double> location( slices.size() );
+    std::vector<std::size_t> order( slices.size() );
+
+    for ( std::size_t i = 0; i < slices.size(); i++ )
+    {
+        float* position = slices[i]->GetImagePositionPatient();
+        location[i] = position[0] * normal[0] + position[1] * normal[1] + position[2] * normal[2];
+        order[i] = i;
+    }
+
+    // stable_sort keeps the file name order for slices at the same location
+    std::stable_sort( order.begin(), order.end(), [&]( std::size_t a, std::size_t b )
+    {
+        return location[a] < location[b];
+    } );
+
+    vtkDICOMImageReader* first = slices[order[0]];
+    int width = first->GetWidth();
+    int height = first->GetHeight();
+    int scalarType = first->GetDataScalarType();
+    int components = first->GetNumberOfScalarComponents();
+
+    for ( std::size_t i = 0; i < slices.size(); i++ )
+    {
+        if ( slices[i]->GetWidth() != width || slices[i]->GetHeight() != height ||
+             slices[i]->GetDataScalarType() != scalarType || slices[i]->GetNumberOfScalarComponents() != components )
+        {
+            std::cout << "ERROR: The DICOM images in " << _Directory << " do not form a single series.\n";
+            return nullptr;
+        }
+    }
+
+    double spacing[3];
+    first->GetDataSpacing( spacing );
+
+    if ( slices.size() > 1 )
+    {
+        double sliceDistance = std::fabs( location[order[1]] - location[order[0]] );
+        if ( sliceDistance > 0.0 )
+        {
+            spacing[2] = sliceDistance;
+        }
+    }
+
+    // Preallocate the whole volume once, the slices are copied straight into it
+    vtkSmartPointer<vtkImageData> volume = vtkSmartPointer<vtkImageData>::New();
+    volume->SetDimensions( width, height, static_cast<int>( slices.size() ) );
+    volume->SetSpacing( spacing );
+    volume->SetOrigin( first->GetDataOrigin() );
+    volume->AllocateScalars( scalarType, components );
+
+    char* volumePointer = static_cast<char*>( volume->GetScalarPointer() );
+    std::size_t sliceBytes = static_cast<std::size_t>( width ) * height * components * volume->GetScalarSize();
+
+    /*
+    *   Pass 2: decode the pixel data of every slice in parallel.
+    *   Each reader is released as soon as its slice has been copied.
+    */
+    parallelFor( 0, slices.size(), [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t z = begin; z < end; z++ )
+        {
+            vtkSmartPointer<vtkDICOMImageReader>& reader = slices[order[z]];
+            reader->Update();
+
+            std::memcpy( volumePointer + z * sliceBytes, reader->GetOutput()->GetScalarPointer(), sliceBytes );
+            reader = nullptr;
+        }
+    }, _NumThreads, 1 );
+
+    return volume;
+}
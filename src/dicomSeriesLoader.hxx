@@ -0,0 +1,112 @@
+/****************************************************************************
+*   dicomSeriesLoader.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Parallel DICOM series loader with a memory mapped
+*                   volume cache.
+****************************************************************************/
+
+#ifndef DICOMSERIESLOADER_H
+#define DICOMSERIESLOADER_H
+
+#include <string>
+#include <vector>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   Loads a DICOM series from a directory.
+*
+*   Slices are decoded concurrently (one vtkDICOMImageReader per file) and copied
+*   straight into a single preallocated volume. After a successful load the volume
+*   is written next to the series as a raw file with a header sidecar
+*   (volumeCache.raw / volumeCache.vhdr). Later runs memory map that file instead
+*   of parsing the DICOM files again, as long as the series has not changed.
+*/
+class DICOMSeriesLoader
+{
+    public:
+        DICOMSeriesLoader();
+
+        /*
+        *   Set the directory containing the DICOM series.
+        *
+        *   @param   directory   Path to the DICOM directory
+        */
+        void setDirectoryName( const std::string& directory );
+
+        /*
+        *   Enable or disable the volume cache (enabled by default).
+        *
+        *   @param   useCache   TRUE to read and write the cache
+        */
+        void setUseCache( bool useCache );
+
+        /*
+        *   Set the number of threads used to decode slices.
+        *
+        *   @param   numThreads   Number of threads (0 = one per core)
+        */
+        void setNumberOfThreads( unsigned int numThreads );
+
+        /*
+        *   Load the series (from the cache if possible).
+        *
+        *   @returns TRUE if a volume was loaded, FALSE otherwise
+        */
+        bool load();
+
+        /*
+        *   @returns The loaded volume
+        */
+        vtkSmartPointer<vtkImageData> getOutput() const { return _Output; }
+
+        /*
+        *   Drop the loader's reference to the volume (and unmap the cache file once no one else holds it).
+        */
+        void release() { _Output = nullptr; }
+
+        /*
+        *   @returns The fingerprint of the series files (empty before load())
+        */
+        const std::string& getFingerprint() const { return _Fingerprint; }
+
+        /*
+        *   @returns The time taken by the last call to load(), in seconds
+        */
+        double getLoadTime() const { return _LoadTime; }
+
+        /*
+        *   @returns TRUE if the last call to load() used the volume cache
+        */
+        bool loadedFromCache() const { return _LoadedFromCache; }
+
+    private:
+        std::string  _Directory;
+        bool         _UseCache;
+        unsigned int _NumThreads;
+
+        vtkSmartPointer<vtkImageData> _Output;
+        std::string _Fingerprint;
+        double      _LoadTime;
+        bool        _LoadedFromCache;
+
+        /*
+        *   List the regular files in the DICOM directory, sorted by name.
+        */
+        std::vector<std::string> listFiles() const;
+
+        /*
+        *   Create a fingerprint from the name, size, and modification time of every file.
+        */
+        std::string computeFingerprint( const std::vector<std::string>& files ) const;
+
+        /*
+        *   Decode all DICOM files in parallel into a single volume.
+        */
+        vtkSmartPointer<vtkImageData> readSeries( const std::vector<std::string>& files ) const;
+};
+
+#endif // DICOMSERIESLOADER_H
@@ -0,0 +1,391 @@
+/****************************************************************************
+*   distanceField.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the signed distance field.
+****************************************************************************/
+
+#include "distanceField.hxx"
+#include "parallelUtils.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+namespace
+{
+
+const double INFINITE_DISTANCE = std::numeric_limits<double>::infinity();
+
+/*
+*   Segmented voxels of the part of the image that is kept.
+*/
+struct BandMask
+{
+    std::vector<unsigned char> inside;
+    int                        boxMin[3];
+    int                        dims[3];
+    double                     centroid[3];
+};
+
+/*
+*   Find the bounding box and centroid of the voxels within [lower, upper], grow the box
+*   by the margin and fill in the mask of the box.
+*/
+template <class T>
+bool createMask( const T* scalars, const int imageDims[3], const int margin[3], double lower, double upper,
+                 unsigned int numThreads, BandMask& mask )
+{
+    std::size_t sliceSize = static_cast<std::size_t>( imageDims[0] ) * imageDims[1];
+
+    int boxMin[3] = { imageDims[0], imageDims[1], imageDims[2] };
+    int boxMax[3] = { -1, -1, -1 };
+    double sum[3] = { 0.0, 0.0, 0.0 };
+    double count = 0.0;
+    std::mutex mutex;
+
+    parallelFor( 0, imageDims[2], [&]( std::size_t begin, std::size_t end )
+    {
+        int chunkMin[3] = { imageDims[0], imageDims[1], imageDims[2] };
+        int chunkMax[3] = { -1, -1, -1 };
+        double chunkSum[3] = { 0.0, 0.0, 0.0 };
+        double chunkCount = 0.0;
+
+        for ( std::size_t k = begin; k < end; k++ )
+        {
+            const T* voxel = scalars + k * sliceSize;
+            for ( int j = 0; j < imageDims[1]; j++ )
+            {
+                for ( int i = 0; i < imageDims[0]; i++, voxel++ )
+                {
+                    if ( *voxel < lower || *voxel > upper )
+                    {
+                        continue;
+                    }
+
+                    int index[3] = { i, j, static_cast<int>( k ) };
+                    for ( int axis = 0; axis < 3; axis++ )
+                    {
+                        chunkMin[axis] = std::min( chunkMin[axis], index[axis] );
+                        chunkMax[axis] = std::max( chunkMax[axis], index[axis] );
+                        chunkSum[axis] += index[axis];
+                    }
+                    chunkCount++;
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock( mutex );
+        for ( int axis = 0; axis < 3; axis++ )
+        {
+            boxMin[axis] = std::min( boxMin[axis], chunkMin[axis] );
+            boxMax[axis] = std::max( boxMax[axis], chunkMax[axis] );
+            sum[axis] += chunkSum[axis];
+        }
+        count += chunkCount;
+    }, numThreads );
+
+    if ( count == 0.0 )
+    {
+        return false;
+    }
+
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        mask.centroid[axis] = sum[axis] / count;
+        mask.boxMin[axis] = std::max( 0, boxMin[axis] - margin[axis] );
+        int last = std::min( imageDims[axis] - 1, boxMax[axis] + margin[axis] );
+        mask.dims[axis] = last - mask.boxMin[axis] + 1;
+    }
+
+    mask.inside.resize( static_cast<std::size_t>( mask.dims[0] ) * mask.dims[1] * mask.dims[2] );
+
+    parallelFor( 0, mask.dims[2], [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t k = begin; k < end; k++ )
+        {
+            unsigned char* out = &mask.inside[k * mask.dims[0] * mask.dims[1]];
+            for ( int j = 0; j < mask.dims[1]; j++ )
+            {
+                const T* voxel = scalars + ( k + mask.boxMin[2] ) * sliceSize +
+                                 static_cast<std::size_t>( j + mask.boxMin[1] ) * imageDims[0] + mask.boxMin[0];
+                for ( int i = 0; i < mask.dims[0]; i++ )
+                {
+                    *out++ = ( voxel[i] >= lower && voxel[i] <= upper );
+                }
+            }
+        }
+    }, numThreads );
+
+    return true;
+}
+
+/*
+*   1D squared distance transform of a sampled function (Felzenszwalb and Huttenlocher).
+*   Samples with an infinite value are not features.
+*
+*   @param   f         Input values
+*   @param   d         Output, d[q] = min over p of ( spacing * ( q - p ) )^2 + f[p]
+*   @param   n         Number of samples
+*   @param   spacing   Distance between samples
+*   @param   v         Scratch, n entries
+*   @param   z         Scratch, n + 1 entries
+*/
+void distanceTransform1D( const double* f, double* d, int n, double spacing, int* v, double* z )
+{
+    int k = -1;
+
+    for ( int q = 0; q < n; q++ )
+    {
+        if ( f[q] == INFINITE_DISTANCE )
+        {
+            continue;
+        }
+
+        // Drop the parabolas hidden by the one at q from the lower envelope
+        double xq = q * spacing;
+        double intersection = -INFINITE_DISTANCE;
+        while ( k >= 0 )
+        {
+            double xv = v[k] * spacing;
+            intersection = ( ( f[q] + xq * xq ) - ( f[v[k]] + xv * xv ) ) / ( 2.0 * ( xq - xv ) );
+            if ( k > 0 && intersection <= z[k] )
+            {
+                k--;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        k++;
+        v[k] = q;
+        z[k] = ( k == 0 ) ? -INFINITE_DISTANCE : intersection;
+        z[k + 1] = INFINITE_DISTANCE;
+    }
+
+    if ( k < 0 )
+    {
+        std::fill( d, d + n, INFINITE_DISTANCE );
+        return;
+    }
+
+    k = 0;
+    for ( int q = 0; q < n; q++ )
+    {
+        while ( z[k + 1] < q * spacing )
+        {
+            k++;
+        }
+
+        double offset = ( q - v[k] ) * spacing;
+        d[q] = offset * offset + f[v[k]];
+    }
+}
+
+/*
+*   Squared Euclidean distance of every voxel to the closest voxel with mask == feature.
+*   The three axes are transformed one after another, the lines of an axis in parallel.
+*/
+void squaredDistanceTransform( const std::vector<unsigned char>& mask, unsigned char feature, const int dims[3],
+                               const double spacing[3], unsigned int numThreads, std::vector<float>& distance )
+{
+    distance.resize( mask.size() );
+    for ( std::size_t n = 0; n < mask.size(); n++ )
+    {
+        distance[n] = ( mask[n] == feature ) ? 0.0f : std::numeric_limits<float>::infinity();
+    }
+
+    std::size_t stride[3] = { 1, static_cast<std::size_t>( dims[0] ), static_cast<std::size_t>( dims[0] ) * dims[1] };
+
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        // The other two axes enumerate the lines
+        int a = ( axis + 1 ) % 3, b = ( axis + 2 ) % 3;
+        std::size_t numLines = static_cast<std::size_t>( dims[a] ) * dims[b];
+        int n = dims[axis];
+
+        parallelFor( 0, numLines, [&]( std::size_t begin, std::size_t end )
+        {
+            std::vector<double> f( n ), d( n ), z( n + 1 );
+            std::vector<int> v( n );
+
+            for ( std::size_t line = begin; line < end; line++ )
+            {
+                float* start = &distance[( line % dims[a] ) * stride[a] + ( line / dims[a] ) * stride[b]];
+
+                for ( int q = 0; q < n; q++ )
+                {
+                    f[q] = start[q * stride[axis]];
+                }
+
+                distanceTransform1D( f.data(), d.data(), n, spacing[axis], v.data(), z.data() );
+
+                for ( int q = 0; q < n; q++ )
+                {
+                    start[q * stride[axis]] = static_cast<float>( d[q] );
+                }
+            }
+        }, numThreads );
+    }
+}
+
+} // namespace
+
+DistanceField::DistanceField()
+{
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        _Dims[axis] = 0;
+        _Origin[axis] = 0.0;
+        _Spacing[axis] = 1.0;
+        _Centroid[axis] = 0.0;
+    }
+}
+
+bool DistanceField::build( vtkImageData* image, double lower, double upper, double margin, unsigned int numThreads )
+{
+    _Distance.clear();
+
+    int* extent = image->GetExtent();
+    int imageDims[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+    double* spacing = image->GetSpacing();
+    double* origin = image->GetOrigin();
+
+    if ( image->GetNumberOfScalarComponents() != 1 )
+    {
+        return false;
+    }
+
+    int marginVoxels[3];
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        marginVoxels[axis] = static_cast<int>( std::ceil( margin / spacing[axis] ) );
+    }
+
+    BandMask mask;
+    bool segmented = false;
+    void* scalars = image->GetScalarPointer();
+
+    switch ( image->GetScalarType() )
+    {
+        vtkTemplateMacro( segmented = createMask( static_cast<const VTK_TT*>( scalars ), imageDims, marginVoxels,
+                                                  lower, upper, numThreads, mask ) );
+        default:
+            break;
+    }
+
+    // Trilinear lookups need at least two voxels along every axis
+    if ( !segmented || mask.dims[0] < 2 || mask.dims[1] < 2 || mask.dims[2] < 2 )
+    {
+        return false;
+    }
+
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        _Dims[axis] = mask.dims[axis];
+        _Spacing[axis] = spacing[axis];
+        _Origin[axis] = origin[axis] + ( extent[2 * axis] + mask.boxMin[axis] ) * spacing[axis];
+        _Centroid[axis] = origin[axis] + ( extent[2 * axis] + mask.centroid[axis] ) * spacing[axis];
+    }
+
+    // Distance to the segmented voxels (outside) and to the background (inside)
+    std::vector<float> outsideDistance;
+    squaredDistanceTransform( mask.inside, 1, _Dims, _Spacing, numThreads, outsideDistance );
+    squaredDistanceTransform( mask.inside, 0, _Dims, _Spacing, numThreads, _Distance );
+
+    // A box without background voxels (the segmentation touches every image border) is clamped to its diagonal
+    float farthest = static_cast<float>( std::sqrt( _Dims[0] * _Spacing[0] * _Dims[0] * _Spacing[0] +
+                                                    _Dims[1] * _Spacing[1] * _Dims[1] * _Spacing[1] +
+                                                    _Dims[2] * _Spacing[2] * _Dims[2] * _Spacing[2] ) );
+
+    parallelFor( 0, _Distance.size(), [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t n = begin; n < end; n++ )
+        {
+            float inside = std::min( std::sqrt( _Distance[n] ), farthest );
+            _Distance[n] = std::sqrt( outsideDistance[n] ) - inside;
+        }
+    }, numThreads );
+
+    return true;
+}
+
+double DistanceField::evaluate( const double position[3], double gradient[3] ) const
+{
+    if ( _Distance.empty() )
+    {
+        if ( gradient != nullptr )
+        {
+            gradient[0] = gradient[1] = gradient[2] = 0.0;
+        }
+        return 0.0;
+    }
+
+    // Cell and position within the cell, clamped to the stored box
+    int cell[3];
+    double t[3];
+    double outside = 0.0;
+    double outsideDirection[3] = { 0.0, 0.0, 0.0 };
+
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        double index = ( position[axis] - _Origin[axis] ) / _Spacing[axis];
+        double clamped = std::min( std::max( index, 0.0 ), _Dims[axis] - 1.0 );
+
+        // Beyond the box the distance grows with the distance to the box
+        double overshoot = ( index - clamped ) * _Spacing[axis];
+        outside += overshoot * overshoot;
+        outsideDirection[axis] = overshoot;
+
+        cell[axis] = std::min( static_cast<int>( clamped ), _Dims[axis] - 2 );
+        t[axis] = clamped - cell[axis];
+    }
+
+    std::size_t sliceSize = static_cast<std::size_t>( _Dims[0] ) * _Dims[1];
+    const float* c = &_Distance[cell[2] * sliceSize + static_cast<std::size_t>( cell[1] ) * _Dims[0] + cell[0]];
+
+    double c000 = c[0], c100 = c[1];
+    double c010 = c[_Dims[0]], c110 = c[_Dims[0] + 1];
+    double c001 = c[sliceSize], c101 = c[sliceSize + 1];
+    double c011 = c[sliceSize + _Dims[0]], c111 = c[sliceSize + _Dims[0] + 1];
+
+    double tx = t[0], ty = t[1], tz = t[2];
+
+    // Interpolate along x, then y, then z
+    double c00 = c000 + tx * ( c100 - c000 ), c10 = c010 + tx * ( c110 - c010 );
+    double c01 = c001 + tx * ( c101 - c001 ), c11 = c011 + tx * ( c111 - c011 );
+    double c0 = c00 + ty * ( c10 - c00 ), c1 = c01 + ty * ( c11 - c01 );
+    double value = c0 + tz * ( c1 - c0 );
+
+    if ( gradient != nullptr )
+    {
+        double dx0 = ( 1.0 - ty ) * ( c100 - c000 ) + ty * ( c110 - c010 );
+        double dx1 = ( 1.0 - ty ) * ( c101 - c001 ) + ty * ( c111 - c011 );
+        gradient[0] = ( ( 1.0 - tz ) * dx0 + tz * dx1 ) / _Spacing[0];
+        gradient[1] = ( ( 1.0 - tz ) * ( c10 - c00 ) + tz * ( c11 - c01 ) ) / _Spacing[1];
+        gradient[2] = ( c1 - c0 ) / _Spacing[2];
+    }
+
+    if ( outside > 0.0 )
+    {
+        outside = std::sqrt( outside );
+        value += outside;
+
+        if ( gradient != nullptr )
+        {
+            for ( int axis = 0; axis < 3; axis++ )
+            {
+                if ( outsideDirection[axis] != 0.0 )
+                {
+                    gradient[axis] = outsideDirection[axis] / outside;
+                }
+            }
+        }
+    }
+
+    return value;
+}
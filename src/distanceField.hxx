@@ -0,0 +1,74 @@
+/****************************************************************************
+*   distanceField.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Signed Euclidean distance field of a thresholded volume.
+****************************************************************************/
+
+#ifndef DISTANCEFIELD_H
+#define DISTANCEFIELD_H
+
+#include <cstddef>
+#include <vector>
+
+#include <vtkImageData.h>
+
+/*
+*   Signed distance to the boundary of the voxels within a threshold band, negative
+*   inside the band and positive outside. The zero level lies halfway between inside
+*   and outside voxels, where marching cubes on the binary mask puts the surface.
+*
+*   The field is computed with the exact, linear time distance transform of
+*   Felzenszwalb and Huttenlocher, one axis at a time, with the lines of every axis
+*   processed in parallel. Only the bounding box of the segmented voxels plus a margin
+*   is stored. Lookups are trilinear and also return the gradient of the interpolated
+*   field; outside the stored box the distance keeps growing linearly.
+*/
+class DistanceField
+{
+    public:
+        DistanceField();
+
+        /*
+        *   Compute the field.
+        *
+        *   @param   image        Single component volume of any scalar type
+        *   @param   lower        Lower threshold (inclusive)
+        *   @param   upper        Upper threshold (inclusive)
+        *   @param   margin       Distance kept around the segmented voxels (world units)
+        *   @param   numThreads   Number of threads (0 = one per core)
+        *
+        *   @returns TRUE if the field was computed, FALSE if no voxel is within the thresholds
+        */
+        bool build( vtkImageData* image, double lower, double upper, double margin, unsigned int numThreads = 0 );
+
+        /*
+        *   Look up the signed distance at a position. Safe to call from many threads at once.
+        *
+        *   @param   position   World position
+        *   @param   gradient   Set to the gradient of the distance (may be nullptr)
+        *
+        *   @returns The signed distance to the segmented surface
+        */
+        double evaluate( const double position[3], double gradient[3] ) const;
+
+        /*
+        *   @returns The centroid of the segmented voxels
+        */
+        const double* getCentroid() const { return _Centroid; }
+
+        /*
+        *   @returns The number of stored voxels
+        */
+        std::size_t getNumberOfVoxels() const { return _Distance.size(); }
+
+    private:
+        std::vector<float> _Distance;
+        int                _Dims[3];
+        double             _Origin[3];      // World position of the first stored voxel
+        double             _Spacing[3];
+        double             _Centroid[3];
+};
+
+#endif // DISTANCEFIELD_H
@@ -0,0 +1,354 @@
+/****************************************************************************
+*   distanceRegistration.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the distance field registration.
+****************************************************************************/
+
+#include "distanceRegistration.hxx"
+#include "parallelUtils.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+
+/*
+*   Rigid pose, x' = R x + t.
+*/
+struct Pose
+{
+    double rotation[3][3];
+    double translation[3];
+};
+
+/*
+*   Distances and gradients of the moved points for one pose.
+*/
+struct PoseEvaluation
+{
+    std::vector<double>      moved;
+    std::vector<double>      residual;
+    std::vector<double>      gradient;
+    std::vector<std::size_t> order;         // The first numKept entries are the points used
+    double                   cost;          // Sum of the squared distances of the used points
+    double                   meanDistance;  // Mean absolute distance of the used points
+};
+
+void evaluatePose( const DistanceField& field, const std::vector<double>& points, const Pose& pose,
+                   std::size_t numKept, unsigned int numThreads, PoseEvaluation& evaluation )
+{
+    std::size_t numPoints = points.size() / 3;
+    evaluation.moved.resize( 3 * numPoints );
+    evaluation.residual.resize( numPoints );
+    evaluation.gradient.resize( 3 * numPoints );
+    evaluation.order.resize( numPoints );
+
+    parallelFor( 0, numPoints, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t i = begin; i < end; i++ )
+        {
+            const double* p = &points[3 * i];
+            double* moved = &evaluation.moved[3 * i];
+            for ( int r = 0; r < 3; r++ )
+            {
+                moved[r] = pose.rotation[r][0] * p[0] + pose.rotation[r][1] * p[1] + pose.rotation[r][2] * p[2] + pose.translation[r];
+            }
+
+            evaluation.residual[i] = field.evaluate( moved, &evaluation.gradient[3 * i] );
+            evaluation.order[i] = i;
+        }
+    }, numThreads );
+
+    // Use the points closest to the surface
+    if ( numKept < numPoints )
+    {
+        const std::vector<double>& residual = evaluation.residual;
+        std::nth_element( evaluation.order.begin(), evaluation.order.begin() + numKept, evaluation.order.end(),
+                          [&residual]( std::size_t a, std::size_t b ) { return std::fabs( residual[a] ) < std::fabs( residual[b] ); } );
+    }
+
+    evaluation.cost = 0.0;
+    evaluation.meanDistance = 0.0;
+    for ( std::size_t n = 0; n < numKept; n++ )
+    {
+        double r = evaluation.residual[evaluation.order[n]];
+        evaluation.cost += r * r;
+        evaluation.meanDistance += std::fabs( r );
+    }
+    evaluation.meanDistance /= numKept;
+}
+
+/*
+*   Rotation matrix of a rotation vector (axis times angle).
+*/
+void rotationFromVector( const double w[3], double rotation[3][3] )
+{
+    double angle = std::sqrt( w[0] * w[0] + w[1] * w[1] + w[2] * w[2] );
+    double k[3] = { 0.0, 0.0, 0.0 };
+    if ( angle > 0.0 )
+    {
+        k[0] = w[0] / angle;
+        k[1] = w[1] / angle;
+        k[2] = w[2] / angle;
+    }
+
+    double s = std::sin( angle ), c = 1.0 - std::cos( angle );
+    double cross[3][3] = { { 0.0, -k[2], k[1] }, { k[2], 0.0, -k[0] }, { -k[1], k[0], 0.0 } };
+
+    for ( int r = 0; r < 3; r++ )
+    {
+        for ( int col = 0; col < 3; col++ )
+        {
+            double square = 0.0;
+            for ( int m = 0; m < 3; m++ )
+            {
+                square += cross[r][m] * cross[m][col];
+            }
+            rotation[r][col] = ( r == col ? 1.0 : 0.0 ) + s * cross[r][col] + c * square;
+        }
+    }
+}
+
+/*
+*   Solve a 6x6 linear system with Gaussian elimination and partial pivoting.
+*
+*   @returns FALSE if the system is singular
+*/
+bool solve6( double a[6][6], double b[6], double x[6] )
+{
+    for ( int column = 0; column < 6; column++ )
+    {
+        int pivot = column;
+        for ( int row = column + 1; row < 6; row++ )
+        {
+            if ( std::fabs( a[row][column] ) > std::fabs( a[pivot][column] ) )
+            {
+                pivot = row;
+            }
+        }
+
+        if ( std::fabs( a[pivot][column] ) < 1e-12 )
+        {
+            return false;
+        }
+
+        if ( pivot != column )
+        {
+            std::swap_ranges( a[pivot], a[pivot] + 6, a[column] );
+            std::swap( b[pivot], b[column] );
+        }
+
+        for ( int row = column + 1; row < 6; row++ )
+        {
+            double factor = a[row][column] / a[column][column];
+            for ( int m = column; m < 6; m++ )
+            {
+                a[row][m] -= factor * a[column][m];
+            }
+            b[row] -= factor * b[column];
+        }
+    }
+
+    for ( int row = 5; row >= 0; row-- )
+    {
+        double sum = b[row];
+        for ( int m = row + 1; m < 6; m++ )
+        {
+            sum -= a[row][m] * x[m];
+        }
+        x[row] = sum / a[row][row];
+    }
+
+    return true;
+}
+
+} // namespace
+
+DistanceFieldRegistration::DistanceFieldRegistration() :
+    _Field( nullptr ), _Matrix( vtkSmartPointer<vtkMatrix4x4>::New() ),
+    _NumIterations( 0 ), _MeanDistance( 0.0 ), _Converged( false ), _Stalled( false )
+{
+}
+
+bool DistanceFieldRegistration::update()
+{
+    _NumIterations = 0;
+    _MeanDistance = 0.0;
+    _Converged = false;
+    _Stalled = false;
+    _Matrix->Identity();
+
+    if ( _Source == nullptr || _Source->GetNumberOfPoints() == 0 || _Field == nullptr || _Field->getNumberOfVoxels() == 0 )
+    {
+        return false;
+    }
+
+    std::size_t numPoints = static_cast<std::size_t>( _Source->GetNumberOfPoints() );
+    std::vector<double> points( 3 * numPoints );
+    double centroid[3] = { 0.0, 0.0, 0.0 };
+
+    for ( std::size_t i = 0; i < numPoints; i++ )
+    {
+        _Source->GetPoint( static_cast<vtkIdType>( i ), &points[3 * i] );
+        centroid[0] += points[3 * i];
+        centroid[1] += points[3 * i + 1];
+        centroid[2] += points[3 * i + 2];
+    }
+
+    Pose pose;
+    for ( int r = 0; r < 3; r++ )
+    {
+        for ( int c = 0; c < 3; c++ )
+        {
+            pose.rotation[r][c] = ( _InitialMatrix != nullptr ) ? _InitialMatrix->GetElement( r, c ) : ( r == c ? 1.0 : 0.0 );
+        }
+
+        if ( _InitialMatrix != nullptr )
+        {
+            pose.translation[r] = _InitialMatrix->GetElement( r, 3 );
+        }
+        else
+        {
+            pose.translation[r] = _Settings.matchCentroids ? _Field->getCentroid()[r] - centroid[r] / numPoints : 0.0;
+        }
+    }
+
+    // A rigid fit has 6 degrees of freedom
+    double trim = std::min( 1.0, std::max( 0.0, _Settings.trimFraction ) );
+    std::size_t numKept = static_cast<std::size_t>( trim * numPoints + 0.5 );
+    numKept = std::min( numPoints, std::max( numKept, static_cast<std::size_t>( 6 ) ) );
+
+    PoseEvaluation current, candidate;
+    evaluatePose( *_Field, points, pose, numKept, _Settings.numThreads, current );
+    _MeanDistance = current.meanDistance;
+
+    double lambda = 1e-3;
+
+    // Only accepted steps count as iterations. Rejected steps raise lambda until a step is
+    // accepted or the solve stalls, so the loop ends.
+    while ( _NumIterations < _Settings.maxIterations )
+    {
+        // Linearise around the centre of the used points, a rotation about it barely moves them as a whole
+        double centre[3] = { 0.0, 0.0, 0.0 };
+        for ( std::size_t n = 0; n < numKept; n++ )
+        {
+            const double* m = &current.moved[3 * current.order[n]];
+            centre[0] += m[0];
+            centre[1] += m[1];
+            centre[2] += m[2];
+        }
+        for ( int c = 0; c < 3; c++ )
+        {
+            centre[c] /= numKept;
+        }
+
+        // Normal equations, the Jacobian row of a point is [ (m - centre) x gradient, gradient ]
+        double hessian[6][6] = { { 0.0 } };
+        double rhs[6] = { 0.0 };
+
+        for ( std::size_t n = 0; n < numKept; n++ )
+        {
+            std::size_t i = current.order[n];
+            const double* m = &current.moved[3 * i];
+            const double* g = &current.gradient[3 * i];
+            double arm[3] = { m[0] - centre[0], m[1] - centre[1], m[2] - centre[2] };
+
+            double jacobian[6] = { arm[1] * g[2] - arm[2] * g[1], arm[2] * g[0] - arm[0] * g[2], arm[0] * g[1] - arm[1] * g[0],
+                                   g[0], g[1], g[2] };
+
+            for ( int r = 0; r < 6; r++ )
+            {
+                for ( int c = 0; c < 6; c++ )
+                {
+                    hessian[r][c] += jacobian[r] * jacobian[c];
+                }
+                rhs[r] -= jacobian[r] * current.residual[i];
+            }
+        }
+
+        for ( int r = 0; r < 6; r++ )
+        {
+            hessian[r][r] *= 1.0 + lambda;
+        }
+
+        double step[6];
+        if ( !solve6( hessian, rhs, step ) )
+        {
+            break;
+        }
+
+        // Rotate by the step about the centre, then translate
+        double increment[3][3];
+        rotationFromVector( step, increment );
+
+        Pose next;
+        for ( int r = 0; r < 3; r++ )
+        {
+            for ( int c = 0; c < 3; c++ )
+            {
+                next.rotation[r][c] = increment[r][0] * pose.rotation[0][c] + increment[r][1] * pose.rotation[1][c] +
+                                      increment[r][2] * pose.rotation[2][c];
+            }
+
+            next.translation[r] = centre[r] + step[3 + r];
+            for ( int c = 0; c < 3; c++ )
+            {
+                next.translation[r] += increment[r][c] * ( pose.translation[c] - centre[c] );
+            }
+        }
+
+        evaluatePose( *_Field, points, next, numKept, _Settings.numThreads, candidate );
+
+        if ( candidate.cost >= current.cost )
+        {
+            // Rejected, fall back towards gradient descent with a shorter step
+            lambda *= 10.0;
+            if ( lambda > 1e8 )
+            {
+                _Stalled = true;
+                break;
+            }
+            continue;
+        }
+
+        double motion = 0.0;
+        for ( std::size_t i = 0; i < numPoints; i++ )
+        {
+            const double* a = &current.moved[3 * i];
+            const double* b = &candidate.moved[3 * i];
+            motion += std::sqrt( ( b[0] - a[0] ) * ( b[0] - a[0] ) + ( b[1] - a[1] ) * ( b[1] - a[1] ) + ( b[2] - a[2] ) * ( b[2] - a[2] ) );
+        }
+
+        pose = next;
+        std::swap( current, candidate );
+        lambda = std::max( lambda * 0.3, 1e-7 );
+        _NumIterations++;
+
+        _MeanDistance = current.meanDistance;
+        if ( _IterationCallback )
+        {
+            _IterationCallback( _NumIterations - 1, _MeanDistance );
+        }
+
+        if ( motion / numPoints < _Settings.tolerance )
+        {
+            _Converged = true;
+            break;
+        }
+    }
+
+    for ( int r = 0; r < 3; r++ )
+    {
+        for ( int c = 0; c < 3; c++ )
+        {
+            _Matrix->SetElement( r, c, pose.rotation[r][c] );
+        }
+        _Matrix->SetElement( r, 3, pose.translation[r] );
+    }
+
+    return true;
+}
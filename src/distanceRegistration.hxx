@@ -0,0 +1,119 @@
+/****************************************************************************
+*   distanceRegistration.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Rigid registration of a surface to a distance field.
+****************************************************************************/
+
+#ifndef DISTANCEREGISTRATION_H
+#define DISTANCEREGISTRATION_H
+
+#include "distanceField.hxx"
+
+#include <functional>
+
+#include <vtkMatrix4x4.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   Parameters of the distance field registration.
+*/
+struct DistanceRegistrationSettings
+{
+    int          maxIterations;     // Upper limit on the number of iterations
+    double       tolerance;         // Stop when the mean point motion of an iteration drops below this (world units)
+    double       trimFraction;      // Fraction of points with the smallest distance used in every iteration (1 = all)
+    bool         matchCentroids;    // Start by moving the source centroid onto the centroid of the segmented voxels (without an initial matrix)
+    unsigned int numThreads;        // 0 = one per core
+
+    DistanceRegistrationSettings() :
+        maxIterations( 75 ), tolerance( 1e-4 ), trimFraction( 0.9 ), matchCentroids( true ), numThreads( 0 ) { }
+};
+
+/*
+*   Finds the rigid transformation that moves the source points onto the zero level
+*   of a distance field, by minimising the sum of the squared distances with
+*   Levenberg-Marquardt. Every iteration is one parallel pass of trilinear lookups
+*   over the points; no surface of the target and no closest point search is needed.
+*/
+class DistanceFieldRegistration
+{
+    public:
+        DistanceFieldRegistration();
+
+        /*
+        *   Set the surface that is moved (the OBJ surface).
+        */
+        void setSource( vtkPolyData* source ) { _Source = source; }
+
+        /*
+        *   Set the distance field of the target. The field must outlive update().
+        */
+        void setField( const DistanceField* field ) { _Field = field; }
+
+        /*
+        *   Start from a known pose instead of matching the centroids.
+        *
+        *   @param   matrix   Initial rigid transformation from the source to the field space (nullptr = none)
+        */
+        void setInitialMatrix( vtkMatrix4x4* matrix ) { _InitialMatrix = matrix; }
+
+        void setSettings( const DistanceRegistrationSettings& settings ) { _Settings = settings; }
+
+        /*
+        *   Set the function called after every iteration.
+        *
+        *   @param   callback   Called as callback( iteration, meanDistance )
+        */
+        void setIterationCallback( const std::function<void( int, double )>& callback ) { _IterationCallback = callback; }
+
+        /*
+        *   Run the registration.
+        *
+        *   @returns TRUE if a transformation was found, FALSE if an input is missing or empty
+        */
+        bool update();
+
+        /*
+        *   @returns The transformation from the source space to the space of the field
+        */
+        vtkMatrix4x4* getMatrix() const { return _Matrix; }
+
+        /*
+        *   @returns The number of accepted steps, rejected trial steps are not counted
+        */
+        int getNumberOfIterations() const { return _NumIterations; }
+
+        /*
+        *   @returns The mean absolute distance of the used points after the last iteration
+        */
+        double getMeanDistance() const { return _MeanDistance; }
+
+        /*
+        *   @returns TRUE if the points moved less than the tolerance in the last step
+        */
+        bool hasConverged() const { return _Converged; }
+
+        /*
+        *   @returns TRUE if no step lowered the cost any more before the tolerance was reached
+        */
+        bool hasStalled() const { return _Stalled; }
+
+    private:
+        vtkSmartPointer<vtkPolyData>  _Source;
+        const DistanceField*          _Field;
+        vtkSmartPointer<vtkMatrix4x4> _Matrix;
+        vtkSmartPointer<vtkMatrix4x4> _InitialMatrix;
+        DistanceRegistrationSettings  _Settings;
+
+        std::function<void( int, double )> _IterationCallback;
+
+        int    _NumIterations;
+        double _MeanDistance;
+        bool   _Converged;
+        bool   _Stalled;
+};
+
+#endif // DISTANCEREGISTRATION_H
@@ -0,0 +1,336 @@
+/****************************************************************************
+*   fastICP.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the fast ICP engine.
+****************************************************************************/
+
+#include "fastICP.hxx"
+#include "parallelUtils.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#include <vtkDataArray.h>
+#include <vtkLandmarkTransform.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyDataNormals.h>
+#include <vtkTransform.h>
+
+// Normal-space sampling: the directions are split into a grid of bins on each of the 6 faces of a cube
+static const int NORMAL_BINS_PER_SIDE = 4;
+
+FastICP::FastICP() :
+    _Matrix( vtkSmartPointer<vtkMatrix4x4>::New() ), _SharedTree( nullptr ), _NumIterations( 0 ), _MeanDistance( 0.0 ), _Converged( false )
+{
+}
+
+/*
+*   Bin of a normal direction, see NORMAL_BINS_PER_SIDE.
+*/
+static int normalBin( const double normal[3] )
+{
+    int axis = 0;
+    if ( std::fabs( normal[1] ) > std::fabs( normal[axis] ) ) axis = 1;
+    if ( std::fabs( normal[2] ) > std::fabs( normal[axis] ) ) axis = 2;
+
+    double length = std::fabs( normal[axis] );
+    if ( length == 0.0 )
+    {
+        return 0;
+    }
+
+    // Position on the cube face, each coordinate in [-1, 1]
+    int face = 2 * axis + ( normal[axis] < 0.0 ? 1 : 0 );
+    double u = normal[( axis + 1 ) % 3] / length;
+    double v = normal[( axis + 2 ) % 3] / length;
+
+    int iu = std::min( NORMAL_BINS_PER_SIDE - 1, static_cast<int>( ( u + 1.0 ) * 0.5 * NORMAL_BINS_PER_SIDE ) );
+    int iv = std::min( NORMAL_BINS_PER_SIDE - 1, static_cast<int>( ( v + 1.0 ) * 0.5 * NORMAL_BINS_PER_SIDE ) );
+
+    return ( face * NORMAL_BINS_PER_SIDE + iu ) * NORMAL_BINS_PER_SIDE + iv;
+}
+
+std::vector<double> FastICP::sampleSource() const
+{
+    vtkIdType numPoints = _Source->GetNumberOfPoints();
+    std::vector<vtkIdType> ids;
+
+    if ( _Settings.sampling == ICP_SAMPLE_ALL || _Settings.numSamples <= 0 || _Settings.numSamples >= numPoints )
+    {
+        ids.resize( numPoints );
+        for ( vtkIdType i = 0; i < numPoints; i++ )
+        {
+            ids[i] = i;
+        }
+    }
+    else if ( _Settings.sampling == ICP_SAMPLE_RANDOM )
+    {
+        std::vector<vtkIdType> all( numPoints );
+        for ( vtkIdType i = 0; i < numPoints; i++ )
+        {
+            all[i] = i;
+        }
+
+        // Partial Fisher-Yates shuffle, the first numSamples entries are the sample
+        std::mt19937 random( _Settings.seed );
+        for ( int i = 0; i < _Settings.numSamples; i++ )
+        {
+            std::uniform_int_distribution<vtkIdType> pick( i, numPoints - 1 );
+            std::swap( all[i], all[pick( random )] );
+        }
+
+        ids.assign( all.begin(), all.begin() + _Settings.numSamples );
+    }
+    else
+    {
+        // Use the normals of the OBJ file when it has them
+        vtkSmartPointer<vtkDataArray> normals = _Source->GetPointData()->GetNormals();
+        if ( normals == nullptr )
+        {
+            vtkSmartPointer<vtkPolyDataNormals> normalFilter = vtkSmartPointer<vtkPolyDataNormals>::New();
+            normalFilter->SetInputData( _Source );
+            normalFilter->ComputePointNormalsOn();
+            normalFilter->SplittingOff();
+            normalFilter->Update();
+            normals = normalFilter->GetOutput()->GetPointData()->GetNormals();
+        }
+
+        std::vector< std::vector<vtkIdType> > bins( 6 * NORMAL_BINS_PER_SIDE * NORMAL_BINS_PER_SIDE );
+        double normal[3];
+        for ( vtkIdType i = 0; i < numPoints; i++ )
+        {
+            normals->GetTuple( i, normal );
+            bins[normalBin( normal )].push_back( i );
+        }
+
+        std::mt19937 random( _Settings.seed );
+        for ( std::size_t b = 0; b < bins.size(); b++ )
+        {
+            std::shuffle( bins[b].begin(), bins[b].end(), random );
+        }
+
+        // Take one point from every bin in turn, so rare directions are as well represented as common ones
+        for ( std::size_t round = 0; static_cast<int>( ids.size() ) < _Settings.numSamples; round++ )
+        {
+            for ( std::size_t b = 0; b < bins.size() && static_cast<int>( ids.size() ) < _Settings.numSamples; b++ )
+            {
+                if ( round < bins[b].size() )
+                {
+                    ids.push_back( bins[b][round] );
+                }
+            }
+        }
+    }
+
+    std::vector<double> samples( 3 * ids.size() );
+    for ( std::size_t i = 0; i < ids.size(); i++ )
+    {
+        _Source->GetPoint( ids[i], &samples[3 * i] );
+    }
+
+    return samples;
+}
+
+/*
+*   Mean of all points of a data set.
+*/
+static void computeCentroid( vtkPolyData* polyData, double centroid[3] )
+{
+    centroid[0] = centroid[1] = centroid[2] = 0.0;
+
+    double p[3];
+    for ( vtkIdType i = 0; i < polyData->GetNumberOfPoints(); i++ )
+    {
+        polyData->GetPoint( i, p );
+        centroid[0] += p[0];
+        centroid[1] += p[1];
+        centroid[2] += p[2];
+    }
+
+    for ( int c = 0; c < 3; c++ )
+    {
+        centroid[c] /= polyData->GetNumberOfPoints();
+    }
+}
+
+bool FastICP::update()
+{
+    _NumIterations = 0;
+    _MeanDistance = 0.0;
+    _Converged = false;
+    _Matrix->Identity();
+
+    if ( _Source == nullptr || _Source->GetNumberOfPoints() == 0 || _Target == nullptr || _Target->GetNumberOfPoints() == 0 )
+    {
+        return false;
+    }
+
+    if ( _SharedTree == nullptr )
+    {
+        _Tree.build( _Target->GetPoints() );
+    }
+    const PointKdTree& tree = ( _SharedTree != nullptr ) ? *_SharedTree : _Tree;
+
+    std::vector<double> samples = sampleSource();
+    std::size_t numSamples = samples.size() / 3;
+
+    vtkSmartPointer<vtkTransform> accumulate = vtkSmartPointer<vtkTransform>::New();
+    accumulate->PostMultiply();
+
+    if ( _InitialMatrix != nullptr )
+    {
+        accumulate->Concatenate( _InitialMatrix );
+
+        for ( std::size_t i = 0; i < numSamples; i++ )
+        {
+            double p[4] = { samples[3 * i], samples[3 * i + 1], samples[3 * i + 2], 1.0 };
+            double moved[4];
+            _InitialMatrix->MultiplyPoint( p, moved );
+            std::copy( moved, moved + 3, &samples[3 * i] );
+        }
+    }
+    else if ( _Settings.matchCentroids )
+    {
+        double sourceCentroid[3], targetCentroid[3];
+        computeCentroid( _Source, sourceCentroid );
+        computeCentroid( _Target, targetCentroid );
+
+        double delta[3] = { targetCentroid[0] - sourceCentroid[0],
+                            targetCentroid[1] - sourceCentroid[1],
+                            targetCentroid[2] - sourceCentroid[2] };
+        accumulate->Translate( delta );
+
+        for ( std::size_t i = 0; i < numSamples; i++ )
+        {
+            samples[3 * i] += delta[0];
+            samples[3 * i + 1] += delta[1];
+            samples[3 * i + 2] += delta[2];
+        }
+    }
+
+    // Number of pairs used for the fit, a rigid fit needs at least 3
+    double trim = std::min( 1.0, std::max( 0.0, _Settings.trimFraction ) );
+    std::size_t numKept = static_cast<std::size_t>( trim * numSamples + 0.5 );
+    numKept = std::min( numSamples, std::max( numKept, static_cast<std::size_t>( 3 ) ) );
+
+    std::vector<double> closest( 3 * numSamples );
+    std::vector<double> distance2( numSamples );
+    std::vector<std::size_t> order( numSamples );
+
+    vtkSmartPointer<vtkPoints> sourceLandmarks = vtkSmartPointer<vtkPoints>::New();
+    sourceLandmarks->SetDataTypeToDouble();
+    sourceLandmarks->SetNumberOfPoints( numKept );
+
+    vtkSmartPointer<vtkPoints> targetLandmarks = vtkSmartPointer<vtkPoints>::New();
+    targetLandmarks->SetDataTypeToDouble();
+    targetLandmarks->SetNumberOfPoints( numKept );
+
+    vtkSmartPointer<vtkLandmarkTransform> landmarkTransform = vtkSmartPointer<vtkLandmarkTransform>::New();
+    landmarkTransform->SetModeToRigidBody();
+    landmarkTransform->SetSourceLandmarks( sourceLandmarks );
+    landmarkTransform->SetTargetLandmarks( targetLandmarks );
+
+    while ( _NumIterations < _Settings.maxIterations )
+    {
+        // Closest target point of every sample
+        parallelFor( 0, numSamples, [&]( std::size_t begin, std::size_t end )
+        {
+            for ( std::size_t i = begin; i < end; i++ )
+            {
+                const double* p = &samples[3 * i];
+                double* q = &closest[3 * i];
+                tree.findClosestPoint( p, q );
+                distance2[i] = ( q[0] - p[0] ) * ( q[0] - p[0] ) + ( q[1] - p[1] ) * ( q[1] - p[1] ) + ( q[2] - p[2] ) * ( q[2] - p[2] );
+            }
+        }, _Settings.numThreads );
+
+        // Keep the closest pairs
+        for ( std::size_t i = 0; i < numSamples; i++ )
+        {
+            order[i] = i;
+        }
+
+        if ( numKept < numSamples )
+        {
+            std::nth_element( order.begin(), order.begin() + numKept, order.end(),
+                              [&distance2]( std::size_t a, std::size_t b ) { return distance2[a] < distance2[b]; } );
+        }
+
+        double totalDistance = 0.0;
+        for ( std::size_t n = 0; n < numKept; n++ )
+        {
+            std::size_t i = order[n];
+            sourceLandmarks->SetPoint( n, &samples[3 * i] );
+            targetLandmarks->SetPoint( n, &closest[3 * i] );
+            totalDistance += std::sqrt( distance2[i] );
+        }
+        sourceLandmarks->Modified();
+        targetLandmarks->Modified();
+
+        _MeanDistance = totalDistance / numKept;
+        if ( _IterationCallback )
+        {
+            _IterationCallback( _NumIterations, _MeanDistance );
+        }
+
+        // Rigid fit of the kept pairs
+        landmarkTransform->Update();
+        vtkMatrix4x4* step = landmarkTransform->GetMatrix();
+        accumulate->Concatenate( step );
+        _NumIterations++;
+
+        // Move the samples and stop once they barely move
+        double motion = 0.0;
+        for ( std::size_t i = 0; i < numSamples; i++ )
+        {
+            double* p = &samples[3 * i];
+            double moved[3];
+            for ( int r = 0; r < 3; r++ )
+            {
+                moved[r] = step->GetElement( r, 0 ) * p[0] + step->GetElement( r, 1 ) * p[1] +
+                           step->GetElement( r, 2 ) * p[2] + step->GetElement( r, 3 );
+            }
+
+            motion += std::sqrt( ( moved[0] - p[0] ) * ( moved[0] - p[0] ) + ( moved[1] - p[1] ) * ( moved[1] - p[1] ) +
+                                 ( moved[2] - p[2] ) * ( moved[2] - p[2] ) );
+            p[0] = moved[0];
+            p[1] = moved[1];
+            p[2] = moved[2];
+        }
+
+        if ( motion / numSamples < _Settings.tolerance )
+        {
+            _Converged = true;
+            break;
+        }
+    }
+
+    _Matrix->DeepCopy( accumulate->GetMatrix() );
+    return true;
+}
+
+bool parseICPSampling( const std::string& name, ICPSampling& sampling )
+{
+    if ( name == "all" )
+    {
+        sampling = ICP_SAMPLE_ALL;
+    }
+    else if ( name == "random" )
+    {
+        sampling = ICP_SAMPLE_RANDOM;
+    }
+    else if ( name == "normals" )
+    {
+        sampling = ICP_SAMPLE_NORMALS;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
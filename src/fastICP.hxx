@@ -0,0 +1,162 @@
+/****************************************************************************
+*   fastICP.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Multithreaded rigid ICP with a k-d tree, subsampling,
+*                   outlier trimming and a convergence test.
+****************************************************************************/
+
+#ifndef FASTICP_H
+#define FASTICP_H
+
+#include "pointKdTree.hxx"
+
+#include <functional>
+#include <string>
+
+#include <vtkMatrix4x4.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   How the source points used for matching are picked.
+*/
+enum ICPSampling
+{
+    ICP_SAMPLE_ALL,         // Use every source point
+    ICP_SAMPLE_RANDOM,      // Uniform random subset
+    ICP_SAMPLE_NORMALS      // Subset spread evenly over the directions of the surface normals
+};
+
+/*
+*   Parameters of the fast ICP engine.
+*/
+struct FastICPSettings
+{
+    int          maxIterations;     // Upper limit on the number of iterations
+    double       tolerance;         // Stop when the mean point motion of an iteration drops below this (world units)
+    ICPSampling  sampling;
+    int          numSamples;        // Number of source points used (ignored for ICP_SAMPLE_ALL)
+    double       trimFraction;      // Fraction of closest pairs kept in every iteration (1 = no trimming)
+    bool         matchCentroids;    // Start by moving the source centroid onto the target centroid (without an initial matrix)
+    unsigned int numThreads;        // 0 = one per core
+    unsigned int seed;              // Seed of the random sampling
+
+    FastICPSettings() :
+        maxIterations( 75 ), tolerance( 1e-4 ), sampling( ICP_SAMPLE_RANDOM ), numSamples( 5000 ),
+        trimFraction( 0.9 ), matchCentroids( true ), numThreads( 0 ), seed( 1 ) { }
+};
+
+/*
+*   Rigid body ICP, a replacement for vtkIterativeClosestPointTransform with the
+*   landmark transform in rigid body mode.
+*
+*   The target points are indexed once in a k-d tree, the closest points of all
+*   samples are found in parallel, and the worst pairs can be dropped before every
+*   fit so that parts of the surfaces without a counterpart do not pull the result.
+*   The rigid fit itself is done by vtkLandmarkTransform, exactly like VTK's ICP.
+*
+*   Note: correspondences are the closest target vertices, not the closest points on
+*   the target triangles. With the decimated CT surface as the target the vertices
+*   are dense enough for this to make no practical difference.
+*/
+class FastICP
+{
+    public:
+        FastICP();
+
+        /*
+        *   Set the surface that is moved (the OBJ surface).
+        */
+        void setSource( vtkPolyData* source ) { _Source = source; }
+
+        /*
+        *   Set the surface the source is registered to (the DICOM surface).
+        */
+        void setTarget( vtkPolyData* target ) { _Target = target; }
+
+        /*
+        *   Search a tree that is already built on the target points instead of building one.
+        *   The tree must outlive update(). Lets concurrent runs on the same target share one tree.
+        *
+        *   @param   tree   Tree of the target points (nullptr = build one in update())
+        */
+        void setTargetTree( const PointKdTree* tree ) { _SharedTree = tree; }
+
+        /*
+        *   Start from a known pose instead of matching the centroids.
+        *
+        *   @param   matrix   Initial transformation from the source to the target space (nullptr = none)
+        */
+        void setInitialMatrix( vtkMatrix4x4* matrix ) { _InitialMatrix = matrix; }
+
+        void setSettings( const FastICPSettings& settings ) { _Settings = settings; }
+        const FastICPSettings& getSettings() const { return _Settings; }
+
+        /*
+        *   Set the function called after every iteration.
+        *
+        *   @param   callback   Called as callback( iteration, meanDistance )
+        */
+        void setIterationCallback( const std::function<void( int, double )>& callback ) { _IterationCallback = callback; }
+
+        /*
+        *   Run the registration.
+        *
+        *   @returns TRUE if a transformation was found, FALSE if an input is missing or empty
+        */
+        bool update();
+
+        /*
+        *   @returns The transformation from the source space to the target space
+        */
+        vtkMatrix4x4* getMatrix() const { return _Matrix; }
+
+        /*
+        *   @returns The number of iterations done by the last update()
+        */
+        int getNumberOfIterations() const { return _NumIterations; }
+
+        /*
+        *   @returns The mean distance between the kept pairs in the last iteration
+        */
+        double getMeanDistance() const { return _MeanDistance; }
+
+        /*
+        *   @returns TRUE if the last update() stopped on the tolerance instead of the iteration limit
+        */
+        bool hasConverged() const { return _Converged; }
+
+    private:
+        vtkSmartPointer<vtkPolyData>  _Source;
+        vtkSmartPointer<vtkPolyData>  _Target;
+        vtkSmartPointer<vtkMatrix4x4> _Matrix;
+        vtkSmartPointer<vtkMatrix4x4> _InitialMatrix;
+        FastICPSettings               _Settings;
+        PointKdTree                   _Tree;
+        const PointKdTree*            _SharedTree;
+
+        std::function<void( int, double )> _IterationCallback;
+
+        int    _NumIterations;
+        double _MeanDistance;
+        bool   _Converged;
+
+        /*
+        *   Pick the source points used for matching.
+        */
+        std::vector<double> sampleSource() const;
+};
+
+/*
+*   Parse the name of a sampling mode (all, random or normals).
+*
+*   @param   name       Name of the mode
+*   @param   sampling   Set to the mode
+*
+*   @returns TRUE if the name is valid, FALSE otherwise
+*/
+bool parseICPSampling( const std::string& name, ICPSampling& sampling );
+
+#endif // FASTICP_H
@@ -0,0 +1,274 @@
+/****************************************************************************
+*   gaussianSmooth.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the separable Gaussian smoothing.
+****************************************************************************/
+
+#include "gaussianSmooth.hxx"
+#include "parallelUtils.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+
+namespace
+{
+
+/*
+*   1D Gaussian kernel with taps -radius to radius, normalised to a sum of 1.
+*/
+struct GaussianKernel
+{
+    int                radius;
+    std::vector<float> weights;
+
+    GaussianKernel( double standardDeviation, double radiusFactor ) :
+        radius( static_cast<int>( standardDeviation * radiusFactor ) ), weights( 2 * radius + 1, 1.0f )
+    {
+        if ( standardDeviation <= 0.0 )
+        {
+            return;
+        }
+
+        double sum = 0.0;
+        std::vector<double> values( weights.size() );
+        for ( int k = -radius; k <= radius; k++ )
+        {
+            values[k + radius] = std::exp( -0.5 * k * k / ( standardDeviation * standardDeviation ) );
+            sum += values[k + radius];
+        }
+        for ( std::size_t k = 0; k < values.size(); k++ )
+        {
+            weights[k] = static_cast<float>( values[k] / sum );
+        }
+    }
+
+    /*
+    *   Weight of tap k (-radius to radius).
+    */
+    float operator()( int k ) const { return weights[k + radius]; }
+
+    /*
+    *   Factor that renormalises position i of an axis of n voxels, 1 unless the kernel is cut off by a border.
+    */
+    float borderScale( int i, int n ) const
+    {
+        if ( i >= radius && i < n - radius )
+        {
+            return 1.0f;
+        }
+
+        float sum = 0.0f;
+        for ( int k = -radius; k <= radius; k++ )
+        {
+            sum += ( i + k >= 0 && i + k < n ) ? weights[k + radius] : 0.0f;
+        }
+        return 1.0f / sum;
+    }
+};
+
+/*
+*   out[j] += weight * in[j], the inner loop of the y and z passes.
+*/
+inline void addScaled( float* out, const float* in, std::size_t count, float weight )
+{
+    for ( std::size_t j = 0; j < count; j++ )
+    {
+        out[j] += weight * in[j];
+    }
+}
+
+inline void scale( float* values, std::size_t count, float factor )
+{
+    for ( std::size_t j = 0; j < count; j++ )
+    {
+        values[j] *= factor;
+    }
+}
+
+/*
+*   Convert a smoothed value back to the voxel type, integer types are rounded.
+*/
+template <typename T>
+inline T toVoxel( float value )
+{
+    return std::numeric_limits<T>::is_integer ? static_cast<T>( std::floor( value + 0.5f ) ) : static_cast<T>( value );
+}
+
+/*
+*   x pass over one row: out[i] = sum_k kernel( k ) * in[i + k]. The taps are the outer loop,
+*   so the loop over the row is a plain multiply-add over contiguous values.
+*/
+template <typename T>
+void convolveRow( const T* in, float* out, int n, const GaussianKernel& kernel )
+{
+    std::fill( out, out + n, 0.0f );
+
+    for ( int k = -kernel.radius; k <= kernel.radius; k++ )
+    {
+        float weight = kernel( k );
+        int first = std::max( 0, -k );
+        int last = std::min( n, n - k );
+
+        for ( int i = first; i < last; i++ )
+        {
+            out[i] += weight * static_cast<float>( in[i + k] );
+        }
+    }
+
+    for ( int i = 0; i < std::min( kernel.radius, n ); i++ )
+    {
+        out[i] *= kernel.borderScale( i, n );
+    }
+    for ( int i = std::max( kernel.radius, n - kernel.radius ); i < n; i++ )
+    {
+        out[i] *= kernel.borderScale( i, n );
+    }
+}
+
+/*
+*   Smooth the slices [zBegin, zEnd) of a volume into the output.
+*/
+template <typename T>
+void smoothSlab( const T* input, T* output, const int dims[3], int zBegin, int zEnd,
+                 const GaussianKernel& kernelX, const GaussianKernel& kernelY, const GaussianKernel& kernelZ )
+{
+    std::size_t rowSize = static_cast<std::size_t>( dims[0] );
+    std::size_t sliceSize = rowSize * dims[1];
+
+    // The slices of the slab and its halo, smoothed along x and y
+    int first = std::max( 0, zBegin - kernelZ.radius );
+    int last = std::min( dims[2], zEnd + kernelZ.radius );
+
+    std::vector<float> planes( ( last - first ) * sliceSize );
+    std::vector<float> rows( sliceSize );
+
+    for ( int z = first; z < last; z++ )
+    {
+        const T* slice = input + z * sliceSize;
+        for ( int y = 0; y < dims[1]; y++ )
+        {
+            convolveRow( slice + y * rowSize, &rows[y * rowSize], dims[0], kernelX );
+        }
+
+        // y pass, whole rows at a time
+        float* plane = &planes[( z - first ) * sliceSize];
+        std::fill( plane, plane + sliceSize, 0.0f );
+
+        for ( int y = 0; y < dims[1]; y++ )
+        {
+            float* out = plane + y * rowSize;
+            for ( int k = -kernelY.radius; k <= kernelY.radius; k++ )
+            {
+                if ( y + k >= 0 && y + k < dims[1] )
+                {
+                    addScaled( out, &rows[( y + k ) * rowSize], rowSize, kernelY( k ) );
+                }
+            }
+            scale( out, rowSize, kernelY.borderScale( y, dims[1] ) );
+        }
+    }
+
+    // z pass, whole slices at a time
+    std::vector<float> result( sliceSize );
+    for ( int z = zBegin; z < zEnd; z++ )
+    {
+        std::fill( result.begin(), result.end(), 0.0f );
+
+        for ( int k = -kernelZ.radius; k <= kernelZ.radius; k++ )
+        {
+            if ( z + k >= 0 && z + k < dims[2] )
+            {
+                addScaled( result.data(), &planes[( z + k - first ) * sliceSize], sliceSize, kernelZ( k ) );
+            }
+        }
+
+        float factor = kernelZ.borderScale( z, dims[2] );
+        T* out = output + z * sliceSize;
+        for ( std::size_t j = 0; j < sliceSize; j++ )
+        {
+            out[j] = toVoxel<T>( factor * result[j] );
+        }
+    }
+}
+
+template <typename T>
+void smoothVolume( const T* input, T* output, const int dims[3], const GaussianSmoothSettings& settings )
+{
+    GaussianKernel kernel( settings.standardDeviation, settings.radiusFactor );
+
+    unsigned int numThreads = getNumberOfWorkerThreads( settings.numThreads );
+    int slabSlices = ( settings.slabSlices > 0 ) ? settings.slabSlices : ( dims[2] + numThreads - 1 ) / numThreads;
+    slabSlices = std::max( 1, slabSlices );
+
+    // At most numThreads slabs are in work at any time
+    std::size_t numSlabs = ( dims[2] + slabSlices - 1 ) / slabSlices;
+    parallelFor( 0, numSlabs, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t slab = begin; slab < end; slab++ )
+        {
+            int zBegin = static_cast<int>( slab ) * slabSlices;
+            int zEnd = std::min( dims[2], zBegin + slabSlices );
+            smoothSlab( input, output, dims, zBegin, zEnd, kernel, kernel, kernel );
+        }
+    }, numThreads, 1 );
+}
+
+} // namespace
+
+vtkSmartPointer<vtkImageData> smoothGaussian( vtkImageData* image, const GaussianSmoothSettings& settings )
+{
+    if ( image->GetNumberOfScalarComponents() != 1 )
+    {
+        return nullptr;
+    }
+
+    int* extent = image->GetExtent();
+    int dims[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+
+    vtkSmartPointer<vtkImageData> output = vtkSmartPointer<vtkImageData>::New();
+    output->SetOrigin( image->GetOrigin() );
+    output->SetSpacing( image->GetSpacing() );
+    output->SetExtent( extent );
+    output->AllocateScalars( image->GetScalarType(), 1 );
+
+    vtkDataArray* inputScalars = image->GetPointData()->GetScalars();
+    if ( inputScalars->GetName() != nullptr )
+    {
+        output->GetPointData()->GetScalars()->SetName( inputScalars->GetName() );
+    }
+
+    if ( dims[0] < 1 || dims[1] < 1 || dims[2] < 1 )
+    {
+        return output;
+    }
+
+    void* input = image->GetScalarPointer();
+    void* smoothed = output->GetScalarPointer();
+
+    switch ( image->GetScalarType() )
+    {
+        vtkTemplateMacro( smoothVolume( static_cast<const VTK_TT*>( input ), static_cast<VTK_TT*>( smoothed ), dims, settings ) );
+        default:
+            return nullptr;
+    }
+
+    return output;
+}
+
+void smoothingExtent( const int volumeExtent[6], const int region[6], const GaussianSmoothSettings& settings, int extent[6] )
+{
+    int radius = GaussianKernel( settings.standardDeviation, settings.radiusFactor ).radius;
+
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        extent[2 * axis] = std::max( volumeExtent[2 * axis], region[2 * axis] - radius );
+        extent[2 * axis + 1] = std::min( volumeExtent[2 * axis + 1], region[2 * axis + 1] + radius );
+    }
+}
@@ -0,0 +1,65 @@
+/****************************************************************************
+*   gaussianSmooth.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Separable 3D Gaussian smoothing that works on the
+*                   volume in slabs of slices.
+****************************************************************************/
+
+#ifndef GAUSSIANSMOOTH_H
+#define GAUSSIANSMOOTH_H
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   Parameters of the Gaussian smoothing.
+*/
+struct GaussianSmoothSettings
+{
+    double       standardDeviation; // In voxels along every axis, like vtkImageGaussianSmooth
+    double       radiusFactor;      // The kernel reaches standardDeviation * radiusFactor voxels (rounded down) to each side
+    int          slabSlices;        // Slices smoothed at once by a thread (0 = the volume split into one slab per thread)
+    unsigned int numThreads;        // 0 = one per core
+
+    GaussianSmoothSettings() : standardDeviation( 1.0 ), radiusFactor( 1.0 ), slabSlices( 0 ), numThreads( 0 ) { }
+};
+
+/*
+*   Smooth a volume with a 3D Gaussian, the same kernel as vtkImageGaussianSmooth with
+*   dimensionality 3 (near the borders the kernel is cut off and renormalised). Unlike VTK the
+*   passes do not round to the voxel type in between, integer results are rounded once at the end.
+*
+*   The volume is split into slabs of slices along z and the threads smooth one slab each.
+*   A slab reads the slices of its halo (the kernel radius above and below it), runs the x and
+*   y passes slice by slice into a float buffer and then the z pass into the output. The voxels
+*   are read in their own type and accumulated in float, every pass runs over whole contiguous
+*   rows or slices so that the inner loops vectorise, and the output has the type of the input.
+*
+*   With slabSlices set, the working memory besides the input and output is bounded by
+*   numThreads * ( slabSlices + 2 * radius + 1 ) float slices, whatever the size of the volume,
+*   and the slabs walk through the input in order (which suits a memory mapped input).
+*
+*   @param   image      Volume to smooth (one scalar component)
+*   @param   settings   Kernel, slab size and number of threads
+*
+*   @returns The smoothed volume with the extent, origin and spacing of the input,
+*            or nullptr if the input does not have exactly one component
+*/
+vtkSmartPointer<vtkImageData> smoothGaussian( vtkImageData* image, const GaussianSmoothSettings& settings );
+
+/*
+*   Extent of the voxels that the smoothed voxels of a region depend on: the region grown by the
+*   kernel radius along every axis, within the extent of the volume. Smoothing the volume cropped
+*   to this extent gives the voxels of the region exactly as smoothing the whole volume does.
+*   The voxels around the region are smoothed with a cut off kernel and differ.
+*
+*   @param   volumeExtent   Extent of the whole volume
+*   @param   region         Extent of the voxels that are needed, within the volume
+*   @param   settings       Kernel of the smoothing
+*   @param   extent         Returns the extent to crop the volume to before smoothing
+*/
+void smoothingExtent( const int volumeExtent[6], const int region[6], const GaussianSmoothSettings& settings, int extent[6] );
+
+#endif // GAUSSIANSMOOTH_H
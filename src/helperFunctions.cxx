@@ -116,4 +116,19 @@ bool checkInputs( std::string dicomFile, std::string objFile )
 
     return ( validDICOM * validOBJ );
 }
+
+std::string fingerprintString( const std::string& text )
+{
+    unsigned long long hash = 14695981039346656037ULL;
+
+    for ( std::size_t i = 0; i < text.size(); i++ )
+    {
+        hash ^= static_cast<unsigned char>( text[i] );
+        hash *= 1099511628211ULL;
+    }
+
+    std::stringstream tmp;
+    tmp << std::hex << std::setw( 16 ) << std::setfill( '0' ) << hash;
+    return tmp.str();
+}
 /***************************************************************************/
\ No newline at end of file
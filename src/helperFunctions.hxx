@@ -16,6 +16,7 @@
 #include <algorithm>
 #include <vector>
 #include <chrono>
+#include <iomanip>
 
 #include <vtkRenderWindow.h>
 #include <vtkRenderWindowInteractor.h>
@@ -117,6 +118,16 @@ class ImageMessage
 */
 bool checkInputs( std::string dicomFile, std::string objFile );
 
+/*
+*   Create a short fingerprint (64-bit FNV-1a hash) of a string.
+*   Used to detect when cached data no longer matches its source.
+*
+*   @param   text   The string to fingerprint
+*
+*   @returns The fingerprint as a 16 character hexadecimal string
+*/
+std::string fingerprintString( const std::string& text );
+
 /***************************************************************************/
 
 #endif // HELPERFUNCTIONS_H
\ No newline at end of file
@@ -0,0 +1,194 @@
+/****************************************************************************
+*   instrumentedICP.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the instrumented ICP transform.
+****************************************************************************/
+
+#include "instrumentedICP.hxx"
+
+#include <cmath>
+
+#include <vtkCellLocator.h>
+#include <vtkDataSet.h>
+#include <vtkLandmarkTransform.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkSmartPointer.h>
+#include <vtkTransform.h>
+
+vtkStandardNewMacro(InstrumentedICPTransform);
+
+void InstrumentedICPTransform::InternalUpdate()
+{
+    // Check source, target
+    if ( this->Source == nullptr || !this->Source->GetNumberOfPoints() )
+    {
+        vtkErrorMacro( << "Can't execute with nullptr or empty input" );
+        return;
+    }
+
+    if ( this->Target == nullptr || !this->Target->GetNumberOfPoints() )
+    {
+        vtkErrorMacro( << "Can't execute with nullptr or empty target" );
+        return;
+    }
+
+    // Create locator
+    if ( this->Locator == nullptr )
+    {
+        this->CreateDefaultLocator();
+    }
+    this->Locator->SetDataSet( this->Target );
+    this->Locator->SetNumberOfCellsPerBucket( 1 );
+    this->Locator->BuildLocator();
+
+    // Create two sets of points to handle iteration, sampled with the same step as VTK
+    vtkIdType step = 1;
+    if ( this->Source->GetNumberOfPoints() > this->MaximumNumberOfLandmarks )
+    {
+        step = this->Source->GetNumberOfPoints() / this->MaximumNumberOfLandmarks;
+    }
+
+    vtkIdType numPoints = this->Source->GetNumberOfPoints() / step;
+
+    vtkSmartPointer<vtkPoints> points1 = vtkSmartPointer<vtkPoints>::New();
+    points1->SetNumberOfPoints( numPoints );
+
+    vtkSmartPointer<vtkPoints> closestPoints = vtkSmartPointer<vtkPoints>::New();
+    closestPoints->SetNumberOfPoints( numPoints );
+
+    vtkSmartPointer<vtkPoints> points2 = vtkSmartPointer<vtkPoints>::New();
+    points2->SetNumberOfPoints( numPoints );
+
+    // Fill with initial positions (sample dataset using step)
+    vtkSmartPointer<vtkTransform> accumulate = vtkSmartPointer<vtkTransform>::New();
+    accumulate->PostMultiply();
+
+    double p1[3], p2[3];
+    double delta[3] = { 0.0, 0.0, 0.0 };
+
+    if ( this->StartByMatchingCentroids )
+    {
+        double sourceCentroid[3] = { 0.0, 0.0, 0.0 };
+        for ( vtkIdType i = 0; i < this->Source->GetNumberOfPoints(); i++ )
+        {
+            this->Source->GetPoint( i, p1 );
+            vtkMath::Add( sourceCentroid, p1, sourceCentroid );
+        }
+        vtkMath::MultiplyScalar( sourceCentroid, 1.0 / this->Source->GetNumberOfPoints() );
+
+        double targetCentroid[3] = { 0.0, 0.0, 0.0 };
+        for ( vtkIdType i = 0; i < this->Target->GetNumberOfPoints(); i++ )
+        {
+            this->Target->GetPoint( i, p1 );
+            vtkMath::Add( targetCentroid, p1, targetCentroid );
+        }
+        vtkMath::MultiplyScalar( targetCentroid, 1.0 / this->Target->GetNumberOfPoints() );
+
+        vtkMath::Subtract( targetCentroid, sourceCentroid, delta );
+        accumulate->Translate( delta );
+    }
+
+    for ( vtkIdType i = 0, j = 0; i < numPoints; i++, j += step )
+    {
+        this->Source->GetPoint( j, p1 );
+        vtkMath::Add( p1, delta, p2 );
+        points1->SetPoint( i, p2 );
+    }
+
+    // Go
+    vtkIdType cellId;
+    int subId;
+    double dist2, totalDistance = 0.0;
+    double outPoint[3];
+
+    vtkPoints* a = points1;
+    vtkPoints* b = points2;
+
+    this->NumberOfIterations = 0;
+
+    do
+    {
+        // Fill points with the closest points to each vertex in input
+        double closestDistance = 0.0;
+        for ( vtkIdType i = 0; i < numPoints; i++ )
+        {
+            this->Locator->FindClosestPoint( a->GetPoint( i ), outPoint, cellId, subId, dist2 );
+            closestPoints->SetPoint( i, outPoint );
+            closestDistance += std::sqrt( dist2 );
+        }
+
+        if ( _IterationCallback )
+        {
+            _IterationCallback( this->NumberOfIterations, closestDistance / numPoints );
+        }
+
+        // Build the landmark transform
+        this->LandmarkTransform->SetSourceLandmarks( a );
+        this->LandmarkTransform->SetTargetLandmarks( closestPoints );
+        this->LandmarkTransform->Update();
+
+        // Concatenate (can't use this->Concatenate directly)
+        accumulate->Concatenate( this->LandmarkTransform->GetMatrix() );
+
+        this->NumberOfIterations++;
+        if ( this->NumberOfIterations >= this->MaximumNumberOfIterations )
+        {
+            break;
+        }
+
+        // Move mesh and compute mean distance if needed
+        if ( this->CheckMeanDistance )
+        {
+            totalDistance = 0.0;
+        }
+
+        for ( vtkIdType i = 0; i < numPoints; i++ )
+        {
+            a->GetPoint( i, p1 );
+            this->LandmarkTransform->InternalTransformPoint( p1, p2 );
+            b->SetPoint( i, p2 );
+
+            if ( this->CheckMeanDistance )
+            {
+                if ( this->MeanDistanceMode == VTK_ICP_MODE_RMS )
+                {
+                    totalDistance += vtkMath::Distance2BetweenPoints( p1, p2 );
+                }
+                else
+                {
+                    totalDistance += std::sqrt( vtkMath::Distance2BetweenPoints( p1, p2 ) );
+                }
+            }
+        }
+
+        if ( this->CheckMeanDistance )
+        {
+            if ( this->MeanDistanceMode == VTK_ICP_MODE_RMS )
+            {
+                this->MeanDistance = std::sqrt( totalDistance / numPoints );
+            }
+            else
+            {
+                this->MeanDistance = totalDistance / numPoints;
+            }
+
+            if ( this->MeanDistance <= this->MaximumMeanDistance )
+            {
+                break;
+            }
+        }
+
+        vtkPoints* temp = a;
+        a = b;
+        b = temp;
+
+    } while ( true );
+
+    // Now recover accumulated result
+    this->Matrix->DeepCopy( accumulate->GetMatrix() );
+}
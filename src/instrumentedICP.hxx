@@ -0,0 +1,53 @@
+/****************************************************************************
+*   instrumentedICP.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    ICP transform that reports the mean closest point
+*                   distance of every iteration.
+****************************************************************************/
+
+#ifndef INSTRUMENTEDICP_H
+#define INSTRUMENTEDICP_H
+
+#include <functional>
+
+#include <vtkIterativeClosestPointTransform.h>
+
+/*
+*   Same algorithm as vtkIterativeClosestPointTransform, but the mean distance between
+*   the source points and their closest target points is passed to a callback after
+*   every iteration. The distances come from the closest point queries that ICP
+*   already does, so no extra searching is needed.
+*/
+class InstrumentedICPTransform : public vtkIterativeClosestPointTransform
+{
+public:
+    static InstrumentedICPTransform* New();
+
+    vtkTypeMacro(InstrumentedICPTransform, vtkIterativeClosestPointTransform);
+
+    /*
+    *   Set the function called after every iteration.
+    *
+    *   @param   callback   Called as callback( iteration, meanDistance )
+    */
+    void setIterationCallback( const std::function<void( int, double )>& callback ) { _IterationCallback = callback; }
+
+protected:
+    InstrumentedICPTransform() { }
+    ~InstrumentedICPTransform() override { }
+
+    /*
+    *   Mirrors vtkIterativeClosestPointTransform::InternalUpdate().
+    */
+    void InternalUpdate() override;
+
+    std::function<void( int, double )> _IterationCallback;
+
+private:
+    InstrumentedICPTransform( const InstrumentedICPTransform& ) = delete;
+    void operator=( const InstrumentedICPTransform& ) = delete;
+};
+
+#endif // INSTRUMENTEDICP_H
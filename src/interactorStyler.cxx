@@ -8,6 +8,23 @@
 
 #include "interactorStyler.hxx"
 
+vtkStandardNewMacro(myInteractorStyler);
+
+// Quiet time after the last key or wheel event before rendering (milliseconds). Key auto-repeat
+// sends an event about every 30 ms, so a held key keeps restarting the timer and is drawn once.
+static const unsigned long RENDER_DELAY_MS = 50;
+
+// Longest wait of a pending render (milliseconds). Once a request is this old the timer is no
+// longer restarted, so the viewer still follows a held key about 5 times per second.
+static const long long RENDER_MAX_LATENCY_MS = 200;
+
+myInteractorStyler::myInteractorStyler() :
+    _ImageViewer( nullptr ), _SliceStatusMapper( nullptr ), _WindowLevelStatusMapper( nullptr ), _WindowStatusMapper( nullptr ),
+    _SliceReview( nullptr ), _ContourMapper( nullptr ), _RenderPending( false ), _RenderTimerId( 0 ), _RenderRequestTime(),
+    slice( 0 ), minSlice( 0 ), maxSlice( 0 ), windowLevel( 0.0 ), window( 0.0 )
+{
+}
+
 void myInteractorStyler::setImageViewer( vtkImageViewer2* imageViewer )
 {
     _ImageViewer = imageViewer;
@@ -35,20 +52,93 @@ void myInteractorStyler::setWindowStatusMapper( vtkTextMapper* statusMapper )
     _WindowStatusMapper = statusMapper;
 }
 
+void myInteractorStyler::setSliceReview( SliceReview* sliceReview, vtkPolyDataMapper* contourMapper )
+{
+    _SliceReview = sliceReview;
+    _ContourMapper = contourMapper;
+    minSlice = sliceReview->getFirstSlice();
+    maxSlice = sliceReview->getLastSlice();
+
+    // Start in the middle of the volume
+    slice = ( minSlice + maxSlice ) / 2;
+
+    std::string msg = ImageMessage::sliceNumberFormat( slice, maxSlice );
+    _SliceStatusMapper->SetInput( msg.c_str() );
+}
+
+void myInteractorStyler::render()
+{
+    _RenderPending = false;
+
+    if ( _SliceReview != nullptr )
+    {
+        vtkSmartPointer<vtkImageData> image;
+        vtkSmartPointer<vtkPolyData> contour;
+
+        if ( _SliceReview->getSlice( slice, image, contour ) )
+        {
+            _ImageViewer->SetInputData( image );
+            _ContourMapper->SetInputData( contour );
+        }
+    }
+
+    _ImageViewer->SetSlice( slice );
+    _ImageViewer->Render();
+}
+
+void myInteractorStyler::requestRender()
+{
+    if ( this->Interactor == nullptr )
+    {
+        render();
+        return;
+    }
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if ( _RenderPending )
+    {
+        long long waited = std::chrono::duration_cast<std::chrono::milliseconds>( now - _RenderRequestTime ).count();
+        if ( waited >= RENDER_MAX_LATENCY_MS )
+        {
+            // Let the running timer fire, render() shows the latest slice
+            return;
+        }
+
+        this->Interactor->DestroyTimer( _RenderTimerId );
+    }
+    else
+    {
+        _RenderPending = true;
+        _RenderRequestTime = now;
+    }
+
+    _RenderTimerId = this->Interactor->CreateOneShotTimer( RENDER_DELAY_MS );
+}
+
+void myInteractorStyler::OnTimer()
+{
+    if ( _RenderPending && this->Interactor->GetTimerEventId() == _RenderTimerId )
+    {
+        render();
+        return;
+    }
+
+    vtkInteractorStyleImage::OnTimer();
+}
+
 void myInteractorStyler::moveSliceForward() 
 {
     if ( slice < maxSlice ) 
     {
         slice += 1;
 
-        _ImageViewer->SetSlice( slice );
-
         // Create the message to be displayed.
         std::string msg = ImageMessage::sliceNumberFormat( slice, maxSlice );
 
-        // Update the mapper and render.
+        // Update the mapper, the slice is drawn with the next render.
         _SliceStatusMapper->SetInput( msg.c_str() );
-        _ImageViewer->Render();
+        requestRender();
     }
 }
 
@@ -58,14 +148,12 @@ void myInteractorStyler::moveSliceBackward()
     {
         slice -= 1;
 
-        _ImageViewer->SetSlice( slice );
-
         // Create the message to be displayed.
         std::string msg = ImageMessage::sliceNumberFormat( slice, maxSlice );
 
-        // Update the mapper and render.
+        // Update the mapper, the slice is drawn with the next render.
         _SliceStatusMapper->SetInput( msg.c_str() );
-        _ImageViewer->Render();
+        requestRender();
     }
 }
 
@@ -80,7 +168,7 @@ void myInteractorStyler::moveWindowLevelForward()
 
     // Update the mapper and render.
     _WindowLevelStatusMapper->SetInput( msg.c_str() );
-    _ImageViewer->Render();
+    requestRender();
 }
 
 void myInteractorStyler::moveWindowLevelBackward() 
@@ -94,7 +182,7 @@ void myInteractorStyler::moveWindowLevelBackward()
 
     // Update the mapper and render.
     _WindowLevelStatusMapper->SetInput( msg.c_str() );
-    _ImageViewer->Render();
+    requestRender();
 }
 
 void myInteractorStyler::moveWindowForward()
@@ -108,7 +196,7 @@ void myInteractorStyler::moveWindowForward()
 
     // Update the mapper and render.
     _WindowStatusMapper->SetInput( msg.c_str() );
-    _ImageViewer->Render();
+    requestRender();
 }
 
 void myInteractorStyler::moveWindowBackward()
@@ -122,5 +210,5 @@ void myInteractorStyler::moveWindowBackward()
 
     // Update the mapper and render.
     _WindowStatusMapper->SetInput( msg.c_str() );
-    _ImageViewer->Render();   
+    requestRender();
 }
\ No newline at end of file
@@ -10,12 +10,14 @@
 #define INTERACTORSTYLER_H
 
 #include "helperFunctions.hxx"
+#include "sliceReview.hxx"
 
 #include <vtkRenderWindow.h>
 #include <vtkRenderWindowInteractor.h>
 #include <vtkRenderer.h>
 #include <vtkActor.h>
 #include <vtkActor2D.h>
+#include <vtkPolyDataMapper.h>
 
 #include <vtkImageViewer2.h>
 #include <vtkDICOMImageReader.h>
@@ -29,6 +31,7 @@
 #include <vtkSmartPointer.h>
 #include <vtkObjectFactory.h>
 
+#include <chrono>
 #include <string>
 
 /* 
@@ -69,17 +72,46 @@ public:
    */
    void setWindowStatusMapper(vtkTextMapper* _WindowStatusMapper);
 
+   /*
+   *   Show the slices of a slice review instead of the slices of the viewer input.
+   *   Call after setImageViewer(), starts at the middle slice.
+   *
+   *   @param   sliceReview     Slices and contours to show
+   *   @param   contourMapper   Mapper from main for the contour of the OBJ surface
+   */
+   void setSliceReview(SliceReview* sliceReview, vtkPolyDataMapper* contourMapper);
+
+   /*
+   *   Show the current slice and render now.
+   */
+   void render();
+
 protected:
-   vtkImageViewer2* _ImageViewer;
-   vtkTextMapper*   _SliceStatusMapper;
-   vtkTextMapper*   _WindowLevelStatusMapper;
-   vtkTextMapper*   _WindowStatusMapper;
+   vtkImageViewer2*   _ImageViewer;
+   vtkTextMapper*     _SliceStatusMapper;
+   vtkTextMapper*     _WindowLevelStatusMapper;
+   vtkTextMapper*     _WindowStatusMapper;
+   SliceReview*       _SliceReview;
+   vtkPolyDataMapper* _ContourMapper;
+   bool _RenderPending;
+   int  _RenderTimerId;
+   std::chrono::steady_clock::time_point _RenderRequestTime;
    int slice;
    int minSlice;
    int maxSlice;
    double windowLevel;
    double window;
 
+   myInteractorStyler();
+
+   /*
+   *   Render on a short timer instead of at once, so a burst of key or wheel events
+   *   (e.g. a held arrow key) only moves the slice number and is drawn once.
+   *   Every event restarts the timer, unless the pending render has already waited
+   *   for the latency limit.
+   */
+   void requestRender();
+
    /*
    *   Move the next slice in the image.
    */
@@ -178,6 +210,12 @@ protected:
    *  leveling is only done with the left and right arrow keys as desired.
    */
    virtual void OnLeftButtonDown()  { }
+
+   /*
+   *   Overload the default interactor event listener for timers.
+   *   Renders when the timer of requestRender() fires.
+   */
+   virtual void OnTimer();
 };
 
 #endif  // INTERACTORSTYLER_H
\ No newline at end of file
@@ -0,0 +1,219 @@
+/****************************************************************************
+*   mappedFile.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the memory mapped file helpers.
+****************************************************************************/
+
+#include "mappedFile.hxx"
+
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkDataArray.h>
+#include <vtkSmartPointer.h>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #include <process.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : _Data( nullptr ), _Size( 0 )
+{
+#ifdef _WIN32
+    _FileHandle = nullptr;
+    _MappingHandle = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open( const std::string& fileName )
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+    if ( file == INVALID_HANDLE_VALUE )
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if ( !GetFileSizeEx( file, &fileSize ) || fileSize.QuadPart == 0 )
+    {
+        CloseHandle( file );
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA( file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr );
+    if ( mapping == nullptr )
+    {
+        CloseHandle( file );
+        return false;
+    }
+
+    void* view = MapViewOfFile( mapping, FILE_MAP_COPY, 0, 0, 0 );
+    if ( view == nullptr )
+    {
+        CloseHandle( mapping );
+        CloseHandle( file );
+        return false;
+    }
+
+    _FileHandle = file;
+    _MappingHandle = mapping;
+    _Data = static_cast<char*>( view );
+    _Size = static_cast<std::size_t>( fileSize.QuadPart );
+#else
+    int fd = ::open( fileName.c_str(), O_RDONLY );
+    if ( fd < 0 )
+    {
+        return false;
+    }
+
+    struct stat info;
+    if ( fstat( fd, &info ) != 0 || info.st_size == 0 )
+    {
+        ::close( fd );
+        return false;
+    }
+
+    void* view = mmap( nullptr, static_cast<std::size_t>( info.st_size ), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+
+    // The mapping stays valid after the descriptor is closed
+    ::close( fd );
+
+    if ( view == MAP_FAILED )
+    {
+        return false;
+    }
+
+    _Data = static_cast<char*>( view );
+    _Size = static_cast<std::size_t>( info.st_size );
+#endif
+
+    return true;
+}
+
+void MappedFile::close()
+{
+    if ( _Data == nullptr )
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile( _Data );
+    CloseHandle( static_cast<HANDLE>( _MappingHandle ) );
+    CloseHandle( static_cast<HANDLE>( _FileHandle ) );
+    _FileHandle = nullptr;
+    _MappingHandle = nullptr;
+#else
+    munmap( _Data, _Size );
+#endif
+
+    _Data = nullptr;
+    _Size = 0;
+}
+
+/*
+*   Called when an array that points into a mapping is deleted.
+*/
+static void releaseMapping( vtkObject* vtkNotUsed( caller ), unsigned long vtkNotUsed( eventId ),
+                            void* clientData, void* vtkNotUsed( callData ) )
+{
+    delete static_cast<MappedFile*>( clientData );
+}
+
+void attachMappingToArray( vtkDataArray* array, MappedFile* mapping )
+{
+    vtkSmartPointer<vtkCallbackCommand> callback = vtkSmartPointer<vtkCallbackCommand>::New();
+    callback->SetCallback( releaseMapping );
+    callback->SetClientData( mapping );
+    array->AddObserver( vtkCommand::DeleteEvent, callback );
+}
+
+/*
+*   Called when one of several arrays that share a mapping is deleted.
+*/
+static void releaseSharedMapping( vtkObject* vtkNotUsed( caller ), unsigned long vtkNotUsed( eventId ),
+                                  void* clientData, void* vtkNotUsed( callData ) )
+{
+    delete static_cast< std::shared_ptr<MappedFile>* >( clientData );
+}
+
+void attachMappingToArrays( const std::vector<vtkDataArray*>& arrays, MappedFile* mapping )
+{
+    std::shared_ptr<MappedFile> shared( mapping );
+
+    // Every array holds one reference, the last one to go deletes the mapping
+    for ( std::size_t i = 0; i < arrays.size(); i++ )
+    {
+        vtkSmartPointer<vtkCallbackCommand> callback = vtkSmartPointer<vtkCallbackCommand>::New();
+        callback->SetCallback( releaseSharedMapping );
+        callback->SetClientData( new std::shared_ptr<MappedFile>( shared ) );
+        arrays[i]->AddObserver( vtkCommand::DeleteEvent, callback );
+    }
+}
+
+bool writeFileAtomically( const std::string& fileName, const void* data, std::size_t size )
+{
+    return writeFileAtomically( fileName, std::vector< std::pair<const void*, std::size_t> >( 1, std::make_pair( data, size ) ) );
+}
+
+bool writeFileAtomically( const std::string& fileName, const std::vector< std::pair<const void*, std::size_t> >& parts )
+{
+    // Use a temporary name that is unique to this process and thread
+    std::stringstream tmpName;
+#ifdef _WIN32
+    tmpName << fileName << ".tmp." << _getpid() << "." << std::hash<std::thread::id>()( std::this_thread::get_id() );
+#else
+    tmpName << fileName << ".tmp." << getpid() << "." << std::hash<std::thread::id>()( std::this_thread::get_id() );
+#endif
+
+    FILE* file = std::fopen( tmpName.str().c_str(), "wb" );
+    if ( file == nullptr )
+    {
+        return false;
+    }
+
+    bool written = true;
+    for ( std::size_t i = 0; i < parts.size() && written; i++ )
+    {
+        written = ( parts[i].second == 0 || std::fwrite( parts[i].first, 1, parts[i].second, file ) == parts[i].second );
+    }
+    written = ( std::fclose( file ) == 0 ) && written;
+
+    if ( written )
+    {
+#ifdef _WIN32
+        written = MoveFileExA( tmpName.str().c_str(), fileName.c_str(), MOVEFILE_REPLACE_EXISTING ) != 0;
+#else
+        written = std::rename( tmpName.str().c_str(), fileName.c_str() ) == 0;
+#endif
+    }
+
+    if ( !written )
+    {
+        std::remove( tmpName.str().c_str() );
+    }
+
+    return written;
+}
@@ -0,0 +1,105 @@
+/****************************************************************************
+*   mappedFile.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Copy-on-write memory mapping of files on disk, used to
+*                   load cached volumes and meshes without copying them.
+****************************************************************************/
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+class vtkDataArray;
+
+/*
+*   A copy-on-write memory mapping of a whole file.
+*   Pages are only read from disk when they are touched. Writing into the mapping
+*   is allowed but the changes stay private to the process and never reach the file.
+*   The mapping is released when the object is destroyed.
+*/
+class MappedFile
+{
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        /*
+        *   Map a file into memory.
+        *
+        *   @param   fileName   Path of the file to map
+        *
+        *   @returns TRUE if the file was mapped, FALSE otherwise
+        */
+        bool open( const std::string& fileName );
+
+        /*
+        *   Release the mapping (if any).
+        */
+        void close();
+
+        char* data() const { return _Data; }
+        std::size_t size() const { return _Size; }
+        bool isOpen() const { return _Data != nullptr; }
+
+    private:
+        char* _Data;
+        std::size_t _Size;
+
+#ifdef _WIN32
+        void* _FileHandle;
+        void* _MappingHandle;
+#endif
+
+        // Mappings own OS resources, do not allow copies
+        MappedFile( const MappedFile& );
+        MappedFile& operator=( const MappedFile& );
+};
+
+/*
+*   Tie the lifetime of a mapping to a VTK array that points into it.
+*   The mapping is deleted when the array is deleted, so the array can be passed
+*   around the pipeline like any other array.
+*
+*   @param   array    Array that was given a pointer into the mapping with SetArray()
+*   @param   mapping  Heap allocated mapping, ownership is transferred to the array
+*/
+void attachMappingToArray( vtkDataArray* array, MappedFile* mapping );
+
+/*
+*   Tie the lifetime of a mapping to several VTK arrays that point into it.
+*   The mapping is deleted when the last of the arrays is deleted.
+*
+*   @param   arrays   Arrays that were given pointers into the mapping with SetArray()
+*   @param   mapping  Heap allocated mapping, ownership is transferred to the arrays
+*/
+void attachMappingToArrays( const std::vector<vtkDataArray*>& arrays, MappedFile* mapping );
+
+/*
+*   Write a buffer to a file by writing a temporary file first and renaming it.
+*   Other processes never see a partially written file.
+*
+*   @param   fileName   Path of the file to write
+*   @param   data       Buffer to write
+*   @param   size       Number of bytes to write
+*
+*   @returns TRUE if the file was written, FALSE otherwise
+*/
+bool writeFileAtomically( const std::string& fileName, const void* data, std::size_t size );
+
+/*
+*   Write several buffers one after the other to a file, see writeFileAtomically() above.
+*
+*   @param   fileName   Path of the file to write
+*   @param   parts      Pointer and number of bytes of every buffer, in file order
+*
+*   @returns TRUE if the file was written, FALSE otherwise
+*/
+bool writeFileAtomically( const std::string& fileName, const std::vector< std::pair<const void*, std::size_t> >& parts );
+
+#endif // MAPPEDFILE_H
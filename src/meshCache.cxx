@@ -0,0 +1,314 @@
+/****************************************************************************
+*   meshCache.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the binary mesh cache files.
+****************************************************************************/
+
+#include "meshCache.hxx"
+#include "mappedFile.hxx"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkFieldData.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkIntArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkStringArray.h>
+#include <vtkTypeInt64Array.h>
+#include <vtkVersionMacros.h>
+
+static const char         MESH_CACHE_MAGIC[8] = { 'V', 'T', 'K', 'R', 'M', 'S', 'H', '\0' };
+static const unsigned int MESH_CACHE_VERSION = 3;
+
+// Every array starts on a multiple of this many bytes
+static const std::size_t MESH_CACHE_ALIGNMENT = 64;
+
+/*
+*   Fixed size header at the start of a mesh cache file, followed by the arrays:
+*   points (3 floats per point), normals (3 floats per point, optional), texture
+*   coordinates (2 floats per point, optional), the cells as the offsets and
+*   connectivity arrays of vtkCellArray::SetData() (64-bit integers, numPolys + 1
+*   offsets), the material of every polygon (optional, one int each) and the
+*   material names (each followed by a newline).
+*/
+struct MeshCacheHeader
+{
+    char               magic[8];
+    unsigned int       version;
+    char               fingerprint[16];
+    unsigned long long numPoints;
+    unsigned long long numPolys;
+    unsigned long long numConnectivity;     // Point ids of all polygons
+    unsigned long long hasNormals;
+    unsigned long long hasTCoords;
+    unsigned long long hasMaterials;
+    unsigned long long materialNameBytes;
+};
+
+/*
+*   Byte offsets of the arrays in a cache file.
+*/
+struct MeshCacheLayout
+{
+    std::size_t points;
+    std::size_t normals;
+    std::size_t tcoords;
+    std::size_t offsets;
+    std::size_t connectivity;
+    std::size_t materialIds;
+    std::size_t materialNames;
+    std::size_t end;
+};
+
+static std::size_t alignOffset( std::size_t offset )
+{
+    return ( offset + MESH_CACHE_ALIGNMENT - 1 ) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT;
+}
+
+static MeshCacheLayout computeLayout( const MeshCacheHeader& header )
+{
+    std::size_t numPoints = static_cast<std::size_t>( header.numPoints );
+
+    MeshCacheLayout layout;
+    layout.points = alignOffset( sizeof( MeshCacheHeader ) );
+    layout.normals = alignOffset( layout.points + 3 * numPoints * sizeof( float ) );
+    layout.tcoords = alignOffset( layout.normals + ( header.hasNormals ? 3 * numPoints * sizeof( float ) : 0 ) );
+    layout.offsets = alignOffset( layout.tcoords + ( header.hasTCoords ? 2 * numPoints * sizeof( float ) : 0 ) );
+    layout.connectivity = alignOffset( layout.offsets + static_cast<std::size_t>( header.numPolys + 1 ) * sizeof( vtkTypeInt64 ) );
+    layout.materialIds = alignOffset( layout.connectivity + static_cast<std::size_t>( header.numConnectivity ) * sizeof( vtkTypeInt64 ) );
+    layout.materialNames = layout.materialIds + ( header.hasMaterials ? static_cast<std::size_t>( header.numPolys ) * sizeof( int ) : 0 );
+    layout.end = layout.materialNames + static_cast<std::size_t>( header.materialNameBytes );
+    return layout;
+}
+
+/*
+*   @returns TRUE if the array holds floats with the given number of components, one tuple per point
+*/
+static bool isFloatArray( vtkDataArray* array, int components, vtkIdType numPoints )
+{
+    return array != nullptr && array->GetDataType() == VTK_FLOAT &&
+           array->GetNumberOfComponents() == components && array->GetNumberOfTuples() == numPoints;
+}
+
+bool writeMeshCache( const std::string& fileName, vtkPolyData* surface, const std::string& fingerprint )
+{
+    vtkIdType numPoints = surface->GetNumberOfPoints();
+    if ( numPoints == 0 || !isFloatArray( surface->GetPoints()->GetData(), 3, numPoints ) )
+    {
+        return false;
+    }
+
+    vtkDataArray* normals = surface->GetPointData()->GetNormals();
+    vtkDataArray* tcoords = surface->GetPointData()->GetTCoords();
+    vtkIdType numPolys = surface->GetNumberOfPolys();
+
+    // Offsets and connectivity from the legacy layout (size followed by the point ids, for every polygon)
+    std::vector<vtkTypeInt64> offsets( static_cast<std::size_t>( numPolys ) + 1, 0 );
+    std::vector<vtkTypeInt64> connectivity;
+    if ( numPolys > 0 )
+    {
+        vtkIdTypeArray* cells = surface->GetPolys()->GetData();
+        const vtkIdType* cell = cells->GetPointer( 0 );
+        connectivity.reserve( static_cast<std::size_t>( cells->GetNumberOfValues() - numPolys ) );
+
+        for ( vtkIdType c = 0; c < numPolys; c++ )
+        {
+            vtkIdType numCorners = *cell++;
+            connectivity.insert( connectivity.end(), cell, cell + numCorners );
+            offsets[c + 1] = offsets[c] + numCorners;
+            cell += numCorners;
+        }
+    }
+
+    vtkIntArray* materialIds = vtkIntArray::SafeDownCast( surface->GetCellData()->GetAbstractArray( "MaterialIds" ) );
+    vtkStringArray* materialNames = vtkStringArray::SafeDownCast( surface->GetFieldData()->GetAbstractArray( "MaterialNames" ) );
+    std::string names;
+
+    bool hasMaterials = materialIds != nullptr && materialNames != nullptr && materialIds->GetNumberOfComponents() == 1 &&
+                        materialIds->GetNumberOfTuples() == numPolys &&
+                        numPolys == surface->GetNumberOfCells();
+    if ( hasMaterials )
+    {
+        for ( vtkIdType n = 0; n < materialNames->GetNumberOfValues(); n++ )
+        {
+            names += materialNames->GetValue( n ) + "\n";
+        }
+    }
+
+    MeshCacheHeader header;
+    std::memset( &header, 0, sizeof( header ) );
+    std::memcpy( header.magic, MESH_CACHE_MAGIC, sizeof( header.magic ) );
+    fingerprint.copy( header.fingerprint, sizeof( header.fingerprint ) );
+    header.version = MESH_CACHE_VERSION;
+    header.numPoints = static_cast<unsigned long long>( numPoints );
+    header.numPolys = static_cast<unsigned long long>( numPolys );
+    header.numConnectivity = static_cast<unsigned long long>( connectivity.size() );
+    header.hasNormals = isFloatArray( normals, 3, numPoints ) ? 1 : 0;
+    header.hasTCoords = isFloatArray( tcoords, 2, numPoints ) ? 1 : 0;
+    header.hasMaterials = hasMaterials ? 1 : 0;
+    header.materialNameBytes = static_cast<unsigned long long>( names.size() );
+
+    MeshCacheLayout layout = computeLayout( header );
+
+    // Zeros for the padding between the arrays
+    static const char padding[MESH_CACHE_ALIGNMENT] = { 0 };
+
+    std::vector< std::pair<const void*, std::size_t> > parts;
+    std::size_t written = 0;
+
+    auto append = [&]( std::size_t offset, const void* data, std::size_t size )
+    {
+        parts.push_back( std::make_pair( static_cast<const void*>( padding ), offset - written ) );
+        parts.push_back( std::make_pair( data, size ) );
+        written = offset + size;
+    };
+
+    append( 0, &header, sizeof( header ) );
+    append( layout.points, surface->GetPoints()->GetData()->GetVoidPointer( 0 ), 3 * numPoints * sizeof( float ) );
+    if ( header.hasNormals )
+    {
+        append( layout.normals, normals->GetVoidPointer( 0 ), 3 * numPoints * sizeof( float ) );
+    }
+    if ( header.hasTCoords )
+    {
+        append( layout.tcoords, tcoords->GetVoidPointer( 0 ), 2 * numPoints * sizeof( float ) );
+    }
+    append( layout.offsets, offsets.data(), offsets.size() * sizeof( vtkTypeInt64 ) );
+    append( layout.connectivity, connectivity.data(), connectivity.size() * sizeof( vtkTypeInt64 ) );
+    if ( header.hasMaterials )
+    {
+        append( layout.materialIds, materialIds->GetVoidPointer( 0 ), static_cast<std::size_t>( header.numPolys ) * sizeof( int ) );
+        append( layout.materialNames, names.data(), names.size() );
+    }
+
+    return writeFileAtomically( fileName, parts );
+}
+
+vtkSmartPointer<vtkPolyData> readMeshCache( const std::string& fileName, const std::string& fingerprint )
+{
+    MappedFile* mapping = new MappedFile();
+    if ( !mapping->open( fileName ) || mapping->size() < sizeof( MeshCacheHeader ) )
+    {
+        delete mapping;
+        return nullptr;
+    }
+
+    MeshCacheHeader header;
+    std::memcpy( &header, mapping->data(), sizeof( header ) );
+
+    char expectedFingerprint[sizeof( header.fingerprint )] = { 0 };
+    fingerprint.copy( expectedFingerprint, sizeof( expectedFingerprint ) );
+
+    if ( std::memcmp( header.magic, MESH_CACHE_MAGIC, sizeof( header.magic ) ) != 0 || header.version != MESH_CACHE_VERSION ||
+         std::memcmp( header.fingerprint, expectedFingerprint, sizeof( header.fingerprint ) ) != 0 ||
+         header.numPoints == 0 || computeLayout( header ).end != mapping->size() )
+    {
+        delete mapping;
+        return nullptr;
+    }
+
+    MeshCacheLayout layout = computeLayout( header );
+    vtkIdType numPoints = static_cast<vtkIdType>( header.numPoints );
+    std::vector<vtkDataArray*> arrays;
+
+    // Point the arrays straight at the mapped pages, VTK must not free them (save = 1)
+    vtkSmartPointer<vtkFloatArray> pointArray = vtkSmartPointer<vtkFloatArray>::New();
+    pointArray->SetNumberOfComponents( 3 );
+    pointArray->SetArray( reinterpret_cast<float*>( mapping->data() + layout.points ), 3 * numPoints, 1 );
+    arrays.push_back( pointArray );
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData( pointArray );
+
+    vtkIdType numPolys = static_cast<vtkIdType>( header.numPolys );
+    vtkTypeInt64* offsetValues = reinterpret_cast<vtkTypeInt64*>( mapping->data() + layout.offsets );
+    vtkTypeInt64* connectivityValues = reinterpret_cast<vtkTypeInt64*>( mapping->data() + layout.connectivity );
+
+    vtkSmartPointer<vtkTypeInt64Array> offsets = vtkSmartPointer<vtkTypeInt64Array>::New();
+    offsets->SetArray( offsetValues, numPolys + 1, 1 );
+    arrays.push_back( offsets );
+
+    vtkSmartPointer<vtkTypeInt64Array> connectivity = vtkSmartPointer<vtkTypeInt64Array>::New();
+    connectivity->SetArray( connectivityValues, static_cast<vtkIdType>( header.numConnectivity ), 1 );
+    arrays.push_back( connectivity );
+
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+
+#if VTK_MAJOR_VERSION >= 9
+    // The cell array uses the two arrays as they are
+    polys->SetData( offsets, connectivity );
+#else
+    // Older versions only store the legacy layout, the cells are copied into it
+    vtkSmartPointer<vtkIdTypeArray> cellArray = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellArray->SetNumberOfValues( numPolys + static_cast<vtkIdType>( header.numConnectivity ) );
+    vtkIdType* cell = cellArray->GetPointer( 0 );
+    for ( vtkIdType c = 0; c < numPolys; c++ )
+    {
+        *cell++ = static_cast<vtkIdType>( offsetValues[c + 1] - offsetValues[c] );
+        for ( vtkTypeInt64 k = offsetValues[c]; k < offsetValues[c + 1]; k++ )
+        {
+            *cell++ = static_cast<vtkIdType>( connectivityValues[k] );
+        }
+    }
+    polys->SetCells( numPolys, cellArray );
+#endif
+
+    vtkSmartPointer<vtkPolyData> surface = vtkSmartPointer<vtkPolyData>::New();
+    surface->SetPoints( points );
+    surface->SetPolys( polys );
+
+    if ( header.hasNormals )
+    {
+        vtkSmartPointer<vtkFloatArray> normals = vtkSmartPointer<vtkFloatArray>::New();
+        normals->SetName( "Normals" );
+        normals->SetNumberOfComponents( 3 );
+        normals->SetArray( reinterpret_cast<float*>( mapping->data() + layout.normals ), 3 * numPoints, 1 );
+        surface->GetPointData()->SetNormals( normals );
+        arrays.push_back( normals );
+    }
+
+    if ( header.hasTCoords )
+    {
+        vtkSmartPointer<vtkFloatArray> tcoords = vtkSmartPointer<vtkFloatArray>::New();
+        tcoords->SetName( "TCoords" );
+        tcoords->SetNumberOfComponents( 2 );
+        tcoords->SetArray( reinterpret_cast<float*>( mapping->data() + layout.tcoords ), 2 * numPoints, 1 );
+        surface->GetPointData()->SetTCoords( tcoords );
+        arrays.push_back( tcoords );
+    }
+
+    if ( header.hasMaterials )
+    {
+        vtkSmartPointer<vtkIntArray> materialIds = vtkSmartPointer<vtkIntArray>::New();
+        materialIds->SetName( "MaterialIds" );
+        materialIds->SetArray( reinterpret_cast<int*>( mapping->data() + layout.materialIds ), static_cast<vtkIdType>( header.numPolys ), 1 );
+        surface->GetCellData()->AddArray( materialIds );
+        arrays.push_back( materialIds );
+
+        // The names are few and short, they are copied
+        vtkSmartPointer<vtkStringArray> materialNames = vtkSmartPointer<vtkStringArray>::New();
+        materialNames->SetName( "MaterialNames" );
+
+        const char* name = mapping->data() + layout.materialNames;
+        const char* namesEnd = name + header.materialNameBytes;
+        while ( name < namesEnd )
+        {
+            const char* nameEnd = std::find( name, namesEnd, '\n' );
+            materialNames->InsertNextValue( std::string( name, nameEnd ) );
+            name = nameEnd + 1;
+        }
+        surface->GetFieldData()->AddArray( materialNames );
+    }
+
+    attachMappingToArrays( arrays, mapping );
+
+    return surface;
+}
@@ -0,0 +1,45 @@
+/****************************************************************************
+*   meshCache.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Binary mesh files used to cache parsed OBJ surfaces.
+*                   Cached meshes are memory mapped when read back and the
+*                   VTK arrays point straight into the mapping.
+****************************************************************************/
+
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <string>
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   Write the points, polygons and (if present) point normals, texture coordinates and
+*   polygon materials ("MaterialIds" and "MaterialNames") of a surface to a binary mesh file. The points, normals and texture coordinates must
+*   be float arrays. The file is written atomically, so a partial file is never read.
+*
+*   @param   fileName      Path of the cache file
+*   @param   surface       Surface to write
+*   @param   fingerprint   String identifying the data the surface was created from
+*
+*   @returns TRUE if the file was written, FALSE otherwise
+*/
+bool writeMeshCache( const std::string& fileName, vtkPolyData* surface, const std::string& fingerprint );
+
+/*
+*   Read a surface written by writeMeshCache() by memory mapping the file.
+*   Nothing is parsed or copied, the arrays of the surface (including the offsets and
+*   connectivity of the polygons) use the mapped pages. VTK before 9 can only hold
+*   polygons in its legacy layout, there the polygons are copied into it.
+*
+*   @param   fileName      Path of the cache file
+*   @param   fingerprint   Expected fingerprint, the cache is ignored if it does not match
+*
+*   @returns The cached surface, or nullptr if there is no valid cache
+*/
+vtkSmartPointer<vtkPolyData> readMeshCache( const std::string& fileName, const std::string& fingerprint );
+
+#endif // MESHCACHE_H
@@ -0,0 +1,267 @@
+/****************************************************************************
+*   multiStartRegistration.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the multi-start pose search.
+****************************************************************************/
+
+#include "multiStartRegistration.hxx"
+#include "threadPool.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+#include <vtkMath.h>
+
+/*
+*   Centroid and covariance matrix of the points of a data set.
+*/
+static void computeMoments( vtkPolyData* polyData, double centroid[3], double covariance[3][3] )
+{
+    vtkIdType numPoints = polyData->GetNumberOfPoints();
+    double p[3];
+
+    centroid[0] = centroid[1] = centroid[2] = 0.0;
+    for ( vtkIdType i = 0; i < numPoints; i++ )
+    {
+        polyData->GetPoint( i, p );
+        centroid[0] += p[0];
+        centroid[1] += p[1];
+        centroid[2] += p[2];
+    }
+    for ( int c = 0; c < 3; c++ )
+    {
+        centroid[c] /= numPoints;
+    }
+
+    for ( int r = 0; r < 3; r++ )
+    {
+        for ( int c = 0; c < 3; c++ )
+        {
+            covariance[r][c] = 0.0;
+        }
+    }
+
+    for ( vtkIdType i = 0; i < numPoints; i++ )
+    {
+        polyData->GetPoint( i, p );
+        double d[3] = { p[0] - centroid[0], p[1] - centroid[1], p[2] - centroid[2] };
+        for ( int r = 0; r < 3; r++ )
+        {
+            for ( int c = 0; c < 3; c++ )
+            {
+                covariance[r][c] += d[r] * d[c] / numPoints;
+            }
+        }
+    }
+}
+
+/*
+*   Eigenvectors of a symmetric 3x3 matrix, as the columns of axes, largest eigenvalue first.
+*/
+static void principalAxes( double covariance[3][3], double axes[3][3] )
+{
+    double eigenvalues[3];
+    double* rows[3] = { covariance[0], covariance[1], covariance[2] };
+    double* axisRows[3] = { axes[0], axes[1], axes[2] };
+    vtkMath::Jacobi( rows, eigenvalues, axisRows );
+}
+
+/*
+*   Pose that rotates the source about its centroid and moves the centroid onto the target centroid.
+*/
+static vtkSmartPointer<vtkMatrix4x4> poseMatrix( const double rotation[3][3], const double sourceCentroid[3], const double targetCentroid[3] )
+{
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    for ( int r = 0; r < 3; r++ )
+    {
+        double translation = targetCentroid[r];
+        for ( int c = 0; c < 3; c++ )
+        {
+            matrix->SetElement( r, c, rotation[r][c] );
+            translation -= rotation[r][c] * sourceCentroid[c];
+        }
+        matrix->SetElement( r, 3, translation );
+    }
+    return matrix;
+}
+
+MultiStartRegistration::MultiStartRegistration() : _Matrix( vtkSmartPointer<vtkMatrix4x4>::New() ), _Seconds( 0.0 )
+{
+}
+
+void MultiStartRegistration::generateHypotheses()
+{
+    double sourceCentroid[3], targetCentroid[3], sourceCovariance[3][3], targetCovariance[3][3];
+    computeMoments( _Source, sourceCentroid, sourceCovariance );
+    computeMoments( _Target, targetCentroid, targetCovariance );
+
+    PoseHypothesis hypothesis;
+    hypothesis.residual = 0.0;
+    hypothesis.rounds = 0;
+    hypothesis.seconds = 0.0;
+
+    // Centroid matching, the start of a plain ICP run
+    double identity[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+    hypothesis.name = "centroids";
+    hypothesis.matrix = poseMatrix( identity, sourceCentroid, targetCentroid );
+    _Hypotheses.push_back( hypothesis );
+
+    // Principal axes alignments. Each axis can be flipped, 4 of the 8 combinations are rotations.
+    double sourceAxes[3][3], targetAxes[3][3];
+    principalAxes( sourceCovariance, sourceAxes );
+    principalAxes( targetCovariance, targetAxes );
+
+    int alignment = 0;
+    for ( int flips = 0; flips < 8; flips++ )
+    {
+        double sign[3] = { ( flips & 1 ) ? -1.0 : 1.0, ( flips & 2 ) ? -1.0 : 1.0, ( flips & 4 ) ? -1.0 : 1.0 };
+
+        // R = T * diag( sign ) * S^T maps the source axes onto the target axes
+        double rotation[3][3];
+        for ( int r = 0; r < 3; r++ )
+        {
+            for ( int c = 0; c < 3; c++ )
+            {
+                rotation[r][c] = 0.0;
+                for ( int k = 0; k < 3; k++ )
+                {
+                    rotation[r][c] += targetAxes[r][k] * sign[k] * sourceAxes[c][k];
+                }
+            }
+        }
+
+        if ( vtkMath::Determinant3x3( rotation ) < 0.0 )
+        {
+            continue;
+        }
+
+        std::stringstream name;
+        name << "principalAxes" << alignment++;
+        hypothesis.name = name.str();
+        hypothesis.matrix = poseMatrix( rotation, sourceCentroid, targetCentroid );
+        _Hypotheses.push_back( hypothesis );
+    }
+
+    // Uniformly distributed rotations (Shoemake's random unit quaternions)
+    std::mt19937 random( _Settings.seed );
+    std::uniform_real_distribution<double> uniform( 0.0, 1.0 );
+
+    for ( int n = 0; n < _Settings.numRandomRotations; n++ )
+    {
+        double u1 = uniform( random ), u2 = uniform( random ), u3 = uniform( random );
+        double w = std::sqrt( 1.0 - u1 ) * std::sin( 2.0 * vtkMath::Pi() * u2 );
+        double x = std::sqrt( 1.0 - u1 ) * std::cos( 2.0 * vtkMath::Pi() * u2 );
+        double y = std::sqrt( u1 ) * std::sin( 2.0 * vtkMath::Pi() * u3 );
+        double z = std::sqrt( u1 ) * std::cos( 2.0 * vtkMath::Pi() * u3 );
+
+        double rotation[3][3] = { { 1.0 - 2.0 * ( y * y + z * z ), 2.0 * ( x * y - w * z ), 2.0 * ( x * z + w * y ) },
+                                  { 2.0 * ( x * y + w * z ), 1.0 - 2.0 * ( x * x + z * z ), 2.0 * ( y * z - w * x ) },
+                                  { 2.0 * ( x * z - w * y ), 2.0 * ( y * z + w * x ), 1.0 - 2.0 * ( x * x + y * y ) } };
+
+        std::stringstream name;
+        name << "random" << n;
+        hypothesis.name = name.str();
+        hypothesis.matrix = poseMatrix( rotation, sourceCentroid, targetCentroid );
+        _Hypotheses.push_back( hypothesis );
+    }
+}
+
+bool MultiStartRegistration::update()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    _Hypotheses.clear();
+    _Matrix->Identity();
+    _Seconds = 0.0;
+
+    if ( _Source == nullptr || _Source->GetNumberOfPoints() == 0 || _Target == nullptr || _Target->GetNumberOfPoints() == 0 )
+    {
+        return false;
+    }
+
+    generateHypotheses();
+
+    // All runs search the same tree, it is only built once
+    PointKdTree tree;
+    tree.build( _Target->GetPoints() );
+
+    FastICPSettings icpSettings = _Settings.icp;
+    icpSettings.maxIterations = _Settings.roundIterations;
+    icpSettings.numThreads = 1;
+
+    std::vector<std::size_t> remaining( _Hypotheses.size() );
+    for ( std::size_t i = 0; i < remaining.size(); i++ )
+    {
+        remaining[i] = i;
+    }
+
+    ThreadPool pool( _Settings.numThreads );
+
+    while ( true )
+    {
+        for ( std::size_t n = 0; n < remaining.size(); n++ )
+        {
+            PoseHypothesis& hypothesis = _Hypotheses[remaining[n]];
+
+            pool.enqueue( [this, &hypothesis, &tree, &icpSettings]()
+            {
+                auto runStart = std::chrono::steady_clock::now();
+
+                FastICP icp;
+                icp.setSource( _Source );
+                icp.setTarget( _Target );
+                icp.setTargetTree( &tree );
+                icp.setInitialMatrix( hypothesis.matrix );
+                icp.setSettings( icpSettings );
+                icp.update();
+
+                hypothesis.matrix->DeepCopy( icp.getMatrix() );
+                hypothesis.residual = icp.getMeanDistance();
+                hypothesis.rounds++;
+                hypothesis.seconds += std::chrono::duration<double>( std::chrono::steady_clock::now() - runStart ).count();
+            } );
+        }
+        pool.wait();
+
+        // Keep the better half, ties go to the earlier hypothesis. A failed run (NaN residual) sorts last,
+        // comparing NaN directly would break the ordering std::sort needs.
+        const std::vector<PoseHypothesis>& hypotheses = _Hypotheses;
+        std::sort( remaining.begin(), remaining.end(), [&hypotheses]( std::size_t a, std::size_t b )
+        {
+            double residualA = std::isnan( hypotheses[a].residual ) ? std::numeric_limits<double>::infinity() : hypotheses[a].residual;
+            double residualB = std::isnan( hypotheses[b].residual ) ? std::numeric_limits<double>::infinity() : hypotheses[b].residual;
+            return ( residualA != residualB ) ? residualA < residualB : a < b;
+        } );
+
+        remaining.resize( ( remaining.size() + 1 ) / 2 );
+        if ( remaining.size() == 1 )
+        {
+            break;
+        }
+    }
+
+    _Matrix->DeepCopy( _Hypotheses[remaining[0]].matrix );
+    _Seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    return true;
+}
+
+bool writeHypothesisReport( const std::string& fileName, const std::vector<PoseHypothesis>& hypotheses )
+{
+    std::ofstream file( fileName );
+    file << "name,residual,rounds,seconds\n";
+
+    for ( std::size_t i = 0; i < hypotheses.size(); i++ )
+    {
+        file << hypotheses[i].name << "," << hypotheses[i].residual << "," << hypotheses[i].rounds << "," << hypotheses[i].seconds << "\n";
+    }
+
+    return static_cast<bool>( file );
+}
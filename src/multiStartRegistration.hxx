@@ -0,0 +1,122 @@
+/****************************************************************************
+*   multiStartRegistration.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Search for the starting pose of the registration by
+*                   running many rigid pose hypotheses concurrently.
+****************************************************************************/
+
+#ifndef MULTISTARTREGISTRATION_H
+#define MULTISTARTREGISTRATION_H
+
+#include "fastICP.hxx"
+
+#include <string>
+#include <vector>
+
+#include <vtkMatrix4x4.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   Parameters of the multi-start search.
+*/
+struct MultiStartSettings
+{
+    int             numRandomRotations; // Rotations sampled uniformly over SO(3), in addition to the principal axis alignments
+    int             roundIterations;    // ICP iterations every remaining hypothesis gets per round
+    FastICPSettings icp;                // Settings of the short ICP runs (maxIterations and numThreads are ignored)
+    unsigned int    numThreads;         // Hypotheses run at the same time (0 = one per core)
+    unsigned int    seed;               // Seed of the sampled rotations
+
+    MultiStartSettings() : numRandomRotations( 16 ), roundIterations( 10 ), numThreads( 0 ), seed( 1 ) { }
+};
+
+/*
+*   One starting pose and how it did.
+*/
+struct PoseHypothesis
+{
+    std::string                   name;         // centroids, principalAxes<n> or random<n>
+    vtkSmartPointer<vtkMatrix4x4> matrix;       // Pose after the last round it took part in
+    double                        residual;     // Mean closest point distance after the last round
+    int                           rounds;       // Number of rounds before it was pruned
+    double                        seconds;      // Wall time of all its ICP runs
+};
+
+/*
+*   Finds a good starting pose for the rigid registration of a source to a target surface.
+*
+*   The hypotheses are the centroid matching pose, the 4 proper rotations that align the
+*   principal axes of the two point clouds and random rotations about the centroids. All
+*   hypotheses get a short ICP run on a thread pool, then the worse half is pruned by its
+*   residual and the rest continue from where they stopped, until one is left.
+*
+*   Every hypothesis runs on one thread with a fixed seed and ties are broken by the order
+*   of the hypotheses, so the result only depends on the seed, not on the thread count.
+*/
+class MultiStartRegistration
+{
+    public:
+        MultiStartRegistration();
+
+        /*
+        *   Set the surface that is moved (the OBJ surface).
+        */
+        void setSource( vtkPolyData* source ) { _Source = source; }
+
+        /*
+        *   Set the surface the source is registered to (the DICOM surface).
+        */
+        void setTarget( vtkPolyData* target ) { _Target = target; }
+
+        void setSettings( const MultiStartSettings& settings ) { _Settings = settings; }
+
+        /*
+        *   Run all hypotheses.
+        *
+        *   @returns TRUE if a pose was found, FALSE if an input is missing or empty
+        */
+        bool update();
+
+        /*
+        *   @returns The pose of the best hypothesis, the starting pose for the final registration
+        */
+        vtkMatrix4x4* getMatrix() const { return _Matrix; }
+
+        /*
+        *   @returns Every hypothesis in the order they were generated
+        */
+        const std::vector<PoseHypothesis>& getHypotheses() const { return _Hypotheses; }
+
+        /*
+        *   @returns The wall time of the whole search
+        */
+        double getSeconds() const { return _Seconds; }
+
+    private:
+        vtkSmartPointer<vtkPolyData>  _Source;
+        vtkSmartPointer<vtkPolyData>  _Target;
+        vtkSmartPointer<vtkMatrix4x4> _Matrix;
+        MultiStartSettings            _Settings;
+        std::vector<PoseHypothesis>   _Hypotheses;
+        double                        _Seconds;
+
+        /*
+        *   Fill in the starting poses of all hypotheses.
+        */
+        void generateHypotheses();
+};
+
+/*
+*   Write the hypotheses of a search as CSV (name,residual,rounds,seconds).
+*
+*   @param   fileName     Path of the report
+*   @param   hypotheses   Hypotheses to write
+*
+*   @returns TRUE if the file was written, FALSE otherwise
+*/
+bool writeHypothesisReport( const std::string& fileName, const std::vector<PoseHypothesis>& hypotheses );
+
+#endif // MULTISTARTREGISTRATION_H
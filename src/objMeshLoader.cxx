@@ -0,0 +1,688 @@
+/****************************************************************************
+*   objMeshLoader.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the parallel OBJ parser and the mesh
+*                   loader.
+****************************************************************************/
+
+#include "objMeshLoader.hxx"
+#include "helperFunctions.hxx"
+#include "mappedFile.hxx"
+#include "meshCache.hxx"
+#include "parallelUtils.hxx"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkFieldData.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkIntArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkStringArray.h>
+#include <vtksys/SystemTools.hxx>
+
+// Chunks are at least this large, smaller files are parsed by fewer threads
+static const std::size_t OBJ_CHUNK_MIN_BYTES = 1 << 20;
+
+// Number of chunks per thread, so that chunks with many faces do not hold up the others
+static const std::size_t OBJ_CHUNKS_PER_THREAD = 4;
+
+namespace
+{
+
+enum OBJLineType
+{
+    OBJ_LINE_OTHER,
+    OBJ_LINE_VERTEX,
+    OBJ_LINE_NORMAL,
+    OBJ_LINE_TCOORD,
+    OBJ_LINE_FACE,
+    OBJ_LINE_MATERIAL,
+    OBJ_LINE_GROUP
+};
+
+/*
+*   Number of elements in a chunk, or the number defined before it after the prefix sum.
+*/
+struct OBJCounts
+{
+    std::size_t vertices;
+    std::size_t normals;
+    std::size_t tcoords;
+    std::size_t faces;
+    std::size_t corners;
+
+    OBJCounts() : vertices( 0 ), normals( 0 ), tcoords( 0 ), faces( 0 ), corners( 0 ) { }
+};
+
+/*
+*   Names of the materials ("usemtl") and groups ("g") selected in a chunk, in file order.
+*/
+struct OBJChunkParts
+{
+    std::vector<std::string> materials;
+    std::vector<std::string> groups;
+};
+
+inline bool isBlank( char c )
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/*
+*   Find the type of a line and move the text pointer past its keyword.
+*/
+OBJLineType readLineType( const char*& text )
+{
+    while ( isBlank( *text ) )
+    {
+        text++;
+    }
+
+    OBJLineType type = OBJ_LINE_OTHER;
+    std::size_t length = 1;
+
+    if ( text[0] == 'v' && isBlank( text[1] ) )
+    {
+        type = OBJ_LINE_VERTEX;
+    }
+    else if ( text[0] == 'v' && text[1] == 'n' && isBlank( text[2] ) )
+    {
+        type = OBJ_LINE_NORMAL;
+        length = 2;
+    }
+    else if ( text[0] == 'v' && text[1] == 't' && isBlank( text[2] ) )
+    {
+        type = OBJ_LINE_TCOORD;
+        length = 2;
+    }
+    else if ( text[0] == 'f' && isBlank( text[1] ) )
+    {
+        type = OBJ_LINE_FACE;
+    }
+    else if ( text[0] == 'g' && isBlank( text[1] ) )
+    {
+        type = OBJ_LINE_GROUP;
+    }
+    else if ( std::strncmp( text, "usemtl", 6 ) == 0 && isBlank( text[6] ) )
+    {
+        type = OBJ_LINE_MATERIAL;
+        length = 6;
+    }
+
+    if ( type != OBJ_LINE_OTHER )
+    {
+        text += length;
+    }
+    return type;
+}
+
+/*
+*   Number of whitespace separated tokens (face corners) in the rest of a line.
+*/
+std::size_t countTokens( const char* text )
+{
+    std::size_t count = 0;
+    while ( *text != '\0' )
+    {
+        while ( isBlank( *text ) )
+        {
+            text++;
+        }
+        if ( *text == '\0' )
+        {
+            break;
+        }
+
+        count++;
+        while ( *text != '\0' && !isBlank( *text ) )
+        {
+            text++;
+        }
+    }
+    return count;
+}
+
+/*
+*   The rest of a line without the surrounding blanks (the name of a material or group).
+*/
+std::string readName( const char* text )
+{
+    while ( isBlank( *text ) )
+    {
+        text++;
+    }
+
+    std::size_t length = std::strlen( text );
+    while ( length > 0 && isBlank( text[length - 1] ) )
+    {
+        length--;
+    }
+    return std::string( text, length );
+}
+
+/*
+*   Read up to count numbers into values.
+*
+*   @returns The number of values read
+*/
+int readFloats( const char* text, float* values, int count )
+{
+    for ( int i = 0; i < count; i++ )
+    {
+        char* next = nullptr;
+        values[i] = std::strtof( text, &next );
+        if ( next == text )
+        {
+            return i;
+        }
+        text = next;
+    }
+    return count;
+}
+
+/*
+*   Convert a 1-based or negative (relative) OBJ index to a 0-based index.
+*
+*   @param   index     Index as written in the file
+*   @param   defined   Number of elements defined before the line
+*   @param   total     Number of elements in the file
+*
+*   @returns The index, -1 if it is out of range
+*/
+vtkIdType resolveIndex( long long index, std::size_t defined, std::size_t total )
+{
+    long long resolved = ( index > 0 ) ? index - 1 : static_cast<long long>( defined ) + index;
+    return ( index != 0 && resolved >= 0 && resolved < static_cast<long long>( total ) ) ? static_cast<vtkIdType>( resolved ) : -1;
+}
+
+/*
+*   Copy one line into a terminated buffer, so numbers can be parsed without reading past the chunk.
+*
+*   @returns The start of the next line
+*/
+const char* nextLine( const char* begin, const char* end, std::string& line )
+{
+    const char* lineEnd = begin;
+    while ( lineEnd < end && *lineEnd != '\n' )
+    {
+        lineEnd++;
+    }
+
+    line.assign( begin, lineEnd );
+    return ( lineEnd < end ) ? lineEnd + 1 : end;
+}
+
+/*
+*   Pass 1: count the elements of a chunk and collect the materials and groups it selects.
+*/
+OBJCounts countChunk( const char* begin, const char* end, OBJChunkParts& parts )
+{
+    OBJCounts counts;
+    std::string line;
+
+    while ( begin < end )
+    {
+        begin = nextLine( begin, end, line );
+
+        const char* text = line.c_str();
+        switch ( readLineType( text ) )
+        {
+            case OBJ_LINE_VERTEX: counts.vertices++; break;
+            case OBJ_LINE_NORMAL: counts.normals++;  break;
+            case OBJ_LINE_TCOORD: counts.tcoords++;  break;
+            case OBJ_LINE_FACE:
+                counts.faces++;
+                counts.corners += countTokens( text );
+                break;
+            case OBJ_LINE_MATERIAL: parts.materials.push_back( readName( text ) ); break;
+            case OBJ_LINE_GROUP:    parts.groups.push_back( readName( text ) );    break;
+            default: break;
+        }
+    }
+
+    return counts;
+}
+
+/*
+*   Destination of the parsed elements.
+*/
+struct OBJArrays
+{
+    OBJCounts  totals;
+    float*     points;
+    float*     normals;
+    float*     tcoords;
+    vtkIdType* cells;           // Size and point ids of every face
+    vtkIdType* cornerNormals;   // Normal index of every face corner (-1 = none)
+    vtkIdType* cornerTCoords;   // Texture coordinate index of every face corner (-1 = none)
+    int*       partIds;         // Material (or group) of every face (-1 = none), nullptr if the file has neither
+
+    OBJLineType                       partLine;     // Statement that selects the part of the following faces
+    const std::map<std::string, int>* partIndex;    // Id of every part name
+};
+
+/*
+*   Pass 2: parse a chunk into the arrays, starting at the positions in first.
+*   firstPart is the part selected before the chunk.
+*
+*   @returns FALSE if a line is invalid
+*/
+bool parseChunk( const char* begin, const char* end, const OBJCounts& first, int firstPart, const OBJArrays& arrays )
+{
+    OBJCounts defined = first;
+    int part = firstPart;
+    std::size_t cellPosition = first.faces + first.corners;
+    std::string line;
+
+    while ( begin < end )
+    {
+        begin = nextLine( begin, end, line );
+
+        const char* text = line.c_str();
+        OBJLineType type = readLineType( text );
+
+        if ( type != OBJ_LINE_OTHER && type == arrays.partLine )
+        {
+            part = arrays.partIndex->find( readName( text ) )->second;
+            continue;
+        }
+
+        switch ( type )
+        {
+            case OBJ_LINE_VERTEX:
+                if ( readFloats( text, arrays.points + 3 * defined.vertices++, 3 ) != 3 )
+                {
+                    return false;
+                }
+                break;
+
+            case OBJ_LINE_NORMAL:
+                if ( readFloats( text, arrays.normals + 3 * defined.normals++, 3 ) != 3 )
+                {
+                    return false;
+                }
+                break;
+
+            case OBJ_LINE_TCOORD:
+            {
+                // The second coordinate is optional
+                float* tcoord = arrays.tcoords + 2 * defined.tcoords++;
+                tcoord[1] = 0.0f;
+                if ( readFloats( text, tcoord, 2 ) < 1 )
+                {
+                    return false;
+                }
+                break;
+            }
+
+            case OBJ_LINE_FACE:
+            {
+                std::size_t numCorners = countTokens( text );
+                arrays.cells[cellPosition++] = static_cast<vtkIdType>( numCorners );
+
+                // Corners are v, v/vt, v//vn or v/vt/vn
+                for ( std::size_t c = 0; c < numCorners; c++ )
+                {
+                    char* next = nullptr;
+                    vtkIdType vertex = resolveIndex( std::strtoll( text, &next, 10 ), defined.vertices, arrays.totals.vertices );
+                    vtkIdType tcoord = -1, normal = -1;
+
+                    if ( next == text || vertex < 0 )
+                    {
+                        return false;
+                    }
+                    text = next;
+
+                    if ( *text == '/' )
+                    {
+                        text++;
+                        if ( *text != '/' )
+                        {
+                            tcoord = resolveIndex( std::strtoll( text, &next, 10 ), defined.tcoords, arrays.totals.tcoords );
+                            if ( next == text || tcoord < 0 )
+                            {
+                                return false;
+                            }
+                            text = next;
+                        }
+
+                        if ( *text == '/' )
+                        {
+                            text++;
+                            normal = resolveIndex( std::strtoll( text, &next, 10 ), defined.normals, arrays.totals.normals );
+                            if ( next == text || normal < 0 )
+                            {
+                                return false;
+                            }
+                            text = next;
+                        }
+                    }
+
+                    arrays.cells[cellPosition++] = vertex;
+                    if ( arrays.cornerNormals != nullptr )
+                    {
+                        arrays.cornerNormals[defined.corners] = normal;
+                    }
+                    if ( arrays.cornerTCoords != nullptr )
+                    {
+                        arrays.cornerTCoords[defined.corners] = tcoord;
+                    }
+                    defined.corners++;
+                }
+
+                if ( arrays.partIds != nullptr )
+                {
+                    arrays.partIds[defined.faces] = part;
+                }
+                defined.faces++;
+                break;
+            }
+
+            default: break;
+        }
+    }
+
+    return true;
+}
+
+/*
+*   Attach an attribute given per face corner to the points, if every point has exactly one value.
+*
+*   @param   cells          Size and point ids of every face
+*   @param   cornerIndex    Index into values for every face corner (-1 = none)
+*   @param   values         The attribute values as defined in the file
+*   @param   components     Number of components of a value
+*   @param   numThreads     Number of threads for the copy
+*
+*   @returns The per-point array, or nullptr if a corner has no value or a point has different values
+*/
+vtkSmartPointer<vtkFloatArray> attributePerPoint( const OBJArrays& arrays, const vtkIdType* cornerIndex, const float* values,
+                                                  int components, unsigned int numThreads )
+{
+    std::size_t numPoints = arrays.totals.vertices;
+    std::vector<vtkIdType> pointIndex( numPoints, -1 );
+
+    std::size_t position = 0, corner = 0;
+    for ( std::size_t face = 0; face < arrays.totals.faces; face++ )
+    {
+        vtkIdType numCorners = arrays.cells[position++];
+        for ( vtkIdType c = 0; c < numCorners; c++, corner++ )
+        {
+            vtkIdType point = arrays.cells[position++];
+            vtkIdType index = cornerIndex[corner];
+
+            if ( index < 0 || ( pointIndex[point] >= 0 && pointIndex[point] != index ) )
+            {
+                return nullptr;
+            }
+            pointIndex[point] = index;
+        }
+    }
+
+    vtkSmartPointer<vtkFloatArray> output = vtkSmartPointer<vtkFloatArray>::New();
+    output->SetNumberOfComponents( components );
+    output->SetNumberOfTuples( static_cast<vtkIdType>( numPoints ) );
+    float* out = output->GetPointer( 0 );
+
+    // Points that are not used by any face get zeros
+    parallelFor( 0, numPoints, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t p = begin; p < end; p++ )
+        {
+            for ( int k = 0; k < components; k++ )
+            {
+                out[components * p + k] = ( pointIndex[p] >= 0 ) ? values[components * pointIndex[p] + k] : 0.0f;
+            }
+        }
+    }, numThreads );
+
+    return output;
+}
+
+} // namespace
+
+vtkSmartPointer<vtkPolyData> readOBJParallel( const std::string& fileName, unsigned int numThreads )
+{
+    MappedFile file;
+    if ( !file.open( fileName ) )
+    {
+        return nullptr;
+    }
+
+    const char* data = file.data();
+    std::size_t size = file.size();
+
+    // Split the file into chunks that start at the beginning of a line
+    std::size_t numChunks = std::min<std::size_t>( OBJ_CHUNKS_PER_THREAD * getNumberOfWorkerThreads( numThreads ),
+                                                   size / OBJ_CHUNK_MIN_BYTES + 1 );
+    std::vector<std::size_t> boundaries( numChunks + 1, size );
+    boundaries[0] = 0;
+
+    for ( std::size_t i = 1; i < numChunks; i++ )
+    {
+        std::size_t position = std::max( boundaries[i - 1], i * ( size / numChunks ) );
+        while ( position > 0 && position < size && data[position - 1] != '\n' )
+        {
+            position++;
+        }
+        boundaries[i] = position;
+    }
+
+    // Pass 1: count the elements of every chunk
+    std::vector<OBJCounts> counts( numChunks );
+    std::vector<OBJChunkParts> chunkParts( numChunks );
+    parallelFor( 0, numChunks, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t i = begin; i < end; i++ )
+        {
+            counts[i] = countChunk( data + boundaries[i], data + boundaries[i + 1], chunkParts[i] );
+        }
+    }, numThreads, 1 );
+
+    // Elements defined before every chunk
+    std::vector<OBJCounts> first( numChunks );
+    OBJArrays arrays;
+    for ( std::size_t i = 0; i < numChunks; i++ )
+    {
+        first[i] = arrays.totals;
+        arrays.totals.vertices += counts[i].vertices;
+        arrays.totals.normals += counts[i].normals;
+        arrays.totals.tcoords += counts[i].tcoords;
+        arrays.totals.faces += counts[i].faces;
+        arrays.totals.corners += counts[i].corners;
+    }
+
+    if ( arrays.totals.vertices == 0 )
+    {
+        return nullptr;
+    }
+
+    // Faces are split into parts by material, or by group if the file has no materials.
+    // Parts are numbered in the order they first appear, firstParts holds the part selected before every chunk.
+    bool hasMaterials = false, hasGroups = false;
+    for ( std::size_t i = 0; i < numChunks; i++ )
+    {
+        hasMaterials = hasMaterials || !chunkParts[i].materials.empty();
+        hasGroups = hasGroups || !chunkParts[i].groups.empty();
+    }
+
+    arrays.partLine = hasMaterials ? OBJ_LINE_MATERIAL : ( hasGroups ? OBJ_LINE_GROUP : OBJ_LINE_OTHER );
+
+    std::map<std::string, int> partIndex;
+    std::vector<std::string> partNames;
+    std::vector<int> firstParts( numChunks, -1 );
+    int part = -1;
+
+    for ( std::size_t i = 0; i < numChunks; i++ )
+    {
+        firstParts[i] = part;
+
+        const std::vector<std::string>& names = hasMaterials ? chunkParts[i].materials : chunkParts[i].groups;
+        for ( std::size_t n = 0; n < names.size(); n++ )
+        {
+            std::map<std::string, int>::const_iterator known = partIndex.find( names[n] );
+            if ( known == partIndex.end() )
+            {
+                known = partIndex.insert( std::make_pair( names[n], static_cast<int>( partNames.size() ) ) ).first;
+                partNames.push_back( names[n] );
+            }
+            part = known->second;
+        }
+    }
+    arrays.partIndex = &partIndex;
+
+    vtkSmartPointer<vtkFloatArray> pointArray = vtkSmartPointer<vtkFloatArray>::New();
+    pointArray->SetNumberOfComponents( 3 );
+    pointArray->SetNumberOfTuples( static_cast<vtkIdType>( arrays.totals.vertices ) );
+
+    vtkSmartPointer<vtkIdTypeArray> cellArray = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellArray->SetNumberOfValues( static_cast<vtkIdType>( arrays.totals.faces + arrays.totals.corners ) );
+
+    std::vector<float> normals( 3 * arrays.totals.normals ), tcoords( 2 * arrays.totals.tcoords );
+    std::vector<vtkIdType> cornerNormals( arrays.totals.normals > 0 ? arrays.totals.corners : 0 );
+    std::vector<vtkIdType> cornerTCoords( arrays.totals.tcoords > 0 ? arrays.totals.corners : 0 );
+
+    vtkSmartPointer<vtkIntArray> partIdArray;
+    if ( !partNames.empty() )
+    {
+        partIdArray = vtkSmartPointer<vtkIntArray>::New();
+        partIdArray->SetName( "MaterialIds" );
+        partIdArray->SetNumberOfValues( static_cast<vtkIdType>( arrays.totals.faces ) );
+    }
+
+    arrays.points = pointArray->GetPointer( 0 );
+    arrays.normals = normals.data();
+    arrays.tcoords = tcoords.data();
+    arrays.cells = ( arrays.totals.faces > 0 ) ? cellArray->GetPointer( 0 ) : nullptr;
+    arrays.cornerNormals = cornerNormals.empty() ? nullptr : cornerNormals.data();
+    arrays.cornerTCoords = cornerTCoords.empty() ? nullptr : cornerTCoords.data();
+    arrays.partIds = ( partIdArray != nullptr && arrays.totals.faces > 0 ) ? partIdArray->GetPointer( 0 ) : nullptr;
+
+    // Pass 2: parse all chunks straight into the arrays
+    std::vector<char> valid( numChunks, 0 );
+    parallelFor( 0, numChunks, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t i = begin; i < end; i++ )
+        {
+            valid[i] = parseChunk( data + boundaries[i], data + boundaries[i + 1], first[i], firstParts[i], arrays ) ? 1 : 0;
+        }
+    }, numThreads, 1 );
+
+    if ( std::find( valid.begin(), valid.end(), 0 ) != valid.end() )
+    {
+        return nullptr;
+    }
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData( pointArray );
+
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+    polys->SetCells( static_cast<vtkIdType>( arrays.totals.faces ), cellArray );
+
+    vtkSmartPointer<vtkPolyData> surface = vtkSmartPointer<vtkPolyData>::New();
+    surface->SetPoints( points );
+    surface->SetPolys( polys );
+
+    if ( partIdArray != nullptr )
+    {
+        // Faces before the first material (or group) statement form a part of their own
+        if ( std::find( arrays.partIds, arrays.partIds + arrays.totals.faces, -1 ) != arrays.partIds + arrays.totals.faces )
+        {
+            std::replace( arrays.partIds, arrays.partIds + arrays.totals.faces, -1, static_cast<int>( partNames.size() ) );
+            partNames.push_back( "default" );
+        }
+
+        vtkSmartPointer<vtkStringArray> nameArray = vtkSmartPointer<vtkStringArray>::New();
+        nameArray->SetName( "MaterialNames" );
+        nameArray->SetNumberOfValues( static_cast<vtkIdType>( partNames.size() ) );
+        for ( std::size_t n = 0; n < partNames.size(); n++ )
+        {
+            nameArray->SetValue( static_cast<vtkIdType>( n ), partNames[n] );
+        }
+
+        surface->GetCellData()->AddArray( partIdArray );
+        surface->GetFieldData()->AddArray( nameArray );
+    }
+
+    if ( arrays.cornerNormals != nullptr )
+    {
+        vtkSmartPointer<vtkFloatArray> pointNormals = attributePerPoint( arrays, arrays.cornerNormals, arrays.normals, 3, numThreads );
+        if ( pointNormals != nullptr )
+        {
+            pointNormals->SetName( "Normals" );
+            surface->GetPointData()->SetNormals( pointNormals );
+        }
+    }
+
+    if ( arrays.cornerTCoords != nullptr )
+    {
+        vtkSmartPointer<vtkFloatArray> pointTCoords = attributePerPoint( arrays, arrays.cornerTCoords, arrays.tcoords, 2, numThreads );
+        if ( pointTCoords != nullptr )
+        {
+            pointTCoords->SetName( "TCoords" );
+            surface->GetPointData()->SetTCoords( pointTCoords );
+        }
+    }
+
+    return surface;
+}
+
+OBJMeshLoader::OBJMeshLoader() :
+    _UseCache( true ), _NumThreads( 0 ), _LoadTime( 0.0 ), _LoadedFromCache( false )
+{
+}
+
+bool OBJMeshLoader::load()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    _Output = nullptr;
+    _LoadedFromCache = false;
+
+    if ( !vtksys::SystemTools::FileExists( _FileName ) )
+    {
+        std::cout << "ERROR: OBJ file " << _FileName << " does not exist.\n";
+        return false;
+    }
+
+    // The cache is invalid as soon as the OBJ file changes size or modification time
+    std::stringstream description;
+    description << _FileName << ":" << vtksys::SystemTools::FileLength( _FileName )
+                << ":" << vtksys::SystemTools::ModifiedTime( _FileName );
+    _Fingerprint = fingerprintString( description.str() );
+    std::string cachePath = _FileName + ".meshcache";
+
+    if ( _UseCache )
+    {
+        _Output = readMeshCache( cachePath, _Fingerprint );
+        _LoadedFromCache = ( _Output != nullptr );
+    }
+
+    if ( _Output == nullptr )
+    {
+        _Output = readOBJParallel( _FileName, _NumThreads );
+
+        if ( _Output == nullptr )
+        {
+            std::cout << "ERROR: Could not read OBJ file " << _FileName << "\n";
+        }
+        else if ( _UseCache && !writeMeshCache( cachePath, _Output, _Fingerprint ) )
+        {
+            std::cout << "WARNING: Could not write the mesh cache to " << cachePath << "\n";
+        }
+    }
+
+    _LoadTime = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    return _Output != nullptr;
+}
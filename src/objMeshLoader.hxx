@@ -0,0 +1,113 @@
+/****************************************************************************
+*   objMeshLoader.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Parallel OBJ parser with a memory mapped binary mesh
+*                   cache.
+****************************************************************************/
+
+#ifndef OBJMESHLOADER_H
+#define OBJMESHLOADER_H
+
+#include <string>
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   Parse a Wavefront OBJ file on several threads.
+*
+*   The file is memory mapped and split into chunks at line boundaries. A first pass
+*   counts the vertices, normals, texture coordinates and face corners of every chunk,
+*   so that the second pass can parse all chunks at the same time straight into the
+*   final arrays. Negative (relative) indices are supported.
+*
+*   Only the vertices ("v"), normals ("vn"), texture coordinates ("vt"), polygons ("f")
+*   and the material ("usemtl") or, in files without materials, group ("g") of every
+*   polygon are read. The material of every polygon is stored in the "MaterialIds" cell
+*   array and the names in the "MaterialNames" field data array, polygons before the
+*   first material statement are put in a material named "default".
+*   Normals and texture coordinates are attached to the points when every vertex has
+*   one of them. On texture seams vtkOBJReader duplicates the vertices; here the
+*   coordinates are dropped instead, so that the surface stays connected.
+*
+*   @param   fileName     Path of the OBJ file
+*   @param   numThreads   Number of threads (0 = one per core)
+*
+*   @returns The surface, or nullptr if the file could not be read or is invalid
+*/
+vtkSmartPointer<vtkPolyData> readOBJParallel( const std::string& fileName, unsigned int numThreads = 0 );
+
+/*
+*   Loads an OBJ surface.
+*
+*   The file is parsed with readOBJParallel() and the result is written next to it
+*   as a binary mesh (<file>.meshcache). Later runs memory map that file instead of
+*   parsing the OBJ file again, as long as its size and modification time are unchanged.
+*/
+class OBJMeshLoader
+{
+    public:
+        OBJMeshLoader();
+
+        /*
+        *   Set the OBJ file to load.
+        *
+        *   @param   fileName   Path of the OBJ file
+        */
+        void setFileName( const std::string& fileName ) { _FileName = fileName; }
+
+        /*
+        *   Enable or disable the mesh cache (enabled by default).
+        *
+        *   @param   useCache   TRUE to read and write the cache
+        */
+        void setUseCache( bool useCache ) { _UseCache = useCache; }
+
+        /*
+        *   Set the number of threads used to parse the file.
+        *
+        *   @param   numThreads   Number of threads (0 = one per core)
+        */
+        void setNumberOfThreads( unsigned int numThreads ) { _NumThreads = numThreads; }
+
+        /*
+        *   Load the surface (from the cache if possible).
+        *
+        *   @returns TRUE if a surface was loaded, FALSE otherwise
+        */
+        bool load();
+
+        /*
+        *   @returns The loaded surface
+        */
+        vtkSmartPointer<vtkPolyData> getOutput() const { return _Output; }
+
+        /*
+        *   @returns The fingerprint of the OBJ file (empty before load())
+        */
+        const std::string& getFingerprint() const { return _Fingerprint; }
+
+        /*
+        *   @returns The time taken by the last call to load(), in seconds
+        */
+        double getLoadTime() const { return _LoadTime; }
+
+        /*
+        *   @returns TRUE if the last call to load() used the mesh cache
+        */
+        bool loadedFromCache() const { return _LoadedFromCache; }
+
+    private:
+        std::string  _FileName;
+        bool         _UseCache;
+        unsigned int _NumThreads;
+
+        vtkSmartPointer<vtkPolyData> _Output;
+        std::string _Fingerprint;
+        double _LoadTime;
+        bool   _LoadedFromCache;
+};
+
+#endif // OBJMESHLOADER_H
@@ -0,0 +1,103 @@
+/****************************************************************************
+*   parallelUtils.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the parallel helper functions.
+****************************************************************************/
+
+#include "parallelUtils.hxx"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+unsigned int getNumberOfWorkerThreads( unsigned int requested )
+{
+    if ( requested > 0 )
+    {
+        return requested;
+    }
+
+    // hardware_concurrency() is allowed to return 0 when the value is not known
+    unsigned int cores = std::thread::hardware_concurrency();
+    return ( cores > 0 ) ? cores : 1;
+}
+
+void parallelFor( std::size_t begin, std::size_t end,
+                  const std::function<void( std::size_t, std::size_t )>& function,
+                  unsigned int numThreads, std::size_t grainSize )
+{
+    if ( end <= begin )
+    {
+        return;
+    }
+
+    std::size_t count = end - begin;
+    unsigned int threads = getNumberOfWorkerThreads( numThreads );
+
+    // Aim for a few chunks per thread so that slow chunks do not stall the others
+    if ( grainSize == 0 )
+    {
+        grainSize = std::max<std::size_t>( 1, count / ( 4 * threads ) );
+    }
+
+    std::size_t numChunks = ( count + grainSize - 1 ) / grainSize;
+    threads = static_cast<unsigned int>( std::min<std::size_t>( threads, numChunks ) );
+
+    if ( threads <= 1 )
+    {
+        function( begin, end );
+        return;
+    }
+
+    std::atomic<std::size_t> nextChunk( 0 );
+    std::exception_ptr error;
+    std::mutex errorMutex;
+
+    auto worker = [&]()
+    {
+        try
+        {
+            for ( std::size_t chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++ )
+            {
+                std::size_t chunkBegin = begin + chunk * grainSize;
+                std::size_t chunkEnd = std::min( end, chunkBegin + grainSize );
+                function( chunkBegin, chunkEnd );
+            }
+        }
+        catch ( ... )
+        {
+            // Keep the first error and stop handing out new chunks
+            std::lock_guard<std::mutex> lock( errorMutex );
+            if ( !error )
+            {
+                error = std::current_exception();
+            }
+            nextChunk = numChunks;
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve( threads - 1 );
+
+    for ( unsigned int i = 1; i < threads; i++ )
+    {
+        pool.emplace_back( worker );
+    }
+
+    worker();
+
+    for ( std::size_t i = 0; i < pool.size(); i++ )
+    {
+        pool[i].join();
+    }
+
+    if ( error )
+    {
+        std::rethrow_exception( error );
+    }
+}
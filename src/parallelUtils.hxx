@@ -0,0 +1,39 @@
+/****************************************************************************
+*   parallelUtils.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Small helpers for splitting work across CPU cores.
+****************************************************************************/
+
+#ifndef PARALLELUTILS_H
+#define PARALLELUTILS_H
+
+#include <cstddef>
+#include <functional>
+
+/*
+*   Get the number of worker threads to use for parallel work.
+*
+*   @param   requested   Number of threads requested by the caller (0 = one per core)
+*
+*   @returns The number of threads to use (always at least 1)
+*/
+unsigned int getNumberOfWorkerThreads( unsigned int requested = 0 );
+
+/*
+*   Run a function over the range [begin, end) split into contiguous chunks.
+*   Chunks are handed out dynamically so that uneven work is balanced between threads.
+*   The calling thread takes part in the work and the function returns once every chunk is done.
+*
+*   @param   begin        First index of the range
+*   @param   end          One past the last index of the range
+*   @param   function     Called as function( chunkBegin, chunkEnd ) for every chunk
+*   @param   numThreads   Number of threads to use (0 = one per core)
+*   @param   grainSize    Number of indices per chunk (0 = pick automatically)
+*/
+void parallelFor( std::size_t begin, std::size_t end,
+                  const std::function<void( std::size_t, std::size_t )>& function,
+                  unsigned int numThreads = 0, std::size_t grainSize = 0 );
+
+#endif // PARALLELUTILS_H
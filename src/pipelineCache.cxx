@@ -0,0 +1,277 @@
+/****************************************************************************
+*   pipelineCache.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the pipeline result cache.
+****************************************************************************/
+
+#include "pipelineCache.hxx"
+#include "helperFunctions.hxx"
+#include "mappedFile.hxx"
+#include "meshCache.hxx"
+#include "volumeCache.hxx"
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include <vtkDirectory.h>
+#include <vtksys/SystemTools.hxx>
+
+static const char* MATRIX_CACHE_MAGIC = "VTKREG_MATRIX";
+static const int   MATRIX_CACHE_VERSION = 1;
+
+// Temporary files older than this belong to writers that crashed (seconds)
+static const long STALE_TEMPORARY_SECONDS = 3600;
+
+namespace
+{
+
+/*
+*   All files of one cached result.
+*/
+struct CacheEntry
+{
+    long long                bytes;
+    long                     lastUsed;
+    std::vector<std::string> files;
+
+    CacheEntry() : bytes( 0 ), lastUsed( 0 ) { }
+};
+
+} // namespace
+
+PipelineCache::PipelineCache() : _MaximumBytes( 2048LL * 1024 * 1024 )
+{
+}
+
+void PipelineCache::setDirectory( const std::string& directory )
+{
+    _Directory = directory;
+
+    while ( _Directory.size() > 1 && ( _Directory.back() == '/' || _Directory.back() == '\\' ) )
+    {
+        _Directory.pop_back();
+    }
+}
+
+void PipelineCache::setMaximumSize( long long megabytes )
+{
+    _MaximumBytes = megabytes * 1024 * 1024;
+}
+
+std::string PipelineCache::makeKey( const std::string& inputKey, const std::string& parameters )
+{
+    return fingerprintString( inputKey + "|" + parameters );
+}
+
+vtkSmartPointer<vtkImageData> PipelineCache::readVolume( const std::string& key ) const
+{
+    if ( !isEnabled() )
+    {
+        return nullptr;
+    }
+
+    std::string path = entryPath( key );
+    vtkSmartPointer<vtkImageData> image = readVolumeCache( path, key );
+    if ( image != nullptr )
+    {
+        touch( path + ".vhdr" );
+        touch( path + ".raw" );
+    }
+    return image;
+}
+
+vtkSmartPointer<vtkPolyData> PipelineCache::readSurface( const std::string& key ) const
+{
+    if ( !isEnabled() )
+    {
+        return nullptr;
+    }
+
+    std::string path = entryPath( key ) + ".mesh";
+    vtkSmartPointer<vtkPolyData> surface = readMeshCache( path, key );
+    if ( surface != nullptr )
+    {
+        touch( path );
+    }
+    return surface;
+}
+
+bool PipelineCache::readMatrix( const std::string& key, vtkMatrix4x4* matrix ) const
+{
+    if ( !isEnabled() )
+    {
+        return false;
+    }
+
+    std::string path = entryPath( key ) + ".matrix";
+    std::ifstream file( path );
+
+    std::string magic, cachedKey;
+    int version = 0;
+    file >> magic >> version >> cachedKey;
+    if ( !file || magic != MATRIX_CACHE_MAGIC || version != MATRIX_CACHE_VERSION || cachedKey != key )
+    {
+        return false;
+    }
+
+    double elements[16];
+    for ( int i = 0; i < 16; i++ )
+    {
+        file >> elements[i];
+    }
+
+    if ( !file )
+    {
+        return false;
+    }
+
+    matrix->DeepCopy( elements );
+    touch( path );
+    return true;
+}
+
+bool PipelineCache::writeVolume( const std::string& key, vtkImageData* image ) const
+{
+    // GetActualMemorySize() is in kB, the file holds the same voxels
+    if ( !fits( 1024LL * static_cast<long long>( image->GetActualMemorySize() ) ) ||
+         !prepareDirectory() || !writeVolumeCache( entryPath( key ), image, key ) )
+    {
+        return false;
+    }
+
+    evict( key );
+    return true;
+}
+
+bool PipelineCache::writeSurface( const std::string& key, vtkPolyData* surface ) const
+{
+    if ( !fits( 1024LL * static_cast<long long>( surface->GetActualMemorySize() ) ) ||
+         !prepareDirectory() || !writeMeshCache( entryPath( key ) + ".mesh", surface, key ) )
+    {
+        return false;
+    }
+
+    evict( key );
+    return true;
+}
+
+bool PipelineCache::writeMatrix( const std::string& key, vtkMatrix4x4* matrix ) const
+{
+    if ( !prepareDirectory() )
+    {
+        return false;
+    }
+
+    std::stringstream text;
+    text.precision( 17 );
+    text << MATRIX_CACHE_MAGIC << " " << MATRIX_CACHE_VERSION << " " << key << "\n";
+
+    for ( int i = 0; i < 4; i++ )
+    {
+        for ( int j = 0; j < 4; j++ )
+        {
+            text << matrix->GetElement( i, j ) << ( j < 3 ? " " : "\n" );
+        }
+    }
+
+    std::string data = text.str();
+    if ( !writeFileAtomically( entryPath( key ) + ".matrix", data.data(), data.size() ) )
+    {
+        return false;
+    }
+
+    evict( key );
+    return true;
+}
+
+bool PipelineCache::prepareDirectory() const
+{
+    return isEnabled() && ( vtksys::SystemTools::FileIsDirectory( _Directory ) || vtksys::SystemTools::MakeDirectory( _Directory ) );
+}
+
+void PipelineCache::touch( const std::string& fileName ) const
+{
+    // Failing to mark the file only makes it an earlier candidate for eviction
+    vtksys::SystemTools::Touch( fileName, false );
+}
+
+void PipelineCache::evict( const std::string& keep ) const
+{
+    vtkSmartPointer<vtkDirectory> directory = vtkSmartPointer<vtkDirectory>::New();
+    if ( !directory->Open( _Directory.c_str() ) )
+    {
+        return;
+    }
+
+    long now = static_cast<long>( std::time( nullptr ) );
+    long long totalBytes = 0;
+    std::map<std::string, CacheEntry> entries;
+
+    for ( vtkIdType i = 0; i < directory->GetNumberOfFiles(); i++ )
+    {
+        std::string name = directory->GetFile( i );
+        std::string path = _Directory + "/" + name;
+
+        if ( name.empty() || name[0] == '.' || vtksys::SystemTools::FileIsDirectory( path ) )
+        {
+            continue;
+        }
+
+        long modified = vtksys::SystemTools::ModifiedTime( path );
+
+        // Files that are still being written are left alone, unless their writer is long gone
+        if ( name.find( ".tmp." ) != std::string::npos )
+        {
+            if ( now - modified > STALE_TEMPORARY_SECONDS )
+            {
+                vtksys::SystemTools::RemoveFile( path );
+            }
+            continue;
+        }
+
+        // The files of a result share the key and differ in their extension
+        CacheEntry& entry = entries[name.substr( 0, name.find( '.' ) )];
+        long long bytes = static_cast<long long>( vtksys::SystemTools::FileLength( path ) );
+
+        entry.bytes += bytes;
+        entry.lastUsed = std::max( entry.lastUsed, modified );
+        entry.files.push_back( path );
+        totalBytes += bytes;
+    }
+
+    if ( totalBytes <= _MaximumBytes )
+    {
+        return;
+    }
+
+    // The result that was just written stays, it fits the limit on its own (see fits())
+    std::vector<const CacheEntry*> order;
+    for ( std::map<std::string, CacheEntry>::const_iterator it = entries.begin(); it != entries.end(); ++it )
+    {
+        if ( it->first != keep )
+        {
+            order.push_back( &it->second );
+        }
+    }
+
+    std::sort( order.begin(), order.end(), []( const CacheEntry* a, const CacheEntry* b )
+    {
+        return a->lastUsed < b->lastUsed;
+    } );
+
+    // Another process may be evicting at the same time, deleting a file twice is harmless
+    for ( std::size_t i = 0; i < order.size() && totalBytes > _MaximumBytes; i++ )
+    {
+        for ( std::size_t j = 0; j < order[i]->files.size(); j++ )
+        {
+            vtksys::SystemTools::RemoveFile( order[i]->files[j] );
+        }
+        totalBytes -= order[i]->bytes;
+    }
+}
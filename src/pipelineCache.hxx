@@ -0,0 +1,122 @@
+/****************************************************************************
+*   pipelineCache.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    On-disk cache of the intermediate results of the
+*                   pipeline (smoothed volume, surfaces, registration),
+*                   so that a rerun with new parameters resumes from the
+*                   last stage whose inputs did not change.
+****************************************************************************/
+
+#ifndef PIPELINECACHE_H
+#define PIPELINECACHE_H
+
+#include <string>
+
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   A directory of cached stage results, named by content keys.
+*
+*   The key of a result is a hash of the key of the data it was computed from and the
+*   parameters of the stage (see makeKey()), so a key changes whenever anything upstream
+*   changes and stale results are never looked up. Volumes are stored as raw volume files
+*   and surfaces as binary mesh files, both memory mapped when read back.
+*
+*   Several processes may use the same directory at once. Files are written to a temporary
+*   name and renamed, so readers only see complete files, and a result is the same whoever
+*   computes it. Reading a result marks it as used (its modification time). After every write
+*   the least recently used other results are deleted until the directory fits the size limit;
+*   results that another process has mapped stay readable by that process (or, on Windows,
+*   cannot be deleted and are tried again by the next eviction). A result larger than the
+*   limit is not written at all.
+*/
+class PipelineCache
+{
+    public:
+        PipelineCache();
+
+        /*
+        *   Set the cache directory, created on the first write. An empty directory disables the cache.
+        *
+        *   @param   directory   Path of the cache directory
+        */
+        void setDirectory( const std::string& directory );
+
+        /*
+        *   Set the size limit of the whole directory.
+        *
+        *   @param   megabytes   Maximum size of all cached results
+        */
+        void setMaximumSize( long long megabytes );
+
+        bool isEnabled() const { return !_Directory.empty(); }
+
+        /*
+        *   Key of a stage result.
+        *
+        *   @param   inputKey     Key (or fingerprint) of the data the stage works on
+        *   @param   parameters   Every parameter of the stage that changes its result
+        *
+        *   @returns The key, 16 hexadecimal characters
+        */
+        static std::string makeKey( const std::string& inputKey, const std::string& parameters );
+
+        /*
+        *   Read a cached result.
+        *
+        *   @returns The result, nullptr (or FALSE) if it is not in the cache or the cache is disabled
+        */
+        vtkSmartPointer<vtkImageData> readVolume( const std::string& key ) const;
+        vtkSmartPointer<vtkPolyData> readSurface( const std::string& key ) const;
+        bool readMatrix( const std::string& key, vtkMatrix4x4* matrix ) const;
+
+        /*
+        *   Store a result and evict the least recently used results if the cache is over its size.
+        *   Surfaces must have float points (see writeMeshCache()).
+        *
+        *   @returns TRUE if the result was written, FALSE otherwise (always FALSE if the cache is disabled
+        *            or the result is larger than the size limit)
+        */
+        bool writeVolume( const std::string& key, vtkImageData* image ) const;
+        bool writeSurface( const std::string& key, vtkPolyData* surface ) const;
+        bool writeMatrix( const std::string& key, vtkMatrix4x4* matrix ) const;
+
+    private:
+        std::string _Directory;
+        long long   _MaximumBytes;
+
+        /*
+        *   Path of the files of a result without the extension.
+        */
+        std::string entryPath( const std::string& key ) const { return _Directory + "/" + key; }
+
+        /*
+        *   Create the directory if it does not exist yet.
+        */
+        bool prepareDirectory() const;
+
+        /*
+        *   Mark a file as used now.
+        */
+        void touch( const std::string& fileName ) const;
+
+        /*
+        *   @returns TRUE if a result of this size can be stored without evicting itself
+        */
+        bool fits( long long bytes ) const { return bytes <= _MaximumBytes; }
+
+        /*
+        *   Delete the least recently used results until the directory fits the size limit,
+        *   and temporary files left behind by writers that did not finish.
+        *
+        *   @param   keep   Key of the result that was just written, it is never deleted
+        */
+        void evict( const std::string& keep ) const;
+};
+
+#endif // PIPELINECACHE_H
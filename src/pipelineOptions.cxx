@@ -0,0 +1,670 @@
+/****************************************************************************
+*   pipelineOptions.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the option parsing.
+****************************************************************************/
+
+#include "pipelineOptions.hxx"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+// Every level halves the resolution, beyond this the coarsest image is only a few voxels wide
+static const int MAX_PYRAMID_LEVELS = 6;
+
+// Config files can include other config files, deeper nesting is taken as a file that includes itself
+static const int MAX_CONFIG_DEPTH = 16;
+
+PipelineOptions::PipelineOptions() :
+    haveThresholds( false ), haveLowerThresh( false ), haveUpperThresh( false ), lowerThresh( 0 ), upperThresh( 0 ),
+    haveIsoValue( false ), isoValue( 0.0 ), fusedExtraction( true ),
+    cropToRegion( true ), regionMargin( 10.0 ), smoothingSlab( 0 ),
+    icpIterations( 75 ), decimationRatio( 0.5 ),
+    clusterDecimation( true ), decimationCellSize( 0.0 ),
+    distanceRegistration( false ),
+    fastICP( true ), icpTolerance( 1e-4 ), icpSampling( "random" ), icpSamples( 5000 ), icpTrim( 0.9 ),
+    pyramidLevels( 1 ),
+    multiStart( false ), multiStartRotations( 16 ), multiStartIterations( 10 ), seed( 1 ),
+    perVertebra( false ), vertebraMargin( 10.0 ), vertebraSmoothness( 0.0 ),
+    resliceSurface( false ),
+    surfaceMetrics( true ), distanceArray( false ), sliceReview( false ),
+    batch( false ), outputDirectory( "." ), numJobs( 0 ), saveResliced( false ),
+    useVolumeCache( true ), cacheSizeMB( 2048 ), lowMemory( false )
+{
+}
+
+void printUsage( const char* program )
+{
+    std::cout << "Usage: " << program << " <DICOM_Folder_Directory> <OBJ_File_Directory> [options]\n"
+              << "       " << program << " --manifest <file> [options]\n\n"
+              << "Options:\n"
+              << "  --lower <value>            Lower threshold\n"
+              << "  --upper <value>            Upper threshold\n"
+              << "  --isovalue <value>         Marching cubes isovalue (between 0-1, mask extraction only)\n"
+              << "  --extraction <mode>        Surface extraction: fused (default) or mask (threshold + marching cubes)\n"
+              << "  --no-roi                   Process the whole volume instead of cropping it to the thresholded region\n"
+              << "  --roi-margin <d>           Margin of the cropped region around the thresholded voxels (default 10)\n"
+              << "  --smoothing-slab <n>       Slices smoothed at once by a thread, bounds the smoothing memory (default 0 = volume / threads)\n"
+              << "  --icp-iterations <n>       Maximum number of ICP iterations (default 75)\n"
+              << "  --decimation <ratio>       Target reduction of the surface triangles (default 0.5)\n"
+              << "  --decimation-method <m>    clustering (default, parallel vertex clustering) or pro (vtkDecimatePro)\n"
+              << "  --decimation-cell <d>      Clustering: grid cell size, overrides the ratio (default from the ratio)\n"
+              << "  --registration <method>    icp (default) or distance (register to the distance field of the segmentation)\n"
+              << "  --icp-engine <engine>      ICP implementation: fast (default) or vtk\n"
+              << "  --icp-tolerance <value>    Fast ICP and distance: stop when the points move less than this per iteration (default 1e-4)\n"
+              << "  --icp-sampling <mode>      Fast ICP: OBJ points used for matching, all, random (default) or normals\n"
+              << "  --icp-samples <n>          Fast ICP: number of sampled OBJ points (default 5000)\n"
+              << "  --icp-trim <fraction>      Fast ICP and distance: fraction of closest points used in every iteration (default 0.9)\n"
+              << "  --pyramid-levels <n>       Register coarse to fine over n resolution levels, each half the previous (default 1)\n"
+              << "  --pyramid-iterations <l>   Iteration limit of every level, coarsest first (e.g. 40,20,5; default --icp-iterations)\n"
+              << "  --multi-start              Try many starting poses in parallel and keep the best (ICP registration only)\n"
+              << "  --multi-start-rotations <n> Multi-start: random rotations tried besides the principal axes (default 16)\n"
+              << "  --multi-start-iterations <n> Multi-start: ICP iterations between two prunings (default 10)\n"
+              << "  --seed <n>                 Seed of the random ICP sampling and rotations (default 1)\n"
+              << "  --per-vertebra             Also register every vertebra (OBJ material or group) on its own\n"
+              << "  --vertebra-margin <d>      Per-vertebra: margin of the matched DICOM region around a vertebra (default 10)\n"
+              << "  --vertebra-smoothness <w>  Per-vertebra: weight of the neighbouring vertebrae, 0 to 1 (default 0, independent)\n"
+              << "  --registered-surface <m>   mesh (default, transform the DICOM surface) or reslice (segment the resliced image)\n"
+              << "  --no-metrics               Do not measure the distances between the OBJ and the registered surface\n"
+              << "  --distance-array           Add the distance to the OBJ surface of every point to the registered surface\n"
+              << "  --review                   Scroll through the resliced image with the OBJ contour instead of the 3D scene\n"
+              << "  --batch                    Headless mode, no prompts and no rendering\n"
+              << "  --output <directory>       Directory for the batch results (default .)\n"
+              << "  --save-resliced            Also write the image resliced into the OBJ space (batch output)\n"
+              << "  --manifest <file>          Process every (DICOM, OBJ) pair in the file (implies --batch)\n"
+              << "  --jobs <n>                 Number of cases processed at the same time (default one per core)\n"
+              << "  --config <file>            Read options from a file (key = value per line)\n"
+              << "  --no-cache                 Do not read or write the DICOM volume cache, the OBJ mesh cache and the pipeline cache\n"
+              << "  --cache-dir <directory>    Pipeline cache of the smoothed volume, surfaces and registration (default <DICOM folder>/pipelineCache)\n"
+              << "  --cache-size <MB>          Size limit of the pipeline cache, least recently used results are deleted first (default 2048)\n"
+              << "  --low-memory               Free intermediate data early, 8-bit masks, smaller smoothing slabs; prints the peak memory\n"
+              << "  --profile <file>           Write per-stage timing, memory and size measurements (.json or .csv)\n";
+}
+
+/*
+*   Options that do not take a value.
+*/
+static bool isFlagOption( const std::string& key )
+{
+    return key == "batch" || key == "no-cache" || key == "save-resliced" || key == "multi-start" ||
+           key == "per-vertebra" || key == "no-roi" || key == "low-memory" ||
+           key == "no-metrics" || key == "distance-array" || key == "review";
+}
+
+/*
+*   Convert a string to a number, printing an error for invalid values.
+*/
+static bool toDouble( const std::string& key, const std::string& value, double& result )
+{
+    try
+    {
+        std::size_t used = 0;
+        result = std::stod( value, &used );
+        if ( used == value.size() )
+        {
+            return true;
+        }
+    }
+    catch ( const std::exception& ) { }
+
+    std::cout << "ERROR: Invalid value \"" << value << "\" for option " << key << ".\n";
+    return false;
+}
+
+static bool toInt( const std::string& key, const std::string& value, int& result )
+{
+    double number = 0.0;
+    if ( !toDouble( key, value, number ) )
+    {
+        return false;
+    }
+
+    // Casting a double outside the range of int is undefined
+    if ( !( number >= std::numeric_limits<int>::min() && number <= std::numeric_limits<int>::max() ) )
+    {
+        std::cout << "ERROR: Value " << value << " of option " << key << " is out of range.\n";
+        return false;
+    }
+
+    result = static_cast<int>( number );
+    if ( result != number )
+    {
+        std::cout << "ERROR: Option " << key << " expects a whole number.\n";
+        return false;
+    }
+
+    return true;
+}
+
+static bool isTrue( const std::string& value )
+{
+    return value.empty() || value == "1" || value == "true" || value == "on" || value == "yes";
+}
+
+static bool readConfigFile( const std::string& fileName, PipelineOptions& options, int depth );
+
+/*
+*   Apply a single option. Shared by the command line and config file parsers.
+*   configDepth is the number of config files the option was read from (0 on the command line).
+*/
+static bool applyOption( const std::string& key, const std::string& value, PipelineOptions& options, int configDepth )
+{
+    int intValue = 0;
+
+    if ( key == "lower" )
+    {
+        options.haveLowerThresh = true;
+        return toInt( key, value, options.lowerThresh );
+    }
+    else if ( key == "upper" )
+    {
+        options.haveUpperThresh = true;
+        return toInt( key, value, options.upperThresh );
+    }
+    else if ( key == "isovalue" )
+    {
+        options.haveIsoValue = true;
+        return toDouble( key, value, options.isoValue );
+    }
+    else if ( key == "extraction" )
+    {
+        if ( value == "fused" || value == "mask" )
+        {
+            options.fusedExtraction = ( value == "fused" );
+        }
+        else
+        {
+            std::cout << "ERROR: The extraction mode must be fused or mask.\n";
+            return false;
+        }
+    }
+    else if ( key == "no-roi" )
+    {
+        options.cropToRegion = !isTrue( value );
+    }
+    else if ( key == "roi-margin" )
+    {
+        if ( !toDouble( key, value, options.regionMargin ) || options.regionMargin < 0.0 )
+        {
+            std::cout << "ERROR: The region of interest margin must not be negative.\n";
+            return false;
+        }
+    }
+    else if ( key == "smoothing-slab" )
+    {
+        if ( !toInt( key, value, options.smoothingSlab ) || options.smoothingSlab < 0 )
+        {
+            std::cout << "ERROR: The smoothing slab must not be negative.\n";
+            return false;
+        }
+    }
+    else if ( key == "icp-iterations" )
+    {
+        if ( !toInt( key, value, options.icpIterations ) || options.icpIterations < 1 )
+        {
+            std::cout << "ERROR: The number of ICP iterations must be at least 1.\n";
+            return false;
+        }
+    }
+    else if ( key == "registration" )
+    {
+        if ( value == "icp" || value == "distance" )
+        {
+            options.distanceRegistration = ( value == "distance" );
+        }
+        else
+        {
+            std::cout << "ERROR: The registration method must be icp or distance.\n";
+            return false;
+        }
+    }
+    else if ( key == "icp-engine" )
+    {
+        if ( value == "fast" || value == "vtk" )
+        {
+            options.fastICP = ( value == "fast" );
+        }
+        else
+        {
+            std::cout << "ERROR: The ICP engine must be fast or vtk.\n";
+            return false;
+        }
+    }
+    else if ( key == "icp-tolerance" )
+    {
+        if ( !toDouble( key, value, options.icpTolerance ) || options.icpTolerance < 0.0 )
+        {
+            std::cout << "ERROR: The ICP tolerance must not be negative.\n";
+            return false;
+        }
+    }
+    else if ( key == "icp-sampling" )
+    {
+        if ( value != "all" && value != "random" && value != "normals" )
+        {
+            std::cout << "ERROR: The ICP sampling must be all, random or normals.\n";
+            return false;
+        }
+        options.icpSampling = value;
+    }
+    else if ( key == "icp-samples" )
+    {
+        if ( !toInt( key, value, options.icpSamples ) || options.icpSamples < 3 )
+        {
+            std::cout << "ERROR: The number of ICP samples must be at least 3.\n";
+            return false;
+        }
+    }
+    else if ( key == "icp-trim" )
+    {
+        if ( !toDouble( key, value, options.icpTrim ) || options.icpTrim <= 0.0 || options.icpTrim > 1.0 )
+        {
+            std::cout << "ERROR: The ICP trim fraction must be between 0 and 1.\n";
+            return false;
+        }
+    }
+    else if ( key == "decimation" )
+    {
+        if ( !toDouble( key, value, options.decimationRatio ) ||
+             options.decimationRatio < 0.0 || options.decimationRatio >= 1.0 )
+        {
+            std::cout << "ERROR: The decimation ratio must be between 0 and 1.\n";
+            return false;
+        }
+    }
+    else if ( key == "decimation-method" )
+    {
+        if ( value == "clustering" || value == "pro" )
+        {
+            options.clusterDecimation = ( value == "clustering" );
+        }
+        else
+        {
+            std::cout << "ERROR: The decimation method must be clustering or pro.\n";
+            return false;
+        }
+    }
+    else if ( key == "decimation-cell" )
+    {
+        if ( !toDouble( key, value, options.decimationCellSize ) || options.decimationCellSize <= 0.0 )
+        {
+            std::cout << "ERROR: The decimation cell size must be positive.\n";
+            return false;
+        }
+    }
+    else if ( key == "pyramid-levels" )
+    {
+        if ( !toInt( key, value, options.pyramidLevels ) || options.pyramidLevels < 1 || options.pyramidLevels > MAX_PYRAMID_LEVELS )
+        {
+            std::cout << "ERROR: The number of pyramid levels must be between 1 and " << MAX_PYRAMID_LEVELS << ".\n";
+            return false;
+        }
+    }
+    else if ( key == "pyramid-iterations" )
+    {
+        options.pyramidIterations.clear();
+
+        std::stringstream list( value );
+        std::string item;
+        while ( std::getline( list, item, ',' ) )
+        {
+            if ( !toInt( key, item, intValue ) || intValue < 1 )
+            {
+                std::cout << "ERROR: The pyramid iterations must be a comma separated list of numbers of at least 1.\n";
+                return false;
+            }
+            options.pyramidIterations.push_back( intValue );
+        }
+    }
+    else if ( key == "multi-start" )
+    {
+        options.multiStart = isTrue( value );
+    }
+    else if ( key == "multi-start-rotations" )
+    {
+        if ( !toInt( key, value, options.multiStartRotations ) || options.multiStartRotations < 0 )
+        {
+            std::cout << "ERROR: The number of multi-start rotations must not be negative.\n";
+            return false;
+        }
+    }
+    else if ( key == "multi-start-iterations" )
+    {
+        if ( !toInt( key, value, options.multiStartIterations ) || options.multiStartIterations < 1 )
+        {
+            std::cout << "ERROR: The number of multi-start iterations must be at least 1.\n";
+            return false;
+        }
+    }
+    else if ( key == "seed" )
+    {
+        if ( !toInt( key, value, intValue ) || intValue < 0 )
+        {
+            std::cout << "ERROR: The seed must not be negative.\n";
+            return false;
+        }
+        options.seed = static_cast<unsigned int>( intValue );
+    }
+    else if ( key == "per-vertebra" )
+    {
+        options.perVertebra = isTrue( value );
+    }
+    else if ( key == "vertebra-margin" )
+    {
+        if ( !toDouble( key, value, options.vertebraMargin ) || options.vertebraMargin <= 0.0 )
+        {
+            std::cout << "ERROR: The vertebra margin must be positive.\n";
+            return false;
+        }
+    }
+    else if ( key == "vertebra-smoothness" )
+    {
+        if ( !toDouble( key, value, options.vertebraSmoothness ) || options.vertebraSmoothness < 0.0 || options.vertebraSmoothness > 1.0 )
+        {
+            std::cout << "ERROR: The vertebra smoothness must be between 0 and 1.\n";
+            return false;
+        }
+    }
+    else if ( key == "registered-surface" )
+    {
+        if ( value == "mesh" || value == "reslice" )
+        {
+            options.resliceSurface = ( value == "reslice" );
+        }
+        else
+        {
+            std::cout << "ERROR: The registered surface must be mesh or reslice.\n";
+            return false;
+        }
+    }
+    else if ( key == "no-metrics" )
+    {
+        options.surfaceMetrics = !isTrue( value );
+    }
+    else if ( key == "distance-array" )
+    {
+        options.distanceArray = isTrue( value );
+    }
+    else if ( key == "review" )
+    {
+        options.sliceReview = isTrue( value );
+    }
+    else if ( key == "save-resliced" )
+    {
+        options.saveResliced = isTrue( value );
+    }
+    else if ( key == "batch" )
+    {
+        options.batch = isTrue( value );
+    }
+    else if ( key == "no-cache" )
+    {
+        options.useVolumeCache = !isTrue( value );
+    }
+    else if ( key == "cache-dir" )
+    {
+        options.cacheDirectory = value;
+    }
+    else if ( key == "cache-size" )
+    {
+        if ( !toInt( key, value, options.cacheSizeMB ) || options.cacheSizeMB < 1 )
+        {
+            std::cout << "ERROR: The cache size must be at least 1 MB.\n";
+            return false;
+        }
+    }
+    else if ( key == "low-memory" )
+    {
+        options.lowMemory = isTrue( value );
+    }
+    else if ( key == "output" )
+    {
+        options.outputDirectory = value;
+    }
+    else if ( key == "manifest" )
+    {
+        options.manifestFile = value;
+        options.batch = true;
+    }
+    else if ( key == "jobs" )
+    {
+        if ( !toInt( key, value, intValue ) || intValue < 0 )
+        {
+            std::cout << "ERROR: The number of jobs must not be negative.\n";
+            return false;
+        }
+        options.numJobs = static_cast<unsigned int>( intValue );
+    }
+    else if ( key == "profile" )
+    {
+        options.profileFile = value;
+    }
+    else if ( key == "config" )
+    {
+        return readConfigFile( value, options, configDepth + 1 );
+    }
+    else if ( key == "dicom" )
+    {
+        options.dicomDirectory = value;
+    }
+    else if ( key == "obj" )
+    {
+        options.objFile = value;
+    }
+    else
+    {
+        std::cout << "ERROR: Unknown option " << key << ".\n";
+        return false;
+    }
+
+    return true;
+}
+
+bool parseCommandLine( int argc, char* argv[], PipelineOptions& options )
+{
+    std::vector<std::string> positional;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        std::string arg = argv[i];
+
+        if ( arg.compare( 0, 2, "--" ) != 0 )
+        {
+            positional.push_back( arg );
+            continue;
+        }
+
+        std::string key = arg.substr( 2 );
+        std::string value;
+
+        if ( !isFlagOption( key ) )
+        {
+            if ( i + 1 >= argc )
+            {
+                std::cout << "ERROR: Option " << arg << " needs a value.\n";
+                return false;
+            }
+            value = argv[++i];
+        }
+
+        if ( !applyOption( key, value, options, 0 ) )
+        {
+            return false;
+        }
+    }
+
+    if ( positional.size() == 2 )
+    {
+        options.dicomDirectory = positional[0];
+        options.objFile = positional[1];
+    }
+    else if ( !positional.empty() )
+    {
+        std::cout << "ERROR: Expected a DICOM directory and an OBJ file.\n";
+        return false;
+    }
+
+    // Only one threshold would leave the other one at 0
+    if ( options.haveLowerThresh != options.haveUpperThresh )
+    {
+        std::cout << "ERROR: --lower and --upper must be given together.\n";
+        return false;
+    }
+    options.haveThresholds = options.haveLowerThresh && options.haveUpperThresh;
+
+    // An empty threshold range would find no voxels
+    if ( options.haveThresholds && options.lowerThresh > options.upperThresh )
+    {
+        std::cout << "ERROR: --lower must not be greater than --upper.\n";
+        return false;
+    }
+
+    if ( !options.pyramidIterations.empty() && static_cast<int>( options.pyramidIterations.size() ) != options.pyramidLevels )
+    {
+        std::cout << "ERROR: --pyramid-iterations needs one value for each of the " << options.pyramidLevels << " pyramid levels.\n";
+        return false;
+    }
+
+    if ( options.multiStart && options.distanceRegistration )
+    {
+        std::cout << "ERROR: --multi-start needs --registration icp.\n";
+        return false;
+    }
+
+    if ( options.manifestFile.empty() && ( options.dicomDirectory.empty() || options.objFile.empty() ) )
+    {
+        std::cout << "ERROR: No DICOM directory and OBJ file given.\n";
+        return false;
+    }
+
+    return true;
+}
+
+/*
+*   Remove leading and trailing whitespace.
+*/
+static std::string trim( const std::string& text )
+{
+    std::size_t first = text.find_first_not_of( " \t\r\n" );
+    if ( first == std::string::npos )
+    {
+        return "";
+    }
+
+    std::size_t last = text.find_last_not_of( " \t\r\n" );
+    return text.substr( first, last - first + 1 );
+}
+
+/*
+*   Read a config file included at the given depth of config files.
+*/
+static bool readConfigFile( const std::string& fileName, PipelineOptions& options, int depth )
+{
+    if ( depth > MAX_CONFIG_DEPTH )
+    {
+        std::cout << "ERROR: Config files are nested more than " << MAX_CONFIG_DEPTH << " deep, " << fileName << " probably includes itself.\n";
+        return false;
+    }
+
+    std::ifstream file( fileName );
+    if ( !file )
+    {
+        std::cout << "ERROR: Could not open config file " << fileName << ".\n";
+        return false;
+    }
+
+    std::string line;
+    while ( std::getline( file, line ) )
+    {
+        line = trim( line );
+        if ( line.empty() || line[0] == '#' )
+        {
+            continue;
+        }
+
+        std::size_t equals = line.find( '=' );
+        std::string key = trim( line.substr( 0, equals ) );
+        std::string value = ( equals == std::string::npos ) ? "" : trim( line.substr( equals + 1 ) );
+
+        if ( !applyOption( key, value, options, depth ) )
+        {
+            std::cout << "ERROR: Invalid line in config file " << fileName << ": " << line << "\n";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool readConfigFile( const std::string& fileName, PipelineOptions& options )
+{
+    return readConfigFile( fileName, options, 1 );
+}
+
+bool readManifest( const std::string& fileName, std::vector<RegistrationCase>& cases )
+{
+    std::ifstream file( fileName );
+    if ( !file )
+    {
+        std::cout << "ERROR: Could not open manifest " << fileName << ".\n";
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    std::set<std::string> names;
+
+    while ( std::getline( file, line ) )
+    {
+        lineNumber++;
+        line = trim( line );
+        if ( line.empty() || line[0] == '#' )
+        {
+            continue;
+        }
+
+        RegistrationCase registrationCase;
+        std::istringstream fields( line );
+        fields >> registrationCase.dicomDirectory >> registrationCase.objFile >> registrationCase.name;
+
+        if ( registrationCase.objFile.empty() )
+        {
+            std::cout << "ERROR: Line " << lineNumber << " of manifest " << fileName << " needs a DICOM directory and an OBJ file.\n";
+            return false;
+        }
+
+        if ( registrationCase.name.empty() )
+        {
+            std::stringstream name;
+            name << "case" << lineNumber;
+            registrationCase.name = name.str();
+        }
+
+        // Every case writes into a directory of its name within the output directory
+        if ( registrationCase.name.find_first_of( "/\\" ) != std::string::npos ||
+             registrationCase.name.find( ".." ) != std::string::npos || registrationCase.name == "." )
+        {
+            std::cout << "ERROR: Line " << lineNumber << " of manifest " << fileName << " uses the case name "
+                      << registrationCase.name << ", which is not a single directory name.\n";
+            return false;
+        }
+
+        if ( !names.insert( registrationCase.name ).second )
+        {
+            std::cout << "ERROR: Line " << lineNumber << " of manifest " << fileName << " uses the case name "
+                      << registrationCase.name << " again.\n";
+            return false;
+        }
+
+        cases.push_back( registrationCase );
+    }
+
+    return true;
+}
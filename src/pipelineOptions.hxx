@@ -0,0 +1,162 @@
+/****************************************************************************
+*   pipelineOptions.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Parameters of the registration pipeline and parsing of
+*                   the command line, config files and batch manifests.
+****************************************************************************/
+
+#ifndef PIPELINEOPTIONS_H
+#define PIPELINEOPTIONS_H
+
+#include <string>
+#include <vector>
+
+/*
+*   All parameters of the registration pipeline.
+*   Values that were not given on the command line or in a config file are
+*   asked for at the prompts (interactive mode only).
+*/
+struct PipelineOptions
+{
+    // Inputs of a single run
+    std::string dicomDirectory;
+    std::string objFile;
+
+    // Segmentation parameters
+    bool   haveThresholds;      // Both thresholds given, see haveLowerThresh and haveUpperThresh
+    bool   haveLowerThresh;
+    bool   haveUpperThresh;
+    int    lowerThresh;
+    int    upperThresh;
+    bool   haveIsoValue;
+    double isoValue;
+    bool   fusedExtraction;     // Extract the band surface directly instead of mask + marching cubes
+
+    // Crop the volume to the region around the voxels within the thresholds before smoothing it
+    bool   cropToRegion;
+    double regionMargin;        // Margin around the thresholded voxels (world units)
+
+    // Slices smoothed at once by a thread, bounds the smoothing buffers (0 = one slab per thread)
+    int    smoothingSlab;
+
+    // Registration parameters
+    int    icpIterations;
+    double decimationRatio;
+    bool   clusterDecimation;   // Parallel vertex clustering instead of vtkDecimatePro
+    double decimationCellSize;  // Vertex clustering: grid cell size (world units, 0 = from the decimation ratio)
+
+    // Register to the distance field of the segmentation instead of ICP on its surface
+    bool        distanceRegistration;
+
+    // ICP engine (fast multithreaded engine or vtkIterativeClosestPointTransform)
+    bool        fastICP;
+    double      icpTolerance;       // Fast engine and distance registration: stop when the mean point motion drops below this
+    std::string icpSampling;        // Fast engine: all, random or normals
+    int         icpSamples;         // Fast engine: number of sampled OBJ points
+    double      icpTrim;            // Fast engine and distance registration: fraction of closest points used in every iteration
+
+    // Coarse-to-fine registration, 1 = full resolution only
+    int              pyramidLevels;
+    std::vector<int> pyramidIterations;     // Iteration limit of every level, coarsest first (empty = icpIterations)
+
+    // Search the starting pose over many rotations instead of only matching the centroids (ICP registration only)
+    bool         multiStart;
+    int          multiStartRotations;   // Random rotations tried besides the centroid and principal axes poses
+    int          multiStartIterations;  // ICP iterations of a hypothesis between two prunings
+    unsigned int seed;                  // Seed of the random ICP sampling and the random rotations
+
+    // Register every vertebra (OBJ material or group) on its own after the rigid registration of the whole spine
+    bool   perVertebra;
+    double vertebraMargin;      // Margin around a vertebra within which DICOM surface points are matched (world units)
+    double vertebraSmoothness;  // Weight of the neighbouring vertebrae when smoothing the transforms (0 = independent)
+
+    // Registered surface from the resliced image instead of transforming the DICOM surface
+    bool resliceSurface;
+
+    // Distances between the OBJ surface and the registered DICOM surface after the registration
+    bool surfaceMetrics;
+    bool distanceArray;     // Add the distance of every point to the registered surface ("SurfaceDistance")
+
+    // Review the registration slice by slice (OBJ contour on the resliced image) instead of the 3D scene
+    bool sliceReview;
+
+    // Headless batch mode
+    bool         batch;
+    std::string  manifestFile;
+    std::string  outputDirectory;
+    unsigned int numJobs;
+    bool         saveResliced;      // Also write the image resliced into the OBJ space
+
+    // DICOM and OBJ loading
+    bool useVolumeCache;    // Also enables the OBJ mesh cache and the pipeline cache
+
+    // Cache of the smoothed volume, surfaces and registration (empty directory = <DICOM directory>/pipelineCache)
+    std::string cacheDirectory;
+    int         cacheSizeMB;
+
+    // Free every intermediate as soon as it is used, keep masks in 8 bits and report the peak memory
+    bool lowMemory;
+
+    // Per-stage instrumentation report (disabled when empty)
+    std::string profileFile;
+
+    PipelineOptions();
+};
+
+/*
+*   One registration case, a DICOM series and the OBJ surface to register to it.
+*/
+struct RegistrationCase
+{
+    std::string name;
+    std::string dicomDirectory;
+    std::string objFile;
+};
+
+/*
+*   Print the program usage and all available options.
+*
+*   @param   program   Name of the executable (argv[0])
+*/
+void printUsage( const char* program );
+
+/*
+*   Parse the command line. Options are applied in the order they are given,
+*   so options after --config override the values in the config file.
+*
+*   @param   argc      Number of arguements
+*   @param   argv      Arguements
+*   @param   options   Options to fill in
+*
+*   @returns TRUE if the command line is valid, FALSE otherwise
+*/
+bool parseCommandLine( int argc, char* argv[], PipelineOptions& options );
+
+/*
+*   Read options from a config file. Each line holds "key = value", where the key
+*   is the name of a command line option without the leading dashes.
+*   Empty lines and lines starting with # are ignored.
+*
+*   @param   fileName   Path to the config file
+*   @param   options    Options to fill in
+*
+*   @returns TRUE if the file was read and all keys are valid, FALSE otherwise
+*/
+bool readConfigFile( const std::string& fileName, PipelineOptions& options );
+
+/*
+*   Read a batch manifest. Each line holds a DICOM directory, an OBJ file and an
+*   optional case name separated by whitespace. Empty lines and lines starting
+*   with # are ignored. Cases without a name are named after their line number,
+*   every case needs its own name (it is the name of its output directory).
+*
+*   @param   fileName   Path to the manifest
+*   @param   cases      List of cases to fill in
+*
+*   @returns TRUE if the manifest was read, FALSE otherwise
+*/
+bool readManifest( const std::string& fileName, std::vector<RegistrationCase>& cases );
+
+#endif // PIPELINEOPTIONS_H
@@ -0,0 +1,152 @@
+/****************************************************************************
+*   pointKdTree.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the k-d tree.
+****************************************************************************/
+
+#include "pointKdTree.hxx"
+
+#include <algorithm>
+#include <limits>
+
+// Ranges with at most this many points are searched linearly
+static const std::size_t LEAF_SIZE = 8;
+
+void PointKdTree::build( vtkPoints* points )
+{
+    std::size_t numPoints = static_cast<std::size_t>( points->GetNumberOfPoints() );
+
+    // Coordinates in input order while the tree is being built
+    _Coordinates.resize( 3 * numPoints );
+    for ( std::size_t n = 0; n < numPoints; n++ )
+    {
+        points->GetPoint( static_cast<vtkIdType>( n ), &_Coordinates[3 * n] );
+    }
+
+    std::vector<long long> order( numPoints );
+    for ( std::size_t n = 0; n < numPoints; n++ )
+    {
+        order[n] = static_cast<long long>( n );
+    }
+
+    _Axes.assign( numPoints, 0 );
+    buildRange( 0, numPoints, order );
+
+    // Store the coordinates in tree order
+    std::vector<double> sorted( 3 * numPoints );
+    for ( std::size_t n = 0; n < numPoints; n++ )
+    {
+        std::copy( &_Coordinates[3 * order[n]], &_Coordinates[3 * order[n]] + 3, &sorted[3 * n] );
+    }
+
+    _Coordinates.swap( sorted );
+    _Ids.swap( order );
+}
+
+void PointKdTree::buildRange( std::size_t begin, std::size_t end, std::vector<long long>& order )
+{
+    if ( end - begin <= LEAF_SIZE )
+    {
+        return;
+    }
+
+    // Split along the axis with the largest spread
+    double lo[3] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+    double hi[3] = { -lo[0], -lo[1], -lo[2] };
+
+    for ( std::size_t n = begin; n < end; n++ )
+    {
+        const double* p = &_Coordinates[3 * order[n]];
+        for ( int axis = 0; axis < 3; axis++ )
+        {
+            lo[axis] = std::min( lo[axis], p[axis] );
+            hi[axis] = std::max( hi[axis], p[axis] );
+        }
+    }
+
+    int axis = 0;
+    if ( hi[1] - lo[1] > hi[axis] - lo[axis] ) axis = 1;
+    if ( hi[2] - lo[2] > hi[axis] - lo[axis] ) axis = 2;
+
+    std::size_t middle = begin + ( end - begin ) / 2;
+    const double* coordinates = _Coordinates.data();
+
+    std::nth_element( order.begin() + begin, order.begin() + middle, order.begin() + end,
+                      [coordinates, axis]( long long a, long long b )
+                      {
+                          return coordinates[3 * a + axis] < coordinates[3 * b + axis];
+                      } );
+
+    _Axes[middle] = static_cast<unsigned char>( axis );
+
+    buildRange( begin, middle, order );
+    buildRange( middle + 1, end, order );
+}
+
+long long PointKdTree::findClosestPoint( const double query[3], double closest[3] ) const
+{
+    if ( _Ids.empty() )
+    {
+        return -1;
+    }
+
+    double bestDistance2 = std::numeric_limits<double>::max();
+    std::size_t best = 0;
+    searchRange( 0, _Ids.size(), query, bestDistance2, best );
+
+    std::copy( &_Coordinates[3 * best], &_Coordinates[3 * best] + 3, closest );
+    return _Ids[best];
+}
+
+void PointKdTree::searchRange( std::size_t begin, std::size_t end, const double query[3],
+                               double& bestDistance2, std::size_t& best ) const
+{
+    if ( end - begin <= LEAF_SIZE )
+    {
+        for ( std::size_t n = begin; n < end; n++ )
+        {
+            const double* p = &_Coordinates[3 * n];
+            double dx = p[0] - query[0], dy = p[1] - query[1], dz = p[2] - query[2];
+            double distance2 = dx * dx + dy * dy + dz * dz;
+            if ( distance2 < bestDistance2 )
+            {
+                bestDistance2 = distance2;
+                best = n;
+            }
+        }
+        return;
+    }
+
+    std::size_t middle = begin + ( end - begin ) / 2;
+    const double* p = &_Coordinates[3 * middle];
+
+    double dx = p[0] - query[0], dy = p[1] - query[1], dz = p[2] - query[2];
+    double distance2 = dx * dx + dy * dy + dz * dz;
+    if ( distance2 < bestDistance2 )
+    {
+        bestDistance2 = distance2;
+        best = middle;
+    }
+
+    // Search the side of the query first, the other side only if it can hold a closer point
+    double offset = query[_Axes[middle]] - p[_Axes[middle]];
+
+    if ( offset < 0.0 )
+    {
+        searchRange( begin, middle, query, bestDistance2, best );
+        if ( offset * offset < bestDistance2 )
+        {
+            searchRange( middle + 1, end, query, bestDistance2, best );
+        }
+    }
+    else
+    {
+        searchRange( middle + 1, end, query, bestDistance2, best );
+        if ( offset * offset < bestDistance2 )
+        {
+            searchRange( begin, middle, query, bestDistance2, best );
+        }
+    }
+}
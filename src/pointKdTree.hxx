@@ -0,0 +1,64 @@
+/****************************************************************************
+*   pointKdTree.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Static k-d tree for closest point queries on a point set.
+****************************************************************************/
+
+#ifndef POINTKDTREE_H
+#define POINTKDTREE_H
+
+#include <cstddef>
+#include <vector>
+
+#include <vtkPoints.h>
+
+/*
+*   Balanced k-d tree over a fixed set of points.
+*
+*   The tree is implicit: the points are reordered so that every subtree is a contiguous
+*   range and its splitting point sits in the middle of the range. No node structures or
+*   pointers are stored, queries only touch one flat coordinate array, and small ranges
+*   at the bottom of the tree are searched linearly.
+*
+*   Queries are read only, so any number of threads can search the same tree at once.
+*/
+class PointKdTree
+{
+    public:
+        PointKdTree() { }
+
+        /*
+        *   Build the tree. Any previous content is replaced.
+        *
+        *   @param   points   Points to index
+        */
+        void build( vtkPoints* points );
+
+        /*
+        *   Find the point closest to a query position.
+        *
+        *   @param   query     Query position
+        *   @param   closest   Set to the position of the closest point
+        *
+        *   @returns The id of the closest point in the input of build(), -1 if the tree is empty
+        */
+        long long findClosestPoint( const double query[3], double closest[3] ) const;
+
+        /*
+        *   @returns The number of indexed points
+        */
+        std::size_t size() const { return _Ids.size(); }
+
+    private:
+        std::vector<double>        _Coordinates;    // x, y, z of every point, in tree order
+        std::vector<long long>     _Ids;            // Input id of every point, in tree order
+        std::vector<unsigned char> _Axes;           // Splitting axis of the range centred on each point
+
+        void buildRange( std::size_t begin, std::size_t end, std::vector<long long>& order );
+        void searchRange( std::size_t begin, std::size_t end, const double query[3],
+                          double& bestDistance2, std::size_t& best ) const;
+};
+
+#endif // POINTKDTREE_H
@@ -0,0 +1,246 @@
+/****************************************************************************
+*   regionOfInterest.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the region of interest search and
+*                   the cropping of volumes.
+****************************************************************************/
+
+#include "regionOfInterest.hxx"
+#include "parallelUtils.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+
+// Every ROI_SAMPLE_STEP-th voxel along every axis is thresholded
+static const int ROI_SAMPLE_STEP = 4;
+
+// Components with fewer samples than this fraction of the largest component are noise
+static const double ROI_MIN_COMPONENT_FRACTION = 0.01;
+
+namespace
+{
+
+/*
+*   Size and bounding box of a connected component of the sampled voxels, in sample coordinates.
+*/
+struct SampleComponent
+{
+    std::size_t count;
+    int         boxMin[3];
+    int         boxMax[3];
+};
+
+/*
+*   Threshold every ROI_SAMPLE_STEP-th voxel along every axis.
+*/
+template <typename T>
+void sampleBand( const T* scalars, const int dims[3], const int grid[3], double lower, double upper,
+                 unsigned int numThreads, std::vector<unsigned char>& inside )
+{
+    inside.assign( static_cast<std::size_t>( grid[0] ) * grid[1] * grid[2], 0 );
+
+    parallelFor( 0, static_cast<std::size_t>( grid[2] ), [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t gz = begin; gz < end; gz++ )
+        {
+            for ( int gy = 0; gy < grid[1]; gy++ )
+            {
+                const T* row = scalars + ( gz * ROI_SAMPLE_STEP * dims[1] + static_cast<std::size_t>( gy ) * ROI_SAMPLE_STEP ) * dims[0];
+                unsigned char* out = &inside[( gz * grid[1] + gy ) * grid[0]];
+
+                for ( int gx = 0; gx < grid[0]; gx++ )
+                {
+                    double value = static_cast<double>( row[gx * ROI_SAMPLE_STEP] );
+                    out[gx] = ( value >= lower && value <= upper ) ? 1 : 0;
+                }
+            }
+        }
+    }, numThreads );
+}
+
+/*
+*   Label the 26-connected components of the sampled voxels within the band.
+*/
+std::vector<SampleComponent> findComponents( const std::vector<unsigned char>& inside, const int grid[3] )
+{
+    std::vector<SampleComponent> components;
+    std::vector<char> visited( inside.size(), 0 );
+    std::vector<std::size_t> stack;
+
+    for ( std::size_t seed = 0; seed < inside.size(); seed++ )
+    {
+        if ( !inside[seed] || visited[seed] )
+        {
+            continue;
+        }
+
+        SampleComponent component;
+        component.count = 0;
+        for ( int axis = 0; axis < 3; axis++ )
+        {
+            component.boxMin[axis] = grid[axis];
+            component.boxMax[axis] = -1;
+        }
+
+        visited[seed] = 1;
+        stack.push_back( seed );
+
+        while ( !stack.empty() )
+        {
+            std::size_t index = stack.back();
+            stack.pop_back();
+
+            int p[3] = { static_cast<int>( index % grid[0] ), static_cast<int>( ( index / grid[0] ) % grid[1] ),
+                         static_cast<int>( index / ( static_cast<std::size_t>( grid[0] ) * grid[1] ) ) };
+
+            component.count++;
+            for ( int axis = 0; axis < 3; axis++ )
+            {
+                component.boxMin[axis] = std::min( component.boxMin[axis], p[axis] );
+                component.boxMax[axis] = std::max( component.boxMax[axis], p[axis] );
+            }
+
+            for ( int dz = -1; dz <= 1; dz++ )
+            {
+                for ( int dy = -1; dy <= 1; dy++ )
+                {
+                    for ( int dx = -1; dx <= 1; dx++ )
+                    {
+                        int q[3] = { p[0] + dx, p[1] + dy, p[2] + dz };
+                        if ( q[0] < 0 || q[1] < 0 || q[2] < 0 || q[0] >= grid[0] || q[1] >= grid[1] || q[2] >= grid[2] )
+                        {
+                            continue;
+                        }
+
+                        std::size_t neighbour = ( static_cast<std::size_t>( q[2] ) * grid[1] + q[1] ) * grid[0] + q[0];
+                        if ( inside[neighbour] && !visited[neighbour] )
+                        {
+                            visited[neighbour] = 1;
+                            stack.push_back( neighbour );
+                        }
+                    }
+                }
+            }
+        }
+
+        components.push_back( component );
+    }
+
+    return components;
+}
+
+} // namespace
+
+bool findRegionOfInterest( vtkImageData* image, double lower, double upper, double margin, unsigned int numThreads, int extent[6] )
+{
+    int* imageExtent = image->GetExtent();
+    int dims[3] = { imageExtent[1] - imageExtent[0] + 1, imageExtent[3] - imageExtent[2] + 1, imageExtent[5] - imageExtent[4] + 1 };
+
+    if ( dims[0] < 1 || dims[1] < 1 || dims[2] < 1 || image->GetNumberOfScalarComponents() != 1 )
+    {
+        return false;
+    }
+
+    int grid[3];
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        grid[axis] = ( dims[axis] + ROI_SAMPLE_STEP - 1 ) / ROI_SAMPLE_STEP;
+    }
+
+    std::vector<unsigned char> inside;
+    void* scalars = image->GetScalarPointer();
+
+    switch ( image->GetScalarType() )
+    {
+        vtkTemplateMacro( sampleBand( static_cast<const VTK_TT*>( scalars ), dims, grid, lower, upper, numThreads, inside ) );
+        default:
+            return false;
+    }
+
+    std::vector<SampleComponent> components = findComponents( inside, grid );
+    if ( components.empty() )
+    {
+        return false;
+    }
+
+    std::size_t largest = 0;
+    for ( std::size_t c = 0; c < components.size(); c++ )
+    {
+        largest = std::max( largest, components[c].count );
+    }
+
+    int boxMin[3] = { grid[0], grid[1], grid[2] }, boxMax[3] = { -1, -1, -1 };
+    for ( std::size_t c = 0; c < components.size(); c++ )
+    {
+        if ( components[c].count < ROI_MIN_COMPONENT_FRACTION * largest )
+        {
+            continue;
+        }
+
+        for ( int axis = 0; axis < 3; axis++ )
+        {
+            boxMin[axis] = std::min( boxMin[axis], components[c].boxMin[axis] );
+            boxMax[axis] = std::max( boxMax[axis], components[c].boxMax[axis] );
+        }
+    }
+
+    // Voxels between the samples can be within the band as well, so grow the box by one step besides the margin
+    double* spacing = image->GetSpacing();
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        int grow = ROI_SAMPLE_STEP + static_cast<int>( std::ceil( margin / std::fabs( spacing[axis] ) ) );
+        int first = std::max( 0, boxMin[axis] * ROI_SAMPLE_STEP - grow );
+        int last = std::min( dims[axis] - 1, boxMax[axis] * ROI_SAMPLE_STEP + grow );
+
+        extent[2 * axis] = imageExtent[2 * axis] + first;
+        extent[2 * axis + 1] = imageExtent[2 * axis] + last;
+    }
+
+    return true;
+}
+
+vtkSmartPointer<vtkImageData> cropImage( vtkImageData* image, const int extent[6], unsigned int numThreads )
+{
+    int* imageExtent = image->GetExtent();
+    int imageDims[2] = { imageExtent[1] - imageExtent[0] + 1, imageExtent[3] - imageExtent[2] + 1 };
+    int dims[3] = { extent[1] - extent[0] + 1, extent[3] - extent[2] + 1, extent[5] - extent[4] + 1 };
+
+    vtkSmartPointer<vtkImageData> cropped = vtkSmartPointer<vtkImageData>::New();
+    cropped->SetOrigin( image->GetOrigin() );
+    cropped->SetSpacing( image->GetSpacing() );
+    cropped->SetExtent( extent[0], extent[1], extent[2], extent[3], extent[4], extent[5] );
+    cropped->AllocateScalars( image->GetScalarType(), image->GetNumberOfScalarComponents() );
+
+    vtkDataArray* inputScalars = image->GetPointData()->GetScalars();
+    if ( inputScalars->GetName() != nullptr )
+    {
+        cropped->GetPointData()->GetScalars()->SetName( inputScalars->GetName() );
+    }
+
+    // Copy the rows of the region, they are contiguous in both images
+    std::size_t voxelBytes = static_cast<std::size_t>( image->GetScalarSize() ) * image->GetNumberOfScalarComponents();
+    std::size_t rowBytes = dims[0] * voxelBytes;
+    const char* input = static_cast<const char*>( image->GetScalarPointer() );
+    char* output = static_cast<char*>( cropped->GetScalarPointer() );
+
+    parallelFor( 0, static_cast<std::size_t>( dims[1] ) * dims[2], [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t row = begin; row < end; row++ )
+        {
+            std::size_t y = extent[2] - imageExtent[2] + row % dims[1];
+            std::size_t z = extent[4] - imageExtent[4] + row / dims[1];
+            std::size_t offset = ( ( z * imageDims[1] + y ) * imageDims[0] + ( extent[0] - imageExtent[0] ) ) * voxelBytes;
+
+            std::memcpy( output + row * rowBytes, input + offset, rowBytes );
+        }
+    }, numThreads );
+
+    return cropped;
+}
@@ -0,0 +1,48 @@
+/****************************************************************************
+*   regionOfInterest.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Find the part of a volume that holds the segmented
+*                   structure and crop the volume to it, so that the
+*                   filters only run on that region.
+****************************************************************************/
+
+#ifndef REGIONOFINTEREST_H
+#define REGIONOFINTEREST_H
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   Find the extent of the voxels within a threshold band.
+*
+*   Only every few voxels along every axis are looked at, in parallel. The connected components
+*   of the sampled voxels within the band are labelled and the box around all components that are
+*   not much smaller than the largest one is taken, so isolated noise voxels do not widen it. The
+*   box is grown by one sample step and by the margin and clipped to the extent of the image.
+*
+*   @param   image        Volume to search
+*   @param   lower        Lower limit of the threshold band
+*   @param   upper        Upper limit of the threshold band
+*   @param   margin       Distance the box is grown by (world units)
+*   @param   numThreads   Number of threads (0 = one per core)
+*   @param   extent       Set to the extent of the region
+*
+*   @returns TRUE if a region was found, FALSE if no sampled voxel is within the band
+*/
+bool findRegionOfInterest( vtkImageData* image, double lower, double upper, double margin, unsigned int numThreads, int extent[6] );
+
+/*
+*   Copy a sub-extent of an image into a new image. The cropped image keeps the origin and
+*   spacing of the input and its extent is the sub-extent, so every voxel keeps its world position.
+*
+*   @param   image        Volume to crop
+*   @param   extent       Sub-extent to keep, within the extent of the image
+*   @param   numThreads   Number of threads for the copy (0 = one per core)
+*
+*   @returns The cropped image
+*/
+vtkSmartPointer<vtkImageData> cropImage( vtkImageData* image, const int extent[6], unsigned int numThreads = 0 );
+
+#endif // REGIONOFINTEREST_H
@@ -0,0 +1,838 @@
+/****************************************************************************
+*   registrationBenchmark.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Benchmarks of the segmentation and registration stages
+*                   on the bundled data and on synthetic volumes.
+*
+*                   Usage: registrationBenchmark [options]
+*                     --dicom <dir>          DICOM series to benchmark (e.g. img/Sawbones)
+*                     --obj <file>           OBJ surface registered to the series
+*                     --sizes <n,n,...>      Synthetic volume sizes, e.g. 256,512,1024 (default 256)
+*                     --threads <n,n,...>    Thread counts to run every stage with (default 1 and all cores)
+*                     --repeat <n>           Runs per stage, the median is reported (default 3)
+*                     --lower/--upper        Threshold band (default -800 and -600)
+*                     --isovalue <value>     Marching cubes isovalue (default 0.5)
+*                     --output <file>        Write the results as CSV
+*                     --baseline <file>      Compare against a stored results file
+*                     --tolerance <ratio>    Allowed slowdown against the baseline (default 0.15)
+*
+*                   The program exits with a failure when a stage is slower
+*                   than the baseline by more than the tolerance.
+****************************************************************************/
+
+#include "helperFunctions.hxx"
+#include "dicomSeriesLoader.hxx"
+#include "bandIsosurface.hxx"
+#include "distanceRegistration.hxx"
+#include "fastICP.hxx"
+#include "gaussianSmooth.hxx"
+#include "objMeshLoader.hxx"
+#include "parallelUtils.hxx"
+#include "regionOfInterest.hxx"
+#include "surfaceDistance.hxx"
+#include "surfaceTransform.hxx"
+#include "vertebraRegistration.hxx"
+#include "vertexClustering.hxx"
+
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <map>
+
+#include <vtkMultiThreader.h>
+#include <vtkPointData.h>
+#include <vtkSMPTools.h>
+
+/*
+*   Data passed from one stage to the next.
+*/
+struct BenchmarkData
+{
+    std::string name;
+    vtkSmartPointer<vtkImageData> uncropped;    // Input of the regionOfInterest stage, which sets image
+    vtkSmartPointer<vtkImageData> image;
+    vtkSmartPointer<vtkImageData> smoothed;
+    vtkSmartPointer<vtkImageData> mask;
+    vtkSmartPointer<vtkPolyData>  surface;
+    vtkSmartPointer<vtkPolyData>  bandSurface;
+    vtkSmartPointer<vtkPolyData>  decimated;
+    vtkSmartPointer<vtkPolyData>  clustered;       // Decimated by vertex clustering instead of vtkDecimatePro
+    vtkSmartPointer<vtkPolyData>  source;
+    vtkSmartPointer<vtkMatrix4x4> matrix;
+    vtkSmartPointer<vtkMatrix4x4> fastMatrix;
+    vtkSmartPointer<vtkMatrix4x4> clusteredMatrix;
+    vtkSmartPointer<vtkMatrix4x4> distanceMatrix;
+};
+
+/*
+*   Parameters shared by all stages.
+*/
+struct BenchmarkSettings
+{
+    int    lowerThresh;
+    int    upperThresh;
+    double isoValue;
+    double decimationRatio;
+    int    icpIterations;
+    double regionMargin;
+    int    repeat;
+};
+
+/*
+*   A single benchmark stage. Stages run in order, each using the output of the previous ones.
+*/
+struct BenchmarkStage
+{
+    const char* name;
+    std::function<void( BenchmarkData&, const BenchmarkSettings& )> run;
+};
+
+/*
+*   Result of one stage on one dataset with one thread count.
+*/
+struct BenchmarkResult
+{
+    std::string dataset;
+    std::string stage;
+    int         threads;
+    double      medianSeconds;
+    double      minSeconds;
+};
+
+/*
+*   Create a synthetic CT-like volume of size^3 voxels: air (-1000) with a hollow
+*   "vertebral column" of stacked rings and spheres whose walls lie in the bone band
+*   used for the Sawbones data. A little deterministic noise keeps the smoothing and
+*   thresholding stages honest.
+*/
+static vtkSmartPointer<vtkImageData> createSyntheticVolume( int size )
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions( size, size, size );
+    image->SetSpacing( 256.0 / size, 256.0 / size, 256.0 / size );
+    image->SetOrigin( 0.0, 0.0, 0.0 );
+    image->AllocateScalars( VTK_SHORT, 1 );
+
+    short* voxels = static_cast<short*>( image->GetScalarPointer() );
+    std::size_t sliceSize = static_cast<std::size_t>( size ) * size;
+    double centre = 0.5 * size;
+    int numBodies = 8;
+
+    parallelFor( 0, size, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t z = begin; z < end; z++ )
+        {
+            // Each "vertebra" is a sphere shell, joined by a ring along the column
+            double bodyLength = static_cast<double>( size ) / numBodies;
+            double bodyCentre = ( std::floor( z / bodyLength ) + 0.5 ) * bodyLength;
+
+            for ( int y = 0; y < size; y++ )
+            {
+                for ( int x = 0; x < size; x++ )
+                {
+                    double dx = x - centre, dy = y - centre * 0.8, dz = z - bodyCentre;
+                    double sphere = std::sqrt( dx * dx + dy * dy + dz * dz ) / ( 0.4 * bodyLength );
+                    double ring = std::sqrt( dx * dx + ( y - centre * 1.3 ) * ( y - centre * 1.3 ) ) / ( 0.12 * size );
+
+                    short value = -1000;
+                    if ( ( sphere > 0.8 && sphere < 1.0 ) || ( ring > 0.7 && ring < 1.0 ) )
+                    {
+                        value = -700;
+                    }
+
+                    // Cheap deterministic noise in [-20, 20]
+                    unsigned int hash = static_cast<unsigned int>( x * 73856093u ) ^ static_cast<unsigned int>( y * 19349663u ) ^ static_cast<unsigned int>( z * 83492791u );
+                    value = static_cast<short>( value + static_cast<int>( hash % 41 ) - 20 );
+
+                    voxels[z * sliceSize + static_cast<std::size_t>( y ) * size + x] = value;
+                }
+            }
+        }
+    } );
+
+    return image;
+}
+
+/*
+*   Move a surface by a small known rigid transform, used as the ICP source for synthetic data.
+*/
+static vtkSmartPointer<vtkPolyData> createDisplacedCopy( vtkPolyData* surface )
+{
+    double* centre = surface->GetCenter();
+
+    vtkSmartPointer<vtkTransform> transform = vtkSmartPointer<vtkTransform>::New();
+    transform->Translate( centre[0] + 4.0, centre[1] - 3.0, centre[2] + 2.0 );
+    transform->RotateWXYZ( 6.0, 0.3, 1.0, 0.2 );
+    transform->Translate( -centre[0], -centre[1], -centre[2] );
+
+    vtkSmartPointer<vtkTransformPolyDataFilter> transformFilter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
+    transformFilter->SetInputData( surface );
+    transformFilter->SetTransform( transform );
+    transformFilter->Update();
+
+    return transformFilter->GetOutput();
+}
+
+/*
+*   The stages of the pipeline in vtkRegistration, with the same parameters.
+*/
+static std::vector<BenchmarkStage> createStages()
+{
+    std::vector<BenchmarkStage> stages;
+
+    BenchmarkStage gaussian = { "gaussianSmooth", []( BenchmarkData& data, const BenchmarkSettings& )
+    {
+        vtkSmartPointer<vtkImageGaussianSmooth> filter = vtkSmartPointer<vtkImageGaussianSmooth>::New();
+        filter->SetInputData( data.image );
+        filter->SetStandardDeviation( 1.0 );
+        filter->SetRadiusFactors( 1.0, 1.0, 1.0 );
+        filter->SetDimensionality( 3 );
+        filter->Update();
+        data.smoothed = filter->GetOutput();
+    } };
+    stages.push_back( gaussian );
+
+    // The separable smoothing of the pipeline, one slab per thread and streamed through slabs of a few slices
+    BenchmarkStage separableGaussian = { "separableGaussian", []( BenchmarkData& data, const BenchmarkSettings& )
+    {
+        GaussianSmoothSettings smoothSettings;
+        smoothSettings.numThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+        data.smoothed = smoothGaussian( data.image, smoothSettings );
+    } };
+    stages.push_back( separableGaussian );
+
+    BenchmarkStage streamedGaussian = { "streamedGaussian", []( BenchmarkData& data, const BenchmarkSettings& )
+    {
+        GaussianSmoothSettings smoothSettings;
+        smoothSettings.slabSlices = 8;
+        smoothSettings.numThreads = vtkMultiThreader::GetGlobalMaximumNumberOfThreads();
+        data.smoothed = smoothGaussian( data.image, smoothSettings );
+    } };
+    stages.push_back( streamedGaussian );
+
+    BenchmarkStage threshold = { "threshold", []( BenchmarkData& data, const BenchmarkSettings& settings )
+    {
+        vtkSmartPointer<vtkImageThreshold> filter = vtkSmartPointer<vtkImageThreshold>::New();
+        filter->SetInputData( data.smoothed );
+        filter->ThresholdBetween( settings.lowerThresh, settings.upperThresh );
+        filter->ReplaceInOn();
+        filter->SetInValue( 1 );
+        filter->ReplaceOutOn();
+        filter->SetOutValue( 0 );
+        filter->SetOutputScalarTypeToFloat();
+        filter->Update();
+        data.mask = filter->GetOutput();
+    } };
+    stages.push_back( threshold );
+
+    BenchmarkStage marchingCubes = { "marchingCubes", []( BenchmarkData& data, const BenchmarkSettings& settings )
+    {
+        vtkSmartPointer<vtkMarchingCubes> filter = vtkSmartPointer<vtkMarchingCubes>::New();
+        filter->SetInputData( data.mask );
+        filter->ComputeNormalsOn();
+        filter->SetValue( 0, settings.isoValue );
+        filter->Update();
+        data.surface = filter->GetOutput();
+    } };
+    stages.push_back( marchingCubes );
+
+    // Fused threshold and isosurface extraction, the same segmentation as the two stages above in one pass
+    BenchmarkStage bandIsosurface = { "bandIsosurface", []( BenchmarkData& data, const BenchmarkSettings& settings )
+    {
+        data.bandSurface = extractBandSurface( data.smoothed, settings.lowerThresh, settings.upperThresh,
+                                               vtkMultiThreader::GetGlobalMaximumNumberOfThreads() );
+    } };
+    stages.push_back( bandIsosurface );
+
+    BenchmarkStage decimate = { "decimate", []( BenchmarkData& data, const BenchmarkSettings& settings )
+    {
+        vtkSmartPointer<vtkDecimatePro> filter = vtkSmartPointer<vtkDecimatePro>::New();
+        filter->SetInputData( data.surface );
+        filter->SetTargetReduction( settings.decimationRatio );
+        filter->Update();
+        data.decimated = filter->GetOutput();
+
+        // Synthetic datasets register a displaced copy of their own surface
+        if ( data.source == nullptr )
+        {
+            data.source = createDisplacedCopy( data.decimated );
+        }
+    } };
+    stages.push_back( decimate );
+
+    // The parallel vertex clustering of the pipeline, aiming for the same number of triangles
+    BenchmarkStage clusterDecimate = { "clusterDecimate", []( BenchmarkData& data, const BenchmarkSettings& settings )
+    {
+        VertexClusteringSettings clusteringSettings;
+        clusteringSettings.targetTriangles = static_cast<vtkIdType>( ( 1.0 - settings.decimationRatio ) * data.surface->GetNumberOfPolys() + 0.5 );
+        clusteringSettings.numThreads = static_cast<unsigned int>( vtkMultiThreader::GetGlobalMaximumNumberOfThreads() );
+        data.clustered = decimateByClustering( data.surface, clusteringSettings );
+    } };
+    stages.push_back( clusterDecimate );
+
+    BenchmarkStage icp = { "icp", []( BenchmarkData& data, const BenchmarkSettings& settings )
+    {
+        vtkSmartPointer<vtkIterativeClosestPointTransform> filter = vtkSmartPointer<vtkIterativeClosestPointTransform>::New();
+        filter->SetSource( data.source );
+        filter->SetTarget( data.decimated );
+        filter->SetMaximumNumberOfIterations( settings.icpIterations );
+        filter->GetLandmarkTransform()->SetModeToRigidBody();
+        filter->StartByMatchingCentroidsOn();
+        filter->Update();
+
+        data.matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+        data.matrix->DeepCopy( filter->GetMatrix() );
+    } };
+    stages.push_back( icp );
+
+    // The fast ICP engine on the same surfaces, with its default sampling and trimming
+    BenchmarkStage fastIcp = { "fastIcp", []( BenchmarkData& data, const BenchmarkSettings& settings )
+    {
+        FastICPSettings icpSettings;
+        icpSettings.maxIterations = settings.icpIterations;
+        icpSettings.numThreads = static_cast<unsigned int>( vtkMultiThreader::GetGlobalMaximumNumberOfThreads() );
+
+        FastICP filter;
+        filter.setSource( data.source );
+        filter.setTarget( data.decimated );
+        filter.setSettings( icpSettings );
+        filter.update();
+
+        data.fastMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+        data.fastMatrix->DeepCopy( filter.getMatrix() );
+    } };
+    stages.push_back( fastIcp );
+
+    // The fast ICP engine on the surface decimated by vertex clustering, for the accuracy of the two decimations
+    BenchmarkStage clusteredIcp = { "clusteredFastIcp", []( BenchmarkData& data, const BenchmarkSettings& settings )
+    {
+        FastICPSettings icpSettings;
+        icpSettings.maxIterations = settings.icpIterations;
+        icpSettings.numThreads = static_cast<unsigned int>( vtkMultiThreader::GetGlobalMaximumNumberOfThreads() );
+
+        FastICP filter;
+        filter.setSource( data.source );
+        filter.setTarget( data.clustered );
+        filter.setSettings( icpSettings );
+        filter.update();
+
+        data.clusteredMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+        data.clusteredMatrix->DeepCopy( filter.getMatrix() );
+    } };
+    stages.push_back( clusteredIcp );
+
+    // Every vertebra registered on its own from the fast ICP result. Synthetic sources have no materials and return at once.
+    BenchmarkStage perVertebra = { "perVertebra", []( BenchmarkData& data, const BenchmarkSettings& settings )
+    {
+        VertebraRegistrationSettings registrationSettings;
+        registrationSettings.icp.maxIterations = settings.icpIterations;
+        registrationSettings.numThreads = static_cast<unsigned int>( vtkMultiThreader::GetGlobalMaximumNumberOfThreads() );
+
+        VertebraRegistration registration;
+        registration.setSource( data.source );
+        registration.setTarget( data.decimated );
+        registration.setInitialMatrix( data.fastMatrix );
+        registration.setSettings( registrationSettings );
+        registration.update();
+    } };
+    stages.push_back( perVertebra );
+
+    // Distance field registration, straight from the smoothed volume without a surface of the target
+    BenchmarkStage distanceRegistration = { "distanceRegistration", []( BenchmarkData& data, const BenchmarkSettings& settings )
+    {
+        unsigned int numThreads = static_cast<unsigned int>( vtkMultiThreader::GetGlobalMaximumNumberOfThreads() );
+
+        DistanceField field;
+        field.build( data.smoothed, settings.lowerThresh, settings.upperThresh, 10.0, numThreads );
+
+        DistanceRegistrationSettings registrationSettings;
+        registrationSettings.maxIterations = settings.icpIterations;
+        registrationSettings.numThreads = numThreads;
+
+        DistanceFieldRegistration registration;
+        registration.setSource( data.source );
+        registration.setField( &field );
+        registration.setSettings( registrationSettings );
+        registration.update();
+
+        data.distanceMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+        data.distanceMatrix->DeepCopy( registration.getMatrix() );
+    } };
+    stages.push_back( distanceRegistration );
+
+    BenchmarkStage reslice = { "reslice", []( BenchmarkData& data, const BenchmarkSettings& )
+    {
+        vtkSmartPointer<vtkTransform> transform = vtkSmartPointer<vtkTransform>::New();
+        transform->SetMatrix( data.matrix );
+
+        vtkSmartPointer<vtkImageReslice> filter = vtkSmartPointer<vtkImageReslice>::New();
+        filter->SetInputData( data.smoothed );
+        filter->InterpolateOff();
+        filter->AutoCropOutputOn();
+        filter->SetResliceTransform( transform );
+        filter->Update();
+    } };
+    stages.push_back( reslice );
+
+    // The fast path of the pipeline, the DICOM surface moved into the OBJ space instead of the reslice above
+    BenchmarkStage surfaceTransform = { "transformSurface", []( BenchmarkData& data, const BenchmarkSettings& )
+    {
+        vtkSmartPointer<vtkMatrix4x4> inverse = vtkSmartPointer<vtkMatrix4x4>::New();
+        vtkMatrix4x4::Invert( data.matrix, inverse );
+        transformSurface( data.decimated, inverse, static_cast<unsigned int>( vtkMultiThreader::GetGlobalMaximumNumberOfThreads() ) );
+    } };
+    stages.push_back( surfaceTransform );
+
+    // The quality metrics run after every case, here against the full resolution surface
+    BenchmarkStage surfaceDistance = { "surfaceDistance", []( BenchmarkData& data, const BenchmarkSettings& )
+    {
+        SurfaceDistanceMetrics metrics;
+        measureSurfaceDistance( data.source, data.surface, false, static_cast<unsigned int>( vtkMultiThreader::GetGlobalMaximumNumberOfThreads() ), metrics );
+    } };
+    stages.push_back( surfaceDistance );
+
+    return stages;
+}
+
+/*
+*   Cropping to the region of interest, run before the other stages on the cropped data sets.
+*/
+static BenchmarkStage createRegionOfInterestStage()
+{
+    BenchmarkStage regionOfInterest = { "regionOfInterest", []( BenchmarkData& data, const BenchmarkSettings& settings )
+    {
+        unsigned int numThreads = static_cast<unsigned int>( vtkMultiThreader::GetGlobalMaximumNumberOfThreads() );
+
+        int region[6];
+        data.image = data.uncropped;
+        if ( findRegionOfInterest( data.uncropped, settings.lowerThresh, settings.upperThresh, settings.regionMargin, numThreads, region ) )
+        {
+            data.image = cropImage( data.uncropped, region, numThreads );
+        }
+    } };
+    return regionOfInterest;
+}
+
+/*
+*   Mean distance between the source points moved by a matrix and their closest target points.
+*   Used to compare the accuracy of the registration methods.
+*/
+static double meanRegistrationDistance( vtkPolyData* source, vtkMatrix4x4* matrix, const PointKdTree& target )
+{
+    double total = 0.0;
+    double p[4] = { 0.0, 0.0, 0.0, 1.0 }, moved[4], closest[3];
+
+    for ( vtkIdType i = 0; i < source->GetNumberOfPoints(); i++ )
+    {
+        source->GetPoint( i, p );
+        matrix->MultiplyPoint( p, moved );
+        target.findClosestPoint( moved, closest );
+        total += std::sqrt( ( moved[0] - closest[0] ) * ( moved[0] - closest[0] ) + ( moved[1] - closest[1] ) * ( moved[1] - closest[1] ) +
+                            ( moved[2] - closest[2] ) * ( moved[2] - closest[2] ) );
+    }
+
+    return total / source->GetNumberOfPoints();
+}
+
+/*
+*   Use the given number of threads in all VTK filters.
+*/
+static void setNumberOfThreads( int threads )
+{
+    vtkMultiThreader::SetGlobalMaximumNumberOfThreads( threads );
+    vtkMultiThreader::SetGlobalDefaultNumberOfThreads( threads );
+    vtkSMPTools::Initialize( threads );
+}
+
+/*
+*   Record and print the median and minimum of the times of one stage.
+*/
+static void recordResult( const std::string& dataset, const char* stage, int threads, std::vector<double> times,
+                          std::vector<BenchmarkResult>& results )
+{
+    std::sort( times.begin(), times.end() );
+
+    BenchmarkResult result;
+    result.dataset = dataset;
+    result.stage = stage;
+    result.threads = threads;
+    result.medianSeconds = times[times.size() / 2];
+    result.minSeconds = times.front();
+    results.push_back( result );
+
+    std::cout << std::left << std::setw( 16 ) << result.dataset << std::setw( 18 ) << result.stage
+              << std::setw( 4 ) << threads << std::fixed << std::setprecision( 4 ) << result.medianSeconds << " s \n";
+}
+
+/*
+*   Time loading a DICOM series from its files (dicomLoad, the volume cache disabled) and from the
+*   volume cache (dicomLoadCached). The first load writes the cache if it is missing. After it the
+*   files are in the page cache of the OS, so dicomLoad measures the decoding rather than the disk.
+*   dicomLoadCached only maps the cache file; its pages are read by the first stage that uses them.
+*/
+static bool runSeriesLoading( const std::string& dataset, const std::string& dicomDirectory, const BenchmarkSettings& settings,
+                              int threads, std::vector<BenchmarkResult>& results )
+{
+    DICOMSeriesLoader loader;
+    loader.setDirectoryName( dicomDirectory );
+    loader.setNumberOfThreads( threads );
+    if ( !loader.load() )
+    {
+        return false;
+    }
+
+    const char* stageNames[2] = { "dicomLoad", "dicomLoadCached" };
+
+    for ( int cached = 0; cached < 2; cached++ )
+    {
+        loader.setUseCache( cached == 1 );
+        std::vector<double> times;
+
+        for ( int r = 0; r < settings.repeat; r++ )
+        {
+            loader.release();
+            if ( !loader.load() )
+            {
+                return false;
+            }
+
+            // The cache cannot be written next to a read-only series
+            if ( cached == 1 && !loader.loadedFromCache() )
+            {
+                std::cout << "WARNING: " << dicomDirectory << " has no volume cache, dicomLoadCached is not measured.\n";
+                return true;
+            }
+            times.push_back( loader.getLoadTime() );
+        }
+
+        recordResult( dataset, stageNames[cached], threads, times, results );
+    }
+
+    return true;
+}
+
+/*
+*   Run every stage on a dataset and record the median time of each.
+*/
+static void runDataset( BenchmarkData data, const std::vector<BenchmarkStage>& stages,
+                        const BenchmarkSettings& settings, int threads, std::vector<BenchmarkResult>& results )
+{
+    setNumberOfThreads( threads );
+
+    for ( std::size_t s = 0; s < stages.size(); s++ )
+    {
+        std::vector<double> times;
+
+        for ( int r = 0; r < settings.repeat; r++ )
+        {
+            auto start = std::chrono::steady_clock::now();
+            stages[s].run( data, settings );
+            times.push_back( std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count() );
+        }
+
+        recordResult( data.name, stages[s].name, threads, times, results );
+    }
+
+    // Accuracy of the registration methods
+    if ( data.matrix != nullptr && data.fastMatrix != nullptr )
+    {
+        PointKdTree target;
+        target.build( data.decimated->GetPoints() );
+
+        std::cout << std::left << std::setw( 16 ) << data.name << "mean distance after registration: vtk ICP "
+                  << meanRegistrationDistance( data.source, data.matrix, target ) << ", fast ICP "
+                  << meanRegistrationDistance( data.source, data.fastMatrix, target );
+
+        if ( data.distanceMatrix != nullptr )
+        {
+            std::cout << ", distance field " << meanRegistrationDistance( data.source, data.distanceMatrix, target );
+        }
+        std::cout << "\n";
+
+        // Both decimations are measured against the vtkDecimatePro surface, the target of the other methods
+        if ( data.clusteredMatrix != nullptr )
+        {
+            std::cout << std::left << std::setw( 16 ) << data.name << "triangles after decimation: vtkDecimatePro "
+                      << data.decimated->GetNumberOfPolys() << ", vertex clustering " << data.clustered->GetNumberOfPolys()
+                      << "; mean distance after fast ICP on the clustered surface "
+                      << meanRegistrationDistance( data.source, data.clusteredMatrix, target ) << "\n";
+        }
+    }
+}
+
+/*
+*   Split a comma separated list of numbers.
+*/
+static std::vector<int> parseList( const std::string& text )
+{
+    std::vector<int> values;
+    std::stringstream stream( text );
+    std::string item;
+
+    while ( std::getline( stream, item, ',' ) )
+    {
+        values.push_back( std::atoi( item.c_str() ) );
+    }
+
+    return values;
+}
+
+static std::string resultKey( const std::string& dataset, const std::string& stage, int threads )
+{
+    std::stringstream key;
+    key << dataset << "," << stage << "," << threads;
+    return key.str();
+}
+
+/*
+*   Print the speedup of every stage on the cropped dataset over the whole one, for every thread count.
+*/
+static void printRegionSpeedup( const std::string& whole, const std::string& cropped, const std::vector<BenchmarkResult>& results )
+{
+    std::map<std::string, double> wholeSeconds;
+    for ( std::size_t i = 0; i < results.size(); i++ )
+    {
+        if ( results[i].dataset == whole )
+        {
+            wholeSeconds[resultKey( whole, results[i].stage, results[i].threads )] = results[i].medianSeconds;
+        }
+    }
+
+    for ( std::size_t i = 0; i < results.size(); i++ )
+    {
+        std::map<std::string, double>::const_iterator match =
+            wholeSeconds.find( resultKey( whole, results[i].stage, results[i].threads ) );
+
+        if ( results[i].dataset == cropped && match != wholeSeconds.end() && results[i].medianSeconds > 0.0 )
+        {
+            std::cout << std::left << std::setw( 16 ) << cropped << std::setw( 18 ) << results[i].stage
+                      << std::setw( 4 ) << results[i].threads << std::fixed << std::setprecision( 2 )
+                      << match->second / results[i].medianSeconds << "x faster than " << whole << "\n";
+        }
+    }
+}
+
+static bool writeResults( const std::string& fileName, const std::vector<BenchmarkResult>& results )
+{
+    std::ofstream file( fileName );
+    file << "dataset,stage,threads,median_seconds,min_seconds\n";
+    file << std::setprecision( 6 );
+
+    for ( std::size_t i = 0; i < results.size(); i++ )
+    {
+        file << results[i].dataset << "," << results[i].stage << "," << results[i].threads << ","
+             << results[i].medianSeconds << "," << results[i].minSeconds << "\n";
+    }
+
+    return static_cast<bool>( file );
+}
+
+/*
+*   Compare the results against a baseline file written by an earlier run.
+*
+*   @returns The number of stages that are slower than the baseline by more than the tolerance
+*/
+static int compareWithBaseline( const std::string& fileName, const std::vector<BenchmarkResult>& results, double tolerance )
+{
+    std::ifstream file( fileName );
+    if ( !file )
+    {
+        std::cout << "ERROR: Could not read the baseline " << fileName << "\n";
+        return -1;
+    }
+
+    std::map<std::string, double> baseline;
+    std::string line;
+    std::getline( file, line );
+
+    while ( std::getline( file, line ) )
+    {
+        std::stringstream fields( line );
+        std::string dataset, stage, threads, median;
+        std::getline( fields, dataset, ',' );
+        std::getline( fields, stage, ',' );
+        std::getline( fields, threads, ',' );
+        std::getline( fields, median, ',' );
+        baseline[resultKey( dataset, stage, std::atoi( threads.c_str() ) )] = std::atof( median.c_str() );
+    }
+
+    int regressions = 0;
+    std::cout << "\n**Comparison with baseline " << fileName << " (tolerance " << tolerance * 100.0 << "%)** \n";
+
+    for ( std::size_t i = 0; i < results.size(); i++ )
+    {
+        std::map<std::string, double>::const_iterator entry = baseline.find( resultKey( results[i].dataset, results[i].stage, results[i].threads ) );
+        if ( entry == baseline.end() || entry->second <= 0.0 )
+        {
+            continue;
+        }
+
+        double change = results[i].medianSeconds / entry->second - 1.0;
+        bool regressed = change > tolerance;
+        regressions += regressed ? 1 : 0;
+
+        std::cout << std::left << std::setw( 16 ) << results[i].dataset << std::setw( 18 ) << results[i].stage
+                  << std::setw( 4 ) << results[i].threads << std::showpos << std::setprecision( 1 ) << change * 100.0
+                  << std::noshowpos << "%" << ( regressed ? "  REGRESSION" : "" ) << "\n";
+    }
+
+    return regressions;
+}
+
+int main( int argc, char* argv[] )
+{
+    BenchmarkSettings settings;
+    settings.lowerThresh = -800;
+    settings.upperThresh = -600;
+    settings.isoValue = 0.5;
+    settings.decimationRatio = 0.5;
+    settings.icpIterations = 75;
+    settings.regionMargin = 10.0;
+    settings.repeat = 3;
+
+    std::string dicomDirectory, objFile, outputFile, baselineFile;
+    std::vector<int> sizes( 1, 256 );
+    std::vector<int> threadCounts;
+    double tolerance = 0.15;
+
+    // All options take a value
+    if ( ( argc - 1 ) % 2 != 0 )
+    {
+        std::cout << "ERROR: Option " << argv[argc - 1] << " needs a value.\n";
+        return EXIT_FAILURE;
+    }
+
+    for ( int i = 1; i + 1 < argc; i += 2 )
+    {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+
+        if ( key == "--dicom" )            dicomDirectory = value;
+        else if ( key == "--obj" )         objFile = value;
+        else if ( key == "--sizes" )       sizes = parseList( value );
+        else if ( key == "--threads" )     threadCounts = parseList( value );
+        else if ( key == "--repeat" )      settings.repeat = std::max( 1, std::atoi( value.c_str() ) );
+        else if ( key == "--lower" )       settings.lowerThresh = std::atoi( value.c_str() );
+        else if ( key == "--upper" )       settings.upperThresh = std::atoi( value.c_str() );
+        else if ( key == "--isovalue" )    settings.isoValue = std::atof( value.c_str() );
+        else if ( key == "--output" )      outputFile = value;
+        else if ( key == "--baseline" )    baselineFile = value;
+        else if ( key == "--tolerance" )   tolerance = std::atof( value.c_str() );
+        else
+        {
+            std::cout << "ERROR: Unknown option " << key << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if ( threadCounts.empty() )
+    {
+        threadCounts.push_back( 1 );
+        if ( getNumberOfWorkerThreads() > 1 )
+        {
+            threadCounts.push_back( static_cast<int>( getNumberOfWorkerThreads() ) );
+        }
+    }
+
+    std::vector<BenchmarkStage> stages = createStages();
+    std::vector<BenchmarkResult> results;
+
+    // The bundled data set
+    if ( !dicomDirectory.empty() && !objFile.empty() )
+    {
+        DICOMSeriesLoader loader;
+        loader.setDirectoryName( dicomDirectory );
+        if ( !loader.load() )
+        {
+            return EXIT_FAILURE;
+        }
+
+        OBJMeshLoader objLoader;
+        objLoader.setFileName( objFile );
+        if ( !objLoader.load() )
+        {
+            return EXIT_FAILURE;
+        }
+
+        BenchmarkData data;
+        data.name = "sawbones";
+        data.image = loader.getOutput();
+        data.source = objLoader.getOutput();
+
+        for ( std::size_t t = 0; t < threadCounts.size(); t++ )
+        {
+            if ( !runSeriesLoading( data.name, dicomDirectory, settings, threadCounts[t], results ) )
+            {
+                return EXIT_FAILURE;
+            }
+        }
+
+        for ( std::size_t t = 0; t < threadCounts.size(); t++ )
+        {
+            runDataset( data, stages, settings, threadCounts[t], results );
+        }
+
+        // The same data cropped to the region of interest, as the pipeline does unless --no-roi is given
+        std::vector<BenchmarkStage> croppedStages( 1, createRegionOfInterestStage() );
+        croppedStages.insert( croppedStages.end(), stages.begin(), stages.end() );
+
+        BenchmarkData cropped;
+        cropped.name = "sawbones-roi";
+        cropped.uncropped = data.image;
+        cropped.source = data.source;
+
+        for ( std::size_t t = 0; t < threadCounts.size(); t++ )
+        {
+            runDataset( cropped, croppedStages, settings, threadCounts[t], results );
+        }
+
+        int region[6];
+        if ( findRegionOfInterest( data.image, settings.lowerThresh, settings.upperThresh, settings.regionMargin, 0, region ) )
+        {
+            double numVoxels = static_cast<double>( data.image->GetNumberOfPoints() );
+            double regionVoxels = static_cast<double>( region[1] - region[0] + 1 ) * ( region[3] - region[2] + 1 ) * ( region[5] - region[4] + 1 );
+            double voxelMegabytes = data.image->GetScalarSize() / ( 1024.0 * 1024.0 );
+
+            std::cout << std::left << std::setw( 16 ) << cropped.name << "region of interest: " << std::setprecision( 1 )
+                      << 100.0 * regionVoxels / numVoxels << "% of the voxels, " << regionVoxels * voxelMegabytes
+                      << " MB per volume instead of " << numVoxels * voxelMegabytes << " MB\n";
+        }
+
+        printRegionSpeedup( data.name, cropped.name, results );
+    }
+
+    // Synthetic volumes to see how every stage scales with the data size
+    for ( std::size_t s = 0; s < sizes.size(); s++ )
+    {
+        std::stringstream name;
+        name << "synthetic" << sizes[s];
+
+        BenchmarkData data;
+        data.name = name.str();
+        data.image = createSyntheticVolume( sizes[s] );
+
+        for ( std::size_t t = 0; t < threadCounts.size(); t++ )
+        {
+            runDataset( data, stages, settings, threadCounts[t], results );
+        }
+    }
+
+    if ( !outputFile.empty() && !writeResults( outputFile, results ) )
+    {
+        std::cout << "ERROR: Could not write " << outputFile << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if ( !baselineFile.empty() )
+    {
+        int regressions = compareWithBaseline( baselineFile, results, tolerance );
+        if ( regressions != 0 )
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,1174 @@
+/****************************************************************************
+*   registrationPipeline.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the registration pipeline.
+****************************************************************************/
+
+#include "registrationPipeline.hxx"
+#include "bandIsosurface.hxx"
+#include "dicomSeriesLoader.hxx"
+#include "distanceRegistration.hxx"
+#include "fastICP.hxx"
+#include "gaussianSmooth.hxx"
+#include "instrumentedICP.hxx"
+#include "objMeshLoader.hxx"
+#include "parallelUtils.hxx"
+#include "pipelineCache.hxx"
+#include "regionOfInterest.hxx"
+#include "surfaceTransform.hxx"
+#include "threadPool.hxx"
+#include "vertexClustering.hxx"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <mutex>
+
+#include <vtkImageShrink3D.h>
+#include <vtkMultiThreader.h>
+#include <vtkTriangleFilter.h>
+#include <vtkXMLImageDataWriter.h>
+#include <vtkXMLPolyDataWriter.h>
+#include <vtksys/SystemTools.hxx>
+
+// Distance kept around the segmented voxels in the distance field (world units)
+static const double DISTANCE_FIELD_MARGIN = 10.0;
+
+// OBJ points matched by the short ICP runs of the multi-start search
+static const int MULTI_START_SAMPLES = 1000;
+
+// Slices smoothed at once by a thread in the low memory mode, unless --smoothing-slab is given
+static const int LOW_MEMORY_SMOOTHING_SLAB = 16;
+
+// Gaussian smoothing of the DICOM series (standard deviation and radius factor, see GaussianSmoothSettings)
+static const double SMOOTHING_DEVIATION = 1.0;
+static const double SMOOTHING_RADIUS_FACTOR = 1.0;
+
+/*
+*   Copy the output of a filter into a new data object. The arrays are shared, not copied, but unlike
+*   the output itself the copy does not keep the filter and its inputs (masks, full surfaces) alive.
+*/
+template <typename T>
+static vtkSmartPointer<T> detachOutput( T* output )
+{
+    vtkSmartPointer<T> copy = vtkSmartPointer<T>::New();
+    copy->ShallowCopy( output );
+    return copy;
+}
+
+/*
+*   @returns TRUE if the extent outer holds every voxel of the extent inner
+*/
+static bool containsExtent( const int outer[6], const int inner[6] )
+{
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        if ( inner[2 * axis] < outer[2 * axis] || inner[2 * axis + 1] > outer[2 * axis + 1] )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+*   @returns TRUE if both extents are the same
+*/
+static bool sameExtent( const int a[6], const int b[6] )
+{
+    return std::equal( a, a + 6, b );
+}
+
+/*
+*   Segment an image with the threshold band and generate its surface.
+*   Either in one fused pass over the image, or with a binary mask followed by marching cubes.
+*/
+static vtkSmartPointer<vtkPolyData> extractSurface( vtkImageData* image, const PipelineOptions& options,
+                                                    unsigned int numThreads, StageProfiler& profiler, bool transformed )
+{
+    if ( options.fusedExtraction )
+    {
+        profiler.beginStage( transformed ? "bandIsosurfaceTransformed" : "bandIsosurface" );
+        vtkSmartPointer<vtkPolyData> surface = extractBandSurface( image, options.lowerThresh, options.upperThresh, numThreads );
+        profiler.setVoxelCount( image->GetNumberOfPoints() );
+        profiler.setTriangleCount( surface->GetNumberOfPolys() );
+        return surface;
+    }
+
+    // Apply the global threshold
+    profiler.beginStage( transformed ? "thresholdTransformed" : "threshold" );
+    vtkSmartPointer<vtkImageThreshold> globalThresh = vtkSmartPointer<vtkImageThreshold>::New();
+    globalThresh->SetInputData( image );
+    globalThresh->ThresholdBetween( options.lowerThresh, options.upperThresh );
+    globalThresh->ReplaceInOn();
+    globalThresh->SetInValue( 1 );
+    globalThresh->ReplaceOutOn();
+    globalThresh->SetOutValue( 0 );
+    // The mask only holds 0 and 1, the low memory mode keeps it in 8 bits
+    if ( options.lowMemory )
+    {
+        globalThresh->SetOutputScalarTypeToUnsignedChar();
+    }
+    else
+    {
+        globalThresh->SetOutputScalarTypeToFloat();
+    }
+    globalThresh->Update();
+    profiler.setVoxelCount( globalThresh->GetOutput()->GetNumberOfPoints() );
+
+    // Use the Marching cubes algorithm to generate the surface
+    profiler.beginStage( transformed ? "marchingCubesTransformed" : "marchingCubes" );
+    vtkSmartPointer<vtkMarchingCubes> surface = vtkSmartPointer<vtkMarchingCubes>::New();
+    surface->SetInputData( globalThresh->GetOutput() );
+    surface->ComputeNormalsOn();
+    surface->SetValue( 0, options.isoValue );
+    surface->Update();
+    profiler.setTriangleCount( surface->GetOutput()->GetNumberOfPolys() );
+
+    return detachOutput( surface->GetOutput() );
+}
+
+/*
+*   Reduce the number of triangles of an extracted surface to speed up computation, by parallel
+*   vertex clustering or with vtkDecimatePro.
+*/
+static vtkSmartPointer<vtkPolyData> decimateSurface( vtkPolyData* surface, const PipelineOptions& options,
+                                                     unsigned int numThreads, StageProfiler& profiler, bool transformed )
+{
+    profiler.beginStage( transformed ? "decimateTransformed" : "decimate" );
+    if ( options.clusterDecimation )
+    {
+        VertexClusteringSettings settings;
+        settings.cellSize = options.decimationCellSize;
+        settings.targetTriangles = static_cast<vtkIdType>( ( 1.0 - options.decimationRatio ) * surface->GetNumberOfPolys() + 0.5 );
+        settings.numThreads = numThreads;
+
+        vtkSmartPointer<vtkPolyData> decimated = decimateByClustering( surface, settings );
+        profiler.setTriangleCount( decimated->GetNumberOfPolys() );
+        return decimated;
+    }
+
+    vtkSmartPointer<vtkDecimatePro> decimate = vtkSmartPointer<vtkDecimatePro>::New();
+    decimate->SetInputData( surface );
+    decimate->SetTargetReduction( options.decimationRatio );
+    decimate->Update();
+    profiler.setTriangleCount( decimate->GetOutput()->GetNumberOfPolys() );
+
+    return detachOutput( decimate->GetOutput() );
+}
+
+/*
+*   Extract the surface of an image and reduce the number of triangles to speed up computation.
+*/
+static vtkSmartPointer<vtkPolyData> extractDecimatedSurface( vtkImageData* image, const PipelineOptions& options,
+                                                             unsigned int numThreads, StageProfiler& profiler, bool transformed )
+{
+    vtkSmartPointer<vtkPolyData> surface = extractSurface( image, options, numThreads, profiler, transformed );
+    return decimateSurface( surface, options, numThreads, profiler, transformed );
+}
+
+/*
+*   Parameters of the surface extraction, part of the pipeline cache keys.
+*/
+static std::string surfaceParameters( const PipelineOptions& options )
+{
+    std::stringstream parameters;
+    parameters.precision( 17 );
+    parameters << "surface " << options.lowerThresh << " " << options.upperThresh << " ";
+
+    // The fused extraction has no isovalue
+    if ( options.fusedExtraction )
+    {
+        parameters << "fused";
+    }
+    else
+    {
+        parameters << "mask " << options.isoValue;
+    }
+    return parameters.str();
+}
+
+/*
+*   Parameters of the decimation, part of the pipeline cache keys.
+*/
+static std::string decimationParameters( const PipelineOptions& options )
+{
+    std::stringstream parameters;
+    parameters.precision( 17 );
+    parameters << "decimate " << options.decimationRatio << " "
+               << ( options.clusterDecimation ? "clustering" : "pro" ) << " " << options.decimationCellSize;
+    return parameters.str();
+}
+
+/*
+*   Parameters of the registration, part of the pipeline cache keys.
+*/
+static std::string registrationParameters( const PipelineOptions& options )
+{
+    std::stringstream parameters;
+    parameters.precision( 17 );
+    parameters << "register " << ( options.distanceRegistration ? "distance" : "icp" ) << " "
+               << ( options.fastICP ? "fast" : "vtk" ) << " " << options.icpIterations << " " << options.icpTolerance << " "
+               << options.icpSampling << " " << options.icpSamples << " " << options.icpTrim << " "
+               << options.pyramidLevels << " [";
+    for ( std::size_t i = 0; i < options.pyramidIterations.size(); i++ )
+    {
+        parameters << options.pyramidIterations[i] << " ";
+    }
+    parameters << "] " << options.multiStart << " " << options.multiStartRotations << " "
+               << options.multiStartIterations << " " << options.seed;
+    return parameters.str();
+}
+
+/*
+*   Get the decimated DICOM surface (the ICP target) from the pipeline cache, or decimate the cached
+*   full surface, or extract and decimate it. What is computed is stored in the cache. The smoothed
+*   volume is only asked for when neither surface is cached.
+*/
+static vtkSmartPointer<vtkPolyData> extractTargetSurface( const std::function<vtkImageData*()>& smoothedVolume, const std::string& volumeKey,
+                                                          const PipelineOptions& options, unsigned int numThreads, StageProfiler& profiler,
+                                                          const PipelineCache& cache, std::ostream& log )
+{
+    std::string surfaceKey = PipelineCache::makeKey( volumeKey, surfaceParameters( options ) );
+    std::string decimatedKey = PipelineCache::makeKey( surfaceKey, decimationParameters( options ) );
+
+    vtkSmartPointer<vtkPolyData> decimated = cache.readSurface( decimatedKey );
+    if ( decimated != nullptr )
+    {
+        log << "(decimated surface from the pipeline cache) ";
+        return decimated;
+    }
+
+    vtkSmartPointer<vtkPolyData> surface = cache.readSurface( surfaceKey );
+    if ( surface != nullptr )
+    {
+        log << "(surface from the pipeline cache) ";
+    }
+    else
+    {
+        surface = extractSurface( smoothedVolume(), options, numThreads, profiler, false );
+        cache.writeSurface( surfaceKey, surface );
+    }
+
+    decimated = decimateSurface( surface, options, numThreads, profiler, false );
+    cache.writeSurface( decimatedKey, decimated );
+    return decimated;
+}
+
+/*
+*   Register the OBJ surface to the DICOM surface with the selected ICP engine.
+*   The mean closest point distance of every iteration is recorded when profiling.
+*   Without an initial matrix the registration starts by matching the centroids.
+*/
+static bool registerSurfaces( vtkPolyData* source, vtkPolyData* target, const PipelineOptions& options,
+                              unsigned int numThreads, StageProfiler& profiler, vtkMatrix4x4* initial, vtkMatrix4x4* matrix )
+{
+    std::function<void( int, double )> recordIteration;
+    if ( profiler.isEnabled() )
+    {
+        recordIteration = [&profiler]( int, double meanDistance )
+        {
+            profiler.addIterationDistance( meanDistance );
+        };
+    }
+
+    if ( options.fastICP )
+    {
+        FastICPSettings settings;
+        settings.maxIterations = options.icpIterations;
+        settings.tolerance = options.icpTolerance;
+        settings.numSamples = options.icpSamples;
+        settings.trimFraction = options.icpTrim;
+        settings.numThreads = numThreads;
+        settings.seed = options.seed;
+        parseICPSampling( options.icpSampling, settings.sampling );
+
+        FastICP icp;
+        icp.setSource( source );
+        icp.setTarget( target );
+        icp.setInitialMatrix( initial );
+        icp.setSettings( settings );
+        icp.setIterationCallback( recordIteration );
+
+        if ( !icp.update() )
+        {
+            return false;
+        }
+
+        matrix->DeepCopy( icp.getMatrix() );
+        return true;
+    }
+
+    // When profiling, an ICP transform that reports the mean distance of every iteration is used
+    vtkSmartPointer<vtkIterativeClosestPointTransform> icp;
+    if ( profiler.isEnabled() )
+    {
+        vtkSmartPointer<InstrumentedICPTransform> instrumentedICP = vtkSmartPointer<InstrumentedICPTransform>::New();
+        instrumentedICP->setIterationCallback( recordIteration );
+        icp = instrumentedICP;
+    }
+    else
+    {
+        icp = vtkSmartPointer<vtkIterativeClosestPointTransform>::New();
+    }
+    // VTK's ICP has no initial transformation, it registers the source moved to the initial pose instead
+    icp->SetSource( ( initial != nullptr ) ? transformSurface( source, initial, numThreads ).GetPointer() : source );
+    icp->SetTarget( target );
+    icp->SetMaximumNumberOfIterations( options.icpIterations );
+    icp->GetLandmarkTransform()->SetModeToRigidBody();
+    icp->SetStartByMatchingCentroids( initial == nullptr );
+    icp->Update();
+
+    if ( initial != nullptr )
+    {
+        vtkMatrix4x4::Multiply4x4( icp->GetMatrix(), initial, matrix );
+    }
+    else
+    {
+        matrix->DeepCopy( icp->GetMatrix() );
+    }
+    return true;
+}
+
+/*
+*   Find the starting pose of the ICP registration with the multi-start search.
+*
+*   @returns The best pose, nullptr when the search is disabled (start by matching the centroids)
+*/
+static vtkSmartPointer<vtkMatrix4x4> findStartingPose( vtkPolyData* source, vtkPolyData* target, const PipelineOptions& options,
+                                                       unsigned int numThreads, std::vector<PoseHypothesis>& hypotheses )
+{
+    if ( !options.multiStart )
+    {
+        return nullptr;
+    }
+
+    MultiStartSettings settings;
+    settings.numRandomRotations = options.multiStartRotations;
+    settings.roundIterations = options.multiStartIterations;
+    settings.numThreads = numThreads;
+    settings.seed = options.seed;
+    settings.icp.tolerance = options.icpTolerance;
+    settings.icp.numSamples = std::min( options.icpSamples, MULTI_START_SAMPLES );
+    settings.icp.trimFraction = options.icpTrim;
+    settings.icp.seed = options.seed;
+    parseICPSampling( options.icpSampling, settings.icp.sampling );
+
+    MultiStartRegistration search;
+    search.setSource( source );
+    search.setTarget( target );
+    search.setSettings( settings );
+
+    if ( !search.update() )
+    {
+        return nullptr;
+    }
+
+    hypotheses = search.getHypotheses();
+
+    vtkSmartPointer<vtkMatrix4x4> pose = vtkSmartPointer<vtkMatrix4x4>::New();
+    pose->DeepCopy( search.getMatrix() );
+    return pose;
+}
+
+/*
+*   Register every vertebra of the OBJ surface on its own, starting from the registration of the whole surface.
+*
+*   @returns FALSE if the OBJ surface has no materials or groups to split it by
+*/
+static bool registerVertebrae( vtkPolyData* obj, vtkPolyData* target, const PipelineOptions& options, unsigned int numThreads,
+                               vtkMatrix4x4* matrix, std::vector<VertebraTransform>& vertebrae )
+{
+    VertebraRegistrationSettings settings;
+    settings.margin = options.vertebraMargin;
+    settings.smoothness = options.vertebraSmoothness;
+    settings.numThreads = numThreads;
+    settings.icp.maxIterations = options.icpIterations;
+    settings.icp.tolerance = options.icpTolerance;
+    settings.icp.numSamples = options.icpSamples;
+    settings.icp.trimFraction = options.icpTrim;
+    settings.icp.seed = options.seed;
+    parseICPSampling( options.icpSampling, settings.icp.sampling );
+
+    VertebraRegistration registration;
+    registration.setSource( obj );
+    registration.setTarget( target );
+    registration.setInitialMatrix( matrix );
+    registration.setSettings( settings );
+
+    if ( !registration.update() )
+    {
+        return false;
+    }
+
+    vertebrae = registration.getTransforms();
+    return true;
+}
+
+/*
+*   Register the OBJ surface to the signed distance field of the segmented image.
+*   No surface of the image is extracted, the field is built from the thresholds directly.
+*   Without an initial matrix the registration starts by matching the centroids.
+*/
+static bool registerToDistanceField( vtkPolyData* source, vtkImageData* image, const PipelineOptions& options,
+                                     unsigned int numThreads, StageProfiler& profiler, vtkMatrix4x4* initial, vtkMatrix4x4* matrix )
+{
+    profiler.beginStage( "distanceField" );
+    DistanceField field;
+    if ( !field.build( image, options.lowerThresh, options.upperThresh, DISTANCE_FIELD_MARGIN, numThreads ) )
+    {
+        return false;
+    }
+    profiler.setVoxelCount( field.getNumberOfVoxels() );
+
+    profiler.beginStage( "distanceRegistration" );
+    DistanceRegistrationSettings settings;
+    settings.maxIterations = options.icpIterations;
+    settings.tolerance = options.icpTolerance;
+    settings.trimFraction = options.icpTrim;
+    settings.numThreads = numThreads;
+
+    DistanceFieldRegistration registration;
+    registration.setSource( source );
+    registration.setField( &field );
+    registration.setInitialMatrix( initial );
+    registration.setSettings( settings );
+
+    if ( profiler.isEnabled() )
+    {
+        registration.setIterationCallback( [&profiler]( int, double meanDistance )
+        {
+            profiler.addIterationDistance( meanDistance );
+        } );
+    }
+
+    if ( !registration.update() )
+    {
+        return false;
+    }
+
+    if ( registration.hasStalled() )
+    {
+        std::cout << "WARNING: The distance registration stalled after " << registration.getNumberOfIterations()
+                  << " iterations, the mean distance is " << registration.getMeanDistance() << ".\n";
+    }
+
+    matrix->DeepCopy( registration.getMatrix() );
+    return true;
+}
+
+/*
+*   Options of one pyramid level, level 0 is the full resolution.
+*/
+static PipelineOptions levelOptions( const PipelineOptions& options, int level )
+{
+    PipelineOptions result = options;
+    if ( !options.pyramidIterations.empty() )
+    {
+        result.icpIterations = options.pyramidIterations[options.pyramidLevels - 1 - level];
+    }
+    return result;
+}
+
+/*
+*   Reduce the number of triangles of a surface. The OBJ polygons are split into triangles first.
+*/
+static vtkSmartPointer<vtkPolyData> reduceSurface( vtkPolyData* surface, double targetReduction )
+{
+    vtkSmartPointer<vtkTriangleFilter> triangles = vtkSmartPointer<vtkTriangleFilter>::New();
+    triangles->SetInputData( surface );
+
+    vtkSmartPointer<vtkDecimatePro> decimate = vtkSmartPointer<vtkDecimatePro>::New();
+    decimate->SetInputConnection( triangles->GetOutputPort() );
+    decimate->SetTargetReduction( targetReduction );
+    decimate->Update();
+
+    return detachOutput( decimate->GetOutput() );
+}
+
+/*
+*   Register on the coarse levels of the pyramid, from the coarsest level up to level 1.
+*   Level n shrinks the image by 2^n along every axis and reduces the OBJ surface to a
+*   matching density. Every level starts from the pose found on the level below it,
+*   only the coarsest one starts by matching the centroids or with the multi-start search.
+*
+*   @returns TRUE if all levels registered, FALSE if a level has an empty segmentation
+*/
+static bool registerCoarseLevels( vtkPolyData* obj, vtkImageData* image, const PipelineOptions& options,
+                                  unsigned int numThreads, StageProfiler& profiler, std::vector<PoseHypothesis>& hypotheses,
+                                  vtkMatrix4x4* matrix )
+{
+    // Each level is profiled as a whole, not stage by stage
+    StageProfiler levelProfiler;
+    vtkSmartPointer<vtkMatrix4x4> initial;
+
+    for ( int level = options.pyramidLevels - 1; level > 0; level-- )
+    {
+        std::stringstream stage;
+        stage << "pyramidLevel" << level;
+        profiler.beginStage( stage.str().c_str() );
+
+        int factor = 1 << level;
+        vtkSmartPointer<vtkImageShrink3D> shrink = vtkSmartPointer<vtkImageShrink3D>::New();
+        shrink->SetInputData( image );
+        shrink->SetShrinkFactors( factor, factor, factor );
+        shrink->AveragingOn();
+        shrink->Update();
+
+        // A coarse voxel averages the input voxels i*f to i*f+f-1 but keeps the position of voxel i*f,
+        // move it to the centre of those voxels so the coarse surface is not shifted by (f-1)/2 voxels
+        vtkSmartPointer<vtkImageData> coarseImage = detachOutput( shrink->GetOutput() );
+        double coarseOrigin[3];
+        for ( int axis = 0; axis < 3; axis++ )
+        {
+            coarseOrigin[axis] = image->GetOrigin()[axis] + 0.5 * ( factor - 1 ) * image->GetSpacing()[axis];
+        }
+        coarseImage->SetOrigin( coarseOrigin );
+
+        // The surface has factor^2 times fewer voxels on it, keep as many OBJ triangles
+        vtkSmartPointer<vtkPolyData> source = reduceSurface( obj, 1.0 - 1.0 / ( factor * factor ) );
+
+        profiler.setVoxelCount( coarseImage->GetNumberOfPoints() );
+        profiler.setTriangleCount( source->GetNumberOfPolys() );
+
+        PipelineOptions coarseOptions = levelOptions( options, level );
+        vtkSmartPointer<vtkMatrix4x4> levelMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+
+        if ( options.distanceRegistration )
+        {
+            if ( !registerToDistanceField( source, coarseImage, coarseOptions, numThreads, levelProfiler, initial, levelMatrix ) )
+            {
+                return false;
+            }
+        }
+        else
+        {
+            // The coarse surface is small enough to be used without decimation
+            vtkSmartPointer<vtkPolyData> target = extractSurface( coarseImage, coarseOptions, numThreads, levelProfiler, false );
+            if ( target->GetNumberOfPoints() == 0 )
+            {
+                return false;
+            }
+
+            if ( initial == nullptr )
+            {
+                initial = findStartingPose( source, target, coarseOptions, numThreads, hypotheses );
+            }
+
+            if ( !registerSurfaces( source, target, coarseOptions, numThreads, levelProfiler, initial, levelMatrix ) )
+            {
+                return false;
+            }
+        }
+
+        initial = levelMatrix;
+    }
+
+    matrix->DeepCopy( initial );
+    return true;
+}
+
+bool runRegistration( const RegistrationCase& registrationCase, const PipelineOptions& options,
+                      unsigned int numThreads, RegistrationResult& result )
+{
+    auto start = std::chrono::steady_clock::now();
+
+    // Progress messages are only shown in interactive mode, batch cases run concurrently
+    std::ostream nullStream( nullptr );
+    std::ostream& log = options.batch ? nullStream : std::cout;
+
+    result = RegistrationResult();
+
+    StageProfiler& profiler = result.profile;
+    profiler.setEnabled( !options.profileFile.empty() );
+
+    /***************************************************************
+    *   Read in the provided DICOM and OBJ files
+    ***************************************************************/
+    // Read all files from the DICOM series in the specified directory.
+    // Slices are decoded in parallel, or memory mapped from the volume cache if the series was loaded before.
+    DICOMSeriesLoader dicomLoader;
+    dicomLoader.setDirectoryName( registrationCase.dicomDirectory );
+    dicomLoader.setUseCache( options.useVolumeCache );
+    dicomLoader.setNumberOfThreads( numThreads );
+
+    profiler.beginStage( "readDICOM" );
+    if ( !dicomLoader.load() )
+    {
+        return false;
+    }
+    profiler.setVoxelCount( dicomLoader.getOutput()->GetNumberOfPoints() );
+
+    log << "Loaded DICOM series " << ( dicomLoader.loadedFromCache() ? "from the volume cache" : "from the DICOM files" )
+        << " in " << dicomLoader.getLoadTime() << " s \n";
+
+    // Read in the OBJ file.
+    // The file is parsed in parallel, or memory mapped from the mesh cache if it was loaded before.
+    OBJMeshLoader objLoader;
+    objLoader.setFileName( registrationCase.objFile );
+    objLoader.setUseCache( options.useVolumeCache );
+    objLoader.setNumberOfThreads( numThreads );
+
+    profiler.beginStage( "readOBJ" );
+    if ( !objLoader.load() )
+    {
+        return false;
+    }
+
+    vtkSmartPointer<vtkPolyData> obj = objLoader.getOutput();
+
+    log << "Loaded OBJ surface " << ( objLoader.loadedFromCache() ? "from the mesh cache" : "from the OBJ file" )
+        << " in " << objLoader.getLoadTime() << " s \n";
+
+    if ( obj->GetNumberOfPoints() == 0 )
+    {
+        std::cout << "ERROR: No points read from OBJ file " << registrationCase.objFile << "\n";
+        return false;
+    }
+    profiler.setTriangleCount( obj->GetNumberOfPolys() );
+
+    // Results of the later stages are cached by the data they were computed from and their parameters
+    PipelineCache cache;
+    if ( options.useVolumeCache )
+    {
+        cache.setDirectory( options.cacheDirectory.empty() ? registrationCase.dicomDirectory + "/pipelineCache" : options.cacheDirectory );
+        cache.setMaximumSize( options.cacheSizeMB );
+    }
+
+    vtkSmartPointer<vtkImageData> volume = dicomLoader.getOutput();
+    if ( volume->GetNumberOfScalarComponents() != 1 )
+    {
+        std::cout << "ERROR: The DICOM series must have a single scalar component. \n";
+        return false;
+    }
+
+    /***************************************************************
+    *   Find the region of interest of the DICOM series
+    ***************************************************************/
+    // The spine fills a small part of the field of view, the filters below only run on the region around it
+    int region[6];
+    std::copy( volume->GetExtent(), volume->GetExtent() + 6, region );
+
+    if ( options.cropToRegion )
+    {
+        profiler.beginStage( "regionOfInterest" );
+
+        if ( !findRegionOfInterest( volume, options.lowerThresh, options.upperThresh, options.regionMargin, numThreads, region ) )
+        {
+            log << "No voxels within the thresholds found, the whole DICOM series is processed \n";
+        }
+    }
+
+    // The smoothed series is cached whatever region was asked for, a rerun with other thresholds crops the cached
+    // copy if it holds the new region. The later stages work on the region, it is part of their keys.
+    std::stringstream smoothingParameters, regionParameters;
+    smoothingParameters << "smooth " << SMOOTHING_DEVIATION << " " << SMOOTHING_RADIUS_FACTOR;
+    regionParameters << "region " << region[0] << " " << region[1] << " " << region[2] << " "
+                     << region[3] << " " << region[4] << " " << region[5];
+    std::string smoothedKey = PipelineCache::makeKey( dicomLoader.getFingerprint(), smoothingParameters.str() );
+    std::string volumeKey = PipelineCache::makeKey( smoothedKey, regionParameters.str() );
+
+    GaussianSmoothSettings smoothSettings;
+    smoothSettings.standardDeviation = SMOOTHING_DEVIATION;
+    smoothSettings.radiusFactor = SMOOTHING_RADIUS_FACTOR;
+    smoothSettings.slabSlices = ( options.lowMemory && options.smoothingSlab == 0 ) ? LOW_MEMORY_SMOOTHING_SLAB : options.smoothingSlab;
+    smoothSettings.numThreads = numThreads;
+
+    // Voxels of the region only depend on the voxels within the kernel radius of it, so the region is smoothed
+    // with that margin (within the series) and its voxels are the same as when the whole series is smoothed
+    int smoothingRegion[6];
+    smoothingExtent( volume->GetExtent(), region, smoothSettings, smoothingRegion );
+
+    // The full series is not needed any more once the region is known, the volume below still holds it until it is cropped
+    if ( options.lowMemory )
+    {
+        dicomLoader.release();
+    }
+
+    /***************************************************************
+    *   Crop the DICOM series and apply a Gaussian filter to it
+    ***************************************************************/
+    // Only done when a stage needs the smoothed volume and it is not in the pipeline cache
+    vtkSmartPointer<vtkImageData> smoothed;
+
+    std::function<vtkImageData*()> smoothedVolume = [&]() -> vtkImageData*
+    {
+        if ( smoothed != nullptr )
+        {
+            return smoothed;
+        }
+
+        // The cached volume may hold a larger region than the one asked for, every voxel of it is exact
+        vtkSmartPointer<vtkImageData> cached = cache.readVolume( smoothedKey );
+        if ( cached != nullptr && containsExtent( cached->GetExtent(), region ) )
+        {
+            smoothed = sameExtent( cached->GetExtent(), region ) ? cached : cropImage( cached, region, numThreads );
+            log << "Loaded the smoothed DICOM series from the pipeline cache \n";
+
+            if ( options.lowMemory )
+            {
+                volume = nullptr;
+            }
+            return smoothed;
+        }
+        cached = nullptr;
+
+        if ( options.cropToRegion )
+        {
+            profiler.beginStage( "cropToRegion" );
+
+            vtkIdType numVoxels = volume->GetNumberOfPoints();
+            volume = cropImage( volume, smoothingRegion, numThreads );
+            profiler.setVoxelCount( volume->GetNumberOfPoints() );
+
+            log << "Cropped the DICOM series to the region of interest, " << volume->GetNumberOfPoints() << " of " << numVoxels
+                << " voxels (" << 100.0 * volume->GetNumberOfPoints() / numVoxels << "%) \n";
+        }
+
+        profiler.beginStage( "gaussianSmooth" );
+        smoothed = smoothGaussian( volume, smoothSettings );
+
+        if ( options.lowMemory )
+        {
+            volume = nullptr;
+        }
+
+        // The voxels of the margin were smoothed with a cut off kernel, only the region is kept and cached
+        if ( !sameExtent( smoothed->GetExtent(), region ) )
+        {
+            smoothed = cropImage( smoothed, region, numThreads );
+        }
+        cache.writeVolume( smoothedKey, smoothed );
+        profiler.setVoxelCount( smoothed->GetNumberOfPoints() );
+
+        return smoothed;
+    };
+
+    vtkSmartPointer<vtkMatrix4x4> m = vtkSmartPointer<vtkMatrix4x4>::New();
+
+    // A rerun with the same data and registration parameters only reads the matrix
+    // The distance registration only uses the thresholds, not the surface of the segmentation
+    std::stringstream targetParameters;
+    targetParameters.precision( 17 );
+    if ( options.distanceRegistration )
+    {
+        targetParameters << "segmentation " << options.lowerThresh << " " << options.upperThresh;
+    }
+    else
+    {
+        targetParameters << surfaceParameters( options ) << " " << decimationParameters( options );
+    }
+
+    std::string registrationKey = PipelineCache::makeKey( volumeKey, objLoader.getFingerprint() + " " + targetParameters.str() + " " +
+                                                          registrationParameters( options ) );
+    bool registrationCached = cache.readMatrix( registrationKey, m );
+
+    if ( registrationCached )
+    {
+        log << "\n**Loaded the registration from the pipeline cache** \n";
+    }
+
+    /***************************************************************
+    *   Find the pose on the coarse levels of the pyramid
+    ***************************************************************/
+    vtkSmartPointer<vtkMatrix4x4> initial;
+    if ( !registrationCached && options.pyramidLevels > 1 )
+    {
+        log << "\n**Registering " << options.pyramidLevels - 1 << " coarse resolution levels** \n";
+
+        initial = vtkSmartPointer<vtkMatrix4x4>::New();
+        if ( !registerCoarseLevels( obj, smoothedVolume(), options, numThreads, profiler, result.hypotheses, initial ) )
+        {
+            std::cout << "ERROR: The coarse registration of " << registrationCase.dicomDirectory << " failed, the segmentation is empty.\n";
+            return false;
+        }
+    }
+
+    // The full resolution level, starting from the coarse pose
+    PipelineOptions fineOptions = levelOptions( options, 0 );
+
+    if ( options.distanceRegistration )
+    {
+        /***************************************************************
+        *   Register the OBJ surface to the distance field of the segmentation
+        ***************************************************************/
+        if ( !registrationCached )
+        {
+            log << "\n**Starting image registration (distance field)** \n";
+
+            if ( !registerToDistanceField( obj, smoothedVolume(), fineOptions, numThreads, profiler, initial, m ) )
+            {
+                std::cout << "ERROR: The segmentation of " << registrationCase.dicomDirectory << " is empty.\n";
+                return false;
+            }
+        }
+    }
+    else
+    {
+        /***************************************************************
+        *   Segment the input DICOM series and generate the surface
+        ***************************************************************/
+        log << "\n**Performing image segmentation and generating the surface** \n";
+        log << "Starting surface rendering...";
+
+        vtkSmartPointer<vtkPolyData> surface = extractTargetSurface( smoothedVolume, volumeKey, options, numThreads, profiler, cache, log );
+
+        log << "Done! \n";
+
+        if ( surface->GetNumberOfPoints() == 0 )
+        {
+            std::cout << "ERROR: The segmentation of " << registrationCase.dicomDirectory << " produced an empty surface.\n";
+            return false;
+        }
+
+        /***************************************************************
+        *   Perform ICP registration
+        ***************************************************************/
+        if ( !registrationCached )
+        {
+            log << "\n**Starting image registration** \n";
+
+            // Without the pyramid the starting pose is searched at full resolution
+            if ( initial == nullptr && options.multiStart )
+            {
+                profiler.beginStage( "multiStart" );
+                initial = findStartingPose( obj, surface, fineOptions, numThreads, result.hypotheses );
+            }
+
+            // Perform the registration between the DICOM images and the OBJ file
+            profiler.beginStage( "icp" );
+            if ( !registerSurfaces( obj, surface, fineOptions, numThreads, profiler, initial, m ) )
+            {
+                std::cout << "ERROR: ICP registration of " << registrationCase.objFile << " failed.\n";
+                return false;
+            }
+        }
+
+        result.targetSurface = surface;
+    }
+
+    if ( !registrationCached )
+    {
+        cache.writeMatrix( registrationKey, m );
+    }
+
+    // When the matrix and the surface came from the pipeline cache and nothing is resliced, the smoothed
+    // volume is never computed, so the series is not needed any more
+    if ( options.lowMemory && result.targetSurface != nullptr && !options.resliceSurface && !options.saveResliced && !options.sliceReview )
+    {
+        volume = nullptr;
+    }
+
+    if ( !result.hypotheses.empty() )
+    {
+        log << "\nMulti-start hypotheses (residual after the last round, rounds, seconds): \n";
+        for ( std::size_t i = 0; i < result.hypotheses.size(); i++ )
+        {
+            const PoseHypothesis& hypothesis = result.hypotheses[i];
+            log << "  " << hypothesis.name << ": " << hypothesis.residual << ", " << hypothesis.rounds << ", " << hypothesis.seconds << "\n";
+        }
+    }
+
+    // Output the transformation matrix
+    log << "\nThe resulting transformation matrix is: \n" << std::fixed << std::setprecision(2) << *m;
+
+    if ( options.perVertebra )
+    {
+        // The distance field registration does not extract the DICOM surface, do it now
+        if ( result.targetSurface == nullptr )
+        {
+            log << "Generating the surface of the DICOM series...";
+            result.targetSurface = extractTargetSurface( smoothedVolume, volumeKey, options, numThreads, profiler, cache, log );
+            log << "Done! \n";
+        }
+
+        /***************************************************************
+        *   Register every vertebra separately
+        ***************************************************************/
+        log << "\n**Registering the vertebrae separately** \n";
+
+        profiler.beginStage( "perVertebra" );
+        if ( registerVertebrae( obj, result.targetSurface, options, numThreads, m, result.vertebrae ) )
+        {
+            log << "Vertebra (residual, ICP iterations, DICOM points in its region, seconds): \n";
+            for ( std::size_t i = 0; i < result.vertebrae.size(); i++ )
+            {
+                const VertebraTransform& vertebra = result.vertebrae[i];
+                log << "  " << vertebra.name << ": " << vertebra.residual << ", " << vertebra.iterations << ", "
+                    << vertebra.numTargetPoints << ", " << vertebra.seconds << "\n";
+            }
+        }
+        else
+        {
+            std::cout << "WARNING: " << registrationCase.objFile << " has no materials or groups, the vertebrae are not registered separately.\n";
+        }
+    }
+
+    // The volume in the OBJ space is only resliced when its voxels are used. The smoothed volume is not
+    // computed for a reslice that is never asked for, and in the low memory mode not kept around for one.
+    if ( options.resliceSurface || options.saveResliced || options.sliceReview || ( !options.lowMemory && smoothed != nullptr ) )
+    {
+        result.resliced.setInput( smoothedVolume(), m );
+    }
+
+    vtkSmartPointer<vtkPolyData> registeredSurface;
+
+    if ( options.resliceSurface )
+    {
+        // Perform the transformation using the transformation matrix determined above
+        log << "Transforming the original image into the new coordinate space...";
+
+        profiler.beginStage( "reslice" );
+        vtkSmartPointer<vtkImageData> resliced = result.resliced.getOutput();
+        profiler.setVoxelCount( resliced->GetNumberOfPoints() );
+
+        if ( options.lowMemory )
+        {
+            result.resliced.releaseInput();
+            smoothed = nullptr;
+        }
+
+        log << "Done! \n";
+
+        log << "Performing image segmentation on the transformed image...";
+
+        // Since we had to reslice the original image, we will need to segment and render the resliced image again...
+        registeredSurface = extractDecimatedSurface( resliced, options, numThreads, profiler, true );
+
+        // The resliced volume is only kept when it is written out or reviewed
+        if ( options.lowMemory && !options.saveResliced && !options.sliceReview )
+        {
+            result.resliced.release();
+        }
+
+        log << "Done! \n";
+    }
+    else
+    {
+        // The distance field registration does not extract the DICOM surface, do it now
+        if ( result.targetSurface == nullptr )
+        {
+            log << "Generating the surface of the DICOM series...";
+            result.targetSurface = extractTargetSurface( smoothedVolume, volumeKey, options, numThreads, profiler, cache, log );
+            log << "Done! \n";
+        }
+
+        if ( options.lowMemory )
+        {
+            smoothed = nullptr;
+            volume = nullptr;
+        }
+
+        // The resliced image is the DICOM image seen through the inverse of the matrix, so is its surface
+        log << "Transforming the surface into the new coordinate space...";
+
+        profiler.beginStage( "transformSurface" );
+        vtkSmartPointer<vtkMatrix4x4> inverse = vtkSmartPointer<vtkMatrix4x4>::New();
+        vtkMatrix4x4::Invert( m, inverse );
+        registeredSurface = transformSurface( result.targetSurface, inverse, numThreads );
+        profiler.setTriangleCount( registeredSurface->GetNumberOfPolys() );
+
+        log << "Done! \n";
+    }
+
+    if ( options.surfaceMetrics )
+    {
+        profiler.beginStage( "surfaceDistance" );
+        if ( measureSurfaceDistance( obj, registeredSurface, options.distanceArray, numThreads, result.distance ) )
+        {
+            // The registered surface is the decimated DICOM surface, the distances are those of the decimated mesh
+            result.distance.dicomDecimated = true;
+
+            const SurfaceDistanceMetrics& distance = result.distance;
+            log << "\nSurface distance to the decimated DICOM surface (mean, RMS, 95th percentile, maximum): \n"
+                << "  OBJ to DICOM: " << distance.objToDicom.mean << ", " << distance.objToDicom.rms << ", "
+                << distance.objToDicom.percentile95 << ", " << distance.objToDicom.maximum << "\n"
+                << "  DICOM to OBJ: " << distance.dicomToObj.mean << ", " << distance.dicomToObj.rms << ", "
+                << distance.dicomToObj.percentile95 << ", " << distance.dicomToObj.maximum << "\n"
+                << "  Hausdorff distance: " << distance.symmetric.maximum << " (" << distance.seconds << " s) \n";
+        }
+        else
+        {
+            std::cout << "WARNING: The surface distances of " << registrationCase.name << " were not measured, a surface has no triangles.\n";
+        }
+    }
+    profiler.endStage();
+
+    result.matrix = m;
+    result.objSurface = obj;
+    result.registeredSurface = registeredSurface;
+    result.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+    result.peakMemoryKB = getPeakResidentMemoryKB();
+    result.success = true;
+
+    if ( options.lowMemory )
+    {
+        log << "Peak resident memory: " << result.peakMemoryKB / 1024 << " MB \n";
+    }
+
+    return true;
+}
+
+bool writeRegistrationResult( const std::string& directory, const RegistrationResult& result, bool saveResliced )
+{
+    if ( !vtksys::SystemTools::MakeDirectory( directory ) )
+    {
+        std::cout << "ERROR: Could not create output directory " << directory << "\n";
+        return false;
+    }
+
+    std::ofstream matrixFile( directory + "/icpMatrix.txt" );
+    matrixFile << std::setprecision( 10 );
+
+    for ( int i = 0; i < 4; i++ )
+    {
+        for ( int j = 0; j < 4; j++ )
+        {
+            matrixFile << result.matrix->GetElement( i, j ) << ( j < 3 ? " " : "\n" );
+        }
+    }
+
+    if ( !matrixFile )
+    {
+        std::cout << "ERROR: Could not write " << directory << "/icpMatrix.txt\n";
+        return false;
+    }
+
+    if ( !result.hypotheses.empty() && !writeHypothesisReport( directory + "/multiStart.csv", result.hypotheses ) )
+    {
+        std::cout << "ERROR: Could not write " << directory << "/multiStart.csv\n";
+        return false;
+    }
+
+    if ( !result.vertebrae.empty() && !writeVertebraReport( directory + "/vertebrae.csv", result.vertebrae ) )
+    {
+        std::cout << "ERROR: Could not write " << directory << "/vertebrae.csv\n";
+        return false;
+    }
+
+    if ( result.distance.isValid() && !writeSurfaceDistanceReport( directory + "/surfaceDistance.csv", result.distance ) )
+    {
+        std::cout << "ERROR: Could not write " << directory << "/surfaceDistance.csv\n";
+        return false;
+    }
+
+    // Only now is the volume resliced, when it is asked for
+    if ( saveResliced && result.resliced.hasInput() )
+    {
+        vtkSmartPointer<vtkXMLImageDataWriter> volumeWriter = vtkSmartPointer<vtkXMLImageDataWriter>::New();
+        volumeWriter->SetFileName( ( directory + "/reslicedVolume.vti" ).c_str() );
+        volumeWriter->SetInputData( result.resliced.getOutput() );
+        volumeWriter->SetDataModeToBinary();
+
+        if ( volumeWriter->Write() == 0 )
+        {
+            std::cout << "ERROR: Could not write " << directory << "/reslicedVolume.vti\n";
+            return false;
+        }
+    }
+
+    vtkSmartPointer<vtkXMLPolyDataWriter> surfaceWriter = vtkSmartPointer<vtkXMLPolyDataWriter>::New();
+    surfaceWriter->SetFileName( ( directory + "/registeredSurface.vtp" ).c_str() );
+    surfaceWriter->SetInputData( result.registeredSurface );
+    surfaceWriter->SetDataModeToBinary();
+
+    if ( surfaceWriter->Write() == 0 )
+    {
+        std::cout << "ERROR: Could not write " << directory << "/registeredSurface.vtp\n";
+        return false;
+    }
+
+    return true;
+}
+
+int runBatchRegistration( const std::vector<RegistrationCase>& cases, const PipelineOptions& options )
+{
+    std::vector<RegistrationCase> validCases;
+    int failed = 0;
+
+    for ( std::size_t i = 0; i < cases.size(); i++ )
+    {
+        if ( checkInputs( cases[i].dicomDirectory, cases[i].objFile ) )
+        {
+            validCases.push_back( cases[i] );
+        }
+        else
+        {
+            std::cout << "ERROR: Skipping case " << cases[i].name << "\n";
+            failed++;
+        }
+    }
+
+    if ( validCases.empty() )
+    {
+        return failed;
+    }
+
+    // Split the cores between the concurrent cases so that the pool does not oversubscribe the machine
+    unsigned int numJobs = static_cast<unsigned int>( std::min<std::size_t>( getNumberOfWorkerThreads( options.numJobs ), validCases.size() ) );
+    unsigned int threadsPerCase = std::max( 1u, getNumberOfWorkerThreads() / numJobs );
+    vtkMultiThreader::SetGlobalMaximumNumberOfThreads( static_cast<int>( threadsPerCase ) );
+
+    std::cout << "\n**Registering " << validCases.size() << " cases with " << numJobs << " workers** \n";
+
+    std::mutex outputMutex;
+    ThreadPool pool( numJobs );
+
+    for ( std::size_t i = 0; i < validCases.size(); i++ )
+    {
+        const RegistrationCase& registrationCase = validCases[i];
+
+        pool.enqueue( [&, registrationCase]()
+        {
+            RegistrationResult result;
+            bool success = false;
+
+            try
+            {
+                std::string caseDirectory = options.outputDirectory + "/" + registrationCase.name;
+                success = runRegistration( registrationCase, options, threadsPerCase, result ) &&
+                          writeRegistrationResult( caseDirectory, result, options.saveResliced );
+
+                // The profile of each case goes into the case directory, under the name given on the command line
+                if ( success && result.profile.isEnabled() )
+                {
+                    std::string profileFile = caseDirectory + "/" + vtksys::SystemTools::GetFilenameName( options.profileFile );
+                    success = result.profile.writeReport( profileFile, registrationCase.name );
+                }
+            }
+            catch ( const std::exception& error )
+            {
+                std::lock_guard<std::mutex> lock( outputMutex );
+                std::cout << "ERROR: " << error.what() << "\n";
+            }
+
+            std::lock_guard<std::mutex> lock( outputMutex );
+            if ( success )
+            {
+                std::cout << "Case " << registrationCase.name << " done in " << result.seconds << " s";
+                if ( result.distance.isValid() )
+                {
+                    std::cout << ", mean surface distance " << result.distance.symmetric.mean
+                              << ", Hausdorff " << result.distance.symmetric.maximum;
+                }
+                if ( options.lowMemory )
+                {
+                    // The cases share the process, so this is the peak of all cases run so far
+                    std::cout << ", peak resident memory " << result.peakMemoryKB / 1024 << " MB";
+                }
+                std::cout << " \n";
+            }
+            else
+            {
+                std::cout << "Case " << registrationCase.name << " FAILED \n";
+                failed++;
+            }
+        } );
+    }
+
+    pool.wait();
+
+    return failed;
+}
@@ -0,0 +1,104 @@
+/****************************************************************************
+*   registrationPipeline.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    The segmentation and registration pipeline, shared by
+*                   the interactive and the headless batch mode.
+****************************************************************************/
+
+#ifndef REGISTRATIONPIPELINE_H
+#define REGISTRATIONPIPELINE_H
+
+#include "helperFunctions.hxx"
+#include "multiStartRegistration.hxx"
+#include "pipelineOptions.hxx"
+#include "stageProfiler.hxx"
+#include "surfaceDistance.hxx"
+#include "surfaceTransform.hxx"
+#include "vertebraRegistration.hxx"
+
+#include <vtkPolyData.h>
+
+/*
+*   Everything produced by a single registration run.
+*/
+struct RegistrationResult
+{
+    bool   success;
+    double seconds;
+
+    // ICP transformation from the OBJ space to the DICOM space
+    vtkSmartPointer<vtkMatrix4x4> matrix;
+
+    // Starting poses tried by the multi-start search (empty when it is disabled)
+    std::vector<PoseHypothesis> hypotheses;
+
+    // Transformation of every vertebra from the OBJ space to the DICOM space (empty without --per-vertebra)
+    std::vector<VertebraTransform> vertebrae;
+
+    // The input OBJ surface
+    vtkSmartPointer<vtkPolyData> objSurface;
+
+    // The DICOM surface used as the ICP target (DICOM space)
+    vtkSmartPointer<vtkPolyData> targetSurface;
+
+    // The DICOM surface transformed into the OBJ space
+    vtkSmartPointer<vtkPolyData> registeredSurface;
+
+    // Distances between the OBJ surface and the registered surface (not valid with --no-metrics)
+    SurfaceDistanceMetrics distance;
+
+    // The smoothed DICOM image resliced into the OBJ space, computed on first use
+    LazyReslice resliced;
+
+    // Per-stage measurements (only filled in when options.profileFile is set)
+    StageProfiler profile;
+
+    // Peak resident memory of the process at the end of the run (kilobytes, 0 if not available)
+    long long peakMemoryKB;
+
+    RegistrationResult() : success( false ), seconds( 0.0 ), peakMemoryKB( 0 ) { }
+};
+
+/*
+*   Run the whole pipeline on one case: load, filter, segment, generate the surface,
+*   register with ICP and transform the DICOM surface into the OBJ space.
+*   The thresholds and isovalue must already be set in the options.
+*
+*   @param   registrationCase   The DICOM directory and OBJ file to register
+*   @param   options            Pipeline parameters
+*   @param   numThreads         Number of threads for the parallel stages (0 = one per core)
+*   @param   result             Filled in with the results of the run
+*
+*   @returns TRUE if the registration finished, FALSE otherwise
+*/
+bool runRegistration( const RegistrationCase& registrationCase, const PipelineOptions& options,
+                      unsigned int numThreads, RegistrationResult& result );
+
+/*
+*   Write the ICP matrix (icpMatrix.txt) and the registered surface (registeredSurface.vtp),
+*   the residual and time of every multi-start hypothesis (multiStart.csv), the transformation
+*   of every vertebra (vertebrae.csv) and the surface distances (surfaceDistance.csv) when there are any.
+*
+*   @param   directory      Output directory, created if it does not exist
+*   @param   result         Result of a successful registration
+*   @param   saveResliced   Also reslice the image and write it (reslicedVolume.vti)
+*
+*   @returns TRUE if all files were written, FALSE otherwise
+*/
+bool writeRegistrationResult( const std::string& directory, const RegistrationResult& result, bool saveResliced = false );
+
+/*
+*   Register many cases headlessly. Cases run concurrently on a bounded pool of
+*   options.numJobs workers and the results of each case (and its profile, when
+*   profiling is enabled) are written to <options.outputDirectory>/<case name>.
+*
+*   @param   cases     Cases to process
+*   @param   options   Pipeline parameters shared by all cases
+*
+*   @returns The number of cases that failed
+*/
+int runBatchRegistration( const std::vector<RegistrationCase>& cases, const PipelineOptions& options );
+
+#endif // REGISTRATIONPIPELINE_H
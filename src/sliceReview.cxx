@@ -0,0 +1,299 @@
+/****************************************************************************
+*   sliceReview.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the slice review data.
+****************************************************************************/
+
+#include "sliceReview.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPoints.h>
+
+// Slices computed ahead of the current one in the direction of the last move, and behind it
+static const int PREFETCH_AHEAD = 6;
+static const int PREFETCH_BEHIND = 2;
+
+// Computed slices further than this from the current one are dropped
+static const int KEEP_SLICES = 16;
+
+// The contour is drawn this far in front of its slice (fraction of the slice spacing), so it is not hidden by the image
+static const double CONTOUR_OFFSET = 0.25;
+
+SliceReview::SliceReview() : _Current( 0 ), _Direction( 1 ), _Stopping( false ), _Prefetcher( 1 )
+{
+    std::fill( _Extent, _Extent + 6, 0 );
+    std::fill( _Origin, _Origin + 3, 0.0 );
+    std::fill( _Spacing, _Spacing + 3, 1.0 );
+}
+
+SliceReview::~SliceReview()
+{
+    {
+        std::lock_guard<std::mutex> lock( _Mutex );
+        _Stopping = true;
+    }
+
+    // The queued tasks see _Stopping and return at once
+    _Prefetcher.wait();
+}
+
+bool SliceReview::setInput( const LazyReslice& volume, vtkPolyData* objSurface )
+{
+    _Prefetcher.wait();
+
+    _Volume = volume;
+    _Slices.clear();
+    _Vertices.clear();
+    _SliceStart.clear();
+    _SliceTriangles.clear();
+
+    if ( !_Volume.getOutputGrid( _Extent, _Origin, _Spacing ) )
+    {
+        return false;
+    }
+
+    int numSlices = _Extent[5] - _Extent[4] + 1;
+    _Current = _Extent[4];
+    _SliceStart.assign( numSlices + 1, 0 );
+
+    vtkPoints* points = objSurface->GetPoints();
+    vtkIdType numPolys = objSurface->GetNumberOfPolys();
+    if ( points == nullptr || numPolys == 0 )
+    {
+        return true;
+    }
+
+    // Triangle vertices, polygons split into fans
+    const vtkIdType* cells = objSurface->GetPolys()->GetData()->GetPointer( 0 );
+    vtkIdType position = 0;
+    double p[3];
+
+    for ( vtkIdType c = 0; c < numPolys; c++ )
+    {
+        vtkIdType numCorners = cells[position];
+        for ( vtkIdType k = 1; k + 1 < numCorners; k++ )
+        {
+            vtkIdType corners[3] = { cells[position + 1], cells[position + 1 + k], cells[position + 2 + k] };
+            for ( int corner = 0; corner < 3; corner++ )
+            {
+                points->GetPoint( corners[corner], p );
+                _Vertices.push_back( static_cast<float>( p[0] ) );
+                _Vertices.push_back( static_cast<float>( p[1] ) );
+                _Vertices.push_back( static_cast<float>( p[2] ) );
+            }
+        }
+        position += numCorners + 1;
+    }
+
+    // Slices crossed by every triangle, then the triangles of every slice (counted first, then filled in)
+    std::size_t numTriangles = _Vertices.size() / 9;
+    std::vector<int> firstSlice( numTriangles ), lastSlice( numTriangles );
+
+    for ( std::size_t t = 0; t < numTriangles; t++ )
+    {
+        const float* v = &_Vertices[9 * t];
+        double zMin = std::min( v[2], std::min( v[5], v[8] ) );
+        double zMax = std::max( v[2], std::max( v[5], v[8] ) );
+
+        firstSlice[t] = std::max( _Extent[4], static_cast<int>( std::ceil( ( zMin - _Origin[2] ) / _Spacing[2] ) ) );
+        lastSlice[t] = std::min( _Extent[5], static_cast<int>( std::floor( ( zMax - _Origin[2] ) / _Spacing[2] ) ) );
+
+        for ( int s = firstSlice[t]; s <= lastSlice[t]; s++ )
+        {
+            _SliceStart[s - _Extent[4] + 1]++;
+        }
+    }
+
+    for ( int s = 0; s < numSlices; s++ )
+    {
+        _SliceStart[s + 1] += _SliceStart[s];
+    }
+
+    _SliceTriangles.resize( _SliceStart[numSlices] );
+    std::vector<std::size_t> next( _SliceStart.begin(), _SliceStart.end() - 1 );
+
+    for ( std::size_t t = 0; t < numTriangles; t++ )
+    {
+        for ( int s = firstSlice[t]; s <= lastSlice[t]; s++ )
+        {
+            _SliceTriangles[next[s - _Extent[4]]++] = t;
+        }
+    }
+
+    return true;
+}
+
+bool SliceReview::getSlice( int slice, vtkSmartPointer<vtkImageData>& image, vtkSmartPointer<vtkPolyData>& contour )
+{
+    if ( slice < _Extent[4] || slice > _Extent[5] || _SliceStart.empty() )
+    {
+        return false;
+    }
+
+    SliceData data;
+    bool found = false;
+    {
+        std::lock_guard<std::mutex> lock( _Mutex );
+
+        if ( slice != _Current )
+        {
+            _Direction = ( slice > _Current ) ? 1 : -1;
+            _Current = slice;
+        }
+
+        // Forget the slices that were left behind
+        for ( std::map<int, SliceData>::iterator it = _Slices.begin(); it != _Slices.end(); )
+        {
+            it = isWanted( it->first ) ? std::next( it ) : _Slices.erase( it );
+        }
+
+        std::map<int, SliceData>::const_iterator cached = _Slices.find( slice );
+        if ( cached != _Slices.end() )
+        {
+            data = cached->second;
+            found = true;
+        }
+    }
+
+    // Not prefetched (yet), compute it now on all cores. The prefetch thread may be computing
+    // the same slice, whichever is stored last is the same slice.
+    if ( !found )
+    {
+        data = computeSlice( slice, 0 );
+
+        std::lock_guard<std::mutex> lock( _Mutex );
+        _Slices[slice] = data;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( _Mutex );
+        prefetchNeighbours();
+    }
+
+    image = data.image;
+    contour = data.contour;
+    return image != nullptr;
+}
+
+SliceReview::SliceData SliceReview::computeSlice( int slice, unsigned int numThreads ) const
+{
+    SliceData data;
+    data.image = _Volume.getSlice( slice, numThreads );
+    data.contour = cutSurface( slice );
+    return data;
+}
+
+vtkSmartPointer<vtkPolyData> SliceReview::cutSurface( int slice ) const
+{
+    double z = _Origin[2] + slice * _Spacing[2];
+    float drawZ = static_cast<float>( z + CONTOUR_OFFSET * _Spacing[2] );
+
+    std::vector<float> coordinates;
+    std::size_t first = _SliceStart[slice - _Extent[4]];
+    std::size_t last = _SliceStart[slice - _Extent[4] + 1];
+
+    for ( std::size_t i = first; i < last; i++ )
+    {
+        const float* v = &_Vertices[9 * _SliceTriangles[i]];
+
+        // Vertices on the plane count as above it, so a triangle has either no or two crossing edges
+        for ( int edge = 0; edge < 3; edge++ )
+        {
+            const float* a = v + 3 * edge;
+            const float* b = v + 3 * ( ( edge + 1 ) % 3 );
+            double da = a[2] - z, db = b[2] - z;
+
+            if ( ( da >= 0.0 ) == ( db >= 0.0 ) )
+            {
+                continue;
+            }
+
+            double t = da / ( da - db );
+            coordinates.push_back( static_cast<float>( a[0] + t * ( b[0] - a[0] ) ) );
+            coordinates.push_back( static_cast<float>( a[1] + t * ( b[1] - a[1] ) ) );
+            coordinates.push_back( drawZ );
+        }
+    }
+
+    vtkIdType numPoints = static_cast<vtkIdType>( coordinates.size() / 3 );
+
+    vtkSmartPointer<vtkFloatArray> pointArray = vtkSmartPointer<vtkFloatArray>::New();
+    pointArray->SetNumberOfComponents( 3 );
+    pointArray->SetNumberOfTuples( numPoints );
+    std::copy( coordinates.begin(), coordinates.end(), pointArray->GetPointer( 0 ) );
+
+    vtkSmartPointer<vtkIdTypeArray> cellArray = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellArray->SetNumberOfValues( 3 * ( numPoints / 2 ) );
+    vtkIdType* cells = cellArray->GetPointer( 0 );
+    for ( vtkIdType line = 0; line < numPoints / 2; line++ )
+    {
+        cells[3 * line] = 2;
+        cells[3 * line + 1] = 2 * line;
+        cells[3 * line + 2] = 2 * line + 1;
+    }
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData( pointArray );
+
+    vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+    lines->SetCells( numPoints / 2, cellArray );
+
+    vtkSmartPointer<vtkPolyData> contour = vtkSmartPointer<vtkPolyData>::New();
+    contour->SetPoints( points );
+    contour->SetLines( lines );
+    return contour;
+}
+
+bool SliceReview::isWanted( int slice ) const
+{
+    return std::abs( slice - _Current ) <= KEEP_SLICES;
+}
+
+void SliceReview::prefetchNeighbours()
+{
+    for ( int distance = 1; distance <= PREFETCH_AHEAD; distance++ )
+    {
+        int candidates[2] = { _Current + _Direction * distance, _Current - _Direction * distance };
+        for ( int c = 0; c < 2; c++ )
+        {
+            int slice = candidates[c];
+            if ( ( c == 1 && distance > PREFETCH_BEHIND ) || slice < _Extent[4] || slice > _Extent[5] ||
+                 _Slices.count( slice ) > 0 || _Queued.count( slice ) > 0 )
+            {
+                continue;
+            }
+
+            _Queued.insert( slice );
+            _Prefetcher.enqueue( [this, slice]()
+            {
+                {
+                    std::lock_guard<std::mutex> lock( _Mutex );
+                    if ( _Stopping || !isWanted( slice ) || _Slices.count( slice ) > 0 )
+                    {
+                        _Queued.erase( slice );
+                        return;
+                    }
+                }
+
+                // One thread, the interactor keeps the other cores for the slices it needs now
+                SliceData data = computeSlice( slice, 1 );
+
+                std::lock_guard<std::mutex> lock( _Mutex );
+                _Queued.erase( slice );
+                if ( !_Stopping && isWanted( slice ) )
+                {
+                    _Slices[slice] = data;
+                }
+            } );
+        }
+    }
+}
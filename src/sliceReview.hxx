@@ -0,0 +1,128 @@
+/****************************************************************************
+*   sliceReview.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Slices of the registered CT volume with the contour of
+*                   the OBJ surface, resampled on demand and prefetched on
+*                   a background thread for the slice review viewer.
+****************************************************************************/
+
+#ifndef SLICEREVIEW_H
+#define SLICEREVIEW_H
+
+#include "surfaceTransform.hxx"
+#include "threadPool.hxx"
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <vtkImageData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   The CT volume resliced into the OBJ space, one slice at a time, with the contour of the
+*   OBJ surface on every slice, for reviewing a registration slice by slice.
+*
+*   A slice is resampled from the CT volume only when it is asked for (see LazyReslice::getSlice()),
+*   the whole volume is never resliced. The OBJ triangles are sorted into the slices they cross
+*   once, so a contour only cuts the triangles of its own slice. After every slice that is asked
+*   for, the next slices in the direction of the last move (and a few behind) are computed on a
+*   background thread, so scrolling usually finds the next slice ready. Slices far from the
+*   current one are dropped again.
+*/
+class SliceReview
+{
+    public:
+        SliceReview();
+
+        /*
+        *   Stop the prefetching, slices that are being computed are finished first.
+        */
+        ~SliceReview();
+
+        /*
+        *   Set the registered volume and the OBJ surface (OBJ space). Drops all computed slices.
+        *
+        *   @param   volume       CT volume and registration matrix, only its input is used
+        *   @param   objSurface   OBJ surface whose contour is drawn on the slices
+        *
+        *   @returns FALSE if the volume has no input
+        */
+        bool setInput( const LazyReslice& volume, vtkPolyData* objSurface );
+
+        /*
+        *   Range of the slice numbers (z indices of the resliced grid).
+        */
+        int getFirstSlice() const { return _Extent[4]; }
+        int getLastSlice() const { return _Extent[5]; }
+
+        /*
+        *   Get a slice and its contour, computed now on all cores unless it was prefetched, and
+        *   start prefetching its neighbours. Only called from one thread (the interactor).
+        *
+        *   @param   slice     Slice number
+        *   @param   image     Set to the slice, one voxel thick, at its place in the resliced grid
+        *   @param   contour   Set to the contour of the OBJ surface on the slice (lines)
+        *
+        *   @returns FALSE if the slice is outside the volume
+        */
+        bool getSlice( int slice, vtkSmartPointer<vtkImageData>& image, vtkSmartPointer<vtkPolyData>& contour );
+
+    private:
+        struct SliceData
+        {
+            vtkSmartPointer<vtkImageData> image;
+            vtkSmartPointer<vtkPolyData>  contour;
+        };
+
+        LazyReslice _Volume;
+        int         _Extent[6];
+        double      _Origin[3];
+        double      _Spacing[3];
+
+        // Vertices of the OBJ triangles (9 per triangle), the triangles crossing slice s are
+        // _SliceTriangles[_SliceStart[s - first slice]] to _SliceTriangles[_SliceStart[s - first slice + 1] - 1]
+        std::vector<float>       _Vertices;
+        std::vector<std::size_t> _SliceStart;
+        std::vector<std::size_t> _SliceTriangles;
+
+        // Computed and queued slices, shared with the prefetch thread
+        std::mutex               _Mutex;
+        std::map<int, SliceData> _Slices;
+        std::set<int>            _Queued;
+        int                      _Current;
+        int                      _Direction;
+        bool                     _Stopping;
+
+        // Declared last, so the thread stops before the data it uses is destroyed
+        ThreadPool _Prefetcher;
+
+        /*
+        *   Resample a slice and cut its contour.
+        */
+        SliceData computeSlice( int slice, unsigned int numThreads ) const;
+
+        /*
+        *   Cut the OBJ triangles crossing a slice with its plane.
+        */
+        vtkSmartPointer<vtkPolyData> cutSurface( int slice ) const;
+
+        /*
+        *   @returns TRUE if a slice is close enough to the current one to be kept (lock held)
+        */
+        bool isWanted( int slice ) const;
+
+        /*
+        *   Queue the neighbours of the current slice that are not computed yet (lock held).
+        */
+        void prefetchNeighbours();
+
+        SliceReview( const SliceReview& );
+        SliceReview& operator=( const SliceReview& );
+};
+
+#endif // SLICEREVIEW_H
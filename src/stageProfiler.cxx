@@ -0,0 +1,223 @@
+/****************************************************************************
+*   stageProfiler.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the pipeline stage profiler.
+****************************************************************************/
+
+#include "stageProfiler.hxx"
+
+#include <fstream>
+#include <iomanip>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+long long getPeakResidentMemoryKB()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if ( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+    {
+        return static_cast<long long>( counters.PeakWorkingSetSize / 1024 );
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if ( getrusage( RUSAGE_SELF, &usage ) != 0 )
+    {
+        return 0;
+    }
+
+    #ifdef __APPLE__
+        // macOS reports bytes, Linux reports kilobytes
+        return static_cast<long long>( usage.ru_maxrss / 1024 );
+    #else
+        return static_cast<long long>( usage.ru_maxrss );
+    #endif
+#endif
+}
+
+StageProfiler::StageProfiler() : _Enabled( false ), _InStage( false ), _StagePeakMemoryKB( 0 )
+{
+}
+
+void StageProfiler::beginStage( const char* name )
+{
+    if ( !_Enabled )
+    {
+        return;
+    }
+
+    if ( _InStage )
+    {
+        endStage();
+    }
+
+    StageRecord record;
+    record.name = name;
+    _Stages.push_back( record );
+
+    _InStage = true;
+    _StagePeakMemoryKB = getPeakResidentMemoryKB();
+    _StageStart = std::chrono::steady_clock::now();
+}
+
+void StageProfiler::endStage()
+{
+    if ( !_Enabled || !_InStage )
+    {
+        return;
+    }
+
+    StageRecord& record = _Stages.back();
+    record.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - _StageStart ).count();
+    record.peakMemoryDeltaKB = getPeakResidentMemoryKB() - _StagePeakMemoryKB;
+
+    _InStage = false;
+}
+
+void StageProfiler::setVoxelCount( long long voxels )
+{
+    if ( _Enabled && !_Stages.empty() )
+    {
+        _Stages.back().voxels = voxels;
+    }
+}
+
+void StageProfiler::setTriangleCount( long long triangles )
+{
+    if ( _Enabled && !_Stages.empty() )
+    {
+        _Stages.back().triangles = triangles;
+    }
+}
+
+void StageProfiler::addIterationDistance( double meanDistance )
+{
+    if ( _Enabled && !_Stages.empty() )
+    {
+        _Stages.back().iterationDistances.push_back( meanDistance );
+    }
+}
+
+bool StageProfiler::writeReport( const std::string& fileName, const std::string& runName ) const
+{
+    std::ofstream file( fileName );
+    if ( !file )
+    {
+        return false;
+    }
+
+    file << std::setprecision( 9 );
+
+    bool isCSV = fileName.size() >= 4 && fileName.compare( fileName.size() - 4, 4, ".csv" ) == 0;
+    return isCSV ? writeCSV( file, runName ) : writeJSON( file, runName );
+}
+
+/*
+*   Quote a string for JSON output.
+*/
+static std::string jsonString( const std::string& text )
+{
+    std::string quoted = "\"";
+    for ( std::size_t i = 0; i < text.size(); i++ )
+    {
+        if ( text[i] == '"' || text[i] == '\\' )
+        {
+            quoted += '\\';
+        }
+        quoted += text[i];
+    }
+    return quoted + "\"";
+}
+
+bool StageProfiler::writeJSON( std::ostream& stream, const std::string& runName ) const
+{
+    double total = 0.0;
+    for ( std::size_t i = 0; i < _Stages.size(); i++ )
+    {
+        total += _Stages[i].seconds;
+    }
+
+    stream << "{\n";
+    stream << "  \"run\": " << jsonString( runName ) << ",\n";
+    stream << "  \"totalSeconds\": " << total << ",\n";
+    stream << "  \"peakMemoryKB\": " << getPeakResidentMemoryKB() << ",\n";
+    stream << "  \"stages\": [\n";
+
+    for ( std::size_t i = 0; i < _Stages.size(); i++ )
+    {
+        const StageRecord& record = _Stages[i];
+
+        stream << "    { \"name\": " << jsonString( record.name )
+               << ", \"seconds\": " << record.seconds
+               << ", \"peakMemoryDeltaKB\": " << record.peakMemoryDeltaKB;
+
+        if ( record.voxels >= 0 )
+        {
+            stream << ", \"voxels\": " << record.voxels;
+        }
+
+        if ( record.triangles >= 0 )
+        {
+            stream << ", \"triangles\": " << record.triangles;
+        }
+
+        if ( !record.iterationDistances.empty() )
+        {
+            stream << ", \"iterationMeanDistances\": [";
+            for ( std::size_t j = 0; j < record.iterationDistances.size(); j++ )
+            {
+                stream << ( j > 0 ? ", " : "" ) << record.iterationDistances[j];
+            }
+            stream << "]";
+        }
+
+        stream << " }" << ( i + 1 < _Stages.size() ? "," : "" ) << "\n";
+    }
+
+    stream << "  ]\n";
+    stream << "}\n";
+
+    return static_cast<bool>( stream );
+}
+
+bool StageProfiler::writeCSV( std::ostream& stream, const std::string& runName ) const
+{
+    stream << "run,stage,seconds,peak_memory_delta_kb,voxels,triangles,iteration_mean_distances\n";
+
+    for ( std::size_t i = 0; i < _Stages.size(); i++ )
+    {
+        const StageRecord& record = _Stages[i];
+
+        stream << runName << "," << record.name << "," << record.seconds << "," << record.peakMemoryDeltaKB << ",";
+
+        if ( record.voxels >= 0 )
+        {
+            stream << record.voxels;
+        }
+        stream << ",";
+
+        if ( record.triangles >= 0 )
+        {
+            stream << record.triangles;
+        }
+        stream << ",";
+
+        // Iteration distances are separated by semicolons to keep one row per stage
+        for ( std::size_t j = 0; j < record.iterationDistances.size(); j++ )
+        {
+            stream << ( j > 0 ? ";" : "" ) << record.iterationDistances[j];
+        }
+        stream << "\n";
+    }
+
+    return static_cast<bool>( stream );
+}
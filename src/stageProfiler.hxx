@@ -0,0 +1,122 @@
+/****************************************************************************
+*   stageProfiler.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Per-stage timing, memory and quality instrumentation
+*                   of the registration pipeline.
+****************************************************************************/
+
+#ifndef STAGEPROFILER_H
+#define STAGEPROFILER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/*
+*   Measurements of a single pipeline stage.
+*   Counts are -1 when they do not apply to the stage.
+*/
+struct StageRecord
+{
+    std::string name;
+    double      seconds;
+    long long   peakMemoryDeltaKB;
+    long long   voxels;
+    long long   triangles;
+
+    // Mean distance between the source points and their closest target points, per ICP iteration
+    std::vector<double> iterationDistances;
+
+    StageRecord() : seconds( 0.0 ), peakMemoryDeltaKB( 0 ), voxels( -1 ), triangles( -1 ) { }
+};
+
+/*
+*   Records wall time, peak resident memory growth and data sizes of every stage.
+*
+*   The profiler is always compiled in. When it is disabled (the default) every call
+*   returns straight away, so the cost is a single branch per call.
+*/
+class StageProfiler
+{
+    public:
+        StageProfiler();
+
+        void setEnabled( bool enabled ) { _Enabled = enabled; }
+        bool isEnabled() const { return _Enabled; }
+
+        /*
+        *   Start timing a new stage. Ends the current stage if there is one.
+        *
+        *   @param   name   Name of the stage as it appears in the report
+        */
+        void beginStage( const char* name );
+
+        /*
+        *   Stop timing the current stage.
+        */
+        void endStage();
+
+        /*
+        *   Record data sizes and ICP progress for the most recent stage.
+        */
+        void setVoxelCount( long long voxels );
+        void setTriangleCount( long long triangles );
+        void addIterationDistance( double meanDistance );
+
+        const std::vector<StageRecord>& getStages() const { return _Stages; }
+
+        /*
+        *   Write the measurements of all stages. The format is chosen from the
+        *   file extension: CSV for ".csv", JSON otherwise.
+        *
+        *   @param   fileName   Path of the report
+        *   @param   runName    Name of the run stored in the report
+        *
+        *   @returns TRUE if the report was written, FALSE otherwise
+        */
+        bool writeReport( const std::string& fileName, const std::string& runName ) const;
+
+    private:
+        bool _Enabled;
+        bool _InStage;
+        long long _StagePeakMemoryKB;
+        std::chrono::steady_clock::time_point _StageStart;
+        std::vector<StageRecord> _Stages;
+
+        bool writeJSON( std::ostream& stream, const std::string& runName ) const;
+        bool writeCSV( std::ostream& stream, const std::string& runName ) const;
+};
+
+/*
+*   Times a stage for as long as the object is in scope.
+*/
+class ScopedStage
+{
+    public:
+        ScopedStage( StageProfiler& profiler, const char* name ) : _Profiler( profiler )
+        {
+            _Profiler.beginStage( name );
+        }
+
+        ~ScopedStage()
+        {
+            _Profiler.endStage();
+        }
+
+    private:
+        StageProfiler& _Profiler;
+
+        ScopedStage( const ScopedStage& );
+        ScopedStage& operator=( const ScopedStage& );
+};
+
+/*
+*   Get the peak resident memory (high-water mark) of the process.
+*
+*   @returns The peak resident memory in kilobytes, or 0 if it is not available
+*/
+long long getPeakResidentMemoryKB();
+
+#endif // STAGEPROFILER_H
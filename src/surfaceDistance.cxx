@@ -0,0 +1,552 @@
+/****************************************************************************
+*   surfaceDistance.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the surface distance metrics.
+****************************************************************************/
+
+#include "surfaceDistance.hxx"
+#include "parallelUtils.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+// Ranges with at most this many triangles are leaves
+static const std::size_t BVH_LEAF_SIZE = 4;
+
+// The top levels are split on one thread until there are this many subtrees per thread
+static const std::size_t BVH_SUBTREES_PER_THREAD = 4;
+
+// Deepest possible traversal stack, median splits keep the depth at log2 of the triangle count
+static const int BVH_MAX_DEPTH = 64;
+
+namespace
+{
+
+/*
+*   Number of nodes of a subtree over n triangles. Every size met while building is stored, so the
+*   subtrees can later look up the size of their left child from several threads at once.
+*/
+std::size_t countNodes( std::size_t n, std::map<std::size_t, std::size_t>& subtreeNodes )
+{
+    if ( n <= BVH_LEAF_SIZE )
+    {
+        return 1;
+    }
+
+    std::map<std::size_t, std::size_t>::const_iterator known = subtreeNodes.find( n );
+    if ( known != subtreeNodes.end() )
+    {
+        return known->second;
+    }
+
+    std::size_t nodes = 1 + countNodes( n / 2, subtreeNodes ) + countNodes( n - n / 2, subtreeNodes );
+    subtreeNodes[n] = nodes;
+    return nodes;
+}
+
+/*
+*   Squared distance from a point to a box, 0 inside.
+*/
+inline double boxDistance2( const double lower[3], const double upper[3], const double p[3] )
+{
+    double distance2 = 0.0;
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        double d = std::max( 0.0, std::max( lower[axis] - p[axis], p[axis] - upper[axis] ) );
+        distance2 += d * d;
+    }
+    return distance2;
+}
+
+inline double dot( const double a[3], const double b[3] )
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+/*
+*   Closest point to p on the triangle abc, by the Voronoi region of p (Ericson, Real-Time Collision Detection 5.1.5).
+*
+*   @returns The squared distance to the closest point
+*/
+double closestPointOnTriangle( const double p[3], const double a[3], const double b[3], const double c[3], double closest[3] )
+{
+    double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    double ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    double ap[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+
+    double d1 = dot( ab, ap ), d2 = dot( ac, ap );
+    double v = 0.0, w = 0.0;
+
+    if ( d1 <= 0.0 && d2 <= 0.0 )
+    {
+        // Vertex a
+    }
+    else
+    {
+        double bp[3] = { p[0] - b[0], p[1] - b[1], p[2] - b[2] };
+        double d3 = dot( ab, bp ), d4 = dot( ac, bp );
+
+        double cp[3] = { p[0] - c[0], p[1] - c[1], p[2] - c[2] };
+        double d5 = dot( ab, cp ), d6 = dot( ac, cp );
+
+        double va = d3 * d6 - d5 * d4;
+        double vb = d5 * d2 - d1 * d6;
+        double vc = d1 * d4 - d3 * d2;
+
+        if ( d3 >= 0.0 && d4 <= d3 )
+        {
+            v = 1.0;    // Vertex b
+        }
+        else if ( d6 >= 0.0 && d5 <= d6 )
+        {
+            w = 1.0;    // Vertex c
+        }
+        else if ( vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0 )
+        {
+            v = d1 / ( d1 - d3 );   // Edge ab
+        }
+        else if ( vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0 )
+        {
+            w = d2 / ( d2 - d6 );   // Edge ac
+        }
+        else if ( va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0 )
+        {
+            w = ( d4 - d3 ) / ( ( d4 - d3 ) + ( d5 - d6 ) );   // Edge bc
+            v = 1.0 - w;
+        }
+        else
+        {
+            double denominator = va + vb + vc;
+            if ( denominator > 0.0 )
+            {
+                v = vb / denominator;
+                w = vc / denominator;
+            }
+        }
+    }
+
+    double distance2 = 0.0;
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        closest[axis] = a[axis] + v * ab[axis] + w * ac[axis];
+        distance2 += ( p[axis] - closest[axis] ) * ( p[axis] - closest[axis] );
+    }
+    return distance2;
+}
+
+} // namespace
+
+void TriangleBVH::build( vtkPolyData* surface, unsigned int numThreads )
+{
+    _Vertices.clear();
+    _Nodes.clear();
+
+    vtkPoints* points = surface->GetPoints();
+    vtkIdType numPolys = surface->GetNumberOfPolys();
+    if ( points == nullptr || numPolys == 0 )
+    {
+        return;
+    }
+
+    std::size_t numPoints = static_cast<std::size_t>( points->GetNumberOfPoints() );
+    std::vector<double> coordinates( 3 * numPoints );
+    parallelFor( 0, numPoints, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t i = begin; i < end; i++ )
+        {
+            points->GetPoint( static_cast<vtkIdType>( i ), &coordinates[3 * i] );
+        }
+    }, numThreads );
+
+    // Three point ids per triangle, polygons split into fans
+    const vtkIdType* cells = surface->GetPolys()->GetData()->GetPointer( 0 );
+    std::vector<vtkIdType> triangles;
+    triangles.reserve( 3 * numPolys );
+
+    vtkIdType position = 0;
+    for ( vtkIdType c = 0; c < numPolys; c++ )
+    {
+        vtkIdType numCorners = cells[position];
+        for ( vtkIdType k = 1; k + 1 < numCorners; k++ )
+        {
+            triangles.push_back( cells[position + 1] );
+            triangles.push_back( cells[position + 1 + k] );
+            triangles.push_back( cells[position + 2 + k] );
+        }
+        position += numCorners + 1;
+    }
+
+    std::size_t numTriangles = triangles.size() / 3;
+    if ( numTriangles == 0 )
+    {
+        return;
+    }
+
+    std::vector<BuildTriangle> order( numTriangles );
+    parallelFor( 0, numTriangles, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t t = begin; t < end; t++ )
+        {
+            for ( int axis = 0; axis < 3; axis++ )
+            {
+                order[t].centre[axis] = static_cast<float>( ( coordinates[3 * triangles[3 * t] + axis] + coordinates[3 * triangles[3 * t + 1] + axis] +
+                                                              coordinates[3 * triangles[3 * t + 2] + axis] ) / 3.0 );
+            }
+            order[t].id = t;
+        }
+    }, numThreads );
+
+    std::map<std::size_t, std::size_t> subtreeNodes;
+    _Nodes.resize( countNodes( numTriangles, subtreeNodes ) );
+
+    // Split the top levels on this thread, then build the subtrees below them in parallel
+    struct Range
+    {
+        std::size_t node;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    std::size_t numSubtrees = BVH_SUBTREES_PER_THREAD * getNumberOfWorkerThreads( numThreads );
+    std::vector<Range> ranges( 1 );
+    ranges[0].node = 0;
+    ranges[0].begin = 0;
+    ranges[0].end = numTriangles;
+
+    bool splitting = true;
+    while ( splitting && ranges.size() < numSubtrees )
+    {
+        splitting = false;
+        std::vector<Range> next;
+
+        for ( std::size_t i = 0; i < ranges.size(); i++ )
+        {
+            const Range& range = ranges[i];
+            std::size_t middle = splitNode( range.node, range.begin, range.end, order, subtreeNodes );
+            if ( middle == range.end )
+            {
+                continue;
+            }
+
+            Range left = { range.node + 1, range.begin, middle };
+            Range right = { _Nodes[range.node].right, middle, range.end };
+            next.push_back( left );
+            next.push_back( right );
+            splitting = true;
+        }
+
+        if ( splitting )
+        {
+            ranges.swap( next );
+        }
+    }
+
+    if ( splitting )
+    {
+        parallelFor( 0, ranges.size(), [&]( std::size_t begin, std::size_t end )
+        {
+            for ( std::size_t i = begin; i < end; i++ )
+            {
+                buildRange( ranges[i].node, ranges[i].begin, ranges[i].end, order, subtreeNodes );
+            }
+        }, numThreads, 1 );
+    }
+
+    // Triangle vertices in tree order
+    _Vertices.resize( 9 * numTriangles );
+    parallelFor( 0, numTriangles, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t t = begin; t < end; t++ )
+        {
+            for ( int corner = 0; corner < 3; corner++ )
+            {
+                std::copy( &coordinates[3 * triangles[3 * order[t].id + corner]], &coordinates[3 * triangles[3 * order[t].id + corner]] + 3,
+                           &_Vertices[9 * t + 3 * corner] );
+            }
+        }
+    }, numThreads );
+
+    // Bounds of the leaves, then of the inner nodes from the bottom up (children come after their parent)
+    parallelFor( 0, _Nodes.size(), [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t n = begin; n < end; n++ )
+        {
+            Node& node = _Nodes[n];
+            if ( node.count == 0 )
+            {
+                continue;
+            }
+
+            for ( int axis = 0; axis < 3; axis++ )
+            {
+                node.lower[axis] = std::numeric_limits<double>::max();
+                node.upper[axis] = -std::numeric_limits<double>::max();
+            }
+
+            for ( std::size_t v = 3 * node.first; v < 3 * ( node.first + node.count ); v++ )
+            {
+                for ( int axis = 0; axis < 3; axis++ )
+                {
+                    node.lower[axis] = std::min( node.lower[axis], _Vertices[3 * v + axis] );
+                    node.upper[axis] = std::max( node.upper[axis], _Vertices[3 * v + axis] );
+                }
+            }
+        }
+    }, numThreads );
+
+    for ( std::size_t n = _Nodes.size(); n-- > 0; )
+    {
+        Node& node = _Nodes[n];
+        if ( node.count > 0 )
+        {
+            continue;
+        }
+
+        const Node& left = _Nodes[n + 1];
+        const Node& right = _Nodes[node.right];
+        for ( int axis = 0; axis < 3; axis++ )
+        {
+            node.lower[axis] = std::min( left.lower[axis], right.lower[axis] );
+            node.upper[axis] = std::max( left.upper[axis], right.upper[axis] );
+        }
+    }
+}
+
+std::size_t TriangleBVH::splitNode( std::size_t node, std::size_t begin, std::size_t end, std::vector<BuildTriangle>& order,
+                                    const std::map<std::size_t, std::size_t>& subtreeNodes )
+{
+    Node& current = _Nodes[node];
+    current.first = begin;
+    current.count = 0;
+    current.right = 0;
+
+    if ( end - begin <= BVH_LEAF_SIZE )
+    {
+        current.count = end - begin;
+        return end;
+    }
+
+    // Split along the axis with the largest spread of the centres
+    float lo[3] = { std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+    float hi[3] = { -lo[0], -lo[1], -lo[2] };
+
+    for ( std::size_t n = begin; n < end; n++ )
+    {
+        const float* p = order[n].centre;
+        for ( int axis = 0; axis < 3; axis++ )
+        {
+            lo[axis] = std::min( lo[axis], p[axis] );
+            hi[axis] = std::max( hi[axis], p[axis] );
+        }
+    }
+
+    int axis = 0;
+    if ( hi[1] - lo[1] > hi[axis] - lo[axis] ) axis = 1;
+    if ( hi[2] - lo[2] > hi[axis] - lo[axis] ) axis = 2;
+
+    std::size_t middle = begin + ( end - begin ) / 2;
+    std::nth_element( order.begin() + begin, order.begin() + middle, order.begin() + end,
+                      [axis]( const BuildTriangle& a, const BuildTriangle& b )
+                      {
+                          return a.centre[axis] < b.centre[axis];
+                      } );
+
+    std::size_t leftSize = middle - begin;
+    current.right = node + 1 + ( leftSize <= BVH_LEAF_SIZE ? 1 : subtreeNodes.find( leftSize )->second );
+    return middle;
+}
+
+void TriangleBVH::buildRange( std::size_t node, std::size_t begin, std::size_t end, std::vector<BuildTriangle>& order,
+                              const std::map<std::size_t, std::size_t>& subtreeNodes )
+{
+    std::size_t middle = splitNode( node, begin, end, order, subtreeNodes );
+    if ( middle == end )
+    {
+        return;
+    }
+
+    std::size_t right = _Nodes[node].right;
+    buildRange( node + 1, begin, middle, order, subtreeNodes );
+    buildRange( right, middle, end, order, subtreeNodes );
+}
+
+double TriangleBVH::findClosestPoint( const double query[3], double closest[3] ) const
+{
+    if ( _Nodes.empty() )
+    {
+        return -1.0;
+    }
+
+    double bestDistance2 = std::numeric_limits<double>::max();
+    double candidate[3];
+
+    std::size_t stack[BVH_MAX_DEPTH];
+    int top = 0;
+    stack[top++] = 0;
+
+    while ( top > 0 )
+    {
+        std::size_t index = stack[--top];
+        const Node& node = _Nodes[index];
+
+        // The box was checked when it was pushed, but a closer triangle may have been found since
+        if ( boxDistance2( node.lower, node.upper, query ) >= bestDistance2 )
+        {
+            continue;
+        }
+
+        if ( node.count > 0 )
+        {
+            for ( std::size_t t = node.first; t < node.first + node.count; t++ )
+            {
+                const double* v = &_Vertices[9 * t];
+                double distance2 = closestPointOnTriangle( query, v, v + 3, v + 6, candidate );
+                if ( distance2 < bestDistance2 )
+                {
+                    bestDistance2 = distance2;
+                    std::copy( candidate, candidate + 3, closest );
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first, it is pushed last
+        std::size_t nearChild = index + 1, farChild = node.right;
+        double nearDistance2 = boxDistance2( _Nodes[nearChild].lower, _Nodes[nearChild].upper, query );
+        double farDistance2 = boxDistance2( _Nodes[farChild].lower, _Nodes[farChild].upper, query );
+        if ( farDistance2 < nearDistance2 )
+        {
+            std::swap( nearChild, farChild );
+            std::swap( nearDistance2, farDistance2 );
+        }
+
+        if ( farDistance2 < bestDistance2 )
+        {
+            stack[top++] = farChild;
+        }
+        if ( nearDistance2 < bestDistance2 )
+        {
+            stack[top++] = nearChild;
+        }
+    }
+
+    return std::sqrt( bestDistance2 );
+}
+
+void computePointDistances( vtkPoints* points, const TriangleBVH& surface, unsigned int numThreads, std::vector<double>& distances )
+{
+    std::size_t numPoints = static_cast<std::size_t>( points->GetNumberOfPoints() );
+    distances.resize( numPoints );
+
+    parallelFor( 0, numPoints, [&]( std::size_t begin, std::size_t end )
+    {
+        double p[3], closest[3];
+        for ( std::size_t i = begin; i < end; i++ )
+        {
+            points->GetPoint( static_cast<vtkIdType>( i ), p );
+            distances[i] = surface.findClosestPoint( p, closest );
+        }
+    }, numThreads );
+}
+
+DistanceStatistics summarizeDistances( const std::vector<double>& distances )
+{
+    DistanceStatistics statistics;
+    statistics.numPoints = distances.size();
+    if ( distances.empty() )
+    {
+        return statistics;
+    }
+
+    double sum = 0.0, sum2 = 0.0;
+    for ( std::size_t i = 0; i < distances.size(); i++ )
+    {
+        sum += distances[i];
+        sum2 += distances[i] * distances[i];
+        statistics.maximum = std::max( statistics.maximum, distances[i] );
+    }
+
+    statistics.mean = sum / distances.size();
+    statistics.rms = std::sqrt( sum2 / distances.size() );
+
+    // Nearest rank percentile
+    std::vector<double> sorted( distances );
+    std::size_t rank = static_cast<std::size_t>( std::ceil( 0.95 * sorted.size() ) );
+    std::nth_element( sorted.begin(), sorted.begin() + ( rank - 1 ), sorted.end() );
+    statistics.percentile95 = sorted[rank - 1];
+
+    return statistics;
+}
+
+bool measureSurfaceDistance( vtkPolyData* objSurface, vtkPolyData* dicomSurface, bool attachArray,
+                             unsigned int numThreads, SurfaceDistanceMetrics& metrics )
+{
+    auto start = std::chrono::steady_clock::now();
+
+    TriangleBVH objTree, dicomTree;
+    objTree.build( objSurface, numThreads );
+    dicomTree.build( dicomSurface, numThreads );
+
+    if ( objTree.size() == 0 || dicomTree.size() == 0 )
+    {
+        return false;
+    }
+
+    std::vector<double> objDistances, dicomDistances;
+    computePointDistances( objSurface->GetPoints(), dicomTree, numThreads, objDistances );
+    computePointDistances( dicomSurface->GetPoints(), objTree, numThreads, dicomDistances );
+
+    metrics.objToDicom = summarizeDistances( objDistances );
+    metrics.dicomToObj = summarizeDistances( dicomDistances );
+
+    if ( attachArray )
+    {
+        vtkSmartPointer<vtkFloatArray> array = vtkSmartPointer<vtkFloatArray>::New();
+        array->SetName( "SurfaceDistance" );
+        array->SetNumberOfTuples( static_cast<vtkIdType>( dicomDistances.size() ) );
+
+        float* values = array->GetPointer( 0 );
+        for ( std::size_t i = 0; i < dicomDistances.size(); i++ )
+        {
+            values[i] = static_cast<float>( dicomDistances[i] );
+        }
+        dicomSurface->GetPointData()->AddArray( array );
+    }
+
+    objDistances.insert( objDistances.end(), dicomDistances.begin(), dicomDistances.end() );
+    metrics.symmetric = summarizeDistances( objDistances );
+    metrics.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    return true;
+}
+
+bool writeSurfaceDistanceReport( const std::string& fileName, const SurfaceDistanceMetrics& metrics )
+{
+    std::ofstream file( fileName );
+    file << std::setprecision( 10 );
+    file << "direction,points,mean,rms,percentile_95,maximum,dicom_surface\n";
+
+    const char* names[3] = { "obj_to_dicom", "dicom_to_obj", "symmetric" };
+    const DistanceStatistics* statistics[3] = { &metrics.objToDicom, &metrics.dicomToObj, &metrics.symmetric };
+
+    for ( int i = 0; i < 3; i++ )
+    {
+        file << names[i] << "," << statistics[i]->numPoints << "," << statistics[i]->mean << "," << statistics[i]->rms << ","
+             << statistics[i]->percentile95 << "," << statistics[i]->maximum << ","
+             << ( metrics.dicomDecimated ? "decimated" : "full" ) << "\n";
+    }
+
+    return static_cast<bool>( file );
+}
@@ -0,0 +1,171 @@
+/****************************************************************************
+*   surfaceDistance.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Distances between two surfaces (mean, RMS, 95th
+*                   percentile and Hausdorff distance) to judge the quality
+*                   of a registration, using a bounding volume hierarchy
+*                   over the triangles.
+****************************************************************************/
+
+#ifndef SURFACEDISTANCE_H
+#define SURFACEDISTANCE_H
+
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+/*
+*   Bounding volume hierarchy over the triangles of a surface for closest point queries.
+*
+*   The triangles are split at the median of their centres along the longest axis until at
+*   most a few are left, and stored in tree order with their vertices, so a leaf reads one
+*   contiguous block. The nodes are laid out depth first (the left child follows its parent),
+*   which lets the subtrees be built in parallel into a preallocated array.
+*
+*   Queries are read only, so any number of threads can search the same tree at once.
+*/
+class TriangleBVH
+{
+    public:
+        TriangleBVH() { }
+
+        /*
+        *   Build the hierarchy. Any previous content is replaced. Polygons with more than three
+        *   points are split into fans, other cells are ignored.
+        *
+        *   @param   surface      Surface to index
+        *   @param   numThreads   Number of threads (0 = one per core)
+        */
+        void build( vtkPolyData* surface, unsigned int numThreads = 0 );
+
+        /*
+        *   Find the point of the surface closest to a query position.
+        *
+        *   @param   query     Query position
+        *   @param   closest   Set to the closest point on the surface
+        *
+        *   @returns The distance to the closest point, -1 if the tree is empty
+        */
+        double findClosestPoint( const double query[3], double closest[3] ) const;
+
+        /*
+        *   @returns The number of indexed triangles
+        */
+        std::size_t size() const { return _Vertices.size() / 9; }
+
+    private:
+        /*
+        *   A node covers a contiguous range of triangles. Leaves have count > 0, the children of
+        *   an inner node are the next node and the node at right.
+        */
+        struct Node
+        {
+            double      lower[3];
+            double      upper[3];
+            std::size_t first;
+            std::size_t count;
+            std::size_t right;
+        };
+
+        /*
+        *   A triangle while the hierarchy is built, its centre is kept with it so the splits
+        *   do not have to look it up.
+        */
+        struct BuildTriangle
+        {
+            float       centre[3];
+            std::size_t id;
+        };
+
+        std::vector<double> _Vertices;      // 3 x 3 coordinates of every triangle, in tree order
+        std::vector<Node>   _Nodes;
+
+        /*
+        *   Split the range of a node at the median of the triangle centres, or make it a leaf.
+        *
+        *   @returns The end of the left half, or end for a leaf
+        */
+        std::size_t splitNode( std::size_t node, std::size_t begin, std::size_t end, std::vector<BuildTriangle>& order,
+                               const std::map<std::size_t, std::size_t>& subtreeNodes );
+
+        void buildRange( std::size_t node, std::size_t begin, std::size_t end, std::vector<BuildTriangle>& order,
+                         const std::map<std::size_t, std::size_t>& subtreeNodes );
+};
+
+/*
+*   Summary of the distances of a point set to a surface.
+*/
+struct DistanceStatistics
+{
+    std::size_t numPoints;
+    double      mean;
+    double      rms;
+    double      percentile95;
+    double      maximum;
+
+    DistanceStatistics() : numPoints( 0 ), mean( 0.0 ), rms( 0.0 ), percentile95( 0.0 ), maximum( 0.0 ) { }
+};
+
+/*
+*   Distances between the OBJ surface and the registered DICOM surface, in both directions.
+*/
+struct SurfaceDistanceMetrics
+{
+    DistanceStatistics objToDicom;      // OBJ points to the DICOM surface
+    DistanceStatistics dicomToObj;      // DICOM points to the OBJ surface
+    DistanceStatistics symmetric;       // All points of both, the maximum is the Hausdorff distance
+    double             seconds;
+    bool               dicomDecimated;  // TRUE if the DICOM surface was decimated before it was measured
+
+    SurfaceDistanceMetrics() : seconds( 0.0 ), dicomDecimated( false ) { }
+
+    bool isValid() const { return objToDicom.numPoints > 0 && dicomToObj.numPoints > 0; }
+};
+
+/*
+*   Distance of every point to the surface indexed by a hierarchy, computed in parallel.
+*
+*   @param   points       Query points
+*   @param   surface      Hierarchy of the surface
+*   @param   numThreads   Number of threads (0 = one per core)
+*   @param   distances    Set to the distance of every point, in point order
+*/
+void computePointDistances( vtkPoints* points, const TriangleBVH& surface, unsigned int numThreads, std::vector<double>& distances );
+
+/*
+*   Mean, RMS, 95th percentile and maximum of a set of distances. The sums are taken in order,
+*   so the result does not depend on the number of threads that computed the distances.
+*/
+DistanceStatistics summarizeDistances( const std::vector<double>& distances );
+
+/*
+*   Measure the distances between the OBJ surface and the DICOM surface registered into the
+*   OBJ space, from the points of each to the triangles of the other.
+*
+*   @param   objSurface     OBJ surface
+*   @param   dicomSurface   DICOM surface in the OBJ space
+*   @param   attachArray    Add the distance of every DICOM point to the OBJ surface to the point
+*                           data of the DICOM surface ("SurfaceDistance", not made the active scalars)
+*   @param   numThreads     Number of threads (0 = one per core)
+*   @param   metrics        Filled in with the distances
+*
+*   @returns TRUE if both surfaces have points and triangles, FALSE otherwise
+*/
+bool measureSurfaceDistance( vtkPolyData* objSurface, vtkPolyData* dicomSurface, bool attachArray,
+                             unsigned int numThreads, SurfaceDistanceMetrics& metrics );
+
+/*
+*   Write the metrics as CSV, one row per direction and one for both together. The last column
+*   says whether the DICOM surface was decimated before it was measured.
+*
+*   @returns TRUE if the file was written, FALSE otherwise
+*/
+bool writeSurfaceDistanceReport( const std::string& fileName, const SurfaceDistanceMetrics& metrics );
+
+#endif // SURFACEDISTANCE_H
@@ -0,0 +1,377 @@
+/****************************************************************************
+*   surfaceTransform.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the surface transformation and the
+*                   lazy reslice.
+****************************************************************************/
+
+#include "surfaceTransform.hxx"
+#include "parallelUtils.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkImageReslice.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkTransform.h>
+
+// Points per chunk, large enough that a chunk takes longer than handing it out
+static const std::size_t TRANSFORM_GRAIN_SIZE = 16384;
+
+/*
+*   out = A * in + b for every 3-component tuple. Positions use the translation,
+*   normals pass a zero translation and are normalised afterwards.
+*/
+template <class T>
+static void transformTuples( const T* in, T* out, std::size_t count, const double a[3][3], const double b[3],
+                             bool normalize, unsigned int numThreads )
+{
+    parallelFor( 0, count, [=]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t i = begin; i < end; i++ )
+        {
+            double x = in[3 * i], y = in[3 * i + 1], z = in[3 * i + 2];
+            double tx = a[0][0] * x + a[0][1] * y + a[0][2] * z + b[0];
+            double ty = a[1][0] * x + a[1][1] * y + a[1][2] * z + b[1];
+            double tz = a[2][0] * x + a[2][1] * y + a[2][2] * z + b[2];
+
+            if ( normalize )
+            {
+                double length = std::sqrt( tx * tx + ty * ty + tz * tz );
+                double scale = ( length > 0.0 ) ? 1.0 / length : 0.0;
+                tx *= scale;
+                ty *= scale;
+                tz *= scale;
+            }
+
+            out[3 * i] = static_cast<T>( tx );
+            out[3 * i + 1] = static_cast<T>( ty );
+            out[3 * i + 2] = static_cast<T>( tz );
+        }
+    }, numThreads, TRANSFORM_GRAIN_SIZE );
+}
+
+/*
+*   Transform a float or double array of 3-component tuples into a new array of the same type.
+*/
+static vtkSmartPointer<vtkDataArray> transformArray( vtkDataArray* input, const double a[3][3], const double b[3],
+                                                     bool normalize, unsigned int numThreads )
+{
+    std::size_t count = static_cast<std::size_t>( input->GetNumberOfTuples() );
+
+    vtkSmartPointer<vtkDataArray> output = vtkSmartPointer<vtkDataArray>::Take( vtkDataArray::CreateDataArray( input->GetDataType() ) );
+    output->SetNumberOfComponents( 3 );
+    output->SetNumberOfTuples( input->GetNumberOfTuples() );
+    output->SetName( input->GetName() );
+
+    if ( input->GetDataType() == VTK_FLOAT )
+    {
+        transformTuples( static_cast<const float*>( input->GetVoidPointer( 0 ) ), static_cast<float*>( output->GetVoidPointer( 0 ) ),
+                         count, a, b, normalize, numThreads );
+    }
+    else
+    {
+        transformTuples( static_cast<const double*>( input->GetVoidPointer( 0 ) ), static_cast<double*>( output->GetVoidPointer( 0 ) ),
+                         count, a, b, normalize, numThreads );
+    }
+
+    return output;
+}
+
+/*
+*   Convert an array to double unless it already is float or double.
+*/
+static vtkSmartPointer<vtkDataArray> asFloatingPoint( vtkDataArray* input )
+{
+    if ( input->GetDataType() == VTK_FLOAT || input->GetDataType() == VTK_DOUBLE )
+    {
+        return input;
+    }
+
+    vtkSmartPointer<vtkDoubleArray> converted = vtkSmartPointer<vtkDoubleArray>::New();
+    converted->SetNumberOfComponents( 3 );
+    converted->SetNumberOfTuples( input->GetNumberOfTuples() );
+    converted->SetName( input->GetName() );
+
+    double tuple[3];
+    for ( vtkIdType i = 0; i < input->GetNumberOfTuples(); i++ )
+    {
+        input->GetTuple( i, tuple );
+        converted->SetTuple3( i, tuple[0], tuple[1], tuple[2] );
+    }
+
+    return converted;
+}
+
+vtkSmartPointer<vtkPolyData> transformSurface( vtkPolyData* surface, vtkMatrix4x4* matrix, unsigned int numThreads )
+{
+    vtkSmartPointer<vtkPolyData> output = vtkSmartPointer<vtkPolyData>::New();
+    output->ShallowCopy( surface );
+
+    if ( surface->GetPoints() == nullptr || surface->GetNumberOfPoints() == 0 )
+    {
+        return output;
+    }
+
+    double a[3][3], b[3];
+    for ( int r = 0; r < 3; r++ )
+    {
+        for ( int c = 0; c < 3; c++ )
+        {
+            a[r][c] = matrix->GetElement( r, c );
+        }
+        b[r] = matrix->GetElement( r, 3 );
+    }
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData( transformArray( asFloatingPoint( surface->GetPoints()->GetData() ), a, b, false, numThreads ) );
+    output->SetPoints( points );
+
+    // Normals are transformed by the inverse transpose (the cofactor matrix, up to a scale removed by normalising)
+    vtkDataArray* normals = surface->GetPointData()->GetNormals();
+    if ( normals != nullptr && normals->GetNumberOfComponents() == 3 )
+    {
+        double cofactor[3][3];
+        for ( int r = 0; r < 3; r++ )
+        {
+            for ( int c = 0; c < 3; c++ )
+            {
+                int r1 = ( r + 1 ) % 3, r2 = ( r + 2 ) % 3, c1 = ( c + 1 ) % 3, c2 = ( c + 2 ) % 3;
+                cofactor[r][c] = a[r1][c1] * a[r2][c2] - a[r1][c2] * a[r2][c1];
+            }
+        }
+
+        // Keep the orientation of the normals for mirroring matrices
+        double determinant = a[0][0] * cofactor[0][0] + a[0][1] * cofactor[0][1] + a[0][2] * cofactor[0][2];
+        if ( determinant < 0.0 )
+        {
+            for ( int r = 0; r < 3; r++ )
+            {
+                for ( int c = 0; c < 3; c++ )
+                {
+                    cofactor[r][c] = -cofactor[r][c];
+                }
+            }
+        }
+
+        double zero[3] = { 0.0, 0.0, 0.0 };
+        output->GetPointData()->SetNormals( transformArray( asFloatingPoint( normals ), cofactor, zero, true, numThreads ) );
+    }
+
+    return output;
+}
+
+void LazyReslice::setInput( vtkImageData* image, vtkMatrix4x4* matrix )
+{
+    _Input = image;
+    _Matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    _Matrix->DeepCopy( matrix );
+    _Output = nullptr;
+}
+
+vtkImageData* LazyReslice::getOutput() const
+{
+    if ( _Output == nullptr && _Input != nullptr )
+    {
+        vtkSmartPointer<vtkTransform> transform = vtkSmartPointer<vtkTransform>::New();
+        transform->SetMatrix( _Matrix );
+
+        vtkSmartPointer<vtkImageReslice> reslice = vtkSmartPointer<vtkImageReslice>::New();
+        reslice->SetInputData( _Input );
+        reslice->InterpolateOff();  // On for nearest neighbour, off for linear
+        reslice->AutoCropOutputOn();
+        reslice->SetResliceTransform( transform );
+        reslice->Update();
+
+        // A copy that shares the voxels but not the pipeline, which would keep the input alive
+        _Output = vtkSmartPointer<vtkImageData>::New();
+        _Output->ShallowCopy( reslice->GetOutput() );
+    }
+
+    return _Output;
+}
+
+/*
+*   Fill one slice with the nearest input voxel of every pixel. The input position moves by a
+*   constant step along a row, voxels outside the input are 0.
+*/
+template <class T>
+static void resampleSlice( const T* input, const int inExtent[6], const double inOrigin[3], const double inSpacing[3], int numComponents,
+                           T* output, const int outExtent[6], const double outOrigin[3], const double outSpacing[3], int slice,
+                           vtkMatrix4x4* matrix, unsigned int numThreads )
+{
+    int width = outExtent[1] - outExtent[0] + 1;
+    int height = outExtent[3] - outExtent[2] + 1;
+    std::size_t inRow = static_cast<std::size_t>( inExtent[1] - inExtent[0] + 1 );
+    std::size_t inSlice = inRow * ( inExtent[3] - inExtent[2] + 1 );
+
+    // Input index of an output position, and its step along a row
+    double a[3][4], step[3];
+    for ( int r = 0; r < 3; r++ )
+    {
+        for ( int c = 0; c < 4; c++ )
+        {
+            a[r][c] = matrix->GetElement( r, c ) / inSpacing[r];
+        }
+        a[r][3] -= inOrigin[r] / inSpacing[r];
+        step[r] = a[r][0] * outSpacing[0];
+    }
+
+    double z = outOrigin[2] + slice * outSpacing[2];
+
+    parallelFor( 0, static_cast<std::size_t>( height ), [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t j = begin; j < end; j++ )
+        {
+            double x = outOrigin[0] + outExtent[0] * outSpacing[0];
+            double y = outOrigin[1] + ( outExtent[2] + static_cast<int>( j ) ) * outSpacing[1];
+
+            double p[3];
+            for ( int r = 0; r < 3; r++ )
+            {
+                p[r] = a[r][0] * x + a[r][1] * y + a[r][2] * z + a[r][3];
+            }
+
+            T* out = output + j * width * numComponents;
+            for ( int i = 0; i < width; i++, out += numComponents )
+            {
+                int ix = static_cast<int>( std::floor( p[0] + step[0] * i + 0.5 ) );
+                int iy = static_cast<int>( std::floor( p[1] + step[1] * i + 0.5 ) );
+                int iz = static_cast<int>( std::floor( p[2] + step[2] * i + 0.5 ) );
+
+                if ( ix < inExtent[0] || ix > inExtent[1] || iy < inExtent[2] || iy > inExtent[3] || iz < inExtent[4] || iz > inExtent[5] )
+                {
+                    std::fill( out, out + numComponents, static_cast<T>( 0 ) );
+                    continue;
+                }
+
+                const T* in = input + ( ( iz - inExtent[4] ) * inSlice + ( iy - inExtent[2] ) * inRow + ( ix - inExtent[0] ) ) * numComponents;
+                std::copy( in, in + numComponents, out );
+            }
+        }
+    }, numThreads );
+}
+
+bool LazyReslice::getOutputGrid( int extent[6], double origin[3], double spacing[3] ) const
+{
+    if ( _Output != nullptr )
+    {
+        _Output->GetExtent( extent );
+        _Output->GetOrigin( origin );
+        _Output->GetSpacing( spacing );
+        return true;
+    }
+
+    if ( _Input == nullptr )
+    {
+        return false;
+    }
+
+    // The corners of the input moved into the source space by the inverse matrix
+    vtkSmartPointer<vtkMatrix4x4> inverse = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkMatrix4x4::Invert( _Matrix, inverse );
+
+    // Bounds from the extent, GetBounds() caches them in the image and is not safe to call from several threads
+    int* inputExtent = _Input->GetExtent();
+    double* inputOrigin = _Input->GetOrigin();
+    double* inputSpacing = _Input->GetSpacing();
+
+    double bounds[6];
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        double first = inputOrigin[axis] + inputExtent[2 * axis] * inputSpacing[axis];
+        double last = inputOrigin[axis] + inputExtent[2 * axis + 1] * inputSpacing[axis];
+        bounds[2 * axis] = std::min( first, last );
+        bounds[2 * axis + 1] = std::max( first, last );
+    }
+
+    double lower[3] = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+    double upper[3] = { -lower[0], -lower[1], -lower[2] };
+    for ( int corner = 0; corner < 8; corner++ )
+    {
+        double p[4] = { bounds[corner & 1], bounds[2 + ( ( corner >> 1 ) & 1 )], bounds[4 + ( ( corner >> 2 ) & 1 )], 1.0 };
+        double moved[4];
+        inverse->MultiplyPoint( p, moved );
+
+        for ( int axis = 0; axis < 3; axis++ )
+        {
+            lower[axis] = std::min( lower[axis], moved[axis] );
+            upper[axis] = std::max( upper[axis], moved[axis] );
+        }
+    }
+
+    for ( int axis = 0; axis < 3; axis++ )
+    {
+        spacing[axis] = std::fabs( inputSpacing[axis] );
+        origin[axis] = lower[axis];
+        extent[2 * axis] = 0;
+        extent[2 * axis + 1] = static_cast<int>( std::floor( ( upper[axis] - lower[axis] ) / spacing[axis] + 1e-4 ) );
+    }
+
+    return true;
+}
+
+vtkSmartPointer<vtkImageData> LazyReslice::getSlice( int slice, unsigned int numThreads ) const
+{
+    int extent[6];
+    double origin[3], spacing[3];
+    if ( !getOutputGrid( extent, origin, spacing ) || slice < extent[4] || slice > extent[5] )
+    {
+        return nullptr;
+    }
+
+    vtkImageData* source = ( _Output != nullptr ) ? _Output.GetPointer() : _Input.GetPointer();
+    int numComponents = source->GetNumberOfScalarComponents();
+
+    vtkSmartPointer<vtkImageData> output = vtkSmartPointer<vtkImageData>::New();
+    output->SetOrigin( origin );
+    output->SetSpacing( spacing );
+    output->SetExtent( extent[0], extent[1], extent[2], extent[3], slice, slice );
+    output->AllocateScalars( source->GetScalarType(), numComponents );
+
+    // Already resliced, copy the slice
+    if ( _Output != nullptr )
+    {
+        std::size_t bytes = static_cast<std::size_t>( extent[1] - extent[0] + 1 ) * ( extent[3] - extent[2] + 1 ) *
+                            numComponents * source->GetScalarSize();
+        std::memcpy( output->GetScalarPointer(), source->GetScalarPointer( extent[0], extent[2], slice ), bytes );
+        return output;
+    }
+
+    int* inExtent = _Input->GetExtent();
+    double* inOrigin = _Input->GetOrigin();
+    double* inSpacing = _Input->GetSpacing();
+    void* input = _Input->GetScalarPointer();
+    void* resampled = output->GetScalarPointer();
+
+    switch ( _Input->GetScalarType() )
+    {
+        vtkTemplateMacro( resampleSlice( static_cast<const VTK_TT*>( input ), inExtent, inOrigin, inSpacing, numComponents,
+                                         static_cast<VTK_TT*>( resampled ), extent, origin, spacing, slice, _Matrix, numThreads ) );
+        default:
+            return nullptr;
+    }
+
+    return output;
+}
+
+void LazyReslice::releaseInput()
+{
+    getOutput();
+    _Input = nullptr;
+}
+
+void LazyReslice::release()
+{
+    _Input = nullptr;
+    _Matrix = nullptr;
+    _Output = nullptr;
+}
@@ -0,0 +1,107 @@
+/****************************************************************************
+*   surfaceTransform.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Fast affine transformation of a surface and lazily
+*                   resliced volumes.
+****************************************************************************/
+
+#ifndef SURFACETRANSFORM_H
+#define SURFACETRANSFORM_H
+
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   Apply an affine matrix to the points and normals of a surface.
+*
+*   Same result as vtkTransformPolyDataFilter, but the coordinates are transformed in
+*   one tight loop over the raw arrays, split over all cores. The topology and all
+*   other point and cell data are shared with the input, not copied.
+*
+*   @param   surface      Surface to transform
+*   @param   matrix       Affine transformation
+*   @param   numThreads   Number of threads (0 = one per core)
+*
+*   @returns The transformed surface
+*/
+vtkSmartPointer<vtkPolyData> transformSurface( vtkPolyData* surface, vtkMatrix4x4* matrix, unsigned int numThreads = 0 );
+
+/*
+*   A volume resliced by a registration matrix, computed on first use.
+*
+*   Holds the input volume and matrix, and only runs vtkImageReslice when the voxels
+*   are asked for. Copies share the input, and the resliced volume if it was computed before
+*   the copy. A volume computed after copying is only seen by the copy that computed it.
+*/
+class LazyReslice
+{
+    public:
+        LazyReslice() { }
+
+        /*
+        *   Set the volume and the registration matrix. Nothing is computed yet.
+        *
+        *   @param   image    Volume in the target space
+        *   @param   matrix   Transformation from the source space to the target space
+        */
+        void setInput( vtkImageData* image, vtkMatrix4x4* matrix );
+
+        /*
+        *   @returns TRUE if an input was set (it may already have been dropped by releaseInput())
+        */
+        bool hasInput() const { return _Input != nullptr || _Output != nullptr; }
+
+        /*
+        *   @returns TRUE if the volume has already been resliced
+        */
+        bool isComputed() const { return _Output != nullptr; }
+
+        /*
+        *   Reslice the volume into the source space on the first call.
+        *
+        *   @returns The resliced volume, nullptr if no input was set
+        */
+        vtkImageData* getOutput() const;
+
+        /*
+        *   Grid of the resliced volume: the bounds of the input moved into the source space, at the
+        *   spacing of the input (the grid of the computed volume once there is one).
+        *
+        *   @returns FALSE if no input was set
+        */
+        bool getOutputGrid( int extent[6], double origin[3], double spacing[3] ) const;
+
+        /*
+        *   Resample one slice (constant z) of the resliced volume without reslicing the whole volume,
+        *   with the nearest voxel like getOutput(). When the volume was already resliced the slice is
+        *   copied from it. Several threads can ask for slices at once, but not while another method
+        *   is called.
+        *
+        *   @param   slice        z index of the slice in the grid of getOutputGrid()
+        *   @param   numThreads   Number of threads (0 = one per core)
+        *
+        *   @returns The slice, a volume one voxel thick, nullptr if there is no input or the slice is outside the grid
+        */
+        vtkSmartPointer<vtkImageData> getSlice( int slice, unsigned int numThreads = 0 ) const;
+
+        /*
+        *   Reslice the volume if that was not done yet and drop the input, only the resliced volume is kept.
+        */
+        void releaseInput();
+
+        /*
+        *   Drop the input and the resliced volume.
+        */
+        void release();
+
+    private:
+        vtkSmartPointer<vtkImageData>         _Input;
+        vtkSmartPointer<vtkMatrix4x4>         _Matrix;
+        mutable vtkSmartPointer<vtkImageData> _Output;
+};
+
+#endif // SURFACETRANSFORM_H
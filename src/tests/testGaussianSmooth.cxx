@@ -0,0 +1,181 @@
+/****************************************************************************
+*   testGaussianSmooth.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Tests of the smoothing of a region and of the smoothed
+*                   volume read back from the pipeline cache.
+****************************************************************************/
+
+#include "gaussianSmooth.hxx"
+#include "pipelineCache.hxx"
+#include "regionOfInterest.hxx"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtksys/SystemTools.hxx>
+
+static const char* CACHE_DIRECTORY = "testGaussianSmooth_cache";
+
+/*
+*   Random 16-bit volume with an extent that does not start at 0.
+*/
+static vtkSmartPointer<vtkImageData> createVolume()
+{
+    vtkSmartPointer<vtkImageData> volume = vtkSmartPointer<vtkImageData>::New();
+    volume->SetExtent( -5, 34, 3, 38, 0, 29 );
+    volume->SetOrigin( -12.5, 4.0, 100.0 );
+    volume->SetSpacing( 0.7, 0.7, 1.25 );
+    volume->AllocateScalars( VTK_SHORT, 1 );
+
+    std::mt19937 generator( 11 );
+    std::uniform_int_distribution<int> intensity( -1000, 1500 );
+
+    short* voxels = static_cast<short*>( volume->GetScalarPointer() );
+    for ( vtkIdType i = 0; i < volume->GetNumberOfPoints(); i++ )
+    {
+        voxels[i] = static_cast<short>( intensity( generator ) );
+    }
+
+    return volume;
+}
+
+/*
+*   @returns TRUE if both volumes have the same geometry and exactly the same voxels
+*/
+static bool sameVolume( vtkImageData* a, vtkImageData* b )
+{
+    for ( int i = 0; i < 6; i++ )
+    {
+        if ( a->GetExtent()[i] != b->GetExtent()[i] )
+        {
+            return false;
+        }
+    }
+
+    for ( int i = 0; i < 3; i++ )
+    {
+        if ( a->GetOrigin()[i] != b->GetOrigin()[i] || a->GetSpacing()[i] != b->GetSpacing()[i] )
+        {
+            return false;
+        }
+    }
+
+    vtkDataArray* scalarsA = a->GetPointData()->GetScalars();
+    vtkDataArray* scalarsB = b->GetPointData()->GetScalars();
+
+    return scalarsA->GetDataType() == scalarsB->GetDataType() &&
+           scalarsA->GetNumberOfValues() == scalarsB->GetNumberOfValues() &&
+           std::memcmp( scalarsA->GetVoidPointer( 0 ), scalarsB->GetVoidPointer( 0 ),
+                        scalarsA->GetNumberOfValues() * scalarsA->GetDataTypeSize() ) == 0;
+}
+
+/*
+*   Smooth a region like the pipeline does: the volume cropped to the smoothing extent of the
+*   region is smoothed and cropped to the region. The voxels must be those of the whole volume
+*   smoothed, and the voxels of the margin must not be (or the margin would not be needed).
+*/
+static bool testRegion( vtkImageData* volume, vtkImageData* smoothedVolume, const int region[6],
+                        const GaussianSmoothSettings& settings, const char* name )
+{
+    int extent[6];
+    smoothingExtent( volume->GetExtent(), region, settings, extent );
+
+    vtkSmartPointer<vtkImageData> withMargin = smoothGaussian( cropImage( volume, extent ), settings );
+    vtkSmartPointer<vtkImageData> smoothed = cropImage( withMargin, region );
+
+    if ( !sameVolume( smoothed, cropImage( smoothedVolume, region ) ) )
+    {
+        std::cout << "ERROR: The smoothed " << name << " differs from the whole volume smoothed.\n";
+        return false;
+    }
+
+    if ( sameVolume( withMargin, cropImage( smoothedVolume, extent ) ) )
+    {
+        std::cout << "ERROR: The margin of the smoothed " << name << " is the same as the whole volume smoothed, "
+                  << "the kernel is not cut off at the margin.\n";
+        return false;
+    }
+
+    return true;
+}
+
+/*
+*   Cache a smoothed region and read it back for a smaller region, like a rerun of the pipeline
+*   with other thresholds. The voxels must be those of a fresh smoothing.
+*/
+static bool testCacheHit( vtkImageData* volume, vtkImageData* smoothedVolume, const GaussianSmoothSettings& settings )
+{
+    int region[6] = { 2, 25, 8, 30, 4, 22 };
+    int rerunRegion[6] = { 5, 20, 8, 27, 10, 22 };
+
+    int extent[6];
+    smoothingExtent( volume->GetExtent(), region, settings, extent );
+    vtkSmartPointer<vtkImageData> smoothed = cropImage( smoothGaussian( cropImage( volume, extent ), settings ), region );
+
+    PipelineCache cache;
+    cache.setDirectory( CACHE_DIRECTORY );
+
+    std::string key = PipelineCache::makeKey( "testGaussianSmooth", "smooth" );
+    if ( !cache.writeVolume( key, smoothed ) )
+    {
+        std::cout << "ERROR: Could not write the smoothed volume to the pipeline cache.\n";
+        return false;
+    }
+
+    bool passed = true;
+    vtkSmartPointer<vtkImageData> cached = cache.readVolume( key );
+
+    if ( cached == nullptr || !sameVolume( cached, smoothed ) )
+    {
+        std::cout << "ERROR: The smoothed volume read from the pipeline cache differs from the one written.\n";
+        passed = false;
+    }
+    else if ( !sameVolume( cropImage( cached, rerunRegion ), cropImage( smoothedVolume, rerunRegion ) ) )
+    {
+        std::cout << "ERROR: A smaller region cropped from the cached volume differs from a fresh smoothing.\n";
+        passed = false;
+    }
+
+    // The cached files are mapped until the volume is released
+    cached = nullptr;
+    vtksys::SystemTools::RemoveADirectory( CACHE_DIRECTORY );
+
+    return passed;
+}
+
+int testGaussianSmooth( int, char*[] )
+{
+    vtkSmartPointer<vtkImageData> volume = createVolume();
+    bool passed = true;
+
+    // The kernel of the pipeline and a wider one, in slabs and in one slab per thread
+    GaussianSmoothSettings settings[2];
+    settings[0].numThreads = 3;
+    settings[1].standardDeviation = 1.5;
+    settings[1].radiusFactor = 2.0;
+    settings[1].slabSlices = 4;
+    settings[1].numThreads = 2;
+
+    for ( int s = 0; s < 2; s++ )
+    {
+        vtkSmartPointer<vtkImageData> smoothedVolume = smoothGaussian( volume, settings[s] );
+
+        int inside[6] = { 4, 20, 10, 30, 6, 21 };
+        passed = testRegion( volume, smoothedVolume, inside, settings[s], "region inside the volume" ) && passed;
+
+        // The margin is cut off by the volume on the low x, high y and low z sides
+        int edge[6] = { -5, 12, 20, 38, 0, 15 };
+        passed = testRegion( volume, smoothedVolume, edge, settings[s], "region at the edge of the volume" ) && passed;
+
+        passed = testCacheHit( volume, smoothedVolume, settings[s] ) && passed;
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
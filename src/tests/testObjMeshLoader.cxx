@@ -0,0 +1,499 @@
+/****************************************************************************
+*   testObjMeshLoader.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Tests of the parallel OBJ parser and the mesh cache.
+****************************************************************************/
+
+#include "meshCache.hxx"
+#include "objMeshLoader.hxx"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkDataArray.h>
+#include <vtkFieldData.h>
+#include <vtkIdTypeArray.h>
+#include <vtkIntArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkStringArray.h>
+
+// Vertex i (from 1) is at (i, 2 i, 0) with texture coordinate (i / 10, i / 5) and normal (i, -i, 1).
+// Indices are absolute, negative and mixed, faces have 3 to 5 corners, vertices 5 and 6 are defined after
+// the first faces (so -1 refers to another vertex before and after them) and the group is ignored
+// because the file has materials.
+static const char* MATERIAL_OBJ =
+    "# Test surface\n"
+    "mtllib test.mtl\n"
+    "v 1 2 0\n"
+    "v 2 4 0\n"
+    "v 3 6 0\n"
+    "v 4 8 0\n"
+    "vt 0.1 0.2\n"
+    "vt 0.2 0.4\n"
+    "vt 0.3 0.6\n"
+    "vt 0.4 0.8\n"
+    "vn 1 -1 1\n"
+    "vn 2 -2 1\n"
+    "vn 3 -3 1\n"
+    "vn 4 -4 1\n"
+    "f 1/1/1 2/2/2 3/3/3\n"
+    "usemtl bone\n"
+    "f -4/-4/-4 -2/-2/-2 -1/-1/-1\n"
+    "v 5 10 0\n"
+    "v 6 12 0\n"
+    "vt 0.5 1.0\n"
+    "vt 0.6 1.2\n"
+    "vn 5 -5 1\n"
+    "vn 6 -6 1\n"
+    "g ignored\n"
+    "f 2/2/2 -2/-2/-2 -1/-1/-1 3/3/3\n"
+    "usemtl disc\n"
+    "f 1/1/1 2/2/2 5/5/5 6/6/6 4/4/4\n"
+    "usemtl bone\n"
+    "f\t4/4/4  3/3/3 -1/6/-1\n";
+
+// Point ids of the faces above, and their materials (in the order they first appear, "default" for the first face)
+static const vtkIdType MATERIAL_CELLS[] = { 3, 0, 1, 2,   3, 0, 2, 3,   4, 1, 4, 5, 2,   5, 0, 1, 4, 5, 3,   3, 3, 2, 5 };
+static const int MATERIAL_IDS[] = { 2, 0, 0, 1, 0 };
+static const char* MATERIAL_NAMES[] = { "bone", "disc", "default" };
+
+// Groups without materials, v//vn and v/vt corners. Point 2 has no normal in the second face, so neither
+// normals nor texture coordinates can be attached to the points.
+static const char* GROUP_OBJ =
+    "v 0 0 0\n"
+    "v 1 0 0\n"
+    "v 0 1 0\n"
+    "v 1 1 0\n"
+    "vt 0 0\n"
+    "vn 0 0 1\n"
+    "g left\n"
+    "f 1//1 2//1 3//1\n"
+    "g right\n"
+    "f 2/1 4/1 3/1\n";
+
+// Grid of the large test file, GRID_SIZE^2 vertices make a file of several MB, parsed in several chunks
+static const int GRID_SIZE = 400;
+static const int GRID_ROWS_PER_MATERIAL = 50;
+
+/*
+*   Write a string to a file.
+*/
+static bool writeFile( const std::string& fileName, const std::string& text )
+{
+    std::ofstream file( fileName.c_str(), std::ios::binary );
+    file << text;
+    return static_cast<bool>( file );
+}
+
+/*
+*   Delete a test file and its mesh cache.
+*/
+static void removeFiles( const std::string& fileName )
+{
+    std::remove( fileName.c_str() );
+    std::remove( ( fileName + ".meshcache" ).c_str() );
+}
+
+/*
+*   @returns TRUE if the cells of a surface are exactly the expected size and point id values
+*/
+static bool hasCells( vtkPolyData* surface, const vtkIdType* expected, std::size_t numValues, vtkIdType numPolys )
+{
+    vtkIdTypeArray* cells = surface->GetPolys()->GetData();
+    if ( surface->GetNumberOfPolys() != numPolys || cells->GetNumberOfValues() != static_cast<vtkIdType>( numValues ) )
+    {
+        return false;
+    }
+
+    const vtkIdType* values = cells->GetPointer( 0 );
+    for ( std::size_t i = 0; i < numValues; i++ )
+    {
+        if ( values[i] != expected[i] )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+*   @returns TRUE if both arrays are missing, or both have the same tuples
+*/
+static bool sameArray( vtkDataArray* a, vtkDataArray* b )
+{
+    if ( a == nullptr || b == nullptr )
+    {
+        return a == b;
+    }
+
+    if ( a->GetNumberOfTuples() != b->GetNumberOfTuples() || a->GetNumberOfComponents() != b->GetNumberOfComponents() )
+    {
+        return false;
+    }
+
+    std::vector<double> x( a->GetNumberOfComponents() ), y( b->GetNumberOfComponents() );
+    for ( vtkIdType i = 0; i < a->GetNumberOfTuples(); i++ )
+    {
+        a->GetTuple( i, x.data() );
+        b->GetTuple( i, y.data() );
+        if ( x != y )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+*   @returns TRUE if two surfaces have the same points, polygons, normals, texture coordinates and materials
+*/
+static bool sameSurface( vtkPolyData* a, vtkPolyData* b )
+{
+    vtkIdTypeArray* cellsA = a->GetPolys()->GetData();
+    vtkIdTypeArray* cellsB = b->GetPolys()->GetData();
+    if ( a->GetNumberOfPolys() != b->GetNumberOfPolys() || cellsA->GetNumberOfValues() != cellsB->GetNumberOfValues() )
+    {
+        return false;
+    }
+
+    for ( vtkIdType i = 0; i < cellsA->GetNumberOfValues(); i++ )
+    {
+        if ( cellsA->GetPointer( 0 )[i] != cellsB->GetPointer( 0 )[i] )
+        {
+            return false;
+        }
+    }
+
+    vtkIntArray* idsA = vtkIntArray::SafeDownCast( a->GetCellData()->GetAbstractArray( "MaterialIds" ) );
+    vtkIntArray* idsB = vtkIntArray::SafeDownCast( b->GetCellData()->GetAbstractArray( "MaterialIds" ) );
+    vtkStringArray* namesA = vtkStringArray::SafeDownCast( a->GetFieldData()->GetAbstractArray( "MaterialNames" ) );
+    vtkStringArray* namesB = vtkStringArray::SafeDownCast( b->GetFieldData()->GetAbstractArray( "MaterialNames" ) );
+
+    if ( !sameArray( idsA, idsB ) || ( namesA == nullptr ) != ( namesB == nullptr ) )
+    {
+        return false;
+    }
+
+    if ( namesA != nullptr )
+    {
+        if ( namesA->GetNumberOfValues() != namesB->GetNumberOfValues() )
+        {
+            return false;
+        }
+        for ( vtkIdType i = 0; i < namesA->GetNumberOfValues(); i++ )
+        {
+            if ( namesA->GetValue( i ) != namesB->GetValue( i ) )
+            {
+                return false;
+            }
+        }
+    }
+
+    return sameArray( a->GetPoints()->GetData(), b->GetPoints()->GetData() ) &&
+           sameArray( a->GetPointData()->GetNormals(), b->GetPointData()->GetNormals() ) &&
+           sameArray( a->GetPointData()->GetTCoords(), b->GetPointData()->GetTCoords() );
+}
+
+/*
+*   Negative indices, corners with texture coordinates and normals, polygons with more than
+*   3 corners and materials, then the same surface loaded again from the mesh cache.
+*/
+static bool testMaterialFile()
+{
+    std::string fileName = "testObjMeshLoader_materials.obj";
+    removeFiles( fileName );
+    if ( !writeFile( fileName, MATERIAL_OBJ ) )
+    {
+        std::cout << "ERROR: Could not write " << fileName << ".\n";
+        return false;
+    }
+
+    bool passed = true;
+    vtkSmartPointer<vtkPolyData> surface = readOBJParallel( fileName, 2 );
+
+    if ( surface == nullptr || surface->GetNumberOfPoints() != 6 )
+    {
+        std::cout << "ERROR: The material test file was not read, or not all of its vertices.\n";
+        removeFiles( fileName );
+        return false;
+    }
+
+    double point[3];
+    for ( vtkIdType p = 0; p < 6; p++ )
+    {
+        surface->GetPoints()->GetPoint( p, point );
+        if ( point[0] != p + 1.0 || point[1] != 2.0 * ( p + 1 ) || point[2] != 0.0 )
+        {
+            std::cout << "ERROR: Vertex " << p << " was read as (" << point[0] << ", " << point[1] << ", " << point[2] << ").\n";
+            passed = false;
+        }
+    }
+
+    if ( !hasCells( surface, MATERIAL_CELLS, sizeof( MATERIAL_CELLS ) / sizeof( MATERIAL_CELLS[0] ), 5 ) )
+    {
+        std::cout << "ERROR: The faces of the material test file were not resolved to the expected polygons.\n";
+        passed = false;
+    }
+
+    vtkDataArray* normals = surface->GetPointData()->GetNormals();
+    vtkDataArray* tcoords = surface->GetPointData()->GetTCoords();
+    if ( normals == nullptr || tcoords == nullptr )
+    {
+        std::cout << "ERROR: The normals or texture coordinates were not attached to the points.\n";
+        passed = false;
+    }
+    else
+    {
+        double normal[3], tcoord[2];
+        for ( vtkIdType p = 0; p < 6; p++ )
+        {
+            normals->GetTuple( p, normal );
+            tcoords->GetTuple( p, tcoord );
+            if ( normal[0] != p + 1.0 || normal[1] != -( p + 1.0 ) || normal[2] != 1.0 ||
+                 std::fabs( tcoord[0] - 0.1 * ( p + 1 ) ) > 1e-6 || std::fabs( tcoord[1] - 0.2 * ( p + 1 ) ) > 1e-6 )
+            {
+                std::cout << "ERROR: Point " << p << " has the wrong normal or texture coordinate.\n";
+                passed = false;
+            }
+        }
+    }
+
+    vtkIntArray* materialIds = vtkIntArray::SafeDownCast( surface->GetCellData()->GetAbstractArray( "MaterialIds" ) );
+    vtkStringArray* materialNames = vtkStringArray::SafeDownCast( surface->GetFieldData()->GetAbstractArray( "MaterialNames" ) );
+    if ( materialIds == nullptr || materialNames == nullptr || materialIds->GetNumberOfTuples() != 5 || materialNames->GetNumberOfValues() != 3 )
+    {
+        std::cout << "ERROR: The materials of the material test file are missing.\n";
+        passed = false;
+    }
+    else
+    {
+        for ( vtkIdType f = 0; f < 5; f++ )
+        {
+            if ( materialIds->GetValue( f ) != MATERIAL_IDS[f] )
+            {
+                std::cout << "ERROR: Face " << f << " has material " << materialIds->GetValue( f ) << " instead of " << MATERIAL_IDS[f] << ".\n";
+                passed = false;
+            }
+        }
+        for ( vtkIdType m = 0; m < 3; m++ )
+        {
+            if ( materialNames->GetValue( m ) != MATERIAL_NAMES[m] )
+            {
+                std::cout << "ERROR: Material " << m << " is named " << materialNames->GetValue( m ) << " instead of " << MATERIAL_NAMES[m] << ".\n";
+                passed = false;
+            }
+        }
+    }
+
+    // The first load parses the file and writes the cache, the second one maps the cache
+    OBJMeshLoader parsed, cached;
+    parsed.setFileName( fileName );
+    cached.setFileName( fileName );
+
+    if ( !parsed.load() || parsed.loadedFromCache() || !cached.load() || !cached.loadedFromCache() )
+    {
+        std::cout << "ERROR: The second load of the material test file did not use the mesh cache.\n";
+        passed = false;
+    }
+    else if ( !sameSurface( surface, parsed.getOutput() ) || !sameSurface( surface, cached.getOutput() ) )
+    {
+        std::cout << "ERROR: The surface read from the mesh cache differs from the parsed surface.\n";
+        passed = false;
+    }
+
+    // A cache written for another fingerprint is ignored
+    if ( readMeshCache( fileName + ".meshcache", "another fingerprint" ) != nullptr )
+    {
+        std::cout << "ERROR: A mesh cache with the wrong fingerprint was read.\n";
+        passed = false;
+    }
+
+    removeFiles( fileName );
+    return passed;
+}
+
+/*
+*   Groups instead of materials, and attributes that are not given at every corner.
+*/
+static bool testGroupFile()
+{
+    std::string fileName = "testObjMeshLoader_groups.obj";
+    if ( !writeFile( fileName, GROUP_OBJ ) )
+    {
+        std::cout << "ERROR: Could not write " << fileName << ".\n";
+        return false;
+    }
+
+    bool passed = true;
+    vtkSmartPointer<vtkPolyData> surface = readOBJParallel( fileName, 1 );
+    static const vtkIdType cells[] = { 3, 0, 1, 2,   3, 1, 3, 2 };
+
+    if ( surface == nullptr || !hasCells( surface, cells, 8, 2 ) )
+    {
+        std::cout << "ERROR: The faces of the group test file were not read.\n";
+        passed = false;
+    }
+    else
+    {
+        if ( surface->GetPointData()->GetNormals() != nullptr || surface->GetPointData()->GetTCoords() != nullptr )
+        {
+            std::cout << "ERROR: Normals or texture coordinates missing at some corners were attached to the points.\n";
+            passed = false;
+        }
+
+        vtkIntArray* materialIds = vtkIntArray::SafeDownCast( surface->GetCellData()->GetAbstractArray( "MaterialIds" ) );
+        vtkStringArray* materialNames = vtkStringArray::SafeDownCast( surface->GetFieldData()->GetAbstractArray( "MaterialNames" ) );
+        if ( materialIds == nullptr || materialNames == nullptr || materialNames->GetNumberOfValues() != 2 ||
+             materialIds->GetValue( 0 ) != 0 || materialIds->GetValue( 1 ) != 1 ||
+             materialNames->GetValue( 0 ) != "left" || materialNames->GetValue( 1 ) != "right" )
+        {
+            std::cout << "ERROR: The groups were not used as materials.\n";
+            passed = false;
+        }
+    }
+
+    // An index past the last vertex makes the file invalid
+    if ( !writeFile( fileName, "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n" ) || readOBJParallel( fileName, 1 ) != nullptr )
+    {
+        std::cout << "ERROR: A face with an index past the last vertex was accepted.\n";
+        passed = false;
+    }
+
+    removeFiles( fileName );
+    return passed;
+}
+
+/*
+*   A file of several MB, split into chunks that are parsed at the same time. Every row of the grid
+*   is written before the quads that connect it to the row below, with negative indices, and the
+*   material changes every few rows, so chunks start between the vertices and the faces using them.
+*/
+static bool testLargeFile()
+{
+    std::string fileName = "testObjMeshLoader_grid.obj";
+    std::ostringstream text;
+    std::vector<vtkIdType> cells;
+    std::vector<int> materials;
+
+    for ( int row = 0; row < GRID_SIZE; row++ )
+    {
+        for ( int column = 0; column < GRID_SIZE; column++ )
+        {
+            text << "v " << column << " " << row << " " << ( row + column ) % 7 << "\n";
+        }
+
+        if ( row == 0 )
+        {
+            continue;
+        }
+
+        if ( ( row - 1 ) % GRID_ROWS_PER_MATERIAL == 0 )
+        {
+            text << "usemtl band" << ( row - 1 ) / GRID_ROWS_PER_MATERIAL << "\n";
+        }
+
+        for ( int column = 0; column + 1 < GRID_SIZE; column++ )
+        {
+            // Relative to the end of the current row
+            text << "f " << -( 2 * GRID_SIZE - column ) << " " << -( 2 * GRID_SIZE - column - 1 ) << " "
+                 << -( GRID_SIZE - column - 1 ) << " " << -( GRID_SIZE - column ) << "\n";
+
+            vtkIdType below = static_cast<vtkIdType>( row - 1 ) * GRID_SIZE + column;
+            vtkIdType above = below + GRID_SIZE;
+            vtkIdType quad[5] = { 4, below, below + 1, above + 1, above };
+            cells.insert( cells.end(), quad, quad + 5 );
+            materials.push_back( ( row - 1 ) / GRID_ROWS_PER_MATERIAL );
+        }
+    }
+
+    if ( !writeFile( fileName, text.str() ) )
+    {
+        std::cout << "ERROR: Could not write " << fileName << ".\n";
+        return false;
+    }
+
+    bool passed = true;
+    vtkSmartPointer<vtkPolyData> serial = readOBJParallel( fileName, 1 );
+    vtkSmartPointer<vtkPolyData> parallel = readOBJParallel( fileName, 4 );
+    vtkIdType numQuads = static_cast<vtkIdType>( materials.size() );
+
+    if ( serial == nullptr || parallel == nullptr || serial->GetNumberOfPoints() != GRID_SIZE * GRID_SIZE )
+    {
+        std::cout << "ERROR: The grid test file was not read.\n";
+        removeFiles( fileName );
+        return false;
+    }
+
+    if ( !hasCells( parallel, cells.data(), cells.size(), numQuads ) )
+    {
+        std::cout << "ERROR: The quads of the grid test file were not resolved to the expected polygons.\n";
+        passed = false;
+    }
+
+    vtkIntArray* materialIds = vtkIntArray::SafeDownCast( parallel->GetCellData()->GetAbstractArray( "MaterialIds" ) );
+    if ( materialIds == nullptr || materialIds->GetNumberOfTuples() != numQuads )
+    {
+        std::cout << "ERROR: The materials of the grid test file are missing.\n";
+        passed = false;
+    }
+    else
+    {
+        for ( vtkIdType f = 0; f < numQuads; f++ )
+        {
+            if ( materialIds->GetValue( f ) != materials[f] )
+            {
+                std::cout << "ERROR: Quad " << f << " of the grid test file has the wrong material.\n";
+                passed = false;
+                break;
+            }
+        }
+    }
+
+    if ( !sameSurface( serial, parallel ) )
+    {
+        std::cout << "ERROR: The grid test file is read differently by 1 and 4 threads.\n";
+        passed = false;
+    }
+
+    // Cache round trip of a large surface, the offsets and connectivity are read from the mapped file
+    std::string cacheName = fileName + ".meshcache";
+    if ( !writeMeshCache( cacheName, parallel, "grid" ) )
+    {
+        std::cout << "ERROR: Could not write the mesh cache of the grid test file.\n";
+        passed = false;
+    }
+    else
+    {
+        vtkSmartPointer<vtkPolyData> cached = readMeshCache( cacheName, "grid" );
+        if ( cached == nullptr || !sameSurface( parallel, cached ) )
+        {
+            std::cout << "ERROR: The grid read from the mesh cache differs from the parsed grid.\n";
+            passed = false;
+        }
+    }
+
+    removeFiles( fileName );
+    return passed;
+}
+
+int testObjMeshLoader( int, char*[] )
+{
+    bool passed = testMaterialFile();
+    passed = testGroupFile() && passed;
+    passed = testLargeFile() && passed;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,393 @@
+/****************************************************************************
+*   testSurfaceDistance.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Tests of the closest point search and the surface
+*                   distance statistics.
+****************************************************************************/
+
+#include "surfaceDistance.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPoints.h>
+
+// Random surface and queries of the brute force comparison
+static const int RANDOM_TRIANGLES = 300;
+static const int RANDOM_QUADS = 50;
+static const int RANDOM_QUERIES = 2000;
+static const unsigned int RANDOM_SEED = 7;
+
+// The coordinates are below 20, the distances are computed in double precision
+static const double DISTANCE_TOLERANCE = 1e-9;
+
+/*
+*   Surface from a list of coordinates and polygons given as size followed by the point ids.
+*/
+static vtkSmartPointer<vtkPolyData> createSurface( const std::vector<double>& coordinates, const std::vector<vtkIdType>& polygons,
+                                                   vtkIdType numPolys )
+{
+    vtkSmartPointer<vtkFloatArray> pointArray = vtkSmartPointer<vtkFloatArray>::New();
+    pointArray->SetNumberOfComponents( 3 );
+    pointArray->SetNumberOfTuples( static_cast<vtkIdType>( coordinates.size() / 3 ) );
+    std::copy( coordinates.begin(), coordinates.end(), pointArray->GetPointer( 0 ) );
+
+    vtkSmartPointer<vtkIdTypeArray> cellArray = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellArray->SetNumberOfValues( static_cast<vtkIdType>( polygons.size() ) );
+    std::copy( polygons.begin(), polygons.end(), cellArray->GetPointer( 0 ) );
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData( pointArray );
+
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+    polys->SetCells( numPolys, cellArray );
+
+    vtkSmartPointer<vtkPolyData> surface = vtkSmartPointer<vtkPolyData>::New();
+    surface->SetPoints( points );
+    surface->SetPolys( polys );
+    return surface;
+}
+
+static double distanceBetween( const double a[3], const double b[3] )
+{
+    return std::sqrt( ( a[0] - b[0] ) * ( a[0] - b[0] ) + ( a[1] - b[1] ) * ( a[1] - b[1] ) + ( a[2] - b[2] ) * ( a[2] - b[2] ) );
+}
+
+/*
+*   Reference distance from p to the segment ab.
+*/
+static double segmentDistance( const double p[3], const double a[3], const double b[3] )
+{
+    double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    double length2 = ab[0] * ab[0] + ab[1] * ab[1] + ab[2] * ab[2];
+    double t = ( length2 > 0.0 ) ? ( ( p[0] - a[0] ) * ab[0] + ( p[1] - a[1] ) * ab[1] + ( p[2] - a[2] ) * ab[2] ) / length2 : 0.0;
+    t = std::min( 1.0, std::max( 0.0, t ) );
+
+    double closest[3] = { a[0] + t * ab[0], a[1] + t * ab[1], a[2] + t * ab[2] };
+    return distanceBetween( p, closest );
+}
+
+/*
+*   Reference distance from p to the triangle abc: the projection onto the plane if it falls
+*   inside the triangle, the nearest edge otherwise (and always for a triangle without area).
+*/
+static double triangleDistance( const double p[3], const double a[3], const double b[3], const double c[3] )
+{
+    double best = std::min( segmentDistance( p, a, b ), std::min( segmentDistance( p, b, c ), segmentDistance( p, c, a ) ) );
+
+    double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+    double ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+    double n[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+    double area2 = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+    if ( area2 < 1e-12 )
+    {
+        return best;
+    }
+
+    // Barycentric coordinates of the projection, from the areas of the sub-triangles
+    double ap[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+    double height = ( ap[0] * n[0] + ap[1] * n[1] + ap[2] * n[2] ) / area2;
+    double q[3] = { p[0] - height * n[0], p[1] - height * n[1], p[2] - height * n[2] };
+
+    double weights[3];
+    const double* corners[3] = { a, b, c };
+    for ( int k = 0; k < 3; k++ )
+    {
+        const double* u = corners[( k + 1 ) % 3];
+        const double* v = corners[( k + 2 ) % 3];
+        double uq[3] = { q[0] - u[0], q[1] - u[1], q[2] - u[2] };
+        double uv[3] = { v[0] - u[0], v[1] - u[1], v[2] - u[2] };
+        double m[3] = { uv[1] * uq[2] - uv[2] * uq[1], uv[2] * uq[0] - uv[0] * uq[2], uv[0] * uq[1] - uv[1] * uq[0] };
+        weights[k] = ( m[0] * n[0] + m[1] * n[1] + m[2] * n[2] ) / area2;
+    }
+
+    if ( weights[0] >= 0.0 && weights[1] >= 0.0 && weights[2] >= 0.0 )
+    {
+        best = std::min( best, distanceBetween( p, q ) );
+    }
+    return best;
+}
+
+/*
+*   Query a hierarchy and compare the distance and the closest point with the expected ones.
+*/
+static bool checkQuery( const TriangleBVH& tree, const double query[3], double expectedDistance, const double* expectedClosest,
+                        const char* name )
+{
+    double closest[3];
+    double distance = tree.findClosestPoint( query, closest );
+
+    bool passed = std::fabs( distance - expectedDistance ) <= DISTANCE_TOLERANCE &&
+                  std::fabs( distanceBetween( query, closest ) - distance ) <= DISTANCE_TOLERANCE &&
+                  ( expectedClosest == nullptr || distanceBetween( closest, expectedClosest ) <= DISTANCE_TOLERANCE );
+
+    if ( !passed )
+    {
+        std::cout << "ERROR: " << name << ": distance " << distance << " instead of " << expectedDistance << ", closest point ("
+                  << closest[0] << ", " << closest[1] << ", " << closest[2] << ").\n";
+    }
+    return passed;
+}
+
+/*
+*   One query in each Voronoi region of a triangle: the three vertices, the three edges and the face.
+*/
+static bool testTriangleRegions()
+{
+    std::vector<double> coordinates = { 0, 0, 0,   4, 0, 0,   0, 3, 0 };
+    std::vector<vtkIdType> polygons = { 3, 0, 1, 2 };
+
+    TriangleBVH tree;
+    tree.build( createSurface( coordinates, polygons, 1 ), 1 );
+
+    struct RegionQuery
+    {
+        const char* name;
+        double      query[3];
+        double      closest[3];
+    };
+
+    // The hypotenuse runs from (4, 0) to (0, 3), (0.6, 0.8) points away from the triangle
+    const RegionQuery queries[7] =
+    {
+        { "Vertex a",  { -1.0, -1.0, 2.0 },                  { 0.0, 0.0, 0.0 } },
+        { "Vertex b",  { 6.0, -1.0, 1.0 },                   { 4.0, 0.0, 0.0 } },
+        { "Vertex c",  { -1.0, 5.0, -1.0 },                  { 0.0, 3.0, 0.0 } },
+        { "Edge ab",   { 2.0, -2.0, 1.0 },                   { 2.0, 0.0, 0.0 } },
+        { "Edge ac",   { -2.0, 1.0, -3.0 },                  { 0.0, 1.0, 0.0 } },
+        { "Edge bc",   { 2.0 + 1.2, 1.5 + 1.6, 1.0 },        { 2.0, 1.5, 0.0 } },
+        { "Face",      { 1.0, 1.0, -5.0 },                   { 1.0, 1.0, 0.0 } }
+    };
+
+    bool passed = true;
+    for ( int i = 0; i < 7; i++ )
+    {
+        double expected = distanceBetween( queries[i].query, queries[i].closest );
+        passed = checkQuery( tree, queries[i].query, expected, queries[i].closest, queries[i].name ) && passed;
+    }
+
+    return passed;
+}
+
+/*
+*   Triangles without area: three points on a line (the first one in the middle) and one point
+*   used three times. The closest point is on the segment, or the point.
+*/
+static bool testDegenerateTriangles()
+{
+    std::vector<double> coordinates = { 1, 0, 0,   0, 0, 0,   2, 0, 0 };
+    std::vector<vtkIdType> polygons = { 3, 0, 1, 2 };
+
+    TriangleBVH line;
+    line.build( createSurface( coordinates, polygons, 1 ), 1 );
+
+    double beside[3] = { 1.8, 1.0, 0.0 }, besideClosest[3] = { 1.8, 0.0, 0.0 };
+    double beyond[3] = { -1.0, 0.0, 2.0 }, beyondClosest[3] = { 0.0, 0.0, 0.0 };
+
+    bool passed = checkQuery( line, beside, 1.0, besideClosest, "Beside a line triangle" );
+    passed = checkQuery( line, beyond, std::sqrt( 5.0 ), beyondClosest, "Beyond a line triangle" ) && passed;
+
+    std::vector<double> pointCoordinates = { 3, 4, 5 };
+    std::vector<vtkIdType> pointPolygons = { 3, 0, 0, 0 };
+
+    TriangleBVH point;
+    point.build( createSurface( pointCoordinates, pointPolygons, 1 ), 1 );
+
+    double query[3] = { 3.0, 4.0, 7.0 }, pointClosest[3] = { 3.0, 4.0, 5.0 };
+    passed = checkQuery( point, query, 2.0, pointClosest, "A point triangle" ) && passed;
+
+    // Nearly collinear (in float precision, as stored), the rounding of the region tests must not
+    // send the query to the face
+    std::vector<double> thinCoordinates = { 0.1, 0.3, 0.7,   5.3, 2.9, 1.1,   10.5, 5.5, 1.5 };
+    for ( std::size_t i = 0; i < thinCoordinates.size(); i++ )
+    {
+        thinCoordinates[i] = static_cast<float>( thinCoordinates[i] );
+    }
+
+    TriangleBVH thin;
+    thin.build( createSurface( thinCoordinates, polygons, 1 ), 1 );
+
+    double thinQuery[3] = { 7.0, -1.0, 4.0 };
+    double expected = triangleDistance( thinQuery, &thinCoordinates[0], &thinCoordinates[3], &thinCoordinates[6] );
+    passed = checkQuery( thin, thinQuery, expected, nullptr, "Beside a nearly collinear triangle" ) && passed;
+
+    return passed;
+}
+
+/*
+*   Random triangles and quads of many sizes, queried at random points with hierarchies built
+*   by 1 and 4 threads, against a loop over all triangles.
+*/
+static bool testBruteForce()
+{
+    std::mt19937 random( RANDOM_SEED );
+    std::uniform_real_distribution<double> position( 0.0, 10.0 ), offset( -2.0, 2.0 ), query( -3.0, 13.0 );
+
+    std::vector<double> coordinates;
+    std::vector<vtkIdType> polygons;
+    std::vector<vtkIdType> triangles;   // The reference list, quads split into fans
+
+    for ( int i = 0; i < RANDOM_TRIANGLES + RANDOM_QUADS; i++ )
+    {
+        int numCorners = ( i < RANDOM_TRIANGLES ) ? 3 : 4;
+        double centre[3] = { position( random ), position( random ), position( random ) };
+        double scale = ( i % 3 == 0 ) ? 0.1 : 1.0;
+        vtkIdType first = static_cast<vtkIdType>( coordinates.size() / 3 );
+
+        // Quads are planar and convex, like the faces of a mesh
+        double u[3] = { offset( random ), offset( random ), offset( random ) };
+        double v[3] = { offset( random ), offset( random ), offset( random ) };
+        for ( int k = 0; k < numCorners; k++ )
+        {
+            double s = ( numCorners == 4 ) ? ( ( k == 1 || k == 2 ) ? 1.0 : -1.0 ) : offset( random );
+            double t = ( numCorners == 4 ) ? ( ( k >= 2 ) ? 1.0 : -1.0 ) : offset( random );
+            for ( int axis = 0; axis < 3; axis++ )
+            {
+                coordinates.push_back( centre[axis] + scale * ( numCorners == 4 ? 0.5 * ( s * u[axis] + t * v[axis] )
+                                                                                  : ( k == 0 ? 0.0 : ( k == 1 ? u[axis] : v[axis] ) ) ) );
+            }
+        }
+
+        polygons.push_back( numCorners );
+        for ( int k = 0; k < numCorners; k++ )
+        {
+            polygons.push_back( first + k );
+        }
+        for ( int k = 1; k + 1 < numCorners; k++ )
+        {
+            triangles.push_back( first );
+            triangles.push_back( first + k );
+            triangles.push_back( first + k + 1 );
+        }
+    }
+
+    vtkSmartPointer<vtkPolyData> surface = createSurface( coordinates, polygons, RANDOM_TRIANGLES + RANDOM_QUADS );
+
+    // The surface stores floats, the reference must use the same coordinates
+    std::vector<double> stored( coordinates.size() );
+    for ( std::size_t i = 0; i < coordinates.size(); i++ )
+    {
+        stored[i] = static_cast<float>( coordinates[i] );
+    }
+
+    bool passed = true;
+    unsigned int threadCounts[2] = { 1, 4 };
+
+    for ( int t = 0; t < 2; t++ )
+    {
+        TriangleBVH tree;
+        tree.build( surface, threadCounts[t] );
+
+        if ( tree.size() != triangles.size() / 3 )
+        {
+            std::cout << "ERROR: The hierarchy holds " << tree.size() << " triangles instead of " << triangles.size() / 3 << ".\n";
+            passed = false;
+            continue;
+        }
+
+        std::mt19937 queryRandom( RANDOM_SEED + 1 );
+        int failures = 0;
+
+        for ( int i = 0; i < RANDOM_QUERIES; i++ )
+        {
+            double p[3] = { query( queryRandom ), query( queryRandom ), query( queryRandom ) };
+
+            double expected = std::numeric_limits<double>::max();
+            for ( std::size_t k = 0; k < triangles.size(); k += 3 )
+            {
+                expected = std::min( expected, triangleDistance( p, &stored[3 * triangles[k]], &stored[3 * triangles[k + 1]],
+                                                                 &stored[3 * triangles[k + 2]] ) );
+            }
+
+            // Only the first difference is printed
+            double closest[3];
+            double distance = tree.findClosestPoint( p, closest );
+            if ( std::fabs( distance - expected ) > DISTANCE_TOLERANCE || std::fabs( distanceBetween( p, closest ) - distance ) > DISTANCE_TOLERANCE )
+            {
+                if ( failures++ == 0 )
+                {
+                    std::cout << "ERROR: The distance to (" << p[0] << ", " << p[1] << ", " << p[2] << ") is " << distance
+                              << " instead of " << expected << ".\n";
+                }
+            }
+        }
+
+        if ( failures > 0 )
+        {
+            std::cout << "ERROR: " << failures << " of " << RANDOM_QUERIES << " queries differ from the brute force search with "
+                      << threadCounts[t] << " build threads.\n";
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+/*
+*   Nearest rank 95th percentile: the value at rank ceil( 0.95 n ) of the sorted values.
+*/
+static bool testPercentile()
+{
+    bool passed = true;
+
+    std::vector<double> one = { 3.0 };
+    std::vector<double> two = { 2.0, 1.0 };
+    std::vector<double> twenty;
+    for ( int i = 20; i >= 1; i-- )
+    {
+        twenty.push_back( i );
+    }
+    std::shuffle( twenty.begin(), twenty.end(), std::mt19937( RANDOM_SEED ) );
+
+    // 1 value: rank 1, 2 values: rank 2 (the larger one), 20 values: rank 19
+    const std::vector<double>* sets[3] = { &one, &two, &twenty };
+    double expected[3] = { 3.0, 2.0, 19.0 };
+
+    for ( int i = 0; i < 3; i++ )
+    {
+        DistanceStatistics statistics = summarizeDistances( *sets[i] );
+        if ( statistics.percentile95 != expected[i] || statistics.numPoints != sets[i]->size() )
+        {
+            std::cout << "ERROR: The 95th percentile of " << sets[i]->size() << " values is " << statistics.percentile95
+                      << " instead of " << expected[i] << ".\n";
+            passed = false;
+        }
+    }
+
+    // Mean, RMS and maximum of 1 to 20
+    DistanceStatistics statistics = summarizeDistances( twenty );
+    if ( std::fabs( statistics.mean - 10.5 ) > 1e-12 || std::fabs( statistics.rms - std::sqrt( 2870.0 / 20.0 ) ) > 1e-12 ||
+         statistics.maximum != 20.0 )
+    {
+        std::cout << "ERROR: The mean, RMS or maximum of 1 to 20 is wrong.\n";
+        passed = false;
+    }
+
+    if ( summarizeDistances( std::vector<double>() ).numPoints != 0 )
+    {
+        std::cout << "ERROR: Statistics of no distances have points.\n";
+        passed = false;
+    }
+
+    return passed;
+}
+
+int testSurfaceDistance( int, char*[] )
+{
+    bool passed = testTriangleRegions();
+    passed = testDegenerateTriangles() && passed;
+    passed = testBruteForce() && passed;
+    passed = testPercentile() && passed;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,199 @@
+/****************************************************************************
+*   testSurfaceTransform.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Tests of the surface transformation and the lazy reslice.
+****************************************************************************/
+
+#include "surfaceTransform.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkPolyDataNormals.h>
+#include <vtkSphereSource.h>
+#include <vtkTransform.h>
+#include <vtkTransformPolyDataFilter.h>
+
+/*
+*   Largest difference between two arrays of 3-component tuples, -1 if their sizes differ.
+*/
+static double maxDifference( vtkDataArray* a, vtkDataArray* b )
+{
+    if ( a == nullptr || b == nullptr || a->GetNumberOfTuples() != b->GetNumberOfTuples() )
+    {
+        return -1.0;
+    }
+
+    double largest = 0.0;
+    double x[3], y[3];
+    for ( vtkIdType i = 0; i < a->GetNumberOfTuples(); i++ )
+    {
+        a->GetTuple( i, x );
+        b->GetTuple( i, y );
+        for ( int c = 0; c < 3; c++ )
+        {
+            largest = std::max( largest, std::fabs( x[c] - y[c] ) );
+        }
+    }
+
+    return largest;
+}
+
+/*
+*   Compare transformSurface() with vtkTransformPolyDataFilter for one matrix.
+*/
+static bool compareWithFilter( vtkPolyData* surface, vtkTransform* transform, const char* name )
+{
+    vtkSmartPointer<vtkTransformPolyDataFilter> filter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
+    filter->SetInputData( surface );
+    filter->SetTransform( transform );
+    filter->Update();
+    vtkPolyData* expected = filter->GetOutput();
+
+    bool passed = true;
+    unsigned int threadCounts[2] = { 1, 4 };
+
+    for ( int t = 0; t < 2; t++ )
+    {
+        vtkSmartPointer<vtkPolyData> transformed = transformSurface( surface, transform->GetMatrix(), threadCounts[t] );
+
+        // Points are stored as floats, the coordinates are below 30
+        double pointError = maxDifference( transformed->GetPoints()->GetData(), expected->GetPoints()->GetData() );
+        double normalError = maxDifference( transformed->GetPointData()->GetNormals(), expected->GetPointData()->GetNormals() );
+
+        if ( pointError < 0.0 || pointError > 1e-4 || normalError < 0.0 || normalError > 1e-5 )
+        {
+            std::cout << "ERROR: " << name << " with " << threadCounts[t] << " threads differs from vtkTransformPolyDataFilter, points by "
+                      << pointError << ", normals by " << normalError << ".\n";
+            passed = false;
+        }
+
+        if ( transformed->GetNumberOfPolys() != surface->GetNumberOfPolys() )
+        {
+            std::cout << "ERROR: " << name << " changed the number of polygons.\n";
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+/*
+*   Volume of 20^3 voxels, every voxel holds x + 20 y + 400 z.
+*/
+static vtkSmartPointer<vtkImageData> createVolume()
+{
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent( 0, 19, 0, 19, 0, 19 );
+    image->SetSpacing( 1.0, 1.0, 1.0 );
+    image->SetOrigin( 0.0, 0.0, 0.0 );
+    image->AllocateScalars( VTK_SHORT, 1 );
+
+    short* voxels = static_cast<short*>( image->GetScalarPointer() );
+    for ( int i = 0; i < 20 * 20 * 20; i++ )
+    {
+        voxels[i] = static_cast<short>( i );
+    }
+
+    return image;
+}
+
+/*
+*   Copies share the input and an output computed before the copy, not one computed after it.
+*/
+static bool testLazyResliceCopies()
+{
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    matrix->SetElement( 0, 3, 3.0 );
+
+    LazyReslice original;
+    original.setInput( createVolume(), matrix );
+
+    LazyReslice before = original;
+    vtkImageData* output = original.getOutput();
+    LazyReslice after = original;
+
+    bool passed = true;
+
+    if ( output == nullptr || !original.isComputed() )
+    {
+        std::cout << "ERROR: The lazy reslice was not computed.\n";
+        return false;
+    }
+
+    if ( before.isComputed() || !before.hasInput() )
+    {
+        std::cout << "ERROR: A copy made before the reslice sees its output.\n";
+        passed = false;
+    }
+
+    if ( !after.isComputed() || after.getOutput() != output )
+    {
+        std::cout << "ERROR: A copy made after the reslice does not share its output.\n";
+        passed = false;
+    }
+
+    // The copy computes its own output, equal to the first one
+    vtkImageData* copyOutput = before.getOutput();
+    if ( copyOutput == output || copyOutput->GetNumberOfPoints() != output->GetNumberOfPoints() )
+    {
+        std::cout << "ERROR: The copy made before the reslice did not compute its own output.\n";
+        passed = false;
+    }
+
+    // Releasing one copy leaves the others alone
+    original.release();
+    if ( original.hasInput() || !after.isComputed() || after.getOutput() != output )
+    {
+        std::cout << "ERROR: Releasing a lazy reslice changed its copies.\n";
+        passed = false;
+    }
+
+    return passed;
+}
+
+int testSurfaceTransform( int, char*[] )
+{
+    vtkSmartPointer<vtkSphereSource> sphere = vtkSmartPointer<vtkSphereSource>::New();
+    sphere->SetRadius( 10.0 );
+    sphere->SetThetaResolution( 40 );
+    sphere->SetPhiResolution( 30 );
+
+    vtkSmartPointer<vtkPolyDataNormals> normals = vtkSmartPointer<vtkPolyDataNormals>::New();
+    normals->SetInputConnection( sphere->GetOutputPort() );
+    normals->ComputePointNormalsOn();
+    normals->SplittingOff();
+    normals->Update();
+
+    vtkPolyData* surface = normals->GetOutput();
+    bool passed = true;
+
+    // Rigid
+    vtkSmartPointer<vtkTransform> rigid = vtkSmartPointer<vtkTransform>::New();
+    rigid->Translate( 4.0, -2.5, 7.0 );
+    rigid->RotateWXYZ( 37.0, 0.3, -0.5, 0.8 );
+    passed = compareWithFilter( surface, rigid, "A rigid transformation" ) && passed;
+
+    // Non-uniform scaling, the normals are not just rotated
+    vtkSmartPointer<vtkTransform> affine = vtkSmartPointer<vtkTransform>::New();
+    affine->Translate( -1.0, 2.0, 0.5 );
+    affine->RotateWXYZ( -65.0, 1.0, 0.2, 0.1 );
+    affine->Scale( 1.5, 0.6, 2.0 );
+    passed = compareWithFilter( surface, affine, "A non-uniform scaling" ) && passed;
+
+    // Mirroring
+    vtkSmartPointer<vtkTransform> mirror = vtkSmartPointer<vtkTransform>::New();
+    mirror->RotateWXYZ( 20.0, 0.0, 1.0, 1.0 );
+    mirror->Scale( -1.0, 1.0, 1.0 );
+    passed = compareWithFilter( surface, mirror, "A mirroring" ) && passed;
+
+    passed = testLazyResliceCopies() && passed;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,266 @@
+/****************************************************************************
+*   testVertexClustering.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Tests of the vertex clustering decimation.
+****************************************************************************/
+
+#include "vertexClustering.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkMath.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+
+// Quads around and along the torus, enough triangles for the parallel sorts of the clustering
+static const int TORUS_SEGMENTS = 600;
+static const int TORUS_RINGS = 300;
+static const double TORUS_RADIUS = 40.0;
+static const double TORUS_TUBE_RADIUS = 15.0;
+
+// The triangle count found from a target is only approximately reached
+static const double TARGET_TOLERANCE_LOW = 0.8;
+static const double TARGET_TOLERANCE_HIGH = 1.2;
+
+// Largest distance of a decimated vertex from the analytic torus
+static const double MAX_DISTANCE_HALF = 0.02;
+static const double MAX_DISTANCE_COARSE = 0.2;
+static const double MAX_DISTANCE_CELLS = 0.1;
+
+// Smallest cosine between a decimated normal and the outward direction of the tube
+static const double MIN_NORMAL_ALIGNMENT = 0.9;
+
+/*
+*   Torus made of quads, so the clustering also has to split polygons into triangles.
+*/
+static vtkSmartPointer<vtkPolyData> createTorus()
+{
+    vtkIdType numPoints = static_cast<vtkIdType>( TORUS_SEGMENTS ) * TORUS_RINGS;
+
+    vtkSmartPointer<vtkFloatArray> pointArray = vtkSmartPointer<vtkFloatArray>::New();
+    pointArray->SetNumberOfComponents( 3 );
+    pointArray->SetNumberOfTuples( numPoints );
+    float* p = pointArray->GetPointer( 0 );
+
+    for ( int segment = 0; segment < TORUS_SEGMENTS; segment++ )
+    {
+        double u = 2.0 * vtkMath::Pi() * segment / TORUS_SEGMENTS;
+        for ( int ring = 0; ring < TORUS_RINGS; ring++ )
+        {
+            double v = 2.0 * vtkMath::Pi() * ring / TORUS_RINGS;
+            double r = TORUS_RADIUS + TORUS_TUBE_RADIUS * std::cos( v );
+            *p++ = static_cast<float>( r * std::cos( u ) );
+            *p++ = static_cast<float>( r * std::sin( u ) );
+            *p++ = static_cast<float>( TORUS_TUBE_RADIUS * std::sin( v ) );
+        }
+    }
+
+    vtkSmartPointer<vtkIdTypeArray> cellArray = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellArray->SetNumberOfValues( 5 * numPoints );
+    vtkIdType* cell = cellArray->GetPointer( 0 );
+
+    for ( int segment = 0; segment < TORUS_SEGMENTS; segment++ )
+    {
+        int nextSegment = ( segment + 1 ) % TORUS_SEGMENTS;
+        for ( int ring = 0; ring < TORUS_RINGS; ring++ )
+        {
+            int nextRing = ( ring + 1 ) % TORUS_RINGS;
+            *cell++ = 4;
+            *cell++ = static_cast<vtkIdType>( segment ) * TORUS_RINGS + ring;
+            *cell++ = static_cast<vtkIdType>( nextSegment ) * TORUS_RINGS + ring;
+            *cell++ = static_cast<vtkIdType>( nextSegment ) * TORUS_RINGS + nextRing;
+            *cell++ = static_cast<vtkIdType>( segment ) * TORUS_RINGS + nextRing;
+        }
+    }
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData( pointArray );
+
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+    polys->SetCells( numPoints, cellArray );
+
+    vtkSmartPointer<vtkPolyData> torus = vtkSmartPointer<vtkPolyData>::New();
+    torus->SetPoints( points );
+    torus->SetPolys( polys );
+    return torus;
+}
+
+/*
+*   @returns TRUE if both arrays have exactly the same tuples
+*/
+static bool sameArray( vtkDataArray* a, vtkDataArray* b )
+{
+    if ( a == nullptr || b == nullptr || a->GetNumberOfTuples() != b->GetNumberOfTuples() ||
+         a->GetNumberOfComponents() != b->GetNumberOfComponents() )
+    {
+        return false;
+    }
+
+    std::vector<double> x( a->GetNumberOfComponents() ), y( b->GetNumberOfComponents() );
+    for ( vtkIdType i = 0; i < a->GetNumberOfTuples(); i++ )
+    {
+        a->GetTuple( i, x.data() );
+        b->GetTuple( i, y.data() );
+        if ( x != y )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+*   @returns TRUE if two surfaces have exactly the same points, normals and triangles
+*/
+static bool sameSurface( vtkPolyData* a, vtkPolyData* b )
+{
+    if ( a->GetNumberOfPolys() != b->GetNumberOfPolys() ||
+         !sameArray( a->GetPoints()->GetData(), b->GetPoints()->GetData() ) ||
+         !sameArray( a->GetPointData()->GetNormals(), b->GetPointData()->GetNormals() ) )
+    {
+        return false;
+    }
+
+    vtkIdTypeArray* cellsA = a->GetPolys()->GetData();
+    vtkIdTypeArray* cellsB = b->GetPolys()->GetData();
+    if ( cellsA->GetNumberOfValues() != cellsB->GetNumberOfValues() )
+    {
+        return false;
+    }
+
+    for ( vtkIdType i = 0; i < cellsA->GetNumberOfValues(); i++ )
+    {
+        if ( cellsA->GetPointer( 0 )[i] != cellsB->GetPointer( 0 )[i] )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+*   Check that the decimated surface still is the torus: the number of triangles near the target,
+*   every vertex close to the analytic torus and every normal of unit length pointing out of the tube.
+*
+*   @param   maxDistance   Largest allowed distance of a vertex from the torus
+*/
+static bool checkFidelity( vtkPolyData* decimated, vtkIdType targetTriangles, double maxDistance, const char* name )
+{
+    bool passed = true;
+    vtkIdType numTriangles = decimated->GetNumberOfPolys();
+
+    // The count is only approximately reached when the cell size is found from it
+    if ( targetTriangles > 0 && ( numTriangles < TARGET_TOLERANCE_LOW * targetTriangles ||
+                                  numTriangles > TARGET_TOLERANCE_HIGH * targetTriangles ) )
+    {
+        std::cout << "ERROR: " << name << " produced " << numTriangles << " triangles for a target of " << targetTriangles << ".\n";
+        passed = false;
+    }
+
+    vtkPoints* points = decimated->GetPoints();
+    vtkDataArray* normals = decimated->GetPointData()->GetNormals();
+    double largestDistance = 0.0;
+    vtkIdType numInward = 0;
+
+    for ( vtkIdType i = 0; i < points->GetNumberOfPoints(); i++ )
+    {
+        double p[3], n[3];
+        points->GetPoint( i, p );
+        normals->GetTuple( i, n );
+
+        // Closest point on the centre circle of the tube, the surface is TORUS_TUBE_RADIUS away from it
+        double radial = std::sqrt( p[0] * p[0] + p[1] * p[1] );
+        double centre[3] = { TORUS_RADIUS * p[0] / radial, TORUS_RADIUS * p[1] / radial, 0.0 };
+        double outward[3] = { p[0] - centre[0], p[1] - centre[1], p[2] };
+        double distance = std::fabs( vtkMath::Norm( outward ) - TORUS_TUBE_RADIUS );
+        largestDistance = std::max( largestDistance, distance );
+
+        vtkMath::Normalize( outward );
+        if ( std::fabs( vtkMath::Norm( n ) - 1.0 ) > 1e-3 || vtkMath::Dot( n, outward ) < MIN_NORMAL_ALIGNMENT )
+        {
+            numInward++;
+        }
+    }
+
+    if ( largestDistance > maxDistance )
+    {
+        std::cout << "ERROR: A vertex of " << name << " is " << largestDistance << " from the torus (at most "
+                  << maxDistance << " allowed).\n";
+        passed = false;
+    }
+
+    if ( numInward > 0 )
+    {
+        std::cout << "ERROR: " << numInward << " normals of " << name << " do not point out of the torus.\n";
+        passed = false;
+    }
+
+    return passed;
+}
+
+/*
+*   Decimate with 1 thread and with several, the outputs must be identical.
+*/
+static bool compareThreadCounts( vtkPolyData* surface, VertexClusteringSettings settings, double maxDistance, const char* name )
+{
+    settings.numThreads = 1;
+    vtkSmartPointer<vtkPolyData> serial = decimateByClustering( surface, settings );
+
+    if ( serial->GetNumberOfPolys() == 0 || serial->GetPointData()->GetNormals() == nullptr )
+    {
+        std::cout << "ERROR: " << name << " produced an empty surface or no normals.\n";
+        return false;
+    }
+
+    bool passed = checkFidelity( serial, settings.targetTriangles, maxDistance, name );
+    unsigned int threadCounts[3] = { 2, 3, 8 };
+
+    for ( int t = 0; t < 3; t++ )
+    {
+        settings.numThreads = threadCounts[t];
+        vtkSmartPointer<vtkPolyData> parallel = decimateByClustering( surface, settings );
+
+        if ( !sameSurface( serial, parallel ) )
+        {
+            std::cout << "ERROR: " << name << " with " << threadCounts[t] << " threads differs from 1 thread.\n";
+            passed = false;
+        }
+    }
+
+    return passed;
+}
+
+int testVertexClustering( int, char*[] )
+{
+    vtkSmartPointer<vtkPolyData> torus = createTorus();
+    vtkIdType numTriangles = 2 * torus->GetNumberOfPolys();
+    bool passed = true;
+
+    // The cell size found from a triangle count, for a small and a large reduction
+    VertexClusteringSettings half;
+    half.targetTriangles = numTriangles / 2;
+    passed = compareThreadCounts( torus, half, MAX_DISTANCE_HALF, "Decimating to half of the triangles" ) && passed;
+
+    VertexClusteringSettings coarse;
+    coarse.targetTriangles = 5000;
+    passed = compareThreadCounts( torus, coarse, MAX_DISTANCE_COARSE, "Decimating to 5000 triangles" ) && passed;
+
+    // A given cell size
+    VertexClusteringSettings cells;
+    cells.cellSize = 1.5;
+    passed = compareThreadCounts( torus, cells, MAX_DISTANCE_CELLS, "Decimating with 1.5 unit cells" ) && passed;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,83 @@
+/****************************************************************************
+*   threadPool.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the worker thread pool.
+****************************************************************************/
+
+#include "threadPool.hxx"
+#include "parallelUtils.hxx"
+
+ThreadPool::ThreadPool( unsigned int numThreads ) : _Running( 0 ), _Stopping( false )
+{
+    numThreads = getNumberOfWorkerThreads( numThreads );
+
+    for ( unsigned int i = 0; i < numThreads; i++ )
+    {
+        _Workers.emplace_back( &ThreadPool::workerLoop, this );
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock( _Mutex );
+        _Stopping = true;
+    }
+    _TaskAvailable.notify_all();
+
+    for ( std::size_t i = 0; i < _Workers.size(); i++ )
+    {
+        _Workers[i].join();
+    }
+}
+
+void ThreadPool::enqueue( const std::function<void()>& task )
+{
+    {
+        std::lock_guard<std::mutex> lock( _Mutex );
+        _Tasks.push_back( task );
+    }
+    _TaskAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock( _Mutex );
+    _AllDone.wait( lock, [this]() { return _Tasks.empty() && _Running == 0; } );
+}
+
+void ThreadPool::workerLoop()
+{
+    while ( true )
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock( _Mutex );
+            _TaskAvailable.wait( lock, [this]() { return _Stopping || !_Tasks.empty(); } );
+
+            // Queued tasks are still run when stopping
+            if ( _Tasks.empty() )
+            {
+                return;
+            }
+
+            task = _Tasks.front();
+            _Tasks.pop_front();
+            _Running++;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock( _Mutex );
+            _Running--;
+            if ( _Tasks.empty() && _Running == 0 )
+            {
+                _AllDone.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,67 @@
+/****************************************************************************
+*   threadPool.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    A fixed size pool of worker threads.
+****************************************************************************/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+*   A bounded pool of worker threads that runs queued tasks.
+*   At most getNumberOfThreads() tasks run at the same time.
+*/
+class ThreadPool
+{
+    public:
+        /*
+        *   Start the worker threads.
+        *
+        *   @param   numThreads   Number of worker threads (0 = one per core)
+        */
+        explicit ThreadPool( unsigned int numThreads = 0 );
+
+        /*
+        *   Finish all queued tasks and stop the worker threads.
+        */
+        ~ThreadPool();
+
+        /*
+        *   Add a task to the queue. Tasks must not throw.
+        *
+        *   @param   task   Function to run on one of the worker threads
+        */
+        void enqueue( const std::function<void()>& task );
+
+        /*
+        *   Block until every queued task has finished.
+        */
+        void wait();
+
+        unsigned int getNumberOfThreads() const { return static_cast<unsigned int>( _Workers.size() ); }
+
+    private:
+        std::vector<std::thread>            _Workers;
+        std::deque< std::function<void()> > _Tasks;
+        std::mutex                          _Mutex;
+        std::condition_variable             _TaskAvailable;
+        std::condition_variable             _AllDone;
+        std::size_t                         _Running;
+        bool                                _Stopping;
+
+        void workerLoop();
+
+        ThreadPool( const ThreadPool& );
+        ThreadPool& operator=( const ThreadPool& );
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,453 @@
+/****************************************************************************
+*   vertebraRegistration.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the piecewise rigid registration.
+****************************************************************************/
+
+#include "vertebraRegistration.hxx"
+#include "parallelUtils.hxx"
+#include "threadPool.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkFieldData.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkIntArray.h>
+#include <vtkMath.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkStringArray.h>
+
+/*
+*   Extract the polygons of one material and the points they use.
+*
+*   @param   surface       Whole surface, only read
+*   @param   cells         Polygons of the surface in the legacy layout (size followed by the point ids)
+*   @param   materialIds   Material of every polygon
+*   @param   material      Material to extract
+*/
+static vtkSmartPointer<vtkPolyData> extractPart( vtkPolyData* surface, const vtkIdType* cells, const int* materialIds, int material )
+{
+    vtkIdType numPolys = surface->GetNumberOfPolys();
+
+    std::vector<vtkIdType> pointMap( surface->GetNumberOfPoints(), -1 );
+    std::vector<vtkIdType> partPoints;
+    std::vector<vtkIdType> partCells;
+    vtkIdType numPartPolys = 0;
+
+    vtkIdType position = 0;
+    for ( vtkIdType c = 0; c < numPolys; c++ )
+    {
+        vtkIdType numCorners = cells[position++];
+        if ( materialIds[c] == material )
+        {
+            partCells.push_back( numCorners );
+            for ( vtkIdType k = 0; k < numCorners; k++ )
+            {
+                vtkIdType point = cells[position + k];
+                if ( pointMap[point] < 0 )
+                {
+                    pointMap[point] = static_cast<vtkIdType>( partPoints.size() );
+                    partPoints.push_back( point );
+                }
+                partCells.push_back( pointMap[point] );
+            }
+            numPartPolys++;
+        }
+        position += numCorners;
+    }
+
+    vtkSmartPointer<vtkPolyData> part = vtkSmartPointer<vtkPolyData>::New();
+    if ( numPartPolys == 0 )
+    {
+        return part;
+    }
+
+    vtkIdType numPoints = static_cast<vtkIdType>( partPoints.size() );
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetDataType( surface->GetPoints()->GetDataType() );
+    points->SetNumberOfPoints( numPoints );
+
+    double p[3];
+    for ( vtkIdType i = 0; i < numPoints; i++ )
+    {
+        surface->GetPoint( partPoints[i], p );
+        points->SetPoint( i, p );
+    }
+
+    vtkSmartPointer<vtkIdTypeArray> cellArray = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellArray->SetNumberOfValues( static_cast<vtkIdType>( partCells.size() ) );
+    std::copy( partCells.begin(), partCells.end(), cellArray->GetPointer( 0 ) );
+
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+    polys->SetCells( numPartPolys, cellArray );
+
+    part->SetPoints( points );
+    part->SetPolys( polys );
+
+    vtkDataArray* normals = surface->GetPointData()->GetNormals();
+    if ( normals != nullptr )
+    {
+        vtkSmartPointer<vtkFloatArray> partNormals = vtkSmartPointer<vtkFloatArray>::New();
+        partNormals->SetName( "Normals" );
+        partNormals->SetNumberOfComponents( 3 );
+        partNormals->SetNumberOfTuples( numPoints );
+
+        double normal[3];
+        for ( vtkIdType i = 0; i < numPoints; i++ )
+        {
+            normals->GetTuple( partPoints[i], normal );
+            partNormals->SetTuple( i, normal );
+        }
+        part->GetPointData()->SetNormals( partNormals );
+    }
+
+    return part;
+}
+
+std::vector<SurfacePart> splitSurfaceByMaterial( vtkPolyData* surface, unsigned int numThreads )
+{
+    std::vector<SurfacePart> parts;
+
+    vtkIntArray* materialIds = vtkIntArray::SafeDownCast( surface->GetCellData()->GetAbstractArray( "MaterialIds" ) );
+    vtkStringArray* materialNames = vtkStringArray::SafeDownCast( surface->GetFieldData()->GetAbstractArray( "MaterialNames" ) );
+
+    // The ids index the polygons, so the surface must not have other cells
+    if ( materialIds == nullptr || materialNames == nullptr || surface->GetNumberOfPolys() == 0 ||
+         surface->GetNumberOfPolys() != surface->GetNumberOfCells() || materialIds->GetNumberOfTuples() != surface->GetNumberOfPolys() )
+    {
+        return parts;
+    }
+
+    std::size_t numMaterials = static_cast<std::size_t>( materialNames->GetNumberOfValues() );
+    const int* ids = materialIds->GetPointer( 0 );
+
+    // VTK 9 builds the legacy layout on every GetData() call, in an array of the cell array,
+    // so it is exported once here and not by every thread
+    const vtkIdType* cells = surface->GetPolys()->GetData()->GetPointer( 0 );
+
+    parts.resize( numMaterials );
+    parallelFor( 0, numMaterials, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t m = begin; m < end; m++ )
+        {
+            parts[m].name = materialNames->GetValue( static_cast<vtkIdType>( m ) );
+            parts[m].surface = extractPart( surface, cells, ids, static_cast<int>( m ) );
+        }
+    }, numThreads, 1 );
+
+    parts.erase( std::remove_if( parts.begin(), parts.end(), []( const SurfacePart& part )
+    {
+        return part.surface->GetNumberOfPolys() == 0;
+    } ), parts.end() );
+
+    return parts;
+}
+
+VertebraRegistration::VertebraRegistration() : _Seconds( 0.0 )
+{
+}
+
+bool VertebraRegistration::update()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    _Transforms.clear();
+    _Seconds = 0.0;
+
+    if ( _Source == nullptr || _Source->GetNumberOfPoints() == 0 || _Target == nullptr || _Target->GetNumberOfPoints() == 0 )
+    {
+        return false;
+    }
+
+    std::vector<SurfacePart> parts = splitSurfaceByMaterial( _Source, _Settings.numThreads );
+    if ( parts.empty() )
+    {
+        return false;
+    }
+
+    vtkSmartPointer<vtkMatrix4x4> initial = vtkSmartPointer<vtkMatrix4x4>::New();
+    if ( _InitialMatrix != nullptr )
+    {
+        initial->DeepCopy( _InitialMatrix );
+    }
+
+    // One task per part, the threads left over go to the ICP runs
+    unsigned int numThreads = getNumberOfWorkerThreads( _Settings.numThreads );
+    unsigned int icpThreads = std::max<unsigned int>( 1, numThreads / static_cast<unsigned int>( parts.size() ) );
+
+    _Transforms.resize( parts.size() );
+    std::vector< std::vector<double> > centroids( parts.size(), std::vector<double>( 3, 0.0 ) );
+
+    ThreadPool pool( numThreads );
+
+    for ( std::size_t i = 0; i < parts.size(); i++ )
+    {
+        pool.enqueue( [this, i, icpThreads, &parts, &initial, &centroids]()
+        {
+            auto partStart = std::chrono::steady_clock::now();
+
+            vtkPolyData* part = parts[i].surface;
+            vtkIdType numPoints = part->GetNumberOfPoints();
+
+            VertebraTransform& transform = _Transforms[i];
+            transform.name = parts[i].name;
+            transform.matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+            transform.matrix->DeepCopy( initial );
+            transform.residual = -1.0;
+            transform.iterations = 0;
+            transform.numPoints = numPoints;
+
+            // Bounds of the part in the target space, grown by the margin
+            double lower[3], upper[3];
+            for ( int k = 0; k < 3; k++ )
+            {
+                lower[k] = std::numeric_limits<double>::max();
+                upper[k] = -std::numeric_limits<double>::max();
+            }
+
+            double p[4] = { 0.0, 0.0, 0.0, 1.0 }, q[4];
+            for ( vtkIdType n = 0; n < numPoints; n++ )
+            {
+                part->GetPoint( n, p );
+                transform.matrix->MultiplyPoint( p, q );
+                for ( int k = 0; k < 3; k++ )
+                {
+                    centroids[i][k] += p[k] / numPoints;
+                    lower[k] = std::min( lower[k], q[k] - _Settings.margin );
+                    upper[k] = std::max( upper[k], q[k] + _Settings.margin );
+                }
+            }
+
+            // The target points in that region
+            vtkSmartPointer<vtkPoints> regionPoints = vtkSmartPointer<vtkPoints>::New();
+            vtkIdType numTargetPoints = _Target->GetNumberOfPoints();
+            for ( vtkIdType n = 0; n < numTargetPoints; n++ )
+            {
+                _Target->GetPoint( n, q );
+                if ( q[0] >= lower[0] && q[0] <= upper[0] && q[1] >= lower[1] && q[1] <= upper[1] && q[2] >= lower[2] && q[2] <= upper[2] )
+                {
+                    regionPoints->InsertNextPoint( q );
+                }
+            }
+            transform.numTargetPoints = regionPoints->GetNumberOfPoints();
+
+            // Too little of the target near the part, it stays where the whole surface put it
+            if ( transform.numTargetPoints >= _Settings.minTargetPoints )
+            {
+                vtkSmartPointer<vtkPolyData> region = vtkSmartPointer<vtkPolyData>::New();
+                region->SetPoints( regionPoints );
+
+                FastICPSettings icpSettings = _Settings.icp;
+                icpSettings.numThreads = icpThreads;
+
+                FastICP icp;
+                icp.setSource( part );
+                icp.setTarget( region );
+                icp.setInitialMatrix( transform.matrix );
+                icp.setSettings( icpSettings );
+
+                if ( icp.update() )
+                {
+                    transform.matrix->DeepCopy( icp.getMatrix() );
+                    transform.residual = icp.getMeanDistance();
+                    transform.iterations = icp.getNumberOfIterations();
+                }
+            }
+
+            transform.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - partStart ).count();
+        } );
+    }
+    pool.wait();
+
+    smoothTransforms( centroids );
+
+    _Seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+
+    return true;
+}
+
+void VertebraRegistration::smoothTransforms( const std::vector< std::vector<double> >& centroids )
+{
+    std::size_t numParts = _Transforms.size();
+    if ( _Settings.smoothness <= 0.0 || numParts < 2 )
+    {
+        return;
+    }
+
+    // The main axis of the part centroids runs along the spine
+    double mean[3] = { 0.0, 0.0, 0.0 };
+    for ( std::size_t i = 0; i < numParts; i++ )
+    {
+        for ( int k = 0; k < 3; k++ )
+        {
+            mean[k] += centroids[i][k] / numParts;
+        }
+    }
+
+    double covariance[3][3] = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 } };
+    for ( std::size_t i = 0; i < numParts; i++ )
+    {
+        for ( int r = 0; r < 3; r++ )
+        {
+            for ( int c = 0; c < 3; c++ )
+            {
+                covariance[r][c] += ( centroids[i][r] - mean[r] ) * ( centroids[i][c] - mean[c] );
+            }
+        }
+    }
+
+    double eigenvalues[3], axes[3][3];
+    double* rows[3] = { covariance[0], covariance[1], covariance[2] };
+    double* axisRows[3] = { axes[0], axes[1], axes[2] };
+    vtkMath::Jacobi( rows, eigenvalues, axisRows );
+
+    // Neighbours are the parts before and after a part along that axis
+    std::vector<double> position( numParts );
+    std::vector<std::size_t> order( numParts );
+    for ( std::size_t i = 0; i < numParts; i++ )
+    {
+        position[i] = ( centroids[i][0] - mean[0] ) * axes[0][0] + ( centroids[i][1] - mean[1] ) * axes[1][0] +
+                      ( centroids[i][2] - mean[2] ) * axes[2][0];
+        order[i] = i;
+    }
+    std::sort( order.begin(), order.end(), [&position]( std::size_t a, std::size_t b )
+    {
+        return ( position[a] != position[b] ) ? position[a] < position[b] : a < b;
+    } );
+
+    for ( int pass = 0; pass < _Settings.smoothingPasses; pass++ )
+    {
+        std::vector< vtkSmartPointer<vtkMatrix4x4> > smoothed( numParts );
+
+        for ( std::size_t n = 0; n < numParts; n++ )
+        {
+            std::size_t i = order[n];
+            std::vector<std::size_t> neighbours;
+            if ( n > 0 )
+            {
+                neighbours.push_back( order[n - 1] );
+            }
+            if ( n + 1 < numParts )
+            {
+                neighbours.push_back( order[n + 1] );
+            }
+
+            double centroid[4] = { centroids[i][0], centroids[i][1], centroids[i][2], 1.0 };
+            double ownWeight = 1.0 - _Settings.smoothness;
+            double neighbourWeight = _Settings.smoothness / neighbours.size();
+
+            // Rotation and position of the centroid of the part, under its own and its neighbours' transformations
+            double rotation[3][3], ownQuaternion[4], quaternion[4], moved[4], target[3];
+            for ( int r = 0; r < 3; r++ )
+            {
+                for ( int c = 0; c < 3; c++ )
+                {
+                    rotation[r][c] = _Transforms[i].matrix->GetElement( r, c );
+                }
+            }
+            vtkMath::Matrix3x3ToQuaternion( rotation, ownQuaternion );
+            _Transforms[i].matrix->MultiplyPoint( centroid, moved );
+
+            for ( int k = 0; k < 4; k++ )
+            {
+                quaternion[k] = ownWeight * ownQuaternion[k];
+            }
+            for ( int k = 0; k < 3; k++ )
+            {
+                target[k] = ownWeight * moved[k];
+            }
+
+            for ( std::size_t j = 0; j < neighbours.size(); j++ )
+            {
+                vtkMatrix4x4* neighbour = _Transforms[neighbours[j]].matrix;
+
+                double neighbourQuaternion[4];
+                for ( int r = 0; r < 3; r++ )
+                {
+                    for ( int c = 0; c < 3; c++ )
+                    {
+                        rotation[r][c] = neighbour->GetElement( r, c );
+                    }
+                }
+                vtkMath::Matrix3x3ToQuaternion( rotation, neighbourQuaternion );
+
+                // q and -q are the same rotation, average on the same side
+                double dot = ownQuaternion[0] * neighbourQuaternion[0] + ownQuaternion[1] * neighbourQuaternion[1] +
+                             ownQuaternion[2] * neighbourQuaternion[2] + ownQuaternion[3] * neighbourQuaternion[3];
+                double sign = ( dot < 0.0 ) ? -1.0 : 1.0;
+                for ( int k = 0; k < 4; k++ )
+                {
+                    quaternion[k] += neighbourWeight * sign * neighbourQuaternion[k];
+                }
+
+                neighbour->MultiplyPoint( centroid, moved );
+                for ( int k = 0; k < 3; k++ )
+                {
+                    target[k] += neighbourWeight * moved[k];
+                }
+            }
+
+            double norm = std::sqrt( quaternion[0] * quaternion[0] + quaternion[1] * quaternion[1] +
+                                     quaternion[2] * quaternion[2] + quaternion[3] * quaternion[3] );
+            for ( int k = 0; k < 4; k++ )
+            {
+                quaternion[k] /= norm;
+            }
+            vtkMath::QuaternionToMatrix3x3( quaternion, rotation );
+
+            // Rotate about the centroid and move it to the averaged position
+            smoothed[i] = vtkSmartPointer<vtkMatrix4x4>::New();
+            for ( int r = 0; r < 3; r++ )
+            {
+                double translation = target[r];
+                for ( int c = 0; c < 3; c++ )
+                {
+                    smoothed[i]->SetElement( r, c, rotation[r][c] );
+                    translation -= rotation[r][c] * centroid[c];
+                }
+                smoothed[i]->SetElement( r, 3, translation );
+            }
+        }
+
+        for ( std::size_t i = 0; i < numParts; i++ )
+        {
+            _Transforms[i].matrix->DeepCopy( smoothed[i] );
+        }
+    }
+}
+
+bool writeVertebraReport( const std::string& fileName, const std::vector<VertebraTransform>& transforms )
+{
+    std::ofstream file( fileName );
+    file << std::setprecision( 10 );
+    file << "name,points,target_points,iterations,residual,seconds,m00,m01,m02,m03,m10,m11,m12,m13,m20,m21,m22,m23\n";
+
+    for ( std::size_t i = 0; i < transforms.size(); i++ )
+    {
+        const VertebraTransform& transform = transforms[i];
+        file << transform.name << "," << transform.numPoints << "," << transform.numTargetPoints << "," << transform.iterations << ","
+             << transform.residual << "," << transform.seconds;
+
+        for ( int r = 0; r < 3; r++ )
+        {
+            for ( int c = 0; c < 4; c++ )
+            {
+                file << "," << transform.matrix->GetElement( r, c );
+            }
+        }
+        file << "\n";
+    }
+
+    return static_cast<bool>( file );
+}
@@ -0,0 +1,153 @@
+/****************************************************************************
+*   vertebraRegistration.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Piecewise rigid registration, every vertebra of the OBJ
+*                   surface is registered on its own.
+****************************************************************************/
+
+#ifndef VERTEBRAREGISTRATION_H
+#define VERTEBRAREGISTRATION_H
+
+#include "fastICP.hxx"
+
+#include <string>
+#include <vector>
+
+#include <vtkMatrix4x4.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   The polygons of one material of a surface.
+*/
+struct SurfacePart
+{
+    std::string                  name;
+    vtkSmartPointer<vtkPolyData> surface;   // Only the points used by the polygons of the part
+};
+
+/*
+*   Split a surface by the "MaterialIds" cell array written by readOBJParallel().
+*   Every part keeps its point normals. Materials without polygons are left out.
+*
+*   @param   surface      Surface with material ids and names
+*   @param   numThreads   Number of threads, the parts are extracted concurrently (0 = one per core)
+*
+*   @returns The parts in the order of the material ids, empty if the surface has no materials
+*/
+std::vector<SurfacePart> splitSurfaceByMaterial( vtkPolyData* surface, unsigned int numThreads = 0 );
+
+/*
+*   Parameters of the piecewise registration.
+*/
+struct VertebraRegistrationSettings
+{
+    double          margin;             // The DICOM surface points within this distance of the bounds of a vertebra are its target
+    double          smoothness;         // Weight of the neighbours in every smoothing pass, 0 to 1 (0 = independent vertebrae)
+    int             smoothingPasses;    // Number of smoothing passes
+    int             minTargetPoints;    // Vertebrae with fewer target points keep the initial matrix
+    FastICPSettings icp;                // Settings of the ICP run of every vertebra (numThreads is ignored)
+    unsigned int    numThreads;         // 0 = one per core
+
+    VertebraRegistrationSettings() :
+        margin( 10.0 ), smoothness( 0.0 ), smoothingPasses( 5 ), minTargetPoints( 50 ), numThreads( 0 ) { }
+};
+
+/*
+*   Registration result of one vertebra.
+*/
+struct VertebraTransform
+{
+    std::string                   name;             // Material (or group) of the vertebra in the OBJ file
+    vtkSmartPointer<vtkMatrix4x4> matrix;           // Transformation of the vertebra from the OBJ space to the DICOM space
+    double                        residual;         // Mean distance of the ICP run (before smoothing), -1 if it was skipped
+    int                           iterations;       // ICP iterations
+    vtkIdType                     numPoints;        // Points of the vertebra
+    vtkIdType                     numTargetPoints;  // DICOM surface points in its region
+    double                        seconds;          // Wall time of its registration
+};
+
+/*
+*   Piecewise rigid registration of a segmented OBJ surface.
+*
+*   Starting from the rigid registration of the whole surface, the surface is split by
+*   material and every part (vertebra) is registered with the fast ICP engine to the target
+*   points within a margin around it. The parts are independent and run as tasks on a thread
+*   pool; when there are fewer parts than threads the ICP runs share the rest of the threads.
+*
+*   The optional smoothing pulls every transformation towards those of its neighbours, the
+*   parts next to it along the spine (the main axis of the part centroids). In every pass the
+*   pose of a part becomes the weighted mean of its own pose and the poses its neighbours
+*   would give it, rotations are averaged as quaternions.
+*/
+class VertebraRegistration
+{
+    public:
+        VertebraRegistration();
+
+        /*
+        *   Set the surface that is split and moved (the OBJ surface, with materials).
+        */
+        void setSource( vtkPolyData* source ) { _Source = source; }
+
+        /*
+        *   Set the surface the parts are registered to (the DICOM surface).
+        */
+        void setTarget( vtkPolyData* target ) { _Target = target; }
+
+        /*
+        *   Set the transformation of the whole surface, the start of every part.
+        *
+        *   @param   matrix   Rigid transformation from the source to the target space
+        */
+        void setInitialMatrix( vtkMatrix4x4* matrix ) { _InitialMatrix = matrix; }
+
+        void setSettings( const VertebraRegistrationSettings& settings ) { _Settings = settings; }
+
+        /*
+        *   Register all parts.
+        *
+        *   @returns TRUE if the source has parts to register, FALSE if it has no materials or an input is missing
+        */
+        bool update();
+
+        /*
+        *   @returns The transformation of every part, in the order of the material ids
+        */
+        const std::vector<VertebraTransform>& getTransforms() const { return _Transforms; }
+
+        /*
+        *   @returns The wall time of the last update(), in seconds
+        */
+        double getSeconds() const { return _Seconds; }
+
+    private:
+        vtkSmartPointer<vtkPolyData>  _Source;
+        vtkSmartPointer<vtkPolyData>  _Target;
+        vtkSmartPointer<vtkMatrix4x4> _InitialMatrix;
+        VertebraRegistrationSettings  _Settings;
+
+        std::vector<VertebraTransform> _Transforms;
+        double                         _Seconds;
+
+        /*
+        *   Blend the transformations of neighbouring parts.
+        *
+        *   @param   centroids   Centroid of every part in the source space
+        */
+        void smoothTransforms( const std::vector<std::vector<double> >& centroids );
+};
+
+/*
+*   Write the transformation, residual and time of every vertebra as CSV.
+*
+*   @param   fileName     Path of the report
+*   @param   transforms   Results of the piecewise registration
+*
+*   @returns TRUE if the file was written, FALSE otherwise
+*/
+bool writeVertebraReport( const std::string& fileName, const std::vector<VertebraTransform>& transforms );
+
+#endif // VERTEBRAREGISTRATION_H
@@ -0,0 +1,513 @@
+/****************************************************************************
+*   vertexClustering.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the vertex clustering decimation.
+****************************************************************************/
+
+#include "vertexClustering.hxx"
+#include "parallelUtils.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkMath.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+
+// Bits of a grid coordinate in a cell key (three coordinates per 64-bit key)
+static const int CLUSTER_KEY_BITS = 21;
+
+// Passes that refine the cell size towards the target triangle count
+static const int CLUSTER_SIZE_PASSES = 4;
+
+// Stop refining when the estimated triangle count is this close to the target (fraction)
+static const double CLUSTER_SIZE_TOLERANCE = 0.05;
+
+// Eigenvalues of a cell quadric below this fraction of the largest one are ignored
+static const double CLUSTER_EIGENVALUE_RATIO = 1e-3;
+
+// Below this many values a sort runs on one thread
+static const std::size_t PARALLEL_SORT_MIN_SIZE = 1 << 16;
+
+namespace
+{
+
+/*
+*   Sort in parallel: the chunks are sorted concurrently and then merged pair by pair.
+*   For a strict total order the result is the same as std::sort's, whatever the number of threads.
+*/
+template <typename T, typename Less>
+void parallelSort( std::vector<T>& values, Less less, unsigned int numThreads )
+{
+    std::size_t numChunks = getNumberOfWorkerThreads( numThreads );
+    if ( numChunks == 1 || values.size() < PARALLEL_SORT_MIN_SIZE )
+    {
+        std::sort( values.begin(), values.end(), less );
+        return;
+    }
+
+    std::vector<std::size_t> bounds( numChunks + 1 );
+    for ( std::size_t c = 0; c <= numChunks; c++ )
+    {
+        bounds[c] = values.size() * c / numChunks;
+    }
+
+    parallelFor( 0, numChunks, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t c = begin; c < end; c++ )
+        {
+            std::sort( values.begin() + bounds[c], values.begin() + bounds[c + 1], less );
+        }
+    }, numThreads, 1 );
+
+    for ( std::size_t width = 1; width < numChunks; width *= 2 )
+    {
+        parallelFor( 0, ( numChunks + 2 * width - 1 ) / ( 2 * width ), [&]( std::size_t begin, std::size_t end )
+        {
+            for ( std::size_t pair = begin; pair < end; pair++ )
+            {
+                std::size_t first = bounds[2 * pair * width];
+                std::size_t middle = bounds[std::min( numChunks, ( 2 * pair + 1 ) * width )];
+                std::size_t last = bounds[std::min( numChunks, ( 2 * pair + 2 ) * width )];
+                std::inplace_merge( values.begin() + first, values.begin() + middle, values.begin() + last, less );
+            }
+        }, numThreads, 1 );
+    }
+}
+
+/*
+*   An output triangle, rotated so that its smallest vertex comes first (keeps the orientation).
+*/
+struct ClusterTriangle
+{
+    vtkIdType ids[3];
+
+    bool operator<( const ClusterTriangle& other ) const
+    {
+        return std::lexicographical_compare( ids, ids + 3, other.ids, other.ids + 3 );
+    }
+
+    bool operator==( const ClusterTriangle& other ) const
+    {
+        return ids[0] == other.ids[0] && ids[1] == other.ids[1] && ids[2] == other.ids[2];
+    }
+};
+
+/*
+*   Split the polygons into triangles, three point ids per triangle.
+*/
+std::vector<vtkIdType> collectTriangles( vtkPolyData* surface, unsigned int numThreads )
+{
+    vtkIdType numPolys = surface->GetNumberOfPolys();
+    vtkIdTypeArray* cellArray = surface->GetPolys()->GetData();
+    const vtkIdType* cells = cellArray->GetPointer( 0 );
+
+    std::vector<vtkIdType> triangles;
+
+    // Marching cubes output is all triangles, which can be copied in parallel
+    if ( cellArray->GetNumberOfValues() == 4 * numPolys )
+    {
+        triangles.resize( 3 * numPolys );
+        parallelFor( 0, static_cast<std::size_t>( numPolys ), [&]( std::size_t begin, std::size_t end )
+        {
+            for ( std::size_t t = begin; t < end; t++ )
+            {
+                triangles[3 * t] = cells[4 * t + 1];
+                triangles[3 * t + 1] = cells[4 * t + 2];
+                triangles[3 * t + 2] = cells[4 * t + 3];
+            }
+        }, numThreads );
+        return triangles;
+    }
+
+    vtkIdType offset = 0;
+    for ( vtkIdType c = 0; c < numPolys; c++ )
+    {
+        vtkIdType size = cells[offset];
+        for ( vtkIdType k = 1; k + 1 < size; k++ )
+        {
+            triangles.push_back( cells[offset + 1] );
+            triangles.push_back( cells[offset + 1 + k] );
+            triangles.push_back( cells[offset + 2 + k] );
+        }
+        offset += size + 1;
+    }
+    return triangles;
+}
+
+/*
+*   Grid cell key of every point.
+*/
+void computeCellKeys( const std::vector<double>& coordinates, const double origin[3], double cellSize,
+                      unsigned int numThreads, std::vector<unsigned long long>& keys )
+{
+    std::size_t numPoints = coordinates.size() / 3;
+    keys.resize( numPoints );
+
+    parallelFor( 0, numPoints, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t i = begin; i < end; i++ )
+        {
+            unsigned long long key = 0;
+            for ( int axis = 0; axis < 3; axis++ )
+            {
+                unsigned long long index = static_cast<unsigned long long>( ( coordinates[3 * i + axis] - origin[axis] ) / cellSize );
+                key |= index << ( axis * CLUSTER_KEY_BITS );
+            }
+            keys[i] = key;
+        }
+    }, numThreads );
+}
+
+/*
+*   Sorted distinct cell keys.
+*/
+std::vector<unsigned long long> distinctKeys( const std::vector<unsigned long long>& keys, unsigned int numThreads )
+{
+    std::vector<unsigned long long> sorted( keys );
+    parallelSort( sorted, std::less<unsigned long long>(), numThreads );
+    sorted.erase( std::unique( sorted.begin(), sorted.end() ), sorted.end() );
+    return sorted;
+}
+
+/*
+*   Point minimising the quadric ( A, g ) of a cell: A x = -g, solved only along the eigenvectors of A with a
+*   large enough eigenvalue and starting from the mean of the cell's points along the others.
+*/
+void placeVertex( const double quadric[9], const double mean[3], double position[3] )
+{
+    // quadric holds A (upper triangle: xx xy xz yy yz zz) and g
+    double a[3][3] = { { quadric[0], quadric[1], quadric[2] },
+                       { quadric[1], quadric[3], quadric[4] },
+                       { quadric[2], quadric[4], quadric[5] } };
+
+    // Residual at the mean: r = -g - A mean
+    double residual[3];
+    for ( int r = 0; r < 3; r++ )
+    {
+        residual[r] = -quadric[6 + r] - ( a[r][0] * mean[0] + a[r][1] * mean[1] + a[r][2] * mean[2] );
+    }
+
+    double eigenvalues[3], axes[3][3];
+    double* rows[3] = { a[0], a[1], a[2] };
+    double* axisRows[3] = { axes[0], axes[1], axes[2] };
+    vtkMath::Jacobi( rows, eigenvalues, axisRows );
+
+    position[0] = mean[0];
+    position[1] = mean[1];
+    position[2] = mean[2];
+
+    for ( int e = 0; e < 3; e++ )
+    {
+        if ( eigenvalues[e] <= CLUSTER_EIGENVALUE_RATIO * eigenvalues[0] || eigenvalues[e] <= 0.0 )
+        {
+            continue;
+        }
+
+        double step = ( axes[0][e] * residual[0] + axes[1][e] * residual[1] + axes[2][e] * residual[2] ) / eigenvalues[e];
+        for ( int r = 0; r < 3; r++ )
+        {
+            position[r] += step * axes[r][e];
+        }
+    }
+}
+
+} // namespace
+
+vtkSmartPointer<vtkPolyData> decimateByClustering( vtkPolyData* surface, const VertexClusteringSettings& settings )
+{
+    unsigned int numThreads = settings.numThreads;
+    vtkIdType numPoints = surface->GetNumberOfPoints();
+    std::vector<vtkIdType> triangles = collectTriangles( surface, numThreads );
+    std::size_t numTriangles = triangles.size() / 3;
+
+    vtkSmartPointer<vtkPolyData> output = vtkSmartPointer<vtkPolyData>::New();
+    if ( numPoints == 0 || numTriangles == 0 )
+    {
+        return output;
+    }
+
+    // Points in double precision, and the bounds of the surface
+    std::vector<double> coordinates( 3 * numPoints );
+    vtkDataArray* pointData = surface->GetPoints()->GetData();
+    parallelFor( 0, static_cast<std::size_t>( numPoints ), [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t i = begin; i < end; i++ )
+        {
+            pointData->GetTuple( static_cast<vtkIdType>( i ), &coordinates[3 * i] );
+        }
+    }, numThreads );
+
+    double bounds[6];
+    surface->GetPoints()->GetBounds( bounds );
+
+    // Area-weighted plane quadric (A: 6 values, g: 3 values) and normal of every triangle
+    std::vector<double> faceQuadrics( 9 * numTriangles );
+    std::vector<double> faceNormals( 3 * numTriangles );
+    std::vector<double> faceAreas( numTriangles );
+
+    parallelFor( 0, numTriangles, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t t = begin; t < end; t++ )
+        {
+            const double* p0 = &coordinates[3 * triangles[3 * t]];
+            const double* p1 = &coordinates[3 * triangles[3 * t + 1]];
+            const double* p2 = &coordinates[3 * triangles[3 * t + 2]];
+
+            double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+            double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+            double* normal = &faceNormals[3 * t];
+            vtkMath::Cross( e1, e2, normal );
+
+            double length = vtkMath::Norm( normal );
+            double area = 0.5 * length;
+            faceAreas[t] = area;
+
+            // Half the cross product has the length of the area, used for the normal weighting
+            normal[0] *= 0.5;
+            normal[1] *= 0.5;
+            normal[2] *= 0.5;
+
+            double* quadric = &faceQuadrics[9 * t];
+            if ( length == 0.0 )
+            {
+                std::fill( quadric, quadric + 9, 0.0 );
+                continue;
+            }
+
+            double n[3] = { 2.0 * normal[0] / length, 2.0 * normal[1] / length, 2.0 * normal[2] / length };
+            double d = -vtkMath::Dot( n, p0 );
+
+            quadric[0] = area * n[0] * n[0];
+            quadric[1] = area * n[0] * n[1];
+            quadric[2] = area * n[0] * n[2];
+            quadric[3] = area * n[1] * n[1];
+            quadric[4] = area * n[1] * n[2];
+            quadric[5] = area * n[2] * n[2];
+            quadric[6] = area * d * n[0];
+            quadric[7] = area * d * n[1];
+            quadric[8] = area * d * n[2];
+        }
+    }, numThreads );
+
+    /***************************************************************
+    *   Cell size
+    ***************************************************************/
+    vtkIdType targetTriangles = ( settings.targetTriangles > 0 ) ? settings.targetTriangles : static_cast<vtkIdType>( numTriangles / 2 );
+    double origin[3] = { bounds[0], bounds[2], bounds[4] };
+    double extent = std::max( bounds[1] - bounds[0], std::max( bounds[3] - bounds[2], bounds[5] - bounds[4] ) );
+
+    // Smallest cell size that keeps the grid coordinates within the key bits
+    double minimumSize = std::max( extent / ( ( 1 << CLUSTER_KEY_BITS ) - 2 ), 1e-12 );
+
+    std::vector<unsigned long long> pointKeys;
+    std::vector<unsigned long long> cellKeys;
+    double cellSize = settings.cellSize;
+
+    if ( cellSize <= 0.0 )
+    {
+        // Serial sum, so the estimate does not depend on the number of threads
+        double area = 0.0;
+        for ( std::size_t t = 0; t < numTriangles; t++ )
+        {
+            area += faceAreas[t];
+        }
+
+        // A surface crosses about 1.5 cells per cell area and has about two triangles per vertex
+        cellSize = std::sqrt( 3.0 * area / std::max<vtkIdType>( targetTriangles, 1 ) );
+
+        for ( int pass = 0; pass < CLUSTER_SIZE_PASSES; pass++ )
+        {
+            cellSize = std::max( cellSize, minimumSize );
+            computeCellKeys( coordinates, origin, cellSize, numThreads, pointKeys );
+            cellKeys = distinctKeys( pointKeys, numThreads );
+
+            double estimate = 2.0 * cellKeys.size();
+            if ( std::fabs( estimate - targetTriangles ) <= CLUSTER_SIZE_TOLERANCE * targetTriangles )
+            {
+                break;
+            }
+            cellSize *= std::sqrt( estimate / targetTriangles );
+            cellKeys.clear();
+        }
+    }
+
+    if ( cellKeys.empty() )
+    {
+        cellSize = std::max( cellSize, minimumSize );
+        computeCellKeys( coordinates, origin, cellSize, numThreads, pointKeys );
+        cellKeys = distinctKeys( pointKeys, numThreads );
+    }
+
+    /***************************************************************
+    *   Cell of every point and the corners of every cell
+    ***************************************************************/
+    std::vector<vtkIdType> pointCells( numPoints );
+    parallelFor( 0, static_cast<std::size_t>( numPoints ), [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t i = begin; i < end; i++ )
+        {
+            pointCells[i] = std::lower_bound( cellKeys.begin(), cellKeys.end(), pointKeys[i] ) - cellKeys.begin();
+        }
+    }, numThreads );
+
+    // Corners of every cell in corner order, by a counting sort, so that every cell sums its
+    // triangles in the same order whatever the number of threads
+    std::size_t numCells = cellKeys.size();
+    std::size_t numCorners = 3 * numTriangles;
+    std::vector<std::size_t> cornerStart( numCells + 1, 0 );
+    for ( std::size_t c = 0; c < numCorners; c++ )
+    {
+        cornerStart[pointCells[triangles[c]] + 1]++;
+    }
+    for ( std::size_t cell = 0; cell < numCells; cell++ )
+    {
+        cornerStart[cell + 1] += cornerStart[cell];
+    }
+
+    std::vector<std::size_t> corners( numCorners );
+    std::vector<std::size_t> next( cornerStart.begin(), cornerStart.end() - 1 );
+    for ( std::size_t c = 0; c < numCorners; c++ )
+    {
+        corners[next[pointCells[triangles[c]]]++] = c;
+    }
+
+    // Output ids of the cells that have triangles, in cell order
+    std::vector<vtkIdType> outputIds( numCells, -1 );
+    vtkIdType numOutputPoints = 0;
+    for ( std::size_t cell = 0; cell < numCells; cell++ )
+    {
+        if ( cornerStart[cell + 1] > cornerStart[cell] )
+        {
+            outputIds[cell] = numOutputPoints++;
+        }
+    }
+
+    /***************************************************************
+    *   Vertex and normal of every cell
+    ***************************************************************/
+    vtkSmartPointer<vtkFloatArray> pointArray = vtkSmartPointer<vtkFloatArray>::New();
+    pointArray->SetNumberOfComponents( 3 );
+    pointArray->SetNumberOfTuples( numOutputPoints );
+
+    vtkSmartPointer<vtkFloatArray> normalArray = vtkSmartPointer<vtkFloatArray>::New();
+    normalArray->SetName( "Normals" );
+    normalArray->SetNumberOfComponents( 3 );
+    normalArray->SetNumberOfTuples( numOutputPoints );
+
+    float* outputPoints = pointArray->GetPointer( 0 );
+    float* outputNormals = normalArray->GetPointer( 0 );
+
+    parallelFor( 0, numCells, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t cell = begin; cell < end; cell++ )
+        {
+            if ( outputIds[cell] < 0 )
+            {
+                continue;
+            }
+
+            double quadric[9] = { 0.0 }, normal[3] = { 0.0, 0.0, 0.0 }, mean[3] = { 0.0, 0.0, 0.0 };
+            for ( std::size_t c = cornerStart[cell]; c < cornerStart[cell + 1]; c++ )
+            {
+                std::size_t corner = corners[c];
+                std::size_t t = corner / 3;
+                const double* point = &coordinates[3 * triangles[corner]];
+
+                for ( int k = 0; k < 9; k++ )
+                {
+                    quadric[k] += faceQuadrics[9 * t + k];
+                }
+                for ( int k = 0; k < 3; k++ )
+                {
+                    normal[k] += faceNormals[3 * t + k];
+                    mean[k] += point[k];
+                }
+            }
+
+            double count = static_cast<double>( cornerStart[cell + 1] - cornerStart[cell] );
+            mean[0] /= count;
+            mean[1] /= count;
+            mean[2] /= count;
+
+            double position[3];
+            placeVertex( quadric, mean, position );
+            vtkMath::Normalize( normal );
+
+            vtkIdType id = outputIds[cell];
+            for ( int k = 0; k < 3; k++ )
+            {
+                outputPoints[3 * id + k] = static_cast<float>( position[k] );
+                outputNormals[3 * id + k] = static_cast<float>( normal[k] );
+            }
+        }
+    }, numThreads );
+
+    /***************************************************************
+    *   Triangles between three different cells, without duplicates
+    ***************************************************************/
+    std::vector<ClusterTriangle> clustered( numTriangles );
+    parallelFor( 0, numTriangles, [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t t = begin; t < end; t++ )
+        {
+            vtkIdType ids[3] = { outputIds[pointCells[triangles[3 * t]]], outputIds[pointCells[triangles[3 * t + 1]]],
+                                 outputIds[pointCells[triangles[3 * t + 2]]] };
+
+            ClusterTriangle& triangle = clustered[t];
+            if ( ids[0] == ids[1] || ids[1] == ids[2] || ids[0] == ids[2] )
+            {
+                // Collapsed triangles sort to the end
+                triangle.ids[0] = triangle.ids[1] = triangle.ids[2] = numOutputPoints;
+                continue;
+            }
+
+            int first = ( ids[0] < ids[1] ) ? ( ( ids[0] < ids[2] ) ? 0 : 2 ) : ( ( ids[1] < ids[2] ) ? 1 : 2 );
+            for ( int k = 0; k < 3; k++ )
+            {
+                triangle.ids[k] = ids[( first + k ) % 3];
+            }
+        }
+    }, numThreads );
+
+    parallelSort( clustered, std::less<ClusterTriangle>(), numThreads );
+    clustered.erase( std::unique( clustered.begin(), clustered.end() ), clustered.end() );
+    if ( !clustered.empty() && clustered.back().ids[0] == numOutputPoints )
+    {
+        clustered.pop_back();
+    }
+
+    vtkIdType numOutputTriangles = static_cast<vtkIdType>( clustered.size() );
+    vtkSmartPointer<vtkIdTypeArray> cellArray = vtkSmartPointer<vtkIdTypeArray>::New();
+    cellArray->SetNumberOfValues( 4 * numOutputTriangles );
+    vtkIdType* cells = cellArray->GetPointer( 0 );
+
+    parallelFor( 0, clustered.size(), [&]( std::size_t begin, std::size_t end )
+    {
+        for ( std::size_t t = begin; t < end; t++ )
+        {
+            cells[4 * t] = 3;
+            cells[4 * t + 1] = clustered[t].ids[0];
+            cells[4 * t + 2] = clustered[t].ids[1];
+            cells[4 * t + 3] = clustered[t].ids[2];
+        }
+    }, numThreads );
+
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    points->SetData( pointArray );
+
+    vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
+    polys->SetCells( numOutputTriangles, cellArray );
+
+    output->SetPoints( points );
+    output->SetPolys( polys );
+    output->GetPointData()->SetNormals( normalArray );
+
+    return output;
+}
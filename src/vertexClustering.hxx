@@ -0,0 +1,56 @@
+/****************************************************************************
+*   vertexClustering.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Parallel surface decimation by vertex clustering with
+*                   quadric error placement of the clustered vertices.
+****************************************************************************/
+
+#ifndef VERTEXCLUSTERING_H
+#define VERTEXCLUSTERING_H
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   Parameters of the vertex clustering decimation. Either the size of the grid cells or
+*   the number of triangles to aim for is given.
+*/
+struct VertexClusteringSettings
+{
+    double       cellSize;          // Edge length of the grid cells (world units, 0 = found from targetTriangles)
+    vtkIdType    targetTriangles;   // Triangles to aim for when cellSize is 0 (0 = half of the input)
+    unsigned int numThreads;        // 0 = one per core
+
+    VertexClusteringSettings() : cellSize( 0.0 ), targetTriangles( 0 ), numThreads( 0 ) { }
+};
+
+/*
+*   Decimate a surface by merging all vertices within a cell of a regular grid into one.
+*
+*   Every input triangle adds its plane, weighted by its area, to the error quadric of the
+*   cells of its three vertices. The vertex of a cell is put where the sum of squared
+*   distances to those planes is smallest (limited to the well-conditioned directions, so
+*   flat and cylindrical cells keep the vertex near the mean of their points), which keeps
+*   edges and the surface position much better than averaging. Triangles whose vertices fall
+*   in fewer than three cells are dropped, and triangles that become duplicates are merged.
+*   The output has point normals, the area-weighted mean of the normals of the input
+*   triangles of every cell.
+*
+*   When only a triangle count is given, the cell size is estimated from the surface area
+*   and refined by counting the occupied cells a few times (an output has about two
+*   triangles per vertex), so the count is only approximately reached.
+*
+*   All stages run on all cores and every sum is taken in a fixed order, so the output is
+*   exactly the same for any number of threads. Polygons with more than three points are
+*   split into fans.
+*
+*   @param   surface    Surface to decimate (polygons only)
+*   @param   settings   Cell size or target triangle count and number of threads
+*
+*   @returns The decimated triangle surface with point normals
+*/
+vtkSmartPointer<vtkPolyData> decimateByClustering( vtkPolyData* surface, const VertexClusteringSettings& settings );
+
+#endif // VERTEXCLUSTERING_H
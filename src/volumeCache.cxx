@@ -0,0 +1,139 @@
+/****************************************************************************
+*   volumeCache.cxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Implementation of the raw volume cache files.
+****************************************************************************/
+
+#include "volumeCache.hxx"
+#include "mappedFile.hxx"
+
+#include <fstream>
+#include <sstream>
+
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+
+static const char* VOLUME_HEADER_MAGIC = "VTKREG_VOLUME";
+static const int   VOLUME_HEADER_VERSION = 1;
+
+bool writeVolumeCache( const std::string& basePath, vtkImageData* image, const std::string& fingerprint )
+{
+    vtkDataArray* scalars = image->GetPointData()->GetScalars();
+    if ( scalars == nullptr )
+    {
+        return false;
+    }
+
+    std::size_t numBytes = static_cast<std::size_t>( scalars->GetNumberOfTuples() ) *
+                           scalars->GetNumberOfComponents() * scalars->GetDataTypeSize();
+
+    if ( !writeFileAtomically( basePath + ".raw", scalars->GetVoidPointer( 0 ), numBytes ) )
+    {
+        return false;
+    }
+
+    int* extent = image->GetExtent();
+    double* spacing = image->GetSpacing();
+    double* origin = image->GetOrigin();
+
+    std::stringstream header;
+    header.precision( 17 );
+    header << VOLUME_HEADER_MAGIC << " " << VOLUME_HEADER_VERSION << "\n";
+    header << "fingerprint " << fingerprint << "\n";
+    header << "extent " << extent[0] << " " << extent[1] << " " << extent[2] << " "
+                        << extent[3] << " " << extent[4] << " " << extent[5] << "\n";
+    header << "spacing " << spacing[0] << " " << spacing[1] << " " << spacing[2] << "\n";
+    header << "origin " << origin[0] << " " << origin[1] << " " << origin[2] << "\n";
+    header << "scalarType " << scalars->GetDataType() << "\n";
+    header << "components " << scalars->GetNumberOfComponents() << "\n";
+
+    std::string text = header.str();
+    return writeFileAtomically( basePath + ".vhdr", text.data(), text.size() );
+}
+
+vtkSmartPointer<vtkImageData> readVolumeCache( const std::string& basePath, const std::string& fingerprint )
+{
+    std::ifstream headerFile( basePath + ".vhdr" );
+    if ( !headerFile )
+    {
+        return nullptr;
+    }
+
+    std::string magic, key, cachedFingerprint;
+    int version = 0, scalarType = -1, components = 0;
+    int extent[6] = { 0, -1, 0, -1, 0, -1 };
+    double spacing[3] = { 1.0, 1.0, 1.0 };
+    double origin[3] = { 0.0, 0.0, 0.0 };
+
+    headerFile >> magic >> version;
+    if ( magic != VOLUME_HEADER_MAGIC || version != VOLUME_HEADER_VERSION )
+    {
+        return nullptr;
+    }
+
+    while ( headerFile >> key )
+    {
+        if ( key == "fingerprint" )
+        {
+            headerFile >> cachedFingerprint;
+        }
+        else if ( key == "extent" )
+        {
+            headerFile >> extent[0] >> extent[1] >> extent[2] >> extent[3] >> extent[4] >> extent[5];
+        }
+        else if ( key == "spacing" )
+        {
+            headerFile >> spacing[0] >> spacing[1] >> spacing[2];
+        }
+        else if ( key == "origin" )
+        {
+            headerFile >> origin[0] >> origin[1] >> origin[2];
+        }
+        else if ( key == "scalarType" )
+        {
+            headerFile >> scalarType;
+        }
+        else if ( key == "components" )
+        {
+            headerFile >> components;
+        }
+    }
+
+    if ( cachedFingerprint != fingerprint || components < 1 || scalarType < 0 )
+    {
+        return nullptr;
+    }
+
+    vtkSmartPointer<vtkDataArray> scalars = vtkSmartPointer<vtkDataArray>::Take( vtkDataArray::CreateDataArray( scalarType ) );
+    if ( scalars == nullptr )
+    {
+        return nullptr;
+    }
+
+    vtkIdType numValues = static_cast<vtkIdType>( extent[1] - extent[0] + 1 ) *
+                          ( extent[3] - extent[2] + 1 ) *
+                          ( extent[5] - extent[4] + 1 ) * components;
+
+    MappedFile* mapping = new MappedFile();
+    if ( numValues <= 0 || !mapping->open( basePath + ".raw" ) ||
+         mapping->size() != static_cast<std::size_t>( numValues ) * scalars->GetDataTypeSize() )
+    {
+        delete mapping;
+        return nullptr;
+    }
+
+    // Point the array straight at the mapped pages, VTK must not free them (save = 1)
+    scalars->SetNumberOfComponents( components );
+    scalars->SetVoidArray( mapping->data(), numValues, 1 );
+    attachMappingToArray( scalars, mapping );
+
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetExtent( extent );
+    image->SetSpacing( spacing );
+    image->SetOrigin( origin );
+    image->GetPointData()->SetScalars( scalars );
+
+    return image;
+}
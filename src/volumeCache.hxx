@@ -0,0 +1,41 @@
+/****************************************************************************
+*   volumeCache.hxx
+*
+*   Created by:     Michael Kuczynski
+*   Created on:     17/10/2026
+*   Description:    Raw volume files with a small text header sidecar.
+*                   Cached volumes are memory mapped when read back, so
+*                   loading them does not copy or parse anything.
+****************************************************************************/
+
+#ifndef VOLUMECACHE_H
+#define VOLUMECACHE_H
+
+#include <string>
+
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+/*
+*   Write an image to a raw volume file (<basePath>.raw) and header file (<basePath>.vhdr).
+*   The header is written last, so a volume is only picked up once both files are complete.
+*
+*   @param   basePath      Path of the cache files without the extension
+*   @param   image         Image to write
+*   @param   fingerprint   String identifying the data the image was created from
+*
+*   @returns TRUE if both files were written, FALSE otherwise
+*/
+bool writeVolumeCache( const std::string& basePath, vtkImageData* image, const std::string& fingerprint );
+
+/*
+*   Read an image written by writeVolumeCache() by memory mapping the raw file.
+*
+*   @param   basePath      Path of the cache files without the extension
+*   @param   fingerprint   Expected fingerprint, the cache is ignored if it does not match
+*
+*   @returns The cached image, or nullptr if there is no valid cache
+*/
+vtkSmartPointer<vtkImageData> readVolumeCache( const std::string& basePath, const std::string& fingerprint );
+
+#endif // VOLUMECACHE_H
@@ -8,182 +8,200 @@
 ****************************************************************************/
 
 #include "interactorStyler.hxx"
-
-vtkStandardNewMacro(myInteractorStyler);
+#include "registrationPipeline.hxx"
+#include "sliceReview.hxx"
 
 int main(int argc, char* argv[])
 {
     /***************************************************************
     *   Check input arguements
     ***************************************************************/
-    if ( argc != 3 )
+    PipelineOptions options;
+
+    if ( !parseCommandLine( argc, argv, options ) )
     {
         std::cout << "ERROR: Incorrect program usage." << std:: endl;
-        std::cout << "Correct usage: " << argv[0] << " <DICOM_Folder_Directory> <OBJ_File_Directory>" << std::endl;
+        printUsage( argv[0] );
         return EXIT_FAILURE;
     }
 
-    vtkSmartPointer<vtkPolyData> obj = vtkSmartPointer<vtkPolyData>::New();
-
-    vtkSmartPointer<vtkDICOMImageReader> dicomReader;
-    vtkSmartPointer<vtkOBJReader>        objReader;
-
-    /***************************************************************
-    *   Read in the provided DICOM and OBJ files
-    ***************************************************************/
-    // Create a variable for the input arguement (if valid type).
-    std::string dicomFile = "";
-    std::string objFile = "";
+    // Headless batch of many cases
+    if ( !options.manifestFile.empty() )
+    {
+        std::vector<RegistrationCase> cases;
+        if ( !readManifest( options.manifestFile, cases ) || cases.empty() )
+        {
+            return EXIT_FAILURE;
+        }
+
+        if ( !options.haveThresholds || ( !options.fusedExtraction && !options.haveIsoValue ) )
+        {
+            std::cout << "ERROR: Batch mode needs --lower and --upper (and --isovalue with --extraction mask)." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        return ( runBatchRegistration( cases, options ) == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
     // Verify that the provided input arguements are valid
-    if ( !checkInputs( argv[1], argv[2] ) )
+    if ( !checkInputs( options.dicomDirectory, options.objFile ) )
     {
         return EXIT_FAILURE;
     }
-    else
-    {
-        dicomFile = argv[1];
-        objFile = argv[2];
-    }
-
-    // Read all files from the DICOM series in the specified directory.
-    dicomReader = vtkSmartPointer<vtkDICOMImageReader>::New();
-    dicomReader->SetDirectoryName( dicomFile.c_str() );
-    dicomReader->Update();
-
-    // Read in the OBJ file
-    objReader = vtkSmartPointer<vtkOBJReader>::New();
-    objReader->SetFileName( objFile.c_str() );
-    objReader->Update();
 
-    obj = objReader->GetOutput();
+    RegistrationCase registrationCase;
+    registrationCase.name = "case";
+    registrationCase.dicomDirectory = options.dicomDirectory;
+    registrationCase.objFile = options.objFile;
 
     /***************************************************************
-    *   Apply a Gaussian filter to the DICOM series
+    *   Get the segmentation parameters
     ***************************************************************/
-    vtkSmartPointer<vtkImageGaussianSmooth> gaussianSmoothFilter = vtkSmartPointer<vtkImageGaussianSmooth>::New();
-    gaussianSmoothFilter->SetInputConnection( dicomReader->GetOutputPort() );
-    gaussianSmoothFilter->SetStandardDeviation( 1.0 );
-    gaussianSmoothFilter->SetRadiusFactors( 1.0, 1.0, 1.0 );
-    gaussianSmoothFilter->SetDimensionality( 3 );
-    gaussianSmoothFilter->Update();
-
-    /***************************************************************
-    *   Segment the input DICOM series
-    ***************************************************************/
-    int lowerThresh = 0, upperThresh = 0;
-    double isoValue = 0.0;
+    if ( options.batch && ( !options.haveThresholds || ( !options.fusedExtraction && !options.haveIsoValue ) ) )
+    {
+        std::cout << "ERROR: Batch mode needs --lower and --upper (and --isovalue with --extraction mask)." << std::endl;
+        return EXIT_FAILURE;
+    }
 
     // Get the threshold and isovalue parameters from the user
-    std::cout << "\n**Performing image segmentation** \n";
-    std::cout << "Please enter upper and lower threshold values (for this assignment, it is recommended to select values between -800 to -600): \n";
-    std::cout << "Lower Threshold = ";
-    std::cin >> lowerThresh;
-    std::cout << "Upper Threshold = ";
-    std::cin >> upperThresh;
-
-    std::cout << "Applying global threshold...";
-
-    // Apply the global threshold
-    vtkSmartPointer<vtkImageThreshold> globalThresh = vtkSmartPointer<vtkImageThreshold>::New();
-    globalThresh->SetInputData( gaussianSmoothFilter->GetOutput() );
-    globalThresh->ThresholdBetween( lowerThresh, upperThresh );
-    globalThresh->ReplaceInOn();
-    globalThresh->SetInValue( 1 );
-    globalThresh->ReplaceOutOn();
-    globalThresh->SetOutValue( 0 );
-    globalThresh->SetOutputScalarTypeToFloat();
-    globalThresh->Update();
+    if ( !options.haveThresholds )
+    {
+        std::cout << "\n**Performing image segmentation** \n";
+        std::cout << "Please enter upper and lower threshold values (for this assignment, it is recommended to select values between -800 to -600): \n";
+        std::cout << "Lower Threshold = ";
+        std::cin >> options.lowerThresh;
+        std::cout << "Upper Threshold = ";
+        std::cin >> options.upperThresh;
+        options.haveThresholds = true;
+    }
 
-    std::cout << "Done! \n";
+    // The isovalue is only used by marching cubes on the binary mask
+    if ( !options.fusedExtraction && !options.haveIsoValue )
+    {
+        std::cout << "Please enter the desired isovalue for the Marching Cubes algortihm (between 0-1): ";
+        std::cin >> options.isoValue;
+        options.haveIsoValue = true;
+    }
 
     /***************************************************************
-    *   Use the Marching cubes algorithm to generate the surface
+    *   Segment the DICOM series and perform ICP registration
     ***************************************************************/
-    std::cout << "\n**Generating surface using Marching cubes** \n";
+    RegistrationResult result;
 
-    std::cout << "Please enter the desired isovalue for the Marching Cubes algortihm (between 0-1): ";
-    std::cin >> isoValue;
-
-    std::cout << "Starting surface rendering...";
-
-    vtkSmartPointer<vtkMarchingCubes> surface = vtkSmartPointer<vtkMarchingCubes>::New();
-    surface->SetInputData( globalThresh->GetOutput() );
-    surface->ComputeNormalsOn();
-    surface->SetValue( 0, isoValue );
+    if ( !runRegistration( registrationCase, options, 0, result ) )
+    {
+        return EXIT_FAILURE;
+    }
 
-    // Reduce the number of triangles by half to speed up computation
-    vtkSmartPointer<vtkDecimatePro> decimate = vtkSmartPointer<vtkDecimatePro>::New();
-    decimate->SetInputConnection( surface->GetOutputPort() );
-    decimate->SetTargetReduction( 0.5 );
-    decimate->Update();
+    if ( result.profile.isEnabled() && !result.profile.writeReport( options.profileFile, registrationCase.name ) )
+    {
+        std::cout << "ERROR: Could not write the profile to " << options.profileFile << std::endl;
+    }
 
-    std::cout << "Done! \n";
+    // Headless mode writes the results and skips all rendering
+    if ( options.batch )
+    {
+        if ( !writeRegistrationResult( options.outputDirectory, result, options.saveResliced ) )
+        {
+            return EXIT_FAILURE;
+        }
+
+        std::cout << "Registration done in " << result.seconds << " s, results written to " << options.outputDirectory << std::endl;
+        if ( options.lowMemory )
+        {
+            std::cout << "Peak resident memory: " << result.peakMemoryKB / 1024 << " MB" << std::endl;
+        }
+        return EXIT_SUCCESS;
+    }
 
     /***************************************************************
-    *   Perform ICP registration
+    *   Review the registration slice by slice
     ***************************************************************/
-    std::cout << "\n**Starting image registration** \n";
-
-    // Perform the registration between the DICOM images and the OBJ file
-    vtkSmartPointer<vtkIterativeClosestPointTransform> icp = vtkSmartPointer<vtkIterativeClosestPointTransform>::New();
-    icp->SetSource( obj );
-    icp->SetTarget( decimate->GetOutput() );
-    icp->SetMaximumNumberOfIterations( 75 );
-    icp->GetLandmarkTransform()->SetModeToRigidBody();
-    icp->StartByMatchingCentroidsOn();
-    icp->Update();
-
-    // Output the transformation matrix
-    vtkSmartPointer<vtkMatrix4x4> m = icp->GetMatrix();
-    std::cout << "\nThe resulting transformation matrix is: \n" << std::fixed << std::setprecision(2) << *m;
-
-    vtkSmartPointer<vtkTransform> icpTransformFilter = vtkSmartPointer<vtkTransform>::New();
-    icpTransformFilter->SetMatrix( icp->GetMatrix() );
-    icpTransformFilter->Update();
-
-    // Perform the transformation using the transformation matrix determined above
-    std::cout << "Transforming the original image into the new coordinate space...";
-
-    vtkSmartPointer<vtkImageReslice> reslice = vtkSmartPointer<vtkImageReslice>::New();
-    reslice->SetInputData( gaussianSmoothFilter->GetOutput() );
-    reslice->InterpolateOff();  // On for nearest neighbour, off for linear
-    reslice->AutoCropOutputOn();
-    reslice->SetResliceTransform( icpTransformFilter );
-    reslice->Update();
-
-    std::cout << "Done! \n";
-
-    std::cout << "Performing image segmentation on the transformed image...";
-
-    // Now render the transformed image
-    // Since we had to reslice the original image, we will need to segment and render the resliced image again...
-    vtkSmartPointer<vtkImageThreshold> globalThreshTransformed = vtkSmartPointer<vtkImageThreshold>::New();
-    globalThreshTransformed->SetInputData( reslice->GetOutput() );
-    globalThreshTransformed->ThresholdBetween( lowerThresh, upperThresh );
-    globalThreshTransformed->ReplaceInOn();
-    globalThreshTransformed->SetInValue( 1 );
-    globalThreshTransformed->ReplaceOutOn();
-    globalThreshTransformed->SetOutValue( 0 );
-    globalThreshTransformed->SetOutputScalarTypeToFloat();
-    globalThreshTransformed->Update();
-
-    std::cout << "Done! \n";
-
-    std::cout << "Starting surface rendering...";
-
-    vtkSmartPointer<vtkMarchingCubes> surfaceTransformed = vtkSmartPointer<vtkMarchingCubes>::New();
-    surfaceTransformed->SetInputData( globalThreshTransformed->GetOutput() );
-    surfaceTransformed->ComputeNormalsOn();
-    surfaceTransformed->SetValue( 0, isoValue );
-
-    // Reduce the number of triangles by half to speed up computation
-    vtkSmartPointer<vtkDecimatePro> decimateTransformed = vtkSmartPointer<vtkDecimatePro>::New();
-    decimateTransformed->SetInputConnection( surfaceTransformed->GetOutputPort() );
-    decimateTransformed->SetTargetReduction( 0.5 );
-    decimateTransformed->Update();
-
-    std::cout << "Done! \n";
+    if ( options.sliceReview )
+    {
+        std::cout << "\n**Reviewing the slices** \n";
+
+        SliceReview review;
+        if ( !review.setInput( result.resliced, result.objSurface ) )
+        {
+            std::cout << "ERROR: There is no resliced image to review." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        // Window and level from the middle slice, changed with the arrow and z/x keys
+        vtkSmartPointer<vtkImageData> image;
+        vtkSmartPointer<vtkPolyData> contour;
+        if ( !review.getSlice( ( review.getFirstSlice() + review.getLastSlice() ) / 2, image, contour ) )
+        {
+            std::cout << "ERROR: Could not resample the resliced image." << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        double range[2];
+        image->GetScalarRange( range );
+
+        vtkSmartPointer<vtkImageViewer2> imageViewer = vtkSmartPointer<vtkImageViewer2>::New();
+        imageViewer->SetInputData( image );
+        imageViewer->SetColorWindow( range[1] - range[0] );
+        imageViewer->SetColorLevel( 0.5 * ( range[0] + range[1] ) );
+
+        // Contour of the OBJ surface on the slice
+        vtkSmartPointer<vtkPolyDataMapper> contourMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
+        contourMapper->SetInputData( contour );
+        contourMapper->ScalarVisibilityOff();
+
+        vtkSmartPointer<vtkActor> contourActor = vtkSmartPointer<vtkActor>::New();
+        contourActor->SetMapper( contourMapper );
+        contourActor->GetProperty()->SetColor( 0, 1, 0 );
+        contourActor->GetProperty()->SetLineWidth( 2 );
+        imageViewer->GetRenderer()->AddActor( contourActor );
+
+        // Status messages
+        vtkSmartPointer<vtkTextProperty> textProperty = vtkSmartPointer<vtkTextProperty>::New();
+        textProperty->SetFontFamilyToCourier();
+        textProperty->SetFontSize( 16 );
+        textProperty->SetVerticalJustificationToBottom();
+        textProperty->SetJustificationToLeft();
+
+        vtkSmartPointer<vtkTextMapper> sliceStatusMapper = vtkSmartPointer<vtkTextMapper>::New();
+        sliceStatusMapper->SetTextProperty( textProperty );
+
+        vtkSmartPointer<vtkTextMapper> windowLevelStatusMapper = vtkSmartPointer<vtkTextMapper>::New();
+        windowLevelStatusMapper->SetInput( ImageMessage::windowLevelFormat( int( imageViewer->GetColorLevel() ) ).c_str() );
+        windowLevelStatusMapper->SetTextProperty( textProperty );
+
+        vtkSmartPointer<vtkTextMapper> windowStatusMapper = vtkSmartPointer<vtkTextMapper>::New();
+        windowStatusMapper->SetInput( ImageMessage::windowFormat( int( imageViewer->GetColorWindow() ) ).c_str() );
+        windowStatusMapper->SetTextProperty( textProperty );
+
+        vtkTextMapper* statusMappers[3] = { sliceStatusMapper, windowLevelStatusMapper, windowStatusMapper };
+        for ( int i = 0; i < 3; i++ )
+        {
+            vtkSmartPointer<vtkActor2D> statusActor = vtkSmartPointer<vtkActor2D>::New();
+            statusActor->SetMapper( statusMappers[i] );
+            statusActor->SetPosition( 15, 10 + 20 * i );
+            imageViewer->GetRenderer()->AddActor2D( statusActor );
+        }
+
+        vtkSmartPointer<vtkRenderWindowInteractor> interactor = vtkSmartPointer<vtkRenderWindowInteractor>::New();
+        vtkSmartPointer<myInteractorStyler> styler = vtkSmartPointer<myInteractorStyler>::New();
+
+        imageViewer->SetupInteractor( interactor );
+        styler->setImageViewer( imageViewer );
+        styler->setSliceStatusMapper( sliceStatusMapper );
+        styler->setWindowLevelStatusMapper( windowLevelStatusMapper );
+        styler->setWindowStatusMapper( windowStatusMapper );
+        styler->setSliceReview( &review, contourMapper );
+        interactor->SetInteractorStyle( styler );
+
+        styler->render();
+
+        std::cout << "Done! Scroll with the mouse wheel or the up and down arrow keys. \n";
+
+        interactor->Start();
+
+        return EXIT_SUCCESS;
+    }
 
     /***************************************************************
     *   Add mappers, actors, renderer, and setup the scene
@@ -193,7 +211,7 @@ int main(int argc, char* argv[])
     // Define mappers
     // 1. Original Image
     // vtkSmartPointer<vtkPolyDataMapper> sourceMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-    // sourceMapper->SetInputData( decimate->GetOutput() );
+    // sourceMapper->SetInputData( result.targetSurface );
 
     // vtkSmartPointer<vtkActor> sourceActor = vtkSmartPointer<vtkActor>::New();
     // sourceActor->SetMapper( sourceMapper );
@@ -203,7 +221,7 @@ int main(int argc, char* argv[])
 
     // 2. OBJ File
     vtkSmartPointer<vtkPolyDataMapper> targetMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-    targetMapper->SetInputData( obj );
+    targetMapper->SetInputData( result.objSurface );
 
     vtkSmartPointer<vtkActor> targetActor = vtkSmartPointer<vtkActor>::New();
     targetActor->SetMapper( targetMapper );
@@ -214,7 +232,7 @@ int main(int argc, char* argv[])
   
     // 3. Registered Image
     vtkSmartPointer<vtkPolyDataMapper> solutionMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-    solutionMapper->SetInputConnection( decimateTransformed->GetOutputPort() );
+    solutionMapper->SetInputData( result.registeredSurface );
 
     vtkSmartPointer<vtkActor> solutionActor = vtkSmartPointer<vtkActor>::New();
     solutionActor->SetMapper( solutionMapper );